@@ -3,6 +3,7 @@
 #include "clock_utils.h"
 #include "event.h"
 #include "format_utils.h"
+#include "minmax.h"
 #include "ptp_core.h"
 #include "ptp_defs.h"
 #include "ptp_types.h"
@@ -19,23 +20,123 @@
 
 // ------------
 
-#define COMPARE_AND_RETURN(pmp1, pmp2, field)   \
+// compare a field of the Announce bodies of A and B, lower value wins
+#define COMPARE_AND_RETURN(pa, pb, field)       \
     {                                           \
-        if (pmp1->field < pmp2->field) {        \
-            return 0;                           \
-        } else if (pmp1->field > pmp2->field) { \
-            return 1;                           \
+        if ((pa)->field < (pb)->field) {        \
+            return PTP_BMCA_A_BETTER;           \
+        } else if ((pa)->field > (pb)->field) { \
+            return PTP_BMCA_B_BETTER;           \
         }                                       \
     }
 
+// compare two port identities: clock identities first, then port numbers
+static int ptp_bmca_compare_port_identity(uint64_t ci1, uint16_t pn1, uint64_t ci2, uint16_t pn2) {
+    if (ci1 != ci2) {
+        return (ci1 < ci2) ? -1 : 1;
+    } else if (pn1 != pn2) {
+        return (pn1 < pn2) ? -1 : 1;
+    }
+    return 0;
+}
+
+PtpBmcaCompResult ptp_bmca_compare_datasets(const PtpBmcaDataset *pA, const PtpBmcaDataset *pB) {
+    const PtpAnnounceBody *a = pA->pAnn;
+    const PtpAnnounceBody *b = pB->pAnn;
+
+    // part A: different grandmasters are compared by their properties
+    if (a->grandmasterClockIdentity != b->grandmasterClockIdentity) {
+        COMPARE_AND_RETURN(a, b, priority1);
+        COMPARE_AND_RETURN(a, b, grandmasterClockClass);
+        COMPARE_AND_RETURN(a, b, grandmasterClockAccuracy);
+        COMPARE_AND_RETURN(a, b, grandmasterClockVariance);
+        COMPARE_AND_RETURN(a, b, priority2);
+        COMPARE_AND_RETURN(a, b, grandmasterClockIdentity);
+    }
+
+    // part B: paths to the same grandmaster are compared by topology
+    uint32_t stepsA = a->localStepsRemoved;
+    uint32_t stepsB = b->localStepsRemoved;
+    if (stepsA > stepsB + 1) {
+        return PTP_BMCA_B_BETTER;
+    } else if (stepsA + 1 < stepsB) {
+        return PTP_BMCA_A_BETTER;
+    }
+
+    int c;
+    if (stepsA > stepsB) { // A is one step further
+        c = ptp_bmca_compare_port_identity(pA->receiverClockIdentity, pA->receiverPortNumber, pA->senderClockIdentity, pA->senderPortNumber);
+        return (c < 0) ? PTP_BMCA_B_BETTER : ((c > 0) ? PTP_BMCA_B_BETTER_BY_TOPOLOGY : PTP_BMCA_ERROR_1);
+    } else if (stepsA < stepsB) { // B is one step further
+        c = ptp_bmca_compare_port_identity(pB->receiverClockIdentity, pB->receiverPortNumber, pB->senderClockIdentity, pB->senderPortNumber);
+        return (c < 0) ? PTP_BMCA_A_BETTER : ((c > 0) ? PTP_BMCA_A_BETTER_BY_TOPOLOGY : PTP_BMCA_ERROR_1);
+    }
+
+    // equal number of steps: the senders decide, then the receiving ports
+    c = ptp_bmca_compare_port_identity(pA->senderClockIdentity, pA->senderPortNumber, pB->senderClockIdentity, pB->senderPortNumber);
+    if (c == 0) {
+        c = (pA->receiverPortNumber < pB->receiverPortNumber) ? -1 : ((pA->receiverPortNumber > pB->receiverPortNumber) ? 1 : 0);
+    }
+    return (c < 0) ? PTP_BMCA_A_BETTER_BY_TOPOLOGY : ((c > 0) ? PTP_BMCA_B_BETTER_BY_TOPOLOGY : PTP_BMCA_ERROR_2);
+}
+
 int ptp_select_better_master(PtpMasterProperties *pMP1, PtpMasterProperties *pMP2) {
-    COMPARE_AND_RETURN(pMP1, pMP2, priority1);
-    COMPARE_AND_RETURN(pMP1, pMP2, grandmasterClockClass);
-    COMPARE_AND_RETURN(pMP1, pMP2, grandmasterClockAccuracy);
-    COMPARE_AND_RETURN(pMP1, pMP2, grandmasterClockVariance);
-    COMPARE_AND_RETURN(pMP1, pMP2, priority2);
-    COMPARE_AND_RETURN(pMP1, pMP2, grandmasterClockIdentity);
-    return 1;
+    // no topology information is available, the properties are considered to be received directly from the grandmasters
+    PtpBmcaDataset a = {pMP1, pMP1->grandmasterClockIdentity, PTP_PORT_ID, S.hwoptions.clockIdentity, PTP_PORT_ID};
+    PtpBmcaDataset b = {pMP2, pMP2->grandmasterClockIdentity, PTP_PORT_ID, S.hwoptions.clockIdentity, PTP_PORT_ID};
+    PtpBmcaCompResult r = ptp_bmca_compare_datasets(&a, &b);
+    return ((r == PTP_BMCA_A_BETTER) || (r == PTP_BMCA_A_BETTER_BY_TOPOLOGY)) ? 0 : 1;
+}
+
+// fill the data set of a foreign master
+static void ptp_bmca_fm_dataset(PtpBmcaDataset *pDS, const PtpForeignMaster *pFM) {
+    pDS->pAnn = &pFM->announce;
+    pDS->senderClockIdentity = pFM->clockIdentity;
+    pDS->senderPortNumber = pFM->portNumber;
+    pDS->receiverClockIdentity = S.hwoptions.clockIdentity;
+    pDS->receiverPortNumber = PTP_PORT_ID;
+}
+
+// fill the data set of a received Announce
+static void ptp_bmca_announce_dataset(PtpBmcaDataset *pDS, const PtpAnnounceBody *pAnn, const PtpHeader *pHeader) {
+    pDS->pAnn = pAnn;
+    pDS->senderClockIdentity = pHeader->clockIdentity;
+    pDS->senderPortNumber = pHeader->sourcePortID;
+    pDS->receiverClockIdentity = S.hwoptions.clockIdentity;
+    pDS->receiverPortNumber = PTP_PORT_ID;
+}
+
+// fill the data set of the current master (it's us, if the master properties are our capabilities)
+static void ptp_bmca_current_dataset(PtpBmcaDataset *pDS) {
+    bool us = S.bmca.masterProps.grandmasterClockIdentity == S.hwoptions.clockIdentity;
+    pDS->pAnn = &S.bmca.masterProps;
+    pDS->senderClockIdentity = us ? S.hwoptions.clockIdentity : S.bmca.masterPortClockIdentity;
+    pDS->senderPortNumber = us ? PTP_PORT_ID : S.bmca.masterPortNumber;
+    pDS->receiverClockIdentity = S.hwoptions.clockIdentity;
+    pDS->receiverPortNumber = PTP_PORT_ID;
+}
+
+// fill the default data set of this clock
+static void ptp_bmca_default_dataset(PtpBmcaDataset *pDS) {
+    pDS->pAnn = &S.capabilities;
+    pDS->senderClockIdentity = S.hwoptions.clockIdentity;
+    pDS->senderPortNumber = PTP_PORT_ID;
+    pDS->receiverClockIdentity = S.hwoptions.clockIdentity;
+    pDS->receiverPortNumber = PTP_PORT_ID;
+}
+
+// is data set A better than B (either by properties or by topology)?
+static bool ptp_bmca_is_better(const PtpBmcaDataset *pA, const PtpBmcaDataset *pB) {
+    PtpBmcaCompResult r = ptp_bmca_compare_datasets(pA, pB);
+    return (r == PTP_BMCA_A_BETTER) || (r == PTP_BMCA_A_BETTER_BY_TOPOLOGY);
+}
+
+// is foreign master A better than B?
+static bool ptp_fm_is_better(const PtpForeignMaster *pA, const PtpForeignMaster *pB) {
+    PtpBmcaDataset a, b;
+    ptp_bmca_fm_dataset(&a, pA);
+    ptp_bmca_fm_dataset(&b, pB);
+    return ptp_bmca_is_better(&a, &b);
 }
 
 static char *BMCA_HINTS[] = {
@@ -69,6 +170,157 @@ static void ptp_bmca_handle_state_change(PtpBmcaFsmState state) {
     }
 }
 
+// ------------
+
+// length of the qualification window of a foreign master in ticks, computed in microseconds and rounded up,
+// but never shorter than PTP_FOREIGN_MASTER_THRESHOLD ticks, as short Announce periods collapse into a few ticks
+static uint32_t ptp_fm_window_ticks(const PtpForeignMaster *pFM) {
+    uint32_t tick_us = PTP_HEARTBEAT_TICKRATE_MS * 1000;
+    uint32_t window = (PTP_FOREIGN_MASTER_TIME_WINDOW * ptp_logi2us(pFM->logAnnPeriod) + tick_us - 1) / tick_us;
+    return MAX(window, PTP_FOREIGN_MASTER_THRESHOLD);
+}
+
+// a foreign master is qualified if the last PTP_FOREIGN_MASTER_THRESHOLD Announces all fall into the window
+static bool ptp_fm_is_qualified(const PtpForeignMaster *pFM) {
+    if (pFM->annCnt < PTP_FOREIGN_MASTER_THRESHOLD) {
+        return false;
+    }
+
+    uint32_t oldest = pFM->annTicks[pFM->annIdx]; // the ring is full, the next write position holds the oldest entry
+    return (S.ticks - oldest) <= ptp_fm_window_ticks(pFM);
+}
+
+// find the best qualified foreign master by scanning the whole dataset
+static void ptp_fm_select_best() {
+    PtpForeignMaster *fms = S.bmca.foreignMasters;
+    int8_t best = -1;
+    for (int8_t i = 0; i < PTP_FOREIGN_MASTER_TABLE_SIZE; i++) {
+        if (!fms[i].valid || !fms[i].qualified) {
+            continue;
+        }
+        if ((best < 0) || ptp_fm_is_better(&fms[i], &fms[best])) {
+            best = i;
+        }
+    }
+    S.bmca.bestForeignMaster = best;
+}
+
+// store an Announce in the foreign master dataset and update the best master incrementally,
+// NULL is returned if the dataset is full of better foreign masters
+static PtpForeignMaster *ptp_fm_record(const PtpAnnounceBody *pAnn, const PtpHeader *pHeader, const PtpNetAddr *pSrcAddr) {
+    PtpForeignMaster *fms = S.bmca.foreignMasters;
+
+    // look up the sender, remember the first free and the worst entries
+    int8_t idx = -1, freeIdx = -1, worst = -1;
+    for (int8_t i = 0; i < PTP_FOREIGN_MASTER_TABLE_SIZE; i++) {
+        if (!fms[i].valid) {
+            if (freeIdx < 0) {
+                freeIdx = i;
+            }
+        } else if ((fms[i].clockIdentity == pHeader->clockIdentity) && (fms[i].portNumber == pHeader->sourcePortID)) {
+            idx = i;
+            break;
+        } else if ((worst < 0) || ptp_fm_is_better(&fms[worst], &fms[i])) {
+            worst = i;
+        }
+    }
+
+    // new sender: take a free entry or replace the worst one if the sender is better,
+    // so that the best candidates can qualify even if more masters are present than entries
+    if (idx < 0) {
+        if (freeIdx >= 0) {
+            idx = freeIdx;
+        } else {
+            PtpBmcaDataset annDS, worstDS;
+            ptp_bmca_announce_dataset(&annDS, pAnn, pHeader);
+            ptp_bmca_fm_dataset(&worstDS, &fms[worst]);
+            if (!ptp_bmca_is_better(&annDS, &worstDS)) {
+                return NULL;
+            }
+            idx = worst;
+        }
+
+        PtpForeignMaster *pFM = &fms[idx];
+        memset(pFM, 0, sizeof(PtpForeignMaster));
+        pFM->valid = true;
+        pFM->clockIdentity = pHeader->clockIdentity;
+        pFM->portNumber = pHeader->sourcePortID;
+        if (idx == S.bmca.bestForeignMaster) {
+            ptp_fm_select_best();
+        }
+    }
+
+    // refresh the record
+    PtpForeignMaster *pFM = &fms[idx];
+    pFM->announce = *pAnn;
+    pFM->logAnnPeriod = MIN(MAX(pHeader->logMessagePeriod, PTP_LOGPER_MIN), PTP_LOGPER_MAX);
+    if (pSrcAddr->valid) {
+        pFM->addr = *pSrcAddr;
+    }
+    pFM->annTicks[pFM->annIdx] = S.ticks;
+    pFM->annIdx = (pFM->annIdx + 1) % PTP_FOREIGN_MASTER_THRESHOLD;
+    pFM->annCnt = MIN(pFM->annCnt + 1, PTP_FOREIGN_MASTER_THRESHOLD);
+    pFM->annTotal++;
+    pFM->lastSeen = S.ticks;
+    pFM->qualified = ptp_fm_is_qualified(pFM);
+
+    // only the refreshed entry has to be compared to the best one, unless the best one itself has changed
+    int8_t best = S.bmca.bestForeignMaster;
+    if (idx == best) {
+        ptp_fm_select_best();
+    } else if (pFM->qualified && ((best < 0) || ptp_fm_is_better(pFM, &fms[best]))) {
+        S.bmca.bestForeignMaster = idx;
+    }
+
+    return pFM;
+}
+
+// expire silent foreign masters and update the qualifications
+static void ptp_fm_tick() {
+    PtpForeignMaster *fms = S.bmca.foreignMasters;
+    bool changed = false;
+    for (int8_t i = 0; i < PTP_FOREIGN_MASTER_TABLE_SIZE; i++) {
+        PtpForeignMaster *pFM = &fms[i];
+        if (!pFM->valid) {
+            continue;
+        }
+
+        if ((S.ticks - pFM->lastSeen) > ptp_fm_window_ticks(pFM)) { // nothing has been heard of the foreign master within the window
+            pFM->valid = false;
+            changed = true;
+        } else {
+            bool qualified = ptp_fm_is_qualified(pFM);
+            changed |= (qualified != pFM->qualified);
+            pFM->qualified = qualified;
+        }
+    }
+
+    if (changed) {
+        ptp_fm_select_best();
+    }
+}
+
+// remove a foreign master by its port identity, other paths to the same grandmaster are kept
+static void ptp_fm_remove_port(uint64_t clockIdentity, uint16_t portNumber) {
+    PtpForeignMaster *fms = S.bmca.foreignMasters;
+    for (int8_t i = 0; i < PTP_FOREIGN_MASTER_TABLE_SIZE; i++) {
+        if (fms[i].valid && (fms[i].clockIdentity == clockIdentity) && (fms[i].portNumber == portNumber)) {
+            fms[i].valid = false;
+        }
+    }
+    ptp_fm_select_best();
+}
+
+// make a foreign master the current master
+static void ptp_bmca_follow(const PtpForeignMaster *pFM) {
+    S.bmca.masterProps = pFM->announce;
+    S.bmca.masterTOCntr = 0;
+    S.bmca.masterAnnPer_ms = ptp_logi2ms(pFM->logAnnPeriod);
+    S.bmca.masterAddr = pFM->addr;
+    S.bmca.masterPortClockIdentity = pFM->clockIdentity;
+    S.bmca.masterPortNumber = pFM->portNumber;
+}
+
 void ptp_bmca_tick() {
     PtpBmcaFsmState state = S.bmca.state;
     uint32_t sd = S.bmca.stateDuration;
@@ -107,18 +359,39 @@ void ptp_bmca_tick() {
     } break;
     case PTP_BMCA_SLAVE: {
         if (S.bmca.masterTOCntr++ > (PTP_ANNOUNCE_RECEIPT_TIMEOUT * S.bmca.masterAnnPer_ms / PTP_HEARTBEAT_TICKRATE_MS)) { // if a master dropout is detected
-            if (master_mode_enabled) {
-                S.bmca.masterProps = S.capabilities; // let's assume we are the best MASTER for this time
+            ptp_fm_remove_port(S.bmca.masterPortClockIdentity, S.bmca.masterPortNumber); // the lost master port is no longer a candidate
+
+            // fail over to the next best qualified foreign master at once if it beats us
+            int8_t best = S.bmca.bestForeignMaster;
+            PtpForeignMaster *pFM = (best >= 0) ? &S.bmca.foreignMasters[best] : NULL;
+            PtpBmcaDataset fmDS, ourDS;
+            if (pFM != NULL) {
+                ptp_bmca_fm_dataset(&fmDS, pFM);
+                ptp_bmca_default_dataset(&ourDS);
+            }
+            if ((pFM != NULL) && (!master_mode_enabled || ptp_bmca_is_better(&fmDS, &ourDS))) {
+                CLILOG(S.logging.bmca, "Master lost, failing over to the next best foreign master\n");
+                ptp_bmca_follow(pFM);
+                state = PTP_BMCA_UNCALIBRATED;
             } else {
-                memset(&S.bmca.masterProps, 0xFF, sizeof(PtpMasterProperties)); // fill the master properties with the worst values regarding the comparison
+                if (master_mode_enabled) {
+                    S.bmca.masterProps = S.capabilities; // let's assume we are the best MASTER for this time
+                } else {
+                    memset(&S.bmca.masterProps, 0xFF, sizeof(PtpMasterProperties)); // fill the master properties with the worst values regarding the comparison
+                }
+                S.bmca.masterAddr.valid = false;    // forget the address of the lost master
+                S.bmca.masterPortClockIdentity = 0; // ...and its port identity
+                state = PTP_BMCA_LISTENING;
             }
-            state = PTP_BMCA_LISTENING;
         }
     } break;
     default:
         break;
     }
 
+    // expire silent foreign masters
+    ptp_fm_tick();
+
     // increase state duration
     S.bmca.stateDuration++;
 
@@ -132,33 +405,47 @@ void ptp_bmca_tick() {
  * @param pAnn pointer to PtpAnnounceBody object
  * @param pHeader pointer to Announce message header
  */
-void ptp_handle_announce_msg(PtpAnnounceBody *pAnn, PtpHeader *pHeader) {
+void ptp_handle_announce_msg(PtpAnnounceBody *pAnn, PtpHeader *pHeader, const PtpNetAddr *pSrcAddr) {
     PtpBmcaState *s = &(S.bmca);
-    bool masterChanged = false;
     PtpBmcaFsmState state = s->state;
     bool master_mode_enabled = PTP_ENABLE_MASTER_OPERATION && (!(S.profile.flags & PTP_PF_SLAVE_ONLY));
 
+    // disregard our own Announces and the ones that have passed through too many boundary clocks
+    if ((pHeader->clockIdentity == S.hwoptions.clockIdentity) || (pAnn->localStepsRemoved >= 255)) {
+        return;
+    }
+
+    // record the Announce in the foreign master dataset
+    PtpForeignMaster *pFM = ptp_fm_record(pAnn, pHeader, pSrcAddr);
+    bool qualified = (pFM != NULL) && pFM->qualified;
+
+    // data sets of the sender and the current master
+    PtpBmcaDataset annDS, curDS;
+    ptp_bmca_announce_dataset(&annDS, pAnn, pHeader);
+    ptp_bmca_current_dataset(&curDS);
+
+    // only qualified foreign masters may take over
     switch (state) {
     case PTP_BMCA_LISTENING:
+        if (!qualified) {
+            break;
+        }
         if (master_mode_enabled) {                                        // if master operation is enabled...
-            if (ptp_select_better_master(pAnn, &(s->masterProps)) == 0) { // compare the new master to the best one we've discovered so far
-                s->masterProps = *pAnn;                                   // store remote master's capabilities if it's better then the former one
-                masterChanged = true;                                     // signal that master has changed
+            if (ptp_bmca_is_better(&annDS, &curDS)) { // compare the new master to the best one we've discovered so far
+                ptp_bmca_follow(pFM);                  // store remote master's capabilities if it's better then the former one
             }
-        } else {                           // slave only operation
-            s->masterProps = *pAnn;        // retain remote master capabilities
-            state = PTP_BMCA_UNCALIBRATED; // change to uncalibrated state
-            masterChanged = true;          // ...
+        } else {                                                       // slave only operation
+            ptp_bmca_follow(&s->foreignMasters[s->bestForeignMaster]); // retain the best remote master's capabilities
+            state = PTP_BMCA_UNCALIBRATED;                             // change to uncalibrated state
         }
         break;
     case PTP_BMCA_PRE_MASTER:
     case PTP_BMCA_MASTER:
     case PTP_BMCA_SLAVE: {
         // if a better master is found, then switch over
-        if (ptp_select_better_master(pAnn, &(s->masterProps)) == 0) {
-            s->masterProps = *pAnn;
+        if (qualified && ptp_bmca_is_better(&annDS, &curDS)) {
+            ptp_bmca_follow(pFM);
             state = PTP_BMCA_UNCALIBRATED;
-            masterChanged = true;
         }
 
         // update UTC offset if necessary
@@ -170,18 +457,17 @@ void ptp_handle_announce_msg(PtpAnnounceBody *pAnn, PtpHeader *pHeader) {
         break;
     }
 
-    // if master has changed, then calculate Announce period
-    if (masterChanged) {
-        S.bmca.masterTOCntr = 0;
-        s->masterAnnPer_ms = ptp_logi2ms(pHeader->logMessagePeriod);
-    }
-
     // clear Master timeout if relevant Announce has arrived
     if (pAnn->grandmasterClockIdentity == s->masterProps.grandmasterClockIdentity) {
-        if (s->masterProps.currentUTCOffset != pAnn->currentUTCOffset) { // update current UTC offset
+        if ((pHeader->clockIdentity == s->masterPortClockIdentity) && (pHeader->sourcePortID == s->masterPortNumber)) { // refresh the data set of the current master
+            s->masterProps = *pAnn;
+        } else if (s->masterProps.currentUTCOffset != pAnn->currentUTCOffset) { // update current UTC offset
             s->masterProps.currentUTCOffset = pAnn->currentUTCOffset;
         }
         S.bmca.masterTOCntr = 0;
+        if (pSrcAddr->valid) { // track the address of the master
+            s->masterAddr = *pSrcAddr;
+        }
     }
 
     // handle possible state change
@@ -209,4 +495,37 @@ void ptp_bmca_destroy() {
 void ptp_bmca_reset() {
     memset(&S.bmca, 0, sizeof(PtpBmcaState)); // SBMC state
     S.bmca.state = PTP_BMCA_INITIALIZING;
-}
\ No newline at end of file
+    S.bmca.bestForeignMaster = -1;
+}
+
+const PtpForeignMaster *ptp_bmca_get_foreign_masters() {
+    return S.bmca.foreignMasters;
+}
+
+int8_t ptp_bmca_get_best_foreign_master() {
+    return S.bmca.bestForeignMaster;
+}
+
+const PtpForeignMaster *ptp_bmca_get_standby_master() {
+    const PtpForeignMaster *fms = S.bmca.foreignMasters;
+    const PtpForeignMaster *pStandby = NULL;
+    for (uint8_t i = 0; i < PTP_FOREIGN_MASTER_TABLE_SIZE; i++) {
+        const PtpForeignMaster *pFM = &fms[i];
+        if (!pFM->valid || !pFM->qualified) {
+            continue;
+        }
+
+        // skip the current master (identified by its grandmaster if its port is unknown)
+        bool current = (S.bmca.masterPortClockIdentity != 0)
+                           ? ((pFM->clockIdentity == S.bmca.masterPortClockIdentity) && (pFM->portNumber == S.bmca.masterPortNumber))
+                           : (pFM->announce.grandmasterClockIdentity == S.bmca.masterProps.grandmasterClockIdentity);
+        if (current) {
+            continue;
+        }
+
+        if ((pStandby == NULL) || ptp_fm_is_better(pFM, pStandby)) {
+            pStandby = pFM;
+        }
+    }
+    return pStandby;
+}
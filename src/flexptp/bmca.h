@@ -16,7 +16,20 @@ extern "C" {
 #endif
 
 /**
- * Select better master. (Not "best", with intent!)
+ * Compare two data sets according to the data set comparison algorithm of IEEE 1588 (part A and part B).
+ * Different grandmasters are compared by their properties, while paths to the same grandmaster
+ * are compared by the steps removed and the identities of the sending and receiving ports.
+ *
+ * @param pA pointer to data set A
+ * @param pB pointer to data set B
+ *
+ * @return result of the comparison
+ */
+PtpBmcaCompResult ptp_bmca_compare_datasets(const PtpBmcaDataset *pA, const PtpBmcaDataset *pB);
+
+/**
+ * Select better master. (Not "best", with intent!) No topology information is considered
+ * beyond the steps removed, use ptp_bmca_compare_datasets() if the sending ports are known.
  * 
  * @param pMP1: pointer to the first master's PtpMasterProperites object
  * @param pMP2: pointer to the second master's PtpMasterProperites object
@@ -30,8 +43,9 @@ int ptp_select_better_master(PtpMasterProperties * pMP1, PtpMasterProperties * p
  *
  * @param pAnn pointer to PtpAnnounceBody object
  * @param pHeader pointer to Announce message header
+ * @param pSrcAddr source address of the Announce message (validity flag might be cleared if unknown)
  */
-void ptp_handle_announce_msg(PtpAnnounceBody *pAnn, PtpHeader *pHeader);
+void ptp_handle_announce_msg(PtpAnnounceBody *pAnn, PtpHeader *pHeader, const PtpNetAddr *pSrcAddr);
 
 /**
  * Initialize SBMC module.
@@ -53,6 +67,27 @@ void ptp_bmca_reset();
  */
 void ptp_bmca_tick();
 
+/**
+ * Get the foreign master dataset.
+ *
+ * @return pointer to the first of the PTP_FOREIGN_MASTER_TABLE_SIZE foreign master records
+ */
+const PtpForeignMaster *ptp_bmca_get_foreign_masters();
+
+/**
+ * Get the index of the best qualified foreign master.
+ *
+ * @return index into the foreign master dataset, -1 if no qualified foreign master is present
+ */
+int8_t ptp_bmca_get_best_foreign_master();
+
+/**
+ * Get the standby master: the best qualified foreign master apart from the port of the current master.
+ *
+ * @return pointer to the foreign master record of the standby, NULL if no standby is present
+ */
+const PtpForeignMaster *ptp_bmca_get_standby_master();
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,14 +3,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 
+#include "bmca.h"
 #include "clock_utils.h"
+#include "holdover.h"
 #include "logging.h"
+#include "master.h"
 #include "profiles.h"
 #include "ptp_core.h"
 #include "ptp_profile_presets.h"
 #include "ptp_types.h"
+#include "servo_registry.h"
+#include "session.h"
 #include "settings_interface.h"
+#include "slave.h"
+#include "stats.h"
+#include "task_ptp.h"
+#include "unicast.h"
 
 #include "minmax.h"
 
@@ -39,6 +49,42 @@ static CMD_FUNCTION(CB_offset) {
     return 0;
 }
 
+static CMD_FUNCTION(CB_asymmetry) {
+    if (argc > 0) {
+        ptp_set_delay_asymmetry(atoi(ppArgs[0]));
+    }
+
+    MSG("> PTP delay asymmetry: %d ns\n", ptp_get_delay_asymmetry());
+    return 0;
+}
+
+static CMD_FUNCTION(CB_latency) {
+    static const char *lsNames[PTP_LS_N] = {"10M", "100M", "1G"};
+
+    if (argc > 0) {
+        PtpLinkSpeed ls;
+        for (ls = 0; ls < PTP_LS_N; ls++) {
+            if (!strcmp(ppArgs[0], lsNames[ls])) {
+                break;
+            }
+        }
+
+        if ((ls == PTP_LS_N) || (argc < 3)) {
+            return -1;
+        }
+
+        ptp_set_port_latency(ls, atoi(ppArgs[1]), atoi(ppArgs[2]));
+    }
+
+    PtpLinkSpeed cls = ptp_get_link_speed();
+    for (PtpLinkSpeed ls = 0; ls < PTP_LS_N; ls++) {
+        int32_t ingress = 0, egress = 0;
+        ptp_get_port_latency(ls, &ingress, &egress);
+        MSG("%c%4s: ingress: %d ns, egress: %d ns\n", (ls == cls) ? '*' : ' ', lsNames[ls], ingress, egress);
+    }
+    return 0;
+}
+
 static CMD_FUNCTION(CB_log) {
     bool logEn = false;
 
@@ -114,6 +160,9 @@ static CMD_FUNCTION(CB_ptpinfo) {
     MSG("\nMaster clock ID: ");
     ptp_print_clock_identity(ptp_get_current_master_clock_identity());
     MSG("\n");
+#ifdef FLEXPTP_LINUX
+    MSG("PTP task CPU usage: %u us/s\n", ptp_get_task_cpu_usage());
+#endif
     return 0;
 }
 
@@ -327,10 +376,432 @@ static CMD_FUNCTION(CB_priority) {
     return 0;
 }
 
+static CMD_FUNCTION(CB_fastComp) {
+    if (argc >= 3) {
+        ptp_set_fast_comp_cycles(atoi(ppArgs[0]), atoi(ppArgs[1]), atoi(ppArgs[2]));
+    }
+    if (argc >= 4) {
+        ptp_set_fast_comp_skew_ci_limit(atof(ppArgs[3]));
+    }
+
+    const PtpFastCompParams *fcp = ptp_get_fast_comp_params();
+    MSG("Fast compensation: max. skew samples: %u, time corr. cycles: %u, propagation cycles: %u, skew CI limit: %.3f ppb\n",
+        fcp->skewMaxSamples, fcp->timeCorrCycles, fcp->propCycles, fcp->skewCiLimit_ppb);
+    MSG("Last time to lock: %u ms\n", ptp_get_stats()->timeToLock_ms);
+    return 0;
+}
+
+static CMD_FUNCTION(CB_adaptiveDelayReq) {
+    if (argc > 0) {
+        int en = ONOFF(ppArgs[0]);
+        if (en < 0) {
+            return -1;
+        }
+        ptp_enable_adaptive_delay_req(en);
+    }
+    if (argc > 1) {
+        ptp_set_adaptive_delay_req_max_backoff(atoi(ppArgs[1]));
+    }
+
+    MSG("Adaptive (P)Delay_Req rate: %s, max. backoff: %u\n", ptp_is_adaptive_delay_req_enabled() ? "on" : "off", ptp_get_adaptive_delay_req_max_backoff());
+    int8_t lp = ptp_get_current_delay_req_log_period();
+    if (lp != PTP_LOGPER_SYNCMATCHED) {
+        MSG("Current (P)Delay_Req log. period: %d\n", lp);
+    }
+    return 0;
+}
+
+static CMD_FUNCTION(CB_holdover) {
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "clear")) {
+            ptp_holdover_clear();
+        } else if (!strcmp(ppArgs[0], "aging") && (argc > 1)) {
+            int en = ONOFF(ppArgs[1]);
+            if (en < 0) {
+                return -1;
+            }
+            ptp_holdover_enable_aging(en);
+        } else {
+            return -1;
+        }
+    }
+
+    const PtpHoldoverState *h = ptp_holdover_get_state();
+    const PtpStats *st = ptp_get_stats();
+    MSG("Holdover: %s, frequency memory: %s (%u samples)\n", h->active ? "ACTIVE" : "inactive", ptp_holdover_is_valid() ? "valid" : "invalid", h->samples);
+    MSG("Frequency: %.3f ppb (+-%.3f ppb), aging: %.3e ppb/s, aging compensation: %s\n", h->freq_ppb, sqrt(h->freqVar), h->aging_ppbps, h->agingEn ? "on" : "off");
+    if (h->active) {
+        MSG("Duration: %u s, estimated time error: %.0f ns\n", st->holdoverDuration_s, st->holdoverTimeErrEst);
+    }
+    if (h->warmStart != PTP_WS_NONE) {
+        MSG("Warm start: %s\n", (h->warmStart == PTP_WS_PENDING) ? "restored, waiting for the master's time" : "accepted");
+    }
+    return 0;
+}
+
+static CMD_FUNCTION(CB_stability) {
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "clear")) {
+            ptp_clear_stability();
+        } else {
+            return -1;
+        }
+    }
+
+    PtpStabilityPoint p;
+    if (!ptp_get_stability(0, &p)) {
+        MSG("No stability data, the clock has not been locked yet.\n");
+        return 0;
+    }
+
+    MSG("     tau [s] |     n |      ADEV |  TDEV [ns] |  MTIE [ns]\n");
+    for (uint8_t i = 0; ptp_get_stability(i, &p); i++) {
+        MSG("%12.4f | %5u | %9.3e | %10.2f | %10.1f\n", p.tau_s, p.n, p.adev, p.tdev_ns, p.mtie_ns);
+    }
+    return 0;
+}
+
+static void ptp_print_hist_window(const char *name, const PtpHistWindow *pW) {
+    MSG("  %-14s | %9u | %10.2f | %10.2f | %10.2f | %10.2f\n", name, pW->count, pW->p[0], pW->p[1], pW->p[2], pW->max);
+}
+
+static CMD_FUNCTION(CB_histograms) {
+    static const char *names[PTP_HQ_N] = {"te", "mpd", "corr"};
+    static const char *titles[PTP_HQ_N] = {"Time error [ns]", "Mean path delay [ns]", "Servo correction [ppb]"};
+    static uint8_t buf[PTP_HIST_EXPORT_MAX_SIZE];
+
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "clear")) {
+            ptp_clear_histograms();
+        } else if (!strcmp(ppArgs[0], "export") && (argc > 1)) {
+            for (uint8_t q = 0; q < PTP_HQ_N; q++) {
+                if (!strcmp(ppArgs[1], names[q])) {
+                    uint32_t len = ptp_export_histogram(q, buf, sizeof(buf));
+                    for (uint32_t i = 0; i < len; i++) {
+                        MSG("%02X%s", buf[i], (((i + 1) % 32) == 0) ? "\n" : "");
+                    }
+                    MSG("\n");
+                    return 0;
+                }
+            }
+            return -1;
+        } else {
+            return -1;
+        }
+    }
+
+    for (uint8_t q = 0; q < PTP_HQ_N; q++) {
+        const PtpDistribution *d = ptp_get_distribution(q);
+        PtpHistWindow all = {d->hist.count,
+                             {ptp_get_hist_percentile(q, 0.5), ptp_get_hist_percentile(q, 0.99), ptp_get_hist_percentile(q, 0.999)},
+                             d->hist.max};
+
+        MSG("%s:\n                 |   samples |        p50 |        p99 |      p99.9 |        max\n", titles[q]);
+        ptp_print_hist_window("histogram", &all);
+        ptp_print_hist_window("last window", &d->last);
+        ptp_print_hist_window("current window", &d->window);
+    }
+    return 0;
+}
+
+static CMD_FUNCTION(CB_syncMode) {
+    bool oneStep = ptp_is_one_step_sync_enabled();
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "onestep")) {
+            oneStep = true;
+        } else if (!strcmp(ppArgs[0], "twostep")) {
+            oneStep = false;
+        } else {
+            return -1;
+        }
+        ptp_enable_one_step_sync(oneStep); // takes effect in the PTP task
+    }
+
+#ifdef PTP_HW_ONE_STEP_SYNC
+    const char *insertion = "hardware";
+#else
+    const char *insertion = "software";
+#endif
+    if (oneStep) {
+        MSG("Sync mode: one-step (%s timestamp insertion)\n", insertion);
+    } else {
+        const PtpMasterSyncSlotState *ss = ptp_master_get_sync_slot_state();
+        MSG("Sync mode: two-step\n");
+        MSG("Outstanding Syncs: %u/%u (max. %u), skipped: %u, expired: %u\n", ss->outstanding, PTP_MASTER_SYNC_SLOTS, ss->maxOutstanding, ss->skipped, ss->expired);
+    }
+    return 0;
+}
+
+static CMD_FUNCTION(CB_peers) {
+    static const char *states[] = {"NONE", "CANDIDATE", "ESTABLISHED"};
+    const PtpP2PSlaveInfo *peers = ptp_master_get_p2p_peers();
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < PTP_MASTER_P2P_PEER_TABLE_SIZE; i++) {
+        const PtpP2PSlaveInfo *pi = &peers[i];
+        if (pi->state == PTP_P2PSS_NONE) {
+            continue;
+        }
+        ptp_print_clock_identity(pi->identity);
+        MSG(" port %u: %s, reports: %u", pi->portNumber, states[pi->state], pi->reportCount);
+        if (pi->linkDelayValid) {
+            MSG(", link delay: %" __PRI64_PREFIX "d ns", nsI(&pi->linkDelay));
+        }
+        MSG("\n");
+        n++;
+    }
+    MSG("%u/%u P2P peers, established peer present: %s\n", n, PTP_MASTER_P2P_PEER_TABLE_SIZE, ptp_master_p2p_peer_established() ? "yes" : "no");
+    return 0;
+}
+
+static CMD_FUNCTION(CB_foreign) {
+    const PtpForeignMaster *fms = ptp_bmca_get_foreign_masters();
+    int8_t best = ptp_bmca_get_best_foreign_master();
+    uint8_t n = 0;
+    for (int8_t i = 0; i < PTP_FOREIGN_MASTER_TABLE_SIZE; i++) {
+        const PtpForeignMaster *pFM = &fms[i];
+        if (!pFM->valid) {
+            continue;
+        }
+        MSG("%c ", (i == best) ? '*' : ' ');
+        ptp_print_clock_identity(pFM->clockIdentity);
+        MSG(" port %u: GM ", pFM->portNumber);
+        ptp_print_clock_identity(pFM->announce.grandmasterClockIdentity);
+        MSG(", P1: %u, class: %u, P2: %u, steps removed: %u, announces: %u, %s\n",
+            pFM->announce.priority1, pFM->announce.grandmasterClockClass, pFM->announce.priority2,
+            pFM->announce.localStepsRemoved, pFM->annTotal, pFM->qualified ? "qualified" : "unqualified");
+        n++;
+    }
+    MSG("%u/%u foreign masters\n", n, PTP_FOREIGN_MASTER_TABLE_SIZE);
+    return 0;
+}
+
+static CMD_FUNCTION(CB_standby) {
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "on")) {
+            ptp_enable_hot_standby(true);
+        } else if (!strcmp(ppArgs[0], "off")) {
+            ptp_enable_hot_standby(false);
+        } else {
+            return -1;
+        }
+    }
+
+    const PtpSlaveStandbyState *sb = ptp_slave_get_standby_state();
+    MSG("Hot-standby tracking: %s, failovers: %u\n", sb->enabled ? "on" : "off", sb->failovers);
+    if (sb->enabled && (sb->clockIdentity != 0)) {
+        MSG("Standby master: ");
+        ptp_print_clock_identity(sb->clockIdentity);
+        MSG(" port %u, Sync cycles: %u\n", sb->portNumber, sb->syncCycles);
+        if (sb->mpdValid) {
+            MSG("Mean path delay: %" __PRI64_PREFIX "d ns\n", nsI(&sb->meanPathDelay));
+        }
+        if (sb->offsetValid) {
+            MSG("Time error: %" __PRI64_PREFIX "d ns\n", nsI(&sb->offset));
+        }
+    }
+    return 0;
+}
+
+static CMD_FUNCTION(CB_servo) {
+    if (argc > 0) {
+        if (!ptp_set_servo(ppArgs[0])) {
+            MSG("Unknown servo '%s'!\n", ppArgs[0]);
+            return -1;
+        }
+
+        // set the parameters if passed
+        if (argc > 1) {
+            double params[PTP_SERVO_MAX_PARAMS];
+            uint8_t paramCnt = MIN(argc - 1, PTP_SERVO_MAX_PARAMS);
+            for (uint8_t i = 0; i < paramCnt; i++) {
+                params[i] = atof(ppArgs[1 + i]);
+            }
+            if (!ptp_set_servo_params(params, paramCnt)) {
+                MSG("Invalid parameters for servo '%s'!\n", ppArgs[0]);
+                return -1;
+            }
+        }
+    }
+
+    uint8_t activeId = ptp_servo_get_id();
+    for (uint8_t i = 0; i < ptp_servo_get_count(); i++) {
+        MSG("%c %s\n", (i == activeId) ? '*' : ' ', ptp_servo_get(i)->name);
+    }
+
+    const PtpServo *servo = ptp_servo_get(activeId);
+    if ((servo != NULL) && (servo->params != NULL)) {
+        servo->params(ptp_servo_get_instance());
+    }
+    return 0;
+}
+
+static void ptp_print_servo_eval_stats(const PtpServoEvalStats *pStats) {
+    double rms = (pStats->cycles > 0) ? sqrt(pStats->sumSqError / pStats->cycles) : 0.0;
+    MSG("cycles: %u, last tuning: %.3f ppb, last error: %.1f ns, RMS: %.1f ns, max.: %.1f ns\n",
+        pStats->cycles, pStats->lastTuning, pStats->lastError, rms, pStats->maxAbsError);
+}
+
+static CMD_FUNCTION(CB_servoShadow) {
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "add") && (argc > 1)) {
+            double params[PTP_SERVO_MAX_PARAMS];
+            uint8_t paramCnt = MIN(argc - 2, PTP_SERVO_MAX_PARAMS);
+            for (uint8_t i = 0; i < paramCnt; i++) {
+                params[i] = atof(ppArgs[2 + i]);
+            }
+            if (ptp_servo_shadow_add(ptp_servo_find(ppArgs[1]), params, paramCnt) < 0) {
+                MSG("Cannot evaluate '%s' in shadow!\n", ppArgs[1]);
+                return -1;
+            }
+        } else if (!strcmp(ppArgs[0], "del") && (argc > 1)) {
+            if (!ptp_servo_shadow_remove(atoi(ppArgs[1]))) {
+                return -1;
+            }
+        } else if (!strcmp(ppArgs[0], "clear")) {
+            ptp_servo_clear_stats();
+        } else {
+            return -1;
+        }
+    }
+
+    MSG("Active servo '%s': ", ptp_servo_get(ptp_servo_get_id())->name);
+    ptp_print_servo_eval_stats(ptp_servo_get_stats());
+
+    for (uint8_t i = 0; i < PTP_SERVO_SHADOW_SLOTS; i++) {
+        const PtpServoShadow *sh = ptp_servo_get_shadow(i);
+        if (!sh->used) {
+            continue;
+        }
+
+        const PtpServo *servo = ptp_servo_get(sh->servoId);
+        MSG("#%u '%s': ", i, servo->name);
+        ptp_print_servo_eval_stats(&sh->stats);
+        MSG("   simulated clock: % .1f ns, % .3f ppb\n", sh->clockOffset, sh->freqOffset);
+        if (servo->params != NULL) {
+            servo->params(ptp_servo_get_shadow_instance(i));
+        }
+    }
+    return 0;
+}
+
+static void ptp_print_unicast_grants(const PtpUnicastGrant *pGrants) {
+    static const char *names[PTP_UCM_N] = {"Announce", "Sync", "Delay_Resp"};
+    for (uint8_t i = 0; i < PTP_UCM_N; i++) {
+        if (pGrants[i].remTicks > 0) {
+            MSG(" %s(%d, %u s)", names[i], pGrants[i].logPeriod, pGrants[i].remTicks * PTP_HEARTBEAT_TICKRATE_MS / 1000);
+        }
+    }
+    MSG("\n");
+}
+
+static CMD_FUNCTION(CB_unicast) {
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "master") && (argc > 2)) {
+            PtpNetAddr addr;
+            if (!ptp_unicast_parse_address(ppArgs[2], &addr)) {
+                return -1;
+            }
+            if (!strcmp(ppArgs[1], "add")) {
+                if (!ptp_unicast_add_master(&addr)) {
+                    MSG("The unicast master table is full!\n");
+                }
+            } else if (!strcmp(ppArgs[1], "del")) {
+                if (!ptp_unicast_remove_master(&addr)) {
+                    MSG("Master not found!\n");
+                }
+            } else {
+                return -1;
+            }
+        } else if (!strcmp(ppArgs[0], "duration") && (argc > 1)) {
+            ptp_set_unicast_grant_duration(atoi(ppArgs[1]));
+        } else {
+            int en = ONOFF(ppArgs[0]);
+            if (en < 0) {
+                return -1;
+            }
+            ptp_enable_unicast_negotiation(en);
+        }
+    }
+
+    const PtpUnicastState *u = ptp_unicast_get_state();
+    MSG("Unicast negotiation: %s%s, grant duration: %u s\n", u->enabled ? "on" : "off", (u->enabled && !ptp_unicast_is_active()) ? " (inactive, requires E2E)" : "", u->grantDuration_s);
+
+    MSG("Masters:\n");
+    for (uint8_t i = 0; i < PTP_UNICAST_MASTER_TABLE_SIZE; i++) {
+        const PtpUnicastMasterEntry *m = &u->masters[i];
+        if (m->addr.valid) {
+            MSG("  ");
+            ptp_unicast_print_address(&m->addr);
+            ptp_print_unicast_grants(m->grants);
+        }
+    }
+
+    MSG("Grantees:\n");
+    for (uint16_t i = 0; i < PTP_UNICAST_GRANT_TABLE_SIZE; i++) {
+        const PtpUnicastGrantee *g = &u->grantees[i];
+        if (g->addr.valid) {
+            MSG("  ");
+            ptp_unicast_print_address(&g->addr);
+            MSG(" [");
+            ptp_print_clock_identity(g->clockIdentity);
+            MSG("/%u]", g->portNumber);
+            ptp_print_unicast_grants(g->grants);
+        }
+    }
+    return 0;
+}
+
+static CMD_FUNCTION(CB_sessions) {
+    bool list = false;
+    if (argc > 0) {
+        if (!strcmp(ppArgs[0], "list")) {
+            list = true;
+        } else if (!strcmp(ppArgs[0], "clear")) {
+            ptp_session_reset();
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+        } else if (!strcmp(ppArgs[0], "loadgen") && (argc > 1)) {
+            if (!strcmp(ppArgs[1], "off")) {
+                ptp_session_loadgen_stop();
+            } else if (argc > 2) {
+                ptp_session_loadgen_start(atoi(ppArgs[1]), atoi(ppArgs[2]));
+            } else {
+                return -1;
+            }
+#endif
+        } else {
+            return -1;
+        }
+    }
+
+    const PtpMasterSessionState *ss = ptp_session_get_state();
+    MSG("Sessions: %u/%u, pending Delay_Resps: %u (max. %u)\n", ss->active, PTP_MASTER_SESSION_TABLE_SIZE, ss->queueLevel, ss->maxQueueLevel);
+    MSG("Delay_Resps sent: %u (%u/s), coalesced: %u, dropped: %u, consumed (synthetic): %u\n", ss->delayRespSent, ss->respRate, ss->delayRespCoalesced, ss->delayRespDropped, ss->delayRespConsumed);
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+    PtpLoadGenResult lg;
+    ptp_session_loadgen_get_result(&lg);
+    MSG("Load generator: %s, %u Delay_Reqs in %u ms, %u responses served (%u/s), %u coalesced, %u dropped\n", ptp_session_loadgen_is_running() ? "running" : "stopped",
+        lg.offered, lg.duration_ms, lg.served, lg.respRate, lg.coalesced, lg.dropped);
+#endif
+
+    if (list) {
+        uint32_t now = ptp_get_tick();
+        for (uint16_t i = 0; i < PTP_MASTER_SESSION_TABLE_SIZE; i++) {
+            const PtpMasterSession *s = &ss->table[i];
+            if (s->used) {
+                ptp_print_clock_identity(s->clockIdentity);
+                MSG("/%u: %u Delay_Reqs, last seen %u ms ago\n", s->portNumber, s->delReqCnt, (now - s->lastSeen) * PTP_HEARTBEAT_TICKRATE_MS);
+            }
+        }
+    }
+    return 0;
+}
+
 // command assignments
 enum PTP_CMD_IDS {
     CMD_RESET,
     CMD_OFFSET,
+    CMD_ASYMMETRY,
+    CMD_LATENCY,
     CMD_LOG,
     CMD_TIME,
     CMD_MASTER,
@@ -346,6 +817,19 @@ enum PTP_CMD_IDS {
     CMD_LOGPERIOD,
     CMD_COARSE_THRESHOLD,
     CMD_PRIORITY,
+    CMD_HOLDOVER,
+    CMD_STABILITY,
+    CMD_HISTOGRAMS,
+    CMD_FAST_COMP,
+    CMD_ADAPTIVE_DELAY_REQ,
+    CMD_UNICAST,
+    CMD_SESSIONS,
+    CMD_SYNC_MODE,
+    CMD_PEERS,
+    CMD_FOREIGN,
+    CMD_STANDBY,
+    CMD_SERVO,
+    CMD_SERVO_SHADOW,
     CMD_N
 };
 
@@ -359,6 +843,8 @@ void ptp_register_cli_commands() {
 #ifdef CLI_REG_CMD
     sCmds[CMD_RESET] = CLI_REG_CMD("ptp reset \t\t\tReset PTP subsystem", 2, 0, CB_reset);
     sCmds[CMD_OFFSET] = CLI_REG_CMD("ptp servo offset [offset_ns] \t\t\tSet or query clock offset", 3, 0, CB_offset);
+    sCmds[CMD_ASYMMETRY] = CLI_REG_CMD("ptp asym [asym_ns] \t\t\tSet or query link delay asymmetry", 2, 0, CB_asymmetry);
+    sCmds[CMD_LATENCY] = CLI_REG_CMD("ptp latency [{10M|100M|1G} <ingress_ns> <egress_ns>] \t\t\tSet or query ingress/egress latencies", 2, 0, CB_latency);
     sCmds[CMD_LOG] = CLI_REG_CMD("ptp log {def|corr|ts|info|locked|bmca} {on|off} \t\t\tTurn on or off logging", 2, 2, CB_log);
     sCmds[CMD_TIME] = CLI_REG_CMD("time [ns] \t\t\tPrint time", 1, 0, CB_time);
     sCmds[CMD_MASTER] = CLI_REG_CMD("ptp master [[un]prefer] [clockid] \t\t\tMaster clock settings", 2, 0, CB_master);
@@ -378,6 +864,19 @@ void ptp_register_cli_commands() {
     sCmds[CMD_LOGPERIOD] = CLI_REG_CMD("ptp period <delreq|sync|ann> [<lp>|matched]\t\t\tPrint or set log. periods", 2, 0, CB_logPeriod);
     sCmds[CMD_COARSE_THRESHOLD] = CLI_REG_CMD("ptp coarse [threshold]\t\t\tPrint or set coarse correction threshold", 2, 0, CB_coarseThreshold);
     sCmds[CMD_PRIORITY] = CLI_REG_CMD("ptp priority [<p1> <p2>]\t\t\tPrint or set clock priority fields", 2, 0, CB_priority);
+    sCmds[CMD_HOLDOVER] = CLI_REG_CMD("ptp holdover [clear|aging {on|off}]\t\t\tPrint holdover state, clear frequency memory or toggle aging compensation", 2, 0, CB_holdover);
+    sCmds[CMD_STABILITY] = CLI_REG_CMD("ptp stability [clear]\t\t\tPrint or clear ADEV, TDEV and MTIE over octave-spaced observation intervals", 2, 0, CB_stability);
+    sCmds[CMD_HISTOGRAMS] = CLI_REG_CMD("ptp hist [clear|export {te|mpd|corr}]\t\t\tPrint percentiles of the time error, path delay and correction, clear or export the histograms", 2, 0, CB_histograms);
+    sCmds[CMD_FAST_COMP] = CLI_REG_CMD("ptp fc [<skew_samples> <time_cycles> <prop_cycles> [ci_limit_ppb]]\t\t\tPrint or set fast compensation parameters", 2, 0, CB_fastComp);
+    sCmds[CMD_ADAPTIVE_DELAY_REQ] = CLI_REG_CMD("ptp delreq adaptive [{on|off} [max_backoff]]\t\t\tPrint or set adaptive (P)Delay_Req rate", 3, 0, CB_adaptiveDelayReq);
+    sCmds[CMD_UNICAST] = CLI_REG_CMD("ptp unicast [{on|off}|master {add|del} <addr>|duration <s>]\t\t\tPrint or set unicast negotiation state and master table", 2, 0, CB_unicast);
+    sCmds[CMD_SESSIONS] = CLI_REG_CMD("ptp sessions [list|clear|loadgen {<slaves> <rate>|off}]\t\t\tPrint or clear master's slave sessions and Delay_Resp statistics", 2, 0, CB_sessions);
+    sCmds[CMD_SYNC_MODE] = CLI_REG_CMD("ptp sync [{onestep|twostep}]\t\t\tPrint or set Sync transmission mode, print Sync slot statistics", 2, 0, CB_syncMode);
+    sCmds[CMD_PEERS] = CLI_REG_CMD("ptp peers\t\t\tPrint the P2P peers responding to master's PDelay_Reqs", 2, 0, CB_peers);
+    sCmds[CMD_FOREIGN] = CLI_REG_CMD("ptp foreign\t\t\tPrint the foreign master dataset", 2, 0, CB_foreign);
+    sCmds[CMD_STANDBY] = CLI_REG_CMD("ptp standby [{on|off}]\t\t\tPrint or set hot-standby master tracking", 2, 0, CB_standby);
+    sCmds[CMD_SERVO] = CLI_REG_CMD("ptp servo select [<name> [params]]\t\t\tList the clock servos or select the active one and set its parameters", 3, 0, CB_servo);
+    sCmds[CMD_SERVO_SHADOW] = CLI_REG_CMD("ptp servo shadow [add <name> [params]|del <slot>|clear]\t\t\tPrint, add or remove servos evaluated in shadow, clear their statistics", 3, 0, CB_servoShadow);
     sCmds[CMD_N] = -1;
 #endif // CLI_REG_CMD
 }
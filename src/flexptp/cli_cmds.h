@@ -9,6 +9,8 @@
   ptp servo log internals {on|off}                   Enable or disable logging of servo internals
   ptp reset                                          Reset PTP subsystem
   ptp servo offset [offset_ns]                       Set or query clock offset
+  ptp asym [asym_ns]                                 Set or query link delay asymmetry
+  ptp latency [{10M|100M|1G} <ingress_ns> <egress_ns>]  Set or query ingress/egress latencies
   ptp log {def|corr|ts|info|locked|bmca} {on|off}    Turn on or off logging
   time [ns]                                          Print time
   ptp master [[un]prefer] [clockid]                  Master clock settings
@@ -25,6 +27,19 @@
   ptp period <delreq|sync|ann> [<lp>|matched]        Print or set log. periods
   ptp coarse [threshold]                             Print or set coarse correction threshold
   ptp priority [<p1> <p2>]                           Print or set clock priority fields
+  ptp holdover [clear|aging {on|off}]                Print holdover state, clear frequency memory or toggle aging compensation
+  ptp stability [clear]                              Print or clear ADEV, TDEV and MTIE over octave-spaced observation intervals
+  ptp hist [clear|export {te|mpd|corr}]              Print percentiles of the time error, path delay and correction, clear or export the histograms
+  ptp delreq adaptive [{on|off} [max_backoff]]       Print or set adaptive (P)Delay_Req rate
+  ptp fc [<skew_samples> <time_cycles> <prop_cycles> [ci_limit_ppb]]  Print or set fast compensation parameters
+  ptp unicast [{on|off}|master {add|del} <addr>|duration <s>]  Print or set unicast negotiation state and master table
+  ptp sessions [list|clear|loadgen {<slaves> <rate>|off}]  Print or clear master's slave sessions and Delay_Resp statistics
+  ptp sync [{onestep|twostep}]                       Print or set Sync transmission mode, print Sync slot statistics
+  ptp peers                                          Print the P2P peers responding to master's PDelay_Reqs
+  ptp foreign                                        Print the foreign master dataset
+  ptp standby [{on|off}]                             Print or set hot-standby master tracking
+  ptp servo select [<name>]                          List the clock servos or select the active one
+  ptp servo shadow [add <name> [params]|del <slot>|clear]  Print, add or remove servos evaluated in shadow, clear their statistics
   @endverbatim
   ******************************************************************************
   */
@@ -6,6 +6,7 @@
 
 #include "ptp_core.h"
 #include "task_ptp.h"
+#include "unicast.h"
 
 #include "msg_utils.h"
 #include "ptp_defs.h"
@@ -56,6 +57,14 @@ void ptp_send_delay_req_message() {
     delReqHeader.sequenceID = (S.bmca.state == PTP_BMCA_SLAVE) ? (++S.slave.messaging.delay_reqSequenceID) : (++S.master.pdelay_reqSequenceID);
     delReqHeader.domainNumber = S.profile.domainNumber;
 
+    // Delay_Reqs are sent to the master directly under unicast negotiation or in hybrid mode
+    bool hybrid = (S.profile.delayMechanism == PTP_DM_E2E) && (S.profile.flags & PTP_PF_HYBRID);
+    bool unicast = (S.bmca.state == PTP_BMCA_SLAVE) && (ptp_unicast_is_active() || hybrid) && S.bmca.masterAddr.valid;
+    delReqHeader.flags.PTP_UNICAST = unicast;
+    if (unicast) {
+        delReqMsg.addr = S.bmca.masterAddr;
+    }
+
     // fill in header
     ptp_construct_binary_header(delReqMsg.data, &delReqHeader);
 
@@ -166,4 +175,20 @@ void ptp_compute_mean_path_delay_p2p(const TimestampI *pTs, const uint64_t *pCf,
 
 void ptp_common_reset() {
     ptp_init_delay_req_header();
-}
\ No newline at end of file
+}
+
+uint32_t ptp_schedule_advance(uint32_t *pAcc_us, uint32_t period_us) {
+    if (period_us == 0) {
+        return 0;
+    }
+
+    *pAcc_us += PTP_HEARTBEAT_TICKRATE_MS * 1000;
+    uint32_t n = *pAcc_us / period_us;
+    *pAcc_us -= n * period_us;
+    return n;
+}
+
+void ptp_schedule_start(uint32_t *pAcc_us, uint32_t period_us) {
+    uint32_t tick_us = PTP_HEARTBEAT_TICKRATE_MS * 1000;
+    *pAcc_us = (period_us > tick_us) ? (period_us - tick_us) : 0;
+}
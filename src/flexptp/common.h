@@ -63,6 +63,24 @@ void ptp_compute_mean_path_delay_p2p(const TimestampI *pTs, const uint64_t *pCf,
  */
 void ptp_common_reset();
 
+/**
+ * Advance a transmission schedule by one heartbeat tick. Periods shorter than the heartbeat
+ * are served by issuing multiple messages in a single tick.
+ *
+ * @param pAcc_us pointer to the time accumulated towards the next transmission (microseconds)
+ * @param period_us transmission period in microseconds
+ * @return number of messages due in this tick
+ */
+uint32_t ptp_schedule_advance(uint32_t *pAcc_us, uint32_t period_us);
+
+/**
+ * Start a transmission schedule so that the first message becomes due in the next heartbeat tick.
+ *
+ * @param pAcc_us pointer to the time accumulated towards the next transmission (microseconds)
+ * @param period_us transmission period in microseconds
+ */
+void ptp_schedule_start(uint32_t *pAcc_us, uint32_t period_us);
+
 #ifdef __cplusplus
 }
 #endif
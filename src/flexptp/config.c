@@ -1,9 +1,13 @@
 #include "config.h"
 
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
+#include "holdover.h"
 #include "ptp_core.h"
+#include "servo_registry.h"
 
 ///\cond 0
 #define S (gPtpCoreState)
@@ -27,7 +31,127 @@
 
 // -----------
 
+/**
+ * @brief Configuration layout of releases before versioning (no header).
+ */
+typedef struct {
+    PtpProfile profile;           ///< PTP-profile
+    TimestampI offset;            ///< PPS signal offset
+    uint32_t logging;             ///< logging compressed into a single bitfield
+    uint8_t priority1, priority2; ///< Clock priority fields
+} PtpConfigLegacy;
+
+/**
+ * @brief Configuration layout version 1 (servo stored by its identifier).
+ */
+typedef struct {
+    uint16_t version;             ///< Layout version (1)
+    uint16_t size;                ///< Size of the configuration object in bytes
+    PtpProfile profile;           ///< PTP-profile
+    TimestampI offset;            ///< PPS signal offset
+    uint32_t logging;             ///< logging compressed into a single bitfield
+    uint8_t priority1, priority2; ///< Clock priority fields
+    TimestampI delayAsymmetry;    ///< Link delay asymmetry
+    PtpPortLatencies latencies;   ///< Ingress and egress latencies
+    uint8_t servo;                ///< Identifier of the selected clock servo
+    PtpWarmStart warmStart;       ///< Frequency memory for warm starting the clock
+} PtpConfigV1;
+
+/**
+ * @brief Configuration layout version 2 (no servo parameters).
+ */
+typedef struct {
+    uint16_t version;                         ///< Layout version (2)
+    uint16_t size;                            ///< Size of the configuration object in bytes
+    PtpProfile profile;                       ///< PTP-profile
+    TimestampI offset;                        ///< PPS signal offset
+    uint32_t logging;                         ///< logging compressed into a single bitfield
+    uint8_t priority1, priority2;             ///< Clock priority fields
+    TimestampI delayAsymmetry;                ///< Link delay asymmetry
+    PtpPortLatencies latencies;               ///< Ingress and egress latencies
+    char servo[PTP_CONFIG_SERVO_NAME_LENGTH]; ///< Name of the selected clock servo
+    PtpWarmStart warmStart;                   ///< Frequency memory for warm starting the clock
+} PtpConfigV2;
+
+/**
+ * Convert a configuration of the pre-versioning layout. Fields missing from
+ * the old layout are taken from the current state.
+ *
+ * @param pConfig pointer to the converted configuration
+ * @param pDump pointer to the dump
+ */
+static void ptp_convert_config_legacy(PtpConfig *pConfig, const void *pDump) {
+    PtpConfigLegacy legacy;
+    memcpy(&legacy, pDump, sizeof(PtpConfigLegacy));
+
+    ptp_store_config(pConfig);
+    memset(&pConfig->warmStart, 0, sizeof(PtpWarmStart)); // no frequency memory was stored
+    pConfig->servoParamCnt = 0;                           // the current servo keeps its parameters
+    pConfig->profile = legacy.profile;
+    pConfig->offset = legacy.offset;
+    pConfig->logging = legacy.logging;
+    pConfig->priority1 = legacy.priority1;
+    pConfig->priority2 = legacy.priority2;
+}
+
+/**
+ * Convert a configuration of layout version 1. The servo identifier is
+ * resolved in the running build, since the registry order is the same
+ * for builds including the same servos.
+ *
+ * @param pConfig pointer to the converted configuration
+ * @param pDump pointer to the dump
+ */
+static void ptp_convert_config_v1(PtpConfig *pConfig, const void *pDump) {
+    PtpConfigV1 v1;
+    memcpy(&v1, pDump, sizeof(PtpConfigV1));
+
+    ptp_store_config(pConfig);
+    pConfig->profile = v1.profile;
+    pConfig->offset = v1.offset;
+    pConfig->logging = v1.logging;
+    pConfig->priority1 = v1.priority1;
+    pConfig->priority2 = v1.priority2;
+    pConfig->delayAsymmetry = v1.delayAsymmetry;
+    pConfig->latencies = v1.latencies;
+    pConfig->warmStart = v1.warmStart;
+    memset(pConfig->servo, 0, PTP_CONFIG_SERVO_NAME_LENGTH);
+    const PtpServo *servo = ptp_servo_get(v1.servo);
+    if (servo != NULL) {
+        strncpy(pConfig->servo, servo->name, PTP_CONFIG_SERVO_NAME_LENGTH - 1);
+    }
+    pConfig->servoParamCnt = 0; // the servo starts with its defaults
+}
+
+/**
+ * Convert a configuration of layout version 2.
+ *
+ * @param pConfig pointer to the converted configuration
+ * @param pDump pointer to the dump
+ */
+static void ptp_convert_config_v2(PtpConfig *pConfig, const void *pDump) {
+    PtpConfigV2 v2;
+    memcpy(&v2, pDump, sizeof(PtpConfigV2));
+
+    memset(pConfig, 0, sizeof(PtpConfig));
+    pConfig->version = PTP_CONFIG_VERSION;
+    pConfig->size = sizeof(PtpConfig);
+    pConfig->profile = v2.profile;
+    pConfig->offset = v2.offset;
+    pConfig->logging = v2.logging;
+    pConfig->priority1 = v2.priority1;
+    pConfig->priority2 = v2.priority2;
+    pConfig->delayAsymmetry = v2.delayAsymmetry;
+    pConfig->latencies = v2.latencies;
+    memcpy(pConfig->servo, v2.servo, PTP_CONFIG_SERVO_NAME_LENGTH);
+    pConfig->warmStart = v2.warmStart; // the servo starts with its defaults
+}
+
+// -----------
+
 void ptp_store_config(PtpConfig *pConfig) {
+    pConfig->version = PTP_CONFIG_VERSION;
+    pConfig->size = sizeof(PtpConfig);
     pConfig->profile = S.profile;
     pConfig->offset = S.hwoptions.offset;
     pConfig->logging = CONFIG_ADD_LOGGING(S.logging.def, CONFIG_LOG_DEF) |
@@ -39,9 +163,25 @@ void ptp_store_config(PtpConfig *pConfig) {
                        CONFIG_ADD_LOGGING(S.logging.transmission, CONFIG_LOG_TRANSMISSION);
     pConfig->priority1 = S.capabilities.priority1;
     pConfig->priority2 = S.capabilities.priority2;
+    pConfig->delayAsymmetry = S.hwoptions.delayAsymmetry;
+    pConfig->latencies = S.hwoptions.latencies;
+    memset(pConfig->servo, 0, PTP_CONFIG_SERVO_NAME_LENGTH);
+    const PtpServo *servo = ptp_servo_get(ptp_servo_get_id());
+    if (servo != NULL) {
+        strncpy(pConfig->servo, servo->name, PTP_CONFIG_SERVO_NAME_LENGTH - 1);
+    }
+    ptp_holdover_save(&pConfig->warmStart);
+    memset(pConfig->servoParams, 0, sizeof(pConfig->servoParams));
+    pConfig->servoParamCnt = ptp_servo_get_params(pConfig->servoParams);
 }
 
 void ptp_load_config(const PtpConfig *pConfig) {
+    // a configuration of a different layout cannot be interpreted
+    if ((pConfig->version != PTP_CONFIG_VERSION) || (pConfig->size != sizeof(PtpConfig))) {
+        MSG("The retained flexPTP configuration has a different layout (version: %u, size: %u), loading aborted!\n", pConfig->version, pConfig->size);
+        return;
+    }
+
     // validate fields
     bool invalid = false;
     invalid |= pConfig->logging & (~CONFIG_LOG_ALL); // if at least a flag not corresponding to any kind of logging is set
@@ -58,6 +198,20 @@ void ptp_load_config(const PtpConfig *pConfig) {
     PtpTransportType tpt = pConfig->profile.transportType;
     invalid |= (tpt != PTP_TP_IPv4) && (tpt != PTP_TP_802_3);
 
+    invalid |= (pConfig->delayAsymmetry.sec != 0); // asymmetry must be less than a second
+
+    for (uint8_t i = 0; i < PTP_LS_N; i++) { // latencies must be less than a second
+        invalid |= (pConfig->latencies.ingress_ns[i] <= -NANO_PREFIX) || (pConfig->latencies.ingress_ns[i] >= NANO_PREFIX);
+        invalid |= (pConfig->latencies.egress_ns[i] <= -NANO_PREFIX) || (pConfig->latencies.egress_ns[i] >= NANO_PREFIX);
+    }
+
+    invalid |= (memchr(pConfig->servo, '\0', PTP_CONFIG_SERVO_NAME_LENGTH) == NULL); // servo name must be terminated
+
+    invalid |= (pConfig->servoParamCnt > PTP_SERVO_MAX_PARAMS);
+    for (uint8_t i = 0; (i < pConfig->servoParamCnt) && (i < PTP_SERVO_MAX_PARAMS); i++) {
+        invalid |= !isfinite(pConfig->servoParams[i]);
+    }
+
     // check validity
     if (invalid) {
         MSG("The retained flexPTP configuration got corrupted, loading aborted!\n");
@@ -69,6 +223,24 @@ void ptp_load_config(const PtpConfig *pConfig) {
     S.hwoptions.offset = pConfig->offset;
     S.capabilities.priority1 = pConfig->priority1;
     S.capabilities.priority2 = pConfig->priority2;
+    S.hwoptions.delayAsymmetry = pConfig->delayAsymmetry;
+    S.hwoptions.latencies = pConfig->latencies;
+
+    // the stored servo might not be built in, then the current one is kept
+    uint8_t servoId = ptp_servo_find(pConfig->servo);
+    if (servoId != PTP_SERVO_INVALID_ID) {
+        ptp_servo_select(servoId);
+        if ((pConfig->servoParamCnt > 0) && !ptp_servo_set_params(pConfig->servoParams, pConfig->servoParamCnt)) {
+            MSG("The retained parameters of servo '%s' are not accepted, keeping the defaults!\n", pConfig->servo);
+        }
+    } else {
+        MSG("The retained servo '%s' is not available, keeping the current one!\n", pConfig->servo);
+    }
+
+    // the frequency memory is optional, an unusable one only prevents the warm start
+    if (ptp_holdover_load(&pConfig->warmStart)) {
+        MSG("Frequency memory restored: %.3f ppb\n", pConfig->warmStart.freq_ppb);
+    }
 
     S.logging.def = (pConfig->logging & CONFIG_LOG_DEF) != 0;
     S.logging.info = (pConfig->logging & CONFIG_LOG_INFO) != 0;
@@ -81,7 +253,23 @@ void ptp_load_config(const PtpConfig *pConfig) {
 
 void ptp_load_config_from_dump(const void *pDump) {
     PtpConfig config;
-    memcpy(&config, pDump, sizeof(PtpConfig));
+    memset(&config, 0, sizeof(PtpConfig));
+
+    // only read the whole object if the header matches, an older (shorter) dump may end earlier
+    memcpy(&config, pDump, offsetof(PtpConfig, profile));
+    if ((config.version == PTP_CONFIG_VERSION) && (config.size == sizeof(PtpConfig))) {
+        memcpy(&config, pDump, sizeof(PtpConfig));
+    } else if ((config.version == 2) && (config.size == sizeof(PtpConfigV2))) {
+        MSG("Converting the retained flexPTP configuration from layout version 2.\n");
+        ptp_convert_config_v2(&config, pDump);
+    } else if ((config.version == 1) && (config.size == sizeof(PtpConfigV1))) {
+        MSG("Converting the retained flexPTP configuration from layout version 1.\n");
+        ptp_convert_config_v1(&config, pDump);
+    } else if ((config.version == 0) || (config.size == 0)) {
+        // before versioning the dump began with the transport type (0 or 1), so one of the header fields is zero
+        MSG("Converting the retained flexPTP configuration from the unversioned layout.\n");
+        ptp_convert_config_legacy(&config, pDump);
+    }
     ptp_load_config(&config);
     ptp_reset();
-}
\ No newline at end of file
+}
@@ -11,19 +11,31 @@
 #define FLEXPTP_CONFIG
 
 #include "ptp_types.h"
+#include "servo_registry.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define PTP_CONFIG_VERSION (3)            ///< Version of the PtpConfig layout, to be incremented on every change of the layout
+#define PTP_CONFIG_SERVO_NAME_LENGTH (16) ///< Maximum length of the stored servo name including the terminating zero
+
 /**
  * @brief Global storable-loadable configuration.
  */
 typedef struct {
-    PtpProfile profile;           ///< PTP-profile
-    TimestampI offset;            ///< PPS signal offset
-    uint32_t logging;             ///< logging compressed into a single bitfield
-    uint8_t priority1, priority2; ///< Clock priority fields
+    uint16_t version;                         ///< Layout version (PTP_CONFIG_VERSION)
+    uint16_t size;                            ///< Size of the configuration object in bytes
+    PtpProfile profile;                       ///< PTP-profile
+    TimestampI offset;                        ///< PPS signal offset
+    uint32_t logging;                         ///< logging compressed into a single bitfield
+    uint8_t priority1, priority2;             ///< Clock priority fields
+    TimestampI delayAsymmetry;                ///< Link delay asymmetry
+    PtpPortLatencies latencies;               ///< Ingress and egress latencies
+    char servo[PTP_CONFIG_SERVO_NAME_LENGTH]; ///< Name of the selected clock servo (identifiers depend on the build)
+    PtpWarmStart warmStart;                   ///< Frequency memory for warm starting the clock
+    double servoParams[PTP_SERVO_MAX_PARAMS]; ///< Parameters of the selected clock servo (servo specific)
+    uint8_t servoParamCnt;                    ///< Number of servo parameters, 0 if the servo defaults are used
 } PtpConfig;
 
 /**
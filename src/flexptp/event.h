@@ -16,10 +16,12 @@ extern "C" {
 // ----------- CORE EVENTS -----------
 
 typedef enum {
-    PTP_CEV_HEARTBEAT = 0x00,   ///< Heartbeat event (tick)
-    PTP_CEV_BMCA_STATE_CHANGED, ///< The BMCA state has changed
-    PTP_CEV_RESET,              ///< A reset has been issued
-    PTP_CEV_TERMINATE,          ///< A shutdown is requested
+    PTP_CEV_HEARTBEAT = 0x00,      ///< Heartbeat event (tick)
+    PTP_CEV_BMCA_STATE_CHANGED,    ///< The BMCA state has changed
+    PTP_CEV_RESET,                 ///< A reset has been issued
+    PTP_CEV_TERMINATE,             ///< A shutdown is requested
+    PTP_CEV_UNICAST_REMOVE_MASTER, ///< A master is to be removed from the unicast master table
+    PTP_CEV_SYNC_MODE_CHANGE,      ///< The Sync transmission mode is to be changed
 } PtpCoreEventCode;
 
 #include <stdint.h>
@@ -71,6 +73,9 @@ typedef enum {
 
     PTP_UEV_NETWORK_ERROR, ///< Indication of lost messages or the absence of expected responses
     PTP_UEV_QUEUE_ERROR,   ///< This event signals that the flexPTP's internal transmission output queue is full and blocked
+
+    PTP_UEV_HOLDOVER_ENTERED, ///< The master has been lost, the clock is running on the memorized frequency
+    PTP_UEV_HOLDOVER_LEFT,    ///< The holdover has ended, synchronization is resumed
 } PtpUserEventCode;
 
 /**
@@ -3,18 +3,23 @@
 #include "format_utils.h"
 #include <stdint.h>
 
-#define LOG_INTERVAL_LOOKUP_OFFSET (6) ///< Index associated with the 1s logarithmic interval.
+#define LOG_INTERVAL_LOOKUP_OFFSET (7) ///< Index associated with the 1s logarithmic interval.
 
 /**
  * Lookup table for log msg. period to ms conversion (ms values are floor-rounded).
  */ 
-static uint16_t sLogIntervalMs[] = { 15, 31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 0 }; // terminating zero as last element
+static uint16_t sLogIntervalMs[] = { 7, 15, 31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 16000, 0 }; // terminating zero as last element
 
 // log interval to milliseconds
 uint16_t ptp_logi2ms(int8_t logi) {
 	return sLogIntervalMs[logi + LOG_INTERVAL_LOOKUP_OFFSET];
 }
 
+// log interval to microseconds
+uint32_t ptp_logi2us(int8_t logi) {
+	return (logi >= 0) ? (1000000 << logi) : (1000000 >> (-logi));
+}
+
 // milliseconds to log interval
 int8_t ptp_ms2logi(uint16_t ms) {
 	uint16_t * pIter = sLogIntervalMs;
@@ -22,8 +27,9 @@ int8_t ptp_ms2logi(uint16_t ms) {
 		if (*pIter == ms) {
 			break;
 		}
+		pIter++;
 	}
-	return (int8_t)(pIter - sLogIntervalMs) + LOG_INTERVAL_LOOKUP_OFFSET;
+	return (int8_t)(pIter - sLogIntervalMs) - LOG_INTERVAL_LOOKUP_OFFSET;
 }
 
 // Network->Host byte order conversion for 64-bit values
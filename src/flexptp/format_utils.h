@@ -19,7 +19,7 @@ extern "C" {
 
 /**
  * Convert logarithmic interval designator code to a milliseconds value.
- * Input must be in the inclusive range of [-6, 3]. 
+ * Input must be in the inclusive range of [-7, 4]. 
  *
  * The function emulates the execution of the following computation: 2^(n) * 1000 
  *
@@ -28,9 +28,19 @@ extern "C" {
  */
 uint16_t ptp_logi2ms(int8_t logi);
 
+/**
+ * Convert logarithmic interval designator code to a microseconds value.
+ * Input must be in the inclusive range of [-7, 4]. Unlike ptp_logi2ms(), this one
+ * is precise enough to schedule message rates above the heartbeat rate.
+ *
+ * @param logi PTP-defined logarithmic interval code
+ * @return period in microseconds (floor-rounded)
+ */
+uint32_t ptp_logi2us(int8_t logi);
+
 /**
  * Convert millisecond period value to PTP-defined logarithmic interval designator code.
- * Input must be a value from the following set: (15, 31, 62, 125, 250, 500, 1000, 2000, 4000, 8000).
+ * Input must be a value from the following set: (7, 15, 31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 16000).
  *
  * This function mimics the following computation: round(log2(T/1000))
  *
@@ -0,0 +1,246 @@
+#include "holdover.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#include "event.h"
+#include "ptp_core.h"
+#include "ptp_defs.h"
+
+#include "minmax.h"
+
+///\cond 0
+#define S (gPtpCoreState)
+///\endcond
+
+#define PTP_HOLDOVER_UPDATE_PERIOD_TICKS FLEXPTP_MS_TO_TICKS(1000) ///< Period of applying the drift model and refreshing the estimates
+
+/**
+ * Get the current frequency tuning of the hardware clock.
+ *
+ * @return tuning in PPB relative to the nominal frequency
+ */
+static double ptp_holdover_get_hw_freq() {
+#ifdef PTP_ADDEND_INTERFACE
+    return ((double)S.hwclock.addend - PTP_ADDEND_INIT) / PTP_ADDEND_CORR_PER_PPB_F;
+#elif defined(PTP_HLT_INTERFACE)
+    return S.hwclock.tuning_ppb;
+#endif
+}
+
+/**
+ * Write an absolute frequency tuning into the hardware clock.
+ *
+ * @param freq_ppb tuning in PPB relative to the nominal frequency
+ */
+static void ptp_holdover_set_hw_freq(double freq_ppb) {
+#ifdef PTP_ADDEND_INTERFACE
+    double addend = PTP_ADDEND_INIT + freq_ppb * PTP_ADDEND_CORR_PER_PPB_F;
+    S.hwclock.addend = (uint32_t)MIN(MAX(addend, 0.0), (double)0xFFFFFFFF);
+    PTP_SET_ADDEND(S.hwclock.addend);
+#elif defined(PTP_HLT_INTERFACE)
+    S.hwclock.tuning_ppb = freq_ppb;
+    PTP_SET_TUNING(S.hwclock.tuning_ppb);
+#endif
+}
+
+// ---------------------------
+
+void ptp_holdover_init() {
+    ptp_holdover_clear();
+    S.holdover.agingEn = PTP_HOLDOVER_AGING_COMPENSATION;
+}
+
+void ptp_holdover_clear() {
+    bool agingEn = S.holdover.agingEn;
+    memset(&S.holdover, 0, sizeof(PtpHoldoverState));
+    S.holdover.agingEn = agingEn;
+}
+
+void ptp_holdover_update(double dt_s) {
+    PtpHoldoverState *h = &S.holdover;
+    double f = ptp_holdover_get_hw_freq();
+
+    // the first sample initializes the memory
+    if (h->samples == 0) {
+        h->freq_ppb = f;
+        h->freqVar = 0.0;
+        h->aging_ppbps = 0.0;
+        h->samples = 1;
+        return;
+    }
+
+    if (dt_s <= 0.0) {
+        return;
+    }
+
+    // exponential averaging of the frequency and its variance
+    double a = exp(-dt_s / PTP_HOLDOVER_FREQ_AVG_TAU_S);
+    double prevFreq = h->freq_ppb;
+    double e = f - prevFreq;
+    h->freq_ppb = prevFreq + (1 - a) * e;
+    h->freqVar = a * (h->freqVar + (1 - a) * e * e);
+
+    // tracking the slope of the averaged frequency (linear aging)
+    double b = exp(-dt_s / PTP_HOLDOVER_AGING_TAU_S);
+    double slope = (h->freq_ppb - prevFreq) / dt_s;
+    h->aging_ppbps = b * h->aging_ppbps + (1 - b) * slope;
+
+    if (h->samples < UINT32_MAX) {
+        h->samples++;
+    }
+
+    // the clock has locked, the restored frequency memory has served its purpose
+    if (h->warmStart == PTP_WS_ACCEPTED) {
+        h->warmStart = PTP_WS_NONE;
+    }
+}
+
+bool ptp_holdover_is_valid() {
+    return S.holdover.samples >= PTP_HOLDOVER_MIN_SAMPLES;
+}
+
+bool ptp_holdover_is_active() {
+    return S.holdover.active;
+}
+
+bool ptp_holdover_restore_frequency() {
+    if (!ptp_holdover_is_valid()) {
+        return false;
+    }
+
+    ptp_holdover_set_hw_freq(S.holdover.freq_ppb);
+    return true;
+}
+
+void ptp_holdover_enter() {
+    if (S.holdover.active || !ptp_holdover_restore_frequency()) {
+        return;
+    }
+
+    S.holdover.active = true;
+    S.holdover.startTick = S.ticks;
+    S.holdover.startTimeError = fabs(S.stats.filtTimeErr);
+
+    S.stats.holdover = true;
+    S.stats.holdoverDuration_s = 0;
+    S.stats.holdoverTimeErrEst = S.holdover.startTimeError;
+
+    CLILOG(S.logging.info, "Holdover entered, frequency: %.3f ppb (+-%.3f ppb), aging: %.3e ppb/s\n",
+           S.holdover.freq_ppb, sqrt(S.holdover.freqVar), S.holdover.aging_ppbps);
+    PTP_IUEV(PTP_UEV_HOLDOVER_ENTERED);
+}
+
+void ptp_holdover_leave() {
+    if (!S.holdover.active) {
+        return;
+    }
+
+    S.holdover.active = false;
+    S.stats.holdover = false;
+
+    CLILOG(S.logging.info, "Holdover left after %u s, estimated time error: %.0f ns\n",
+           S.stats.holdoverDuration_s, S.stats.holdoverTimeErrEst);
+    PTP_IUEV(PTP_UEV_HOLDOVER_LEFT);
+}
+
+void ptp_holdover_tick() {
+    if (!S.holdover.active) {
+        return;
+    }
+
+    uint32_t elapsedTicks = S.ticks - S.holdover.startTick;
+    if ((elapsedTicks % PTP_HOLDOVER_UPDATE_PERIOD_TICKS) != 0) {
+        return;
+    }
+
+    double t = elapsedTicks * (PTP_HEARTBEAT_TICKRATE_MS / 1000.0);
+
+    // apply the linear aging model
+    if (S.holdover.agingEn) {
+        ptp_holdover_set_hw_freq(S.holdover.freq_ppb + S.holdover.aging_ppbps * t);
+    }
+
+    // time error bound: initial error + frequency uncertainty integrated + uncompensated drift
+    double te = S.holdover.startTimeError + sqrt(S.holdover.freqVar) * t;
+    if (!S.holdover.agingEn) {
+        te += 0.5 * fabs(S.holdover.aging_ppbps) * t * t;
+    }
+
+    S.stats.holdoverDuration_s = (uint32_t)t;
+    S.stats.holdoverTimeErrEst = te;
+}
+
+const PtpHoldoverState *ptp_holdover_get_state() {
+    return &S.holdover;
+}
+
+void ptp_holdover_enable_aging(bool en) {
+    S.holdover.agingEn = en;
+}
+
+void ptp_holdover_save(PtpWarmStart *pWs) {
+    memset(pWs, 0, sizeof(PtpWarmStart));
+    if (!ptp_holdover_is_valid()) {
+        return;
+    }
+
+    TimestampU t;
+    PTP_HW_GET_TIME(&t);
+
+    pWs->savedAt_s = t.sec;
+    pWs->samples = S.holdover.samples;
+    pWs->freq_ppb = S.holdover.freq_ppb;
+    pWs->freqVar = S.holdover.freqVar;
+    pWs->aging_ppbps = S.holdover.aging_ppbps;
+}
+
+bool ptp_holdover_load(const PtpWarmStart *pWs) {
+    if ((pWs->samples < PTP_HOLDOVER_MIN_SAMPLES) || !isfinite(pWs->freq_ppb) ||
+        !isfinite(pWs->aging_ppbps) || !isfinite(pWs->freqVar) || (pWs->freqVar < 0.0)) {
+        return false;
+    }
+
+    ptp_holdover_clear();
+    S.holdover.samples = pWs->samples;
+    S.holdover.freq_ppb = pWs->freq_ppb;
+    S.holdover.freqVar = pWs->freqVar;
+    S.holdover.aging_ppbps = pWs->aging_ppbps;
+    S.holdover.savedAt_s = pWs->savedAt_s;
+    S.holdover.warmStart = PTP_WS_PENDING;
+    return true;
+}
+
+void ptp_holdover_check_warm_start(uint64_t now_s) {
+    if (S.holdover.warmStart != PTP_WS_PENDING) {
+        return;
+    }
+
+    int64_t age = (int64_t)(now_s - S.holdover.savedAt_s);
+    if ((age < 0) || (age > PTP_WARM_START_MAX_AGE_S)) {
+        CLILOG(S.logging.info, "Restored frequency memory is %" __PRI64_PREFIX "d s old, discarded!\n", age);
+        ptp_holdover_clear();
+        ptp_holdover_set_hw_freq(0.0);
+        return;
+    }
+
+    // extrapolate the frequency over the downtime if the aging model is in use
+    if (S.holdover.agingEn) {
+        S.holdover.freq_ppb += S.holdover.aging_ppbps * age;
+        ptp_holdover_set_hw_freq(S.holdover.freq_ppb);
+    }
+
+    S.holdover.warmStart = PTP_WS_ACCEPTED;
+    CLILOG(S.logging.info, "Warm start: %.3f ppb (+-%.3f ppb), memory age: %" __PRI64_PREFIX "d s\n",
+           S.holdover.freq_ppb, sqrt(S.holdover.freqVar), age);
+}
+
+bool ptp_holdover_take_warm_start() {
+    if (S.holdover.warmStart != PTP_WS_ACCEPTED) {
+        return false;
+    }
+
+    S.holdover.warmStart = PTP_WS_NONE;
+    return true;
+}
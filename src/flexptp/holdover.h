@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * @file    holdover.h
+  * @copyright András Wiesner, 2026-\showdate "%Y"
+  * @brief   This module implements the holdover mode: it memorizes the averaged
+  * frequency tuning while the clock is locked and keeps the clock free-running
+  * on the learnt frequency once the master is lost.
+  ******************************************************************************
+  */
+
+#ifndef FLEXPTP_HOLDOVER_H_
+#define FLEXPTP_HOLDOVER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ptp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initialize the holdover module.
+ */
+void ptp_holdover_init();
+
+/**
+ * Forget the frequency memory and the drift model.
+ */
+void ptp_holdover_clear();
+
+/**
+ * Feed the frequency memory with the current hardware clock tuning.
+ * Should be called after each servo run while the clock is locked.
+ *
+ * @param dt_s elapsed time since the previous sample in seconds
+ */
+void ptp_holdover_update(double dt_s);
+
+/**
+ * Enter holdover: load the memorized frequency into the hardware clock.
+ * Does nothing if no valid frequency memory is present.
+ */
+void ptp_holdover_enter();
+
+/**
+ * Leave holdover.
+ */
+void ptp_holdover_leave();
+
+/**
+ * Tick the holdover module.
+ */
+void ptp_holdover_tick();
+
+/**
+ * Is holdover active?
+ *
+ * @return holdover is running
+ */
+bool ptp_holdover_is_active();
+
+/**
+ * Does the frequency memory contain a usable estimate?
+ *
+ * @return the frequency memory is valid
+ */
+bool ptp_holdover_is_valid();
+
+/**
+ * Load the memorized frequency into the hardware clock.
+ *
+ * @return the frequency memory was valid and has been loaded
+ */
+bool ptp_holdover_restore_frequency();
+
+/**
+ * Get the frequency memory.
+ *
+ * @return pointer to the holdover state
+ */
+const PtpHoldoverState *ptp_holdover_get_state();
+
+/**
+ * Enable or disable the linear aging compensation applied during holdover.
+ *
+ * @param en enable aging compensation
+ */
+void ptp_holdover_enable_aging(bool en);
+
+/**
+ * Save the frequency memory for storing it in the configuration.
+ * Only a valid frequency memory is saved, otherwise the sample count is zeroed.
+ *
+ * @param pWs pointer to the output object
+ */
+void ptp_holdover_save(PtpWarmStart *pWs);
+
+/**
+ * Restore a frequency memory saved by ptp_holdover_save().
+ * The restored memory is loaded into the hardware clock on the next PTP reset
+ * and gets validated against the master's time on the first Sync.
+ *
+ * @param pWs pointer to the saved frequency memory
+ * @return the saved frequency memory was valid and has been restored
+ */
+bool ptp_holdover_load(const PtpWarmStart *pWs);
+
+/**
+ * Check the age of a restored frequency memory. Too old (or future) memories
+ * are dropped and the hardware clock is reverted to its nominal frequency.
+ * Does nothing if no restored frequency memory is pending.
+ *
+ * @param now_s current PTP time in seconds (taken from the master's timestamps)
+ */
+void ptp_holdover_check_warm_start(uint64_t now_s);
+
+/**
+ * Take the accepted restored frequency memory: the first compensation after
+ * a warm start can rely on it instead of estimating the skew.
+ *
+ * @return a restored frequency memory has been accepted and not taken yet
+ */
+bool ptp_holdover_take_warm_start();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLEXPTP_HOLDOVER_H_ */
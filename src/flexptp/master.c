@@ -1,5 +1,6 @@
 #include "master.h"
 
+#include "clock_utils.h"
 #include "common.h"
 #include "flexptp_options.h"
 #include "format_utils.h"
@@ -9,9 +10,11 @@
 #include "ptp_profile_presets.h"
 #include "ptp_sync_cycle_data.h"
 #include "ptp_types.h"
+#include "session.h"
 #include "task_ptp.h"
 #include "timeutils.h"
 #include "tlv.h"
+#include "unicast.h"
 
 #include <inttypes.h>
 #include <string.h>
@@ -24,11 +27,10 @@
 
 /*
  * Message headaers and compiled bodies. They can be statically
- * allocated, since nothing depends on the Announce message
- * and a Follow_Up is always triggered by the transmission of
- * a Sync. TODO: Maybe Sync transmissions should be constrained,
- * so that no new Sync transmission would be scheduled if the Follow_Up
- * was in the queue.
+ * allocated, since messages are copied into the transmit queue.
+ * A Follow_Up is always triggered by the transmission of a Sync,
+ * the outstanding two-step Syncs are tracked in a ring of slots
+ * keyed by their sequence IDs (see S.master.syncSlots).
  */
 static PtpHeader announceHeader;
 static RawPtpMessage announce;
@@ -71,7 +73,7 @@ static void ptp_init_sync_header() {
     syncHeader.transportSpecific = (uint8_t)S.profile.transportSpecific;
     syncHeader.versionPTP = 2;
     syncHeader.domainNumber = S.profile.domainNumber;
-    syncHeader.flags.PTP_TWO_STEP = true;
+    syncHeader.flags.PTP_TWO_STEP = !S.master.oneStepSync; // one-step Syncs carry the origin timestamp themselves
     // syncHeader.flags.PTP_TIMESCALE = false;
     syncHeader.correction_ns = 0;
     syncHeader.correction_subns = 0;
@@ -83,7 +85,7 @@ static void ptp_init_sync_header() {
     syncHeader.logMessagePeriod = S.profile.logSyncPeriod;
 
     // insert TLVs from the profile
-    uint16_t tlvSize = ptp_tlv_insert(announce.data + PTP_PCKT_SIZE_SYNC,
+    uint16_t tlvSize = ptp_tlv_insert(sync_.data + PTP_PCKT_SIZE_SYNC,
                                       tlvChain,
                                       PTP_MT_Sync,
                                       MAX_PTP_MSG_SIZE - PTP_PCKT_SIZE_SYNC);
@@ -102,10 +104,19 @@ static void ptp_init_follow_up_message() {
     followUp.size = PTP_PCKT_SIZE_FOLLOW_UP + tlvSize;
 }
 
-static void ptp_send_announce_message() {
-    // set sequence ID
-    announceHeader.sequenceID = S.master.messaging.announceSequenceID++;
+/**
+ * Send an Announce message.
+ *
+ * @param pAddr unicast destination address, NULL if the message is sent to the multicast group
+ * @param sequenceID sequence ID of the message
+ * @param logPeriod log. message period advertised in the header
+ */
+static void ptp_send_announce_message(const PtpNetAddr *pAddr, uint16_t sequenceID, int8_t logPeriod) {
+    // set sequence ID and addressing related fields
+    announceHeader.sequenceID = sequenceID;
     announceHeader.transportSpecific = S.profile.transportSpecific;
+    announceHeader.logMessagePeriod = logPeriod;
+    announceHeader.flags.PTP_UNICAST = (pAddr != NULL);
 
     // fill-in fields
     ptp_construct_binary_header(announce.data, &announceHeader);           // insert header
@@ -118,17 +129,107 @@ static void ptp_send_announce_message() {
     announce.tx_dm = S.profile.delayMechanism;
     announce.tx_mc = PTP_MC_GENERAL;
     announce.ttl = FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS;
+    memset(&announce.addr, 0, sizeof(PtpNetAddr));
+    if (pAddr != NULL) {
+        announce.addr = *pAddr;
+    }
 
     // send message
     ptp_transmit_enqueue(&announce);
 }
 
+// ------------------------
+
+static bool ptp_sync_slot_addr_equal(const PtpNetAddr *pA, const PtpNetAddr *pB) {
+    return (pA->valid == pB->valid) && (pA->ip == pB->ip) && (!memcmp(pA->hw, pB->hw, 6));
+}
+
+/**
+ * Occupy a slot for a two-step Sync.
+ *
+ * @param pAddr destination of the Sync, NULL if multicast
+ * @param sequenceID sequence ID of the Sync
+ * @return a slot could be occupied (false if all slots are in use)
+ */
+static bool ptp_sync_slot_alloc(const PtpNetAddr *pAddr, uint16_t sequenceID) {
+    PtpMasterSyncSlotState *ss = &S.master.syncSlots;
+    if (ss->outstanding >= PTP_MASTER_SYNC_SLOTS) {
+        ss->skipped++;
+        return false;
+    }
+
+    // slots are mostly released in order, start searching at the next one
+    for (uint8_t i = 0; i < PTP_MASTER_SYNC_SLOTS; i++) {
+        uint8_t idx = (ss->next + i) % PTP_MASTER_SYNC_SLOTS;
+        PtpMasterSyncSlot *slot = &ss->slots[idx];
+        if (!slot->used) {
+            slot->used = true;
+            slot->sequenceID = sequenceID;
+            slot->enqueueTick = S.ticks;
+            memset(&slot->addr, 0, sizeof(PtpNetAddr));
+            if (pAddr != NULL) {
+                slot->addr = *pAddr;
+            }
+
+            ss->next = (idx + 1) % PTP_MASTER_SYNC_SLOTS;
+            ss->outstanding++;
+            ss->maxOutstanding = MAX(ss->maxOutstanding, ss->outstanding);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Release the slot of a Sync.
+ *
+ * @param pAddr destination of the Sync
+ * @param sequenceID sequence ID of the Sync
+ * @return the Sync has owned a slot
+ */
+static bool ptp_sync_slot_release(const PtpNetAddr *pAddr, uint16_t sequenceID) {
+    PtpMasterSyncSlotState *ss = &S.master.syncSlots;
+    for (uint8_t i = 0; i < PTP_MASTER_SYNC_SLOTS; i++) {
+        PtpMasterSyncSlot *slot = &ss->slots[i];
+        if (slot->used && (slot->sequenceID == sequenceID) && ptp_sync_slot_addr_equal(&slot->addr, pAddr)) {
+            slot->used = false;
+            ss->outstanding--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Release the slots of the Syncs whose transmit timestamps have not arrived in time.
+ */
+static void ptp_sync_slot_expire() {
+    PtpMasterSyncSlotState *ss = &S.master.syncSlots;
+    for (uint8_t i = 0; (i < PTP_MASTER_SYNC_SLOTS) && (ss->outstanding > 0); i++) {
+        PtpMasterSyncSlot *slot = &ss->slots[i];
+        if (slot->used && ((S.ticks - slot->enqueueTick) > PTP_MASTER_SYNC_SLOT_TIMEOUT_TICKS)) {
+            slot->used = false;
+            ss->outstanding--;
+            ss->expired++;
+        }
+    }
+}
+
+// ------------------------
+
 static void ptp_send_follow_up(const RawPtpMessage *pMsg) {
     // fetch header from preceding Sync
     PtpHeader header;
     ptp_extract_header(&header, pMsg->data);
     TimestampI t1 = pMsg->ts;
 
+    // only a Sync owning a slot gets its Follow_Up (the slot might have expired meanwhile)
+    if (!ptp_sync_slot_release(&pMsg->addr, header.sequenceID)) {
+        return;
+    }
+
     // modify header fields
     header.minorVersionPTP = 0;
     header.transportSpecific = S.profile.transportSpecific;
@@ -147,64 +248,67 @@ static void ptp_send_follow_up(const RawPtpMessage *pMsg) {
     followUp.tx_dm = S.profile.delayMechanism;
     followUp.tx_mc = PTP_MC_GENERAL;
     followUp.ttl = FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS;
+    followUp.addr = pMsg->addr; // follow the Sync to the same destination
 
     // transmit
     ptp_transmit_enqueue(&followUp);
 }
 
-static void ptp_send_sync_message() {
-    // set sequence ID
-    syncHeader.sequenceID = S.master.messaging.syncSequenceID++;
+/**
+ * Send a Sync message. In two-step mode the Follow_Up is sent from the transmit callback,
+ * in one-step mode the origin timestamp is inserted on transmission.
+ *
+ * @param pAddr unicast destination address, NULL if the message is sent to the multicast group
+ * @param sequenceID sequence ID of the message
+ * @param logPeriod log. message period advertised in the header
+ * @return the Sync has been enqueued (two-step Syncs are skipped if all slots are occupied)
+ */
+static bool ptp_send_sync_message(const PtpNetAddr *pAddr, uint16_t sequenceID, int8_t logPeriod) {
+    // a two-step Sync needs a slot to await its transmit timestamp in
+    if ((!S.master.oneStepSync) && (!ptp_sync_slot_alloc(pAddr, sequenceID))) {
+        return false;
+    }
+
+    // set sequence ID and addressing related fields
+    syncHeader.sequenceID = sequenceID;
+    syncHeader.logMessagePeriod = logPeriod;
+    syncHeader.flags.PTP_UNICAST = (pAddr != NULL);
+
+#ifdef PTP_HW_ONE_STEP_SYNC
+    // the hardware inserts the timestamp taken at the timestamping point, the egress latency is passed in the correction field
+    syncHeader.correction_ns = S.master.oneStepSync ? (uint64_t)((int64_t)S.hwoptions.latencies.egress_ns[S.hwoptions.linkSpeed]) : 0;
+#endif
 
     // fill-in fields
     ptp_construct_binary_header(sync_.data, &syncHeader); // insert header
-    ptp_write_binary_timestamps(sync_.data, &zeroTs, 1);  // insert an empty timestamp (TWO_STEP -> "reserved")
+    ptp_write_binary_timestamps(sync_.data, &zeroTs, 1);  // insert an empty timestamp (TWO_STEP -> "reserved", one-step -> filled on transmission)
 
     // setup packet
     sync_.tag = RPMT_RANDOM;
-    sync_.pTxCb = ptp_send_follow_up;
+    sync_.pTxCb = S.master.oneStepSync ? NULL : ptp_send_follow_up;
+    sync_.tx_1step = S.master.oneStepSync;
     sync_.tx_dm = S.profile.delayMechanism;
     sync_.tx_mc = PTP_MC_EVENT;
-    sync_.ttl = FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS; // S.master.syncTickPeriod;
+    sync_.ttl = FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS;
+    memset(&sync_.addr, 0, sizeof(PtpNetAddr));
+    if (pAddr != NULL) {
+        sync_.addr = *pAddr;
+    }
 
     // send message
     ptp_transmit_enqueue(&sync_);
+    return true;
 }
 
-static void ptp_send_delay_resp_message(const RawPtpMessage *pRawMsg, const PtpHeader *pHeader) {
-    RawPtpMessage delRespMsg = {0};
-
-    PtpHeader header = *pHeader; // make a copy
-    header.minorVersionPTP = 0;
-    TimestampI t4 = pRawMsg->ts; // fetch t4 timestamp
-
-    // create requestingSourcePortIdentity based on clockId from the header
-    PtpDelay_RespIdentification reqDelRespId = {header.clockIdentity, header.sourcePortID};
-
-    // modify header fields
-    header.messageType = PTP_MT_Delay_Resp;           // change message type
-    ptp_clear_flags(&header.flags);                   // clear flags
-    header.flags.PTP_TWO_STEP = true;                 // set TWO_STEP flag
-    header.sourcePortID = PTP_PORT_ID;                // set source port number
-    header.messageLength = PTP_PCKT_SIZE_DELAY_RESP;  // set appropriate size
-    header.clockIdentity = S.hwoptions.clockIdentity; // set our clock identity
-    header.control = PTP_CON_Delay_Resp;
-
-    // write fields
-    ptp_construct_binary_header(delRespMsg.data, &header);        // HEADER
-    ptp_write_binary_timestamps(delRespMsg.data, &t4, 1);         // t4 TIMESTAMP
-    ptp_write_delay_resp_id_data(delRespMsg.data, &reqDelRespId); // REQ.SRC.PORT.ID
+void ptp_master_send_unicast_sync(const PtpNetAddr *pAddr, uint16_t sequenceID, int8_t logPeriod) {
+    if (ptp_send_sync_message(pAddr, sequenceID, logPeriod)) {
+        PTP_IUEV(PTP_UEV_SYNC_SENT);
+    }
+}
 
-    // setup packet
-    delRespMsg.tag = RPMT_RANDOM;
-    delRespMsg.size = PTP_PCKT_SIZE_DELAY_RESP;
-    delRespMsg.pTxCb = NULL;
-    delRespMsg.tx_dm = PTP_DM_E2E;
-    delRespMsg.tx_mc = PTP_MC_GENERAL;
-    delRespMsg.ttl = FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS;
-
-    // send packet
-    ptp_transmit_enqueue(&delRespMsg);
+void ptp_master_send_unicast_announce(const PtpNetAddr *pAddr, uint16_t sequenceID, int8_t logPeriod) {
+    ptp_send_announce_message(pAddr, sequenceID, logPeriod);
+    PTP_IUEV(PTP_UEV_ANNOUNCE_SENT);
 }
 
 // ------------------------
@@ -214,70 +318,111 @@ static char *P2P_SLAVE_STATE_HINTS[] = {
     "CANDIDATE",
     "ESTABLISHED"};
 
-#define PTP_MASTER_P2P_SLAVE_STATE_LOG() \
-    CLILOG(S.logging.def && (si->state != prevState), "%s -> %s\n", P2P_SLAVE_STATE_HINTS[prevState], P2P_SLAVE_STATE_HINTS[si->state])
+#define PTP_MASTER_P2P_PEER_STATE_LOG()                                                                                       \
+    if (S.logging.def && (pi->state != prevState)) {                                                                          \
+        MSG("P2P peer ");                                                                                                     \
+        ptp_print_clock_identity(pi->identity);                                                                               \
+        MSG(": %s -> %s\n", P2P_SLAVE_STATE_HINTS[prevState], P2P_SLAVE_STATE_HINTS[pi->state]);                             \
+    }
 
 /**
- * Function to track what's going on with the slave.
+ * Find a peer in the peer table or allocate a new entry for it.
  *
- * @param slClockId clock ID of the slave that responded to our PDelay_Req message
+ * @param clockIdentity clock identity of the peer
+ * @param portNumber port number of the peer
+ * @return pointer to the peer entry, NULL if the peer is unknown and the table is full
  */
-static void ptp_master_p2p_slave_reported(uint64_t slClockId) {
-    PtpP2PSlaveInfo *si = &(S.master.p2pSlave);
-    PtpP2PSlaveState prevState = si->state;
-
-    switch (si->state) {
-    case PTP_P2PSS_NONE:
-        si->reportCount = 0;                  // increase the report count
-        si->dropoutCntr = PTP_PDELAY_DROPOUT; // reload the dropout counter
-        si->identity = slClockId;             // save the clock ID
-        si->state = PTP_P2PSS_CANDIDATE;      // switch to candidate state
-        break;
-    case PTP_P2PSS_CANDIDATE:
-    case PTP_P2PSS_ESTABLISHED:
-        if (si->identity == slClockId) {                                                    // if the slave candidate keep reporting in...
-            si->dropoutCntr = PTP_PDELAY_DROPOUT;                                           // reload the counter
-            si->reportCount = MIN(PTP_PDELAY_SLAVE_QUALIFICATION + 1, si->reportCount + 1); // increase the report count
-            if (si->reportCount > PTP_PDELAY_SLAVE_QUALIFICATION) {                         // switch to ESTABLISHED if qualification has passed
-                si->state = PTP_P2PSS_ESTABLISHED;
-            }
-        } else {                        // if a different slave has also appeared, then it's either a fault, or the previous one had been replaced
-            si->state = PTP_P2PSS_NONE; // revert to NONE state
-            si->identity = 0;           // clear the identity
-            si->dropoutCntr = 0;        // clear the dropout counter
-            si->reportCount = 0;        // clear the report counter
+static PtpP2PSlaveInfo *ptp_master_p2p_get_peer(uint64_t clockIdentity, uint16_t portNumber) {
+    PtpP2PSlaveInfo *pFree = NULL;
+    for (uint8_t i = 0; i < PTP_MASTER_P2P_PEER_TABLE_SIZE; i++) {
+        PtpP2PSlaveInfo *pi = &S.master.p2pPeers[i];
+        if (pi->state == PTP_P2PSS_NONE) {
+            pFree = (pFree == NULL) ? pi : pFree;
+        } else if ((pi->identity == clockIdentity) && (pi->portNumber == portNumber)) {
+            return pi;
         }
-        break;
     }
 
-    PTP_MASTER_P2P_SLAVE_STATE_LOG();
+    // take a free entry, the new peer becomes a candidate
+    if (pFree != NULL) {
+        PtpP2PSlaveInfo *pi = pFree;
+        PtpP2PSlaveState prevState = PTP_P2PSS_NONE;
+        memset(pi, 0, sizeof(PtpP2PSlaveInfo));
+        pi->identity = clockIdentity;
+        pi->portNumber = portNumber;
+        pi->dropoutCntr = PTP_PDELAY_DROPOUT;
+        pi->state = PTP_P2PSS_CANDIDATE;
+        PTP_MASTER_P2P_PEER_STATE_LOG();
+    }
+
+    return pFree;
 }
 
-// /**
-//  * Calculate the mean path delay.
-//  */
-// static void ptp_master_calculate_mean_path_delay() {
-//     // fetch value arrays
-//     TimestampI * pMPD = &S.network.meanPathDelay;
-//     uint64_t * pCf = S.master.scd.cf;
-
-//     // convert correction field values to timestamp objects
-//     TimestampI * pTs = S.master.scd.t;
-//     TimestampI cf = {0, 0}; // variable for accounting correction fields in
-//     nsToTsI(&cf, pCf[T2] + pCf[T3]);
-
-//     // compute difference between master and slave clock
-//     subTime(pMPD, &pTs[T4], &pTs[T1]); // t4 - t1 ...
-//     subTime(pMPD, pMPD, &pTs[T3]);     // - t3 ...
-//     addTime(pMPD, pMPD, &pTs[T2]);     // + t2
-//     subTime(pMPD, pMPD, &cf);          // - CF of (PDelay_Resp + PDelay_Resp_Follow_Up)
-//     divTime(pMPD, pMPD, 2);            // division by 2
-// }
-
-static void ptp_master_commence_mpd_computation() {
-    PtpSyncCycleData *scd = &S.master.scd;
-    TimestampI *mpd = &S.network.meanPathDelay;
-    ptp_compute_mean_path_delay_p2p(scd->t, scd->cf, mpd);
+/**
+ * Function to track what's going on with a peer.
+ *
+ * @param pi pointer to the peer that responded to our PDelay_Req message
+ */
+static void ptp_master_p2p_peer_reported(PtpP2PSlaveInfo *pi) {
+    PtpP2PSlaveState prevState = pi->state;
+
+    pi->dropoutCntr = PTP_PDELAY_DROPOUT;                                           // reload the dropout counter
+    pi->reportCount = MIN(PTP_PDELAY_SLAVE_QUALIFICATION + 1, pi->reportCount + 1); // increase the report count
+    if (pi->reportCount > PTP_PDELAY_SLAVE_QUALIFICATION) {                         // switch to ESTABLISHED if qualification has passed
+        pi->state = PTP_P2PSS_ESTABLISHED;
+    }
+
+    PTP_MASTER_P2P_PEER_STATE_LOG();
+}
+
+/**
+ * Age the peers on every PDelay_Req transmission, drop the ones that went silent.
+ */
+static void ptp_master_p2p_age_peers() {
+    for (uint8_t i = 0; i < PTP_MASTER_P2P_PEER_TABLE_SIZE; i++) {
+        PtpP2PSlaveInfo *pi = &S.master.p2pPeers[i];
+        if (pi->state == PTP_P2PSS_NONE) {
+            continue;
+        }
+
+        PtpP2PSlaveState prevState = pi->state;
+        pi->dropoutCntr = (pi->dropoutCntr > 0) ? (pi->dropoutCntr - 1) : 0; // decrease the peer dropout counter
+        if (pi->dropoutCntr == 0) {
+            pi->state = PTP_P2PSS_NONE;
+        }
+        PTP_MASTER_P2P_PEER_STATE_LOG();
+    }
+}
+
+/**
+ * Get the peer whose link delay is published as the mean path delay:
+ * the first ESTABLISHED peer, or the first candidate if none is established.
+ *
+ * @return pointer to the peer, NULL if no peer is present
+ */
+static const PtpP2PSlaveInfo *ptp_master_p2p_primary_peer() {
+    const PtpP2PSlaveInfo *pCandidate = NULL;
+    for (uint8_t i = 0; i < PTP_MASTER_P2P_PEER_TABLE_SIZE; i++) {
+        const PtpP2PSlaveInfo *pi = &S.master.p2pPeers[i];
+        if (pi->state == PTP_P2PSS_ESTABLISHED) {
+            return pi;
+        } else if ((pi->state == PTP_P2PSS_CANDIDATE) && (pCandidate == NULL)) {
+            pCandidate = pi;
+        }
+    }
+    return pCandidate;
+}
+
+static void ptp_master_commence_mpd_computation(PtpP2PSlaveInfo *pi) {
+    PtpSyncCycleData *scd = &pi->scd;
+    scd->t[T1] = S.master.pdelayReqT1;
+    ptp_compute_mean_path_delay_p2p(scd->t, scd->cf, &pi->linkDelay);
+    pi->linkDelayValid = true;
+
+    // publish the link delay of the primary peer
+    if (ptp_master_p2p_primary_peer() == pi) {
+        S.network.meanPathDelay = pi->linkDelay;
+    }
 
     CLILOG(S.logging.timestamps,
            "seqID: %u\n"
@@ -293,7 +438,7 @@ static void ptp_master_commence_mpd_computation() {
            (int32_t)scd->t[T4].sec, scd->t[T4].nanosec,
            scd->cf[T2], scd->cf[T3]);
 
-    CLILOG(S.logging.def, "%" __PRI64_PREFIX "d\n", nsI(mpd));
+    CLILOG(S.logging.def, "%" __PRI64_PREFIX "d\n", nsI(&pi->linkDelay));
 }
 
 void ptp_master_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
@@ -304,17 +449,28 @@ void ptp_master_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
         // dispatch DELAY_REQ_RECVED user event
         PTP_IUEV(PTP_UEV_DELAY_REQ_RECVED);
 
-        // send Delay_Resp message
-        ptp_send_delay_resp_message(pRawMsg, pHeader);
+        // under unicast negotiation only the holders of a Delay_Resp grant are responded, directly
+        const PtpNetAddr *pAddr = NULL;
+        if (ptp_unicast_is_active()) {
+            if ((!pRawMsg->addr.valid) || (!ptp_unicast_is_granted(pHeader->clockIdentity, pHeader->sourcePortID, PTP_UCM_DELAY_RESP))) {
+                return;
+            }
+            pAddr = &pRawMsg->addr;
+        } else if (pHeader->flags.PTP_UNICAST && pRawMsg->addr.valid) { // unicast Delay_Reqs (hybrid mode) are responded directly
+            pAddr = &pRawMsg->addr;
+        }
 
-        // dispatch DELAY_RESP_SENT user event
-        PTP_IUEV(PTP_UEV_DELAY_RESP_SENT);
+        // record the Delay_Req in the slave's session, the Delay_Resp is sent as soon as the transmit queue permits
+        ptp_session_delay_req(pHeader, &pRawMsg->ts, pAddr);
 
     } else if (((mt == PTP_MT_PDelay_Resp) || (mt == PTP_MT_PDelay_Resp_Follow_Up)) && (dm == PTP_DM_P2P)) { // let PDelay_Resp and PDelay_Resp_Follow_Up through in P2P mode
 
-        // try fetching PDelay_Req timestamp
-        if ((mt == PTP_MT_PDelay_Resp) && (!ptp_read_and_clear_transmit_timestamp(RPMT_DELAY_REQ, &S.master.scd.t[T1]))) {
-            return;
+        // fetch the PDelay_Req timestamp once, it is shared by all the responding peers
+        if ((mt == PTP_MT_PDelay_Resp) && (!S.master.pdelayReqT1Valid)) {
+            if (!ptp_read_and_clear_transmit_timestamp(RPMT_DELAY_REQ, &S.master.pdelayReqT1)) {
+                return;
+            }
+            S.master.pdelayReqT1Valid = true;
         }
 
         PtpDelay_RespIdentification delay_respID; // acquire PDelay_Resp(_Follow_Up) identification info
@@ -322,43 +478,43 @@ void ptp_master_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
 
         if ((delay_respID.requestingSourceClockIdentity == S.hwoptions.clockIdentity) &&
             (delay_respID.requestingSourcePortIdentity == PTP_PORT_ID) && (pHeader->sequenceID == S.master.pdelay_reqSequenceID)) {
-            PtpSyncCycleData *scd = &S.master.scd;
+
+            // look up the responding peer, ignore it if the peer table is full
+            PtpP2PSlaveInfo *pi = ptp_master_p2p_get_peer(pHeader->clockIdentity, pHeader->sourcePortID);
+            if (pi == NULL) {
+                return;
+            }
+            PtpSyncCycleData *scd = &pi->scd;
 
             if (mt == PTP_MT_PDelay_Resp) {
-                if (S.master.p2pSlave.state != PTP_P2PSS_NONE) {
-                    ptp_extract_timestamps(&(scd->t[T2]), pRawMsg->data, 1); // extract PDelay_Req reception time
-                    scd->cf[T2] = pHeader->correction_ns;                    // correction field of the PDelay_Resp
-                    scd->t[T4] = pRawMsg->ts;                                // save PDelay_Resp reception time
-                }
+                ptp_extract_timestamps(&(scd->t[T2]), pRawMsg->data, 1); // extract PDelay_Req reception time
+                scd->cf[T2] = pHeader->correction_ns;                    // correction field of the PDelay_Resp
+                scd->t[T4] = pRawMsg->ts;                                // save PDelay_Resp reception time
 
                 if (!pHeader->flags.PTP_TWO_STEP) {
-                    ptp_master_p2p_slave_reported(pHeader->clockIdentity);
+                    ptp_master_p2p_peer_reported(pi);
 
-                    // mean path delay calculation
-                    if (S.master.p2pSlave.state != PTP_P2PSS_NONE) { // one-step mode responder
-                        scd->t[T2] = scd->t[T3] = zeroTs;
-                        scd->cf[T3] = 0;
-                        ptp_master_commence_mpd_computation();
-                    }
+                    // mean path delay calculation (one-step mode responder)
+                    scd->t[T2] = scd->t[T3] = zeroTs;
+                    scd->cf[T3] = 0;
+                    ptp_master_commence_mpd_computation(pi);
 
                     // dispatch user event
                     PTP_IUEV(PTP_UEV_PDELAY_RESP_RECVED);
                 } else { // expect a ...FollowUp coming in two-step mode
-                    S.master.expectPDelRespFollowUp = true;
+                    pi->expectFollowUp = true;
                 }
             } else if (mt == PTP_MT_PDelay_Resp_Follow_Up) {
-                if (!S.master.expectPDelRespFollowUp) {
+                if (!pi->expectFollowUp) {
                     return;
                 }
-                S.master.expectPDelRespFollowUp = false;
+                pi->expectFollowUp = false;
 
-                if (S.master.p2pSlave.state != PTP_P2PSS_NONE) {
-                    ptp_extract_timestamps(&(scd->t[T3]), pRawMsg->data, 1); // extract PDelay_Resp transmission time
-                    scd->cf[T3] = pHeader->correction_ns;                    // correction field of the PDelay_Resp_Follow_Up
-                    ptp_master_commence_mpd_computation();
-                }
+                ptp_extract_timestamps(&(scd->t[T3]), pRawMsg->data, 1); // extract PDelay_Resp transmission time
+                scd->cf[T3] = pHeader->correction_ns;                    // correction field of the PDelay_Resp_Follow_Up
 
-                ptp_master_p2p_slave_reported(pHeader->clockIdentity);
+                ptp_master_p2p_peer_reported(pi);
+                ptp_master_commence_mpd_computation(pi);
 
                 // dispatch user event
                 PTP_IUEV(PTP_UEV_PDELAY_RESP_FOLLOW_UP_RECVED);
@@ -370,6 +526,9 @@ void ptp_master_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
 // ------------------------
 
 void ptp_master_init() {
+    // load the default Sync mode
+    S.master.oneStepSync = PTP_ONE_STEP_SYNC;
+
     // reset master module
     ptp_master_reset();
 }
@@ -394,11 +553,17 @@ void ptp_master_reset() {
     // disable the module
     S.master.enabled = false;
 
-    // don't expect a PDelay_Req_Follow_Up coming
-    S.master.expectPDelRespFollowUp = false;
+    // no PDelay_Req timestamp is available
+    S.master.pdelayReqT1Valid = false;
 
     // clear the messaging state
     memset(&S.master.messaging, 0, sizeof(PtpMasterMessagingState));
+
+    // release all Sync slots
+    memset(&S.master.syncSlots, 0, sizeof(PtpMasterSyncSlotState));
+
+    // drop the slave sessions
+    ptp_session_reset();
 }
 
 void ptp_master_enable() {
@@ -406,23 +571,33 @@ void ptp_master_enable() {
     S.master.enabled = true;
 
     // calculate periods
-    S.master.syncTickPeriod = ptp_logi2ms(S.profile.logSyncPeriod) / PTP_HEARTBEAT_TICKRATE_MS;
-    S.master.announceTickPeriod = ptp_logi2ms(S.profile.logAnnouncePeriod) / PTP_HEARTBEAT_TICKRATE_MS;
-    S.master.pdelayReqTickPeriod = ptp_logi2ms((S.profile.logDelayReqPeriod == PTP_LOGPER_SYNCMATCHED) ? S.profile.logSyncPeriod : S.profile.logDelayReqPeriod) / PTP_HEARTBEAT_TICKRATE_MS;
+    int8_t logPDelReqPeriod = (S.profile.logDelayReqPeriod == PTP_LOGPER_SYNCMATCHED) ? S.profile.logSyncPeriod : S.profile.logDelayReqPeriod;
+    S.master.logSyncPeriod = MAX(S.profile.logSyncPeriod, PTP_LOGPER_SYNC_MIN);
+    if (S.master.logSyncPeriod != S.profile.logSyncPeriod) {
+        CLILOG(S.logging.info, "Sync period 2^%d s is shorter than the heartbeat, Syncs are sent every 2^%d s\n", S.profile.logSyncPeriod, S.master.logSyncPeriod);
+    }
+    S.master.syncPeriod_us = ptp_logi2us(S.master.logSyncPeriod);
+    S.master.announcePeriod_us = ptp_logi2us(S.profile.logAnnouncePeriod);
+    S.master.pdelayReqPeriod_us = ptp_logi2us(logPDelReqPeriod);
+    S.master.pdelayReqTickPeriod = MAX(S.master.pdelayReqPeriod_us / (PTP_HEARTBEAT_TICKRATE_MS * 1000), 1);
+    if (S.master.pdelayReqPeriod_us < (PTP_HEARTBEAT_TICKRATE_MS * 1000)) {
+        CLILOG(S.logging.info, "PDelay_Req period 2^%d s is shorter than the heartbeat, one PDelay_Req is sent per %u ms\n", logPDelReqPeriod, PTP_HEARTBEAT_TICKRATE_MS);
+    }
 
-    // clear counters
-    S.master.syncTmr = 0;
-    S.master.announceTmr = 0;
-    S.master.pdelayReqTmr = 0;
+    // the first Sync is sent after a full period, the first Announce and PDelay_Req in the next tick
+    S.master.syncAcc_us = 0;
+    ptp_schedule_start(&S.master.announceAcc_us, S.master.announcePeriod_us);
+    ptp_schedule_start(&S.master.pdelayReqAcc_us, S.master.pdelayReqPeriod_us);
 
     // reset PDelay_Request's sequence ID
     S.master.pdelay_reqSequenceID = 0;
 
-    // clear Sync cycle data
-    memset(&S.master.scd, 0, sizeof(PtpSyncCycleData));
+    // clear the PDelay_Req timestamp and the peer table
+    S.master.pdelayReqT1Valid = false;
+    memset(S.master.p2pPeers, 0, sizeof(S.master.p2pPeers));
 
-    // clear P2P slave information
-    memset(&S.master.p2pSlave, 0, sizeof(PtpP2PSlaveInfo));
+    // start with an empty session table
+    ptp_session_reset();
 }
 
 void ptp_master_disable() {
@@ -437,52 +612,64 @@ void ptp_master_tick() {
     PtpDelayMechanism dm = S.profile.delayMechanism; // fetch Delay Mechanism
 
     // gating signal for Sync and Announce transmission
-    bool infoEn = (dm == PTP_DM_E2E) || ((dm == PTP_DM_P2P) && ((S.master.p2pSlave.state == PTP_P2PSS_ESTABLISHED) || (!(S.profile.flags & PTP_PF_ISSUE_SYNC_FOR_COMPLIANT_SLAVE_ONLY_IN_P2P))));
+    bool infoEn = (dm == PTP_DM_E2E) || ((dm == PTP_DM_P2P) && (ptp_master_p2p_peer_established() || (!(S.profile.flags & PTP_PF_ISSUE_SYNC_FOR_COMPLIANT_SLAVE_ONLY_IN_P2P))));
 
-    // Sync transmission
-    if (++S.master.syncTmr >= S.master.syncTickPeriod) {
-        S.master.syncTmr = 0;
+    // give up on the Syncs whose transmit timestamps got lost
+    ptp_sync_slot_expire();
 
-        if (infoEn) {
-            ptp_send_sync_message();
-            PTP_IUEV(PTP_UEV_SYNC_SENT);
-        }
+    // serve the pending Delay_Resps and maintain the slave sessions
+    if (dm == PTP_DM_E2E) {
+        ptp_session_tick();
     }
 
-    // Announce transmission
-    if (++S.master.announceTmr >= S.master.announceTickPeriod) { // advance Announce timer
-        S.master.announceTmr = 0;
+    // under unicast negotiation Sync and Announce messages are only sent to the grantees
+    if (ptp_unicast_is_active()) {
+        ptp_unicast_master_tick();
+        return;
     }
 
-    if (infoEn) {
-        // shift Announce transmission phase with 1 tick
-        if (S.master.announceTmr == 1) {
-            ptp_send_announce_message();
-            PTP_IUEV(PTP_UEV_ANNOUNCE_SENT);
+    // Sync transmission (the period is not shorter than the heartbeat, so at most one Sync is due per tick)
+    if ((ptp_schedule_advance(&S.master.syncAcc_us, S.master.syncPeriod_us) > 0) && infoEn) {
+        if (ptp_send_sync_message(NULL, S.master.messaging.syncSequenceID, S.master.logSyncPeriod)) {
+            S.master.messaging.syncSequenceID++;
+            PTP_IUEV(PTP_UEV_SYNC_SENT);
         }
     }
 
-    // issue PDelay_Req messages
-    if (dm == PTP_DM_P2P) {
-        if (++S.master.pdelayReqTmr >= S.master.pdelayReqTickPeriod) { // advance the PDelay_Req counter
-            S.master.pdelayReqTmr = 0;
-        }
+    // Announce transmission (periods shorter than the heartbeat yield multiple Announces per tick)
+    uint32_t announceDue = ptp_schedule_advance(&S.master.announceAcc_us, S.master.announcePeriod_us);
+    for (uint32_t i = 0; (i < announceDue) && infoEn; i++) {
+        ptp_send_announce_message(NULL, S.master.messaging.announceSequenceID++, S.profile.logAnnouncePeriod);
+        PTP_IUEV(PTP_UEV_ANNOUNCE_SENT);
+    }
 
-        // separate PDelay_Req transmission from the Sync-Follow_Up pair by shifting it's phase by one tick
-        if (S.master.pdelayReqTmr == 1) {
-            PtpP2PSlaveInfo *si = &(S.master.p2pSlave);
-            PtpP2PSlaveState prevState = si->state;
-            si->dropoutCntr = (si->dropoutCntr > 0) ? (si->dropoutCntr - 1) : 0; // decrease the slave dropout counter
-            if (si->dropoutCntr == 0) {
-                si->state = PTP_P2PSS_NONE;
-                si->identity = 0;
-            }
-            PTP_MASTER_P2P_SLAVE_STATE_LOG();
+    // issue PDelay_Req messages (only a single exchange can be in progress, at most one is sent per tick)
+    if (dm == PTP_DM_P2P) {
+        if (ptp_schedule_advance(&S.master.pdelayReqAcc_us, S.master.pdelayReqPeriod_us) > 0) {
+            ptp_master_p2p_age_peers(); // drop the peers that went silent
 
-            ptp_send_delay_req_message(); // send a PDelay_Request message
+            S.master.pdelayReqT1Valid = false; // a new timestamp belongs to the new PDelay_Req
+            ptp_send_delay_req_message();      // send a PDelay_Request message
 
             // dispatch PDELAY_REQUEST_SENT message
             PTP_IUEV(PTP_UEV_PDELAY_REQ_SENT);
         }
     }
-}
\ No newline at end of file
+}
+
+const PtpMasterSyncSlotState *ptp_master_get_sync_slot_state() {
+    return &S.master.syncSlots;
+}
+
+bool ptp_master_p2p_peer_established() {
+    for (uint8_t i = 0; i < PTP_MASTER_P2P_PEER_TABLE_SIZE; i++) {
+        if (S.master.p2pPeers[i].state == PTP_P2PSS_ESTABLISHED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const PtpP2PSlaveInfo *ptp_master_get_p2p_peers() {
+    return S.master.p2pPeers;
+}
@@ -56,6 +56,45 @@ void ptp_master_disable();
  */
 void ptp_master_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader);
 
+/**
+ * Send a Sync message (and the corresponding Follow_Up) to a unicast grantee.
+ *
+ * @param pAddr address of the grantee
+ * @param sequenceID sequence ID of the message
+ * @param logPeriod granted log. message period
+ */
+void ptp_master_send_unicast_sync(const PtpNetAddr *pAddr, uint16_t sequenceID, int8_t logPeriod);
+
+/**
+ * Send an Announce message to a unicast grantee.
+ *
+ * @param pAddr address of the grantee
+ * @param sequenceID sequence ID of the message
+ * @param logPeriod granted log. message period
+ */
+void ptp_master_send_unicast_announce(const PtpNetAddr *pAddr, uint16_t sequenceID, int8_t logPeriod);
+
+/**
+ * Get the state of the outstanding two-step Sync slots.
+ *
+ * @return pointer to the Sync slot state
+ */
+const PtpMasterSyncSlotState *ptp_master_get_sync_slot_state();
+
+/**
+ * Is there at least one ESTABLISHED peer responding to our PDelay_Reqs?
+ *
+ * @return an established peer is present
+ */
+bool ptp_master_p2p_peer_established();
+
+/**
+ * Get the P2P peer table. Entries in PTP_P2PSS_NONE state are unused.
+ *
+ * @return pointer to the array of PTP_MASTER_P2P_PEER_TABLE_SIZE peers
+ */
+const PtpP2PSlaveInfo *ptp_master_get_p2p_peers();
+
 /**
  * Render a PTP Sync message based on header data.
  * @param pData pointer to target the PTP message
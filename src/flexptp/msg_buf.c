@@ -254,4 +254,8 @@ uint32_t msgb_get_error(PtpMsgBuf * buf) {
     PtpMsgBufError err = buf->error;
     buf->error = MSGB_ERR_NONE;
     return err;
-}
\ No newline at end of file
+}
+
+uint32_t msgb_get_free(const PtpMsgBuf *buf) {
+    return buf->n - buf->used;
+}
@@ -155,6 +155,14 @@ void msgb_report(PtpMsgBuf *buf);
  */
 uint32_t msgb_get_error(PtpMsgBuf * buf);
 
+/**
+ * Get the number of free blocks.
+ *
+ * @param buf pointer to the PtpMsgBuf object
+ * @return number of blocks available for allocation
+ */
+uint32_t msgb_get_free(const PtpMsgBuf *buf);
+
 #ifdef __cplusplus
 }
 #endif
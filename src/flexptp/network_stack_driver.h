@@ -3,7 +3,8 @@
   * @file    network_stack_driver.h
   * @copyright András Wiesner, 2025-\showdate "%Y"
   * @brief   This file is a header for the employed Network Stack Driver (NSD).
-  * A NSD must define ALL four functions listed below.
+  * A NSD must define ALL four functions listed below, and ptp_nsd_set_one_step_sync()
+  * too if the port defines PTP_HW_ONE_STEP_SYNC.
   ******************************************************************************
   */
 
@@ -46,6 +47,17 @@ void ptp_nsd_transmit_msg(RawPtpMessage *pMsg, uint32_t uid);
  */
 void ptp_nsd_igmp_join_leave(bool join);
 
+#ifdef PTP_HW_ONE_STEP_SYNC
+/**
+ * Switch the hardware timestamping between one-step and two-step Sync transmission.
+ * Only required if the port defines PTP_HW_ONE_STEP_SYNC. It is called from the PTP task
+ * when the Sync mode changes, before any Sync of the new mode is transmitted.
+ *
+ * @param en let the hardware insert the origin timestamp into the Syncs flagged by `tx_1step`
+ */
+void ptp_nsd_set_one_step_sync(bool en);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -107,6 +107,7 @@ static int ptp_receive_cb(const Pckt *packet, PcktSieveLayerTag tag) {
         break;
     }
 
+    // NOTE: source addresses are not reported, so this driver cannot be used for unicast negotiation
     if (tp != -1) {
         ptp_receive_enqueue(packet->payload, packet->payloadSize, packet->time_s, packet->time_ns, tp);
     } else {
@@ -128,9 +129,15 @@ void ptp_nsd_transmit_msg(RawPtpMessage *pMsg, uint32_t uid) {
         cbd conn = (mc == PTP_MC_EVENT) ? PTP_L4_EVENT : PTP_L4_GENERAL;                // select connection by message type
         uint16_t port = (mc == PTP_MC_EVENT) ? PTP_PORT_EVENT : PTP_PORT_GENERAL;       // select port by message class
         ip_addr_t ipaddr = (DM == PTP_DM_E2E) ? PTP_IGMP_PRIMARY : PTP_IGMP_PEER_DELAY; // select destination IP-address by delmech.
+        if (pMsg->addr.valid) {
+            ipaddr = pMsg->addr.ip; // unicast destination
+        }
         udp_sendto_arg(conn, pMsg->data, pMsg->size, ipaddr, port, uid);     // send packet
     } else if (TP == PTP_TP_802_3) {
         const uint8_t *ethaddr = (DM == PTP_DM_E2E) ? PTP_ETHERNET_PRIMARY : PTP_ETHERNET_PEER_DELAY; // select destination address by delmech.
+        if (pMsg->addr.valid) {
+            ethaddr = pMsg->addr.hw; // unicast destination
+        }
         cet_send_arg(PTP_L2, ethaddr, pMsg->data, pMsg->size, uid);                        // send frame
     }
 }
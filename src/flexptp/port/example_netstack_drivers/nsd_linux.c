@@ -1,6 +1,7 @@
 #include "../../network_stack_driver.h"
 
 #include "../../ptp_defs.h"
+#include "../../settings_interface.h"
 #include "../../task_ptp.h"
 
 #include <arpa/inet.h>
@@ -243,12 +244,12 @@ void ptp_nsd_igmp_join_leave(bool join) {
     // don't have to explicitly leave the IGMP group
 }
 
-static int open_udp_socket(PtpDelayMechanism dm, uint16_t port, const char *hint) {
+static int open_udp_socket(uint16_t port, const char *hint) {
     // prepare socket address
     struct sockaddr_in addr;
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = PF_INET;
-    addr.sin_addr.s_addr = (dm == PTP_DM_E2E) ? PTP_IGMP_PRIMARY : PTP_IGMP_PEER_DELAY;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY); // bind to any address to receive unicast messages as well
 
     // create socket
     // man 2 socket
@@ -340,16 +341,8 @@ static int open_raw_socket(PtpDelayMechanism dm, bool bind_socket, const char *h
     return sfd;
 }
 
-static void enable_timestamping(int sfd) {
-    // enable timestamping on the socket
-    // https://www.kernel.org/doc/html/latest/networking/timestamping.html#scm-timestamping-records
-    int optval = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_TX_HARDWARE;
-    int err = setsockopt(sfd, SOL_SOCKET, SO_TIMESTAMPING, &optval, sizeof(optval));
-    if (err < 0) {
-        MSG("Failed to enable timestamping\n");
-    }
-
-    // enable timestamping in the hardware
+// configure the hardware timestamping of the interface
+static void configure_hw_timestamping(int sfd, bool oneStepSync) {
     struct ifreq ifreq;
     struct hwtstamp_config cfg;
     memset(&ifreq, 0, sizeof(ifreq));
@@ -358,7 +351,7 @@ static void enable_timestamping(int sfd) {
     ifreq.ifr_data = (void *)&cfg;
 
     // get current timestamping settings
-    err = ioctl(sfd, SIOCGHWTSTAMP, &ifreq);
+    int err = ioctl(sfd, SIOCGHWTSTAMP, &ifreq);
     if (err < 0) {
         MSG("Failed to get timestamping settings.\n");
         return;
@@ -368,11 +361,32 @@ static void enable_timestamping(int sfd) {
     // https://www.kernel.org/doc/html/latest/networking/timestamping.html#hardware-timestamping-configuration-ethtool-msg-tsconfig-set-get
     cfg.flags = 0;
     cfg.tx_type = HWTSTAMP_TX_ON;
+#ifdef PTP_HW_ONE_STEP_SYNC
+    // let the hardware insert the origin timestamp into Sync messages
+    if (oneStepSync) {
+        cfg.tx_type = HWTSTAMP_TX_ONESTEP_SYNC;
+    }
+#else
+    (void)oneStepSync;
+#endif
     cfg.rx_filter = HWTSTAMP_FILTER_PTP_V2_EVENT;
     err = ioctl(sfd, SIOCSHWTSTAMP, &ifreq);
     if (err < 0) {
         MSG("Failed to set timestamping settings.\n");
     }
+}
+
+static void enable_timestamping(int sfd) {
+    // enable timestamping on the socket
+    // https://www.kernel.org/doc/html/latest/networking/timestamping.html#scm-timestamping-records
+    int optval = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_TX_HARDWARE;
+    int err = setsockopt(sfd, SOL_SOCKET, SO_TIMESTAMPING, &optval, sizeof(optval));
+    if (err < 0) {
+        MSG("Failed to enable timestamping\n");
+    }
+
+    // enable timestamping in the hardware
+    configure_hw_timestamping(sfd, ptp_is_one_step_sync_enabled());
 
     // enable TX timestamp communication through the socket error queue
     // man 7 socket
@@ -390,6 +404,20 @@ static char msg_buf[MSG_BUF_SIZE];
 #define CTRL_BUF_SIZE (256)
 static char rx_ctrl_buf[CTRL_BUF_SIZE];
 
+// extract the source address of a received message
+static void get_source_address(const void *pName, socklen_t nameLen, PtpNetAddr *pAddr) {
+    memset(pAddr, 0, sizeof(PtpNetAddr));
+    if ((TP == PTP_TP_IPv4) && (nameLen >= sizeof(struct sockaddr_in))) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)pName;
+        pAddr->ip = sin->sin_addr.s_addr;
+        pAddr->valid = true;
+    } else if ((TP == PTP_TP_802_3) && (nameLen >= sizeof(struct sockaddr_ll))) {
+        const struct sockaddr_ll *sll = (const struct sockaddr_ll *)pName;
+        memcpy(pAddr->hw, sll->sll_addr, ETH_ALEN);
+        pAddr->valid = true;
+    }
+}
+
 static void *nsd_thread(void *arg) {
     bool run = true;
     while (run) {
@@ -476,7 +504,9 @@ static void *nsd_thread(void *arg) {
 
                     // forward only event messages over IPv4 and ALL messages over Ethernet
                     if (((TP == PTP_TP_IPv4) && (ts_found)) || (TP == PTP_TP_802_3)) {
-                        ptp_receive_enqueue(msg_buf, size, ts.tv_sec, ts.tv_nsec, TP);
+                        PtpNetAddr src;
+                        get_source_address(msg.msg_name, msg.msg_namelen, &src);
+                        ptp_receive_enqueue_from(msg_buf, size, ts.tv_sec, ts.tv_nsec, TP, &src);
                     }
                 }
             }
@@ -484,9 +514,12 @@ static void *nsd_thread(void *arg) {
             // general message reception (in IPv4 mode)
             if (TP == PTP_TP_IPv4) {
                 if (pfd[2].revents & POLLIN) {
-                    ssize_t size = recv(general_fd, msg_buf, MSG_BUF_SIZE, 0);
+                    socklen_t nameLen = NAME_BUF_SIZE;
+                    ssize_t size = recvfrom(general_fd, msg_buf, MSG_BUF_SIZE, 0, (struct sockaddr *)name_buf, &nameLen);
                     if (size > 0) {
-                        ptp_receive_enqueue(msg_buf, size, 0, 0, TP);
+                        PtpNetAddr src;
+                        get_source_address(name_buf, nameLen, &src);
+                        ptp_receive_enqueue_from(msg_buf, size, 0, 0, TP, &src);
                     }
                 }
             }
@@ -525,8 +558,8 @@ void ptp_nsd_init(PtpTransportType tp, PtpDelayMechanism dm) {
 
     // open event and general connections
     if (tp == PTP_TP_IPv4) {
-        event_fd = open_udp_socket(dm, PTP_PORT_EVENT, "EVENT");
-        general_fd = open_udp_socket(dm, PTP_PORT_GENERAL, "GENERAL");
+        event_fd = open_udp_socket(PTP_PORT_EVENT, "EVENT");
+        general_fd = open_udp_socket(PTP_PORT_GENERAL, "GENERAL");
     } else if (tp == PTP_TP_802_3) {
         event_fd = open_raw_socket(dm, true, "EVENT");
         general_fd = open_raw_socket(dm, false, "GENERAL");
@@ -570,6 +603,9 @@ void ptp_nsd_transmit_msg(RawPtpMessage *pMsg, uint32_t uid) {
         memset(&addr, 0, sizeof(addr));
         addr.sin_family = PF_INET;
         addr.sin_addr.s_addr = (DM == PTP_DM_E2E) ? PTP_IGMP_PRIMARY : PTP_IGMP_PEER_DELAY; // select destination IP-address by delmech.
+        if (pMsg->addr.valid) {
+            addr.sin_addr.s_addr = pMsg->addr.ip; // unicast destination
+        }
         addr.sin_port = htons((mc == PTP_MC_EVENT) ? PTP_PORT_EVENT : PTP_PORT_GENERAL);    // select port by message class
 
         // send packet
@@ -579,6 +615,9 @@ void ptp_nsd_transmit_msg(RawPtpMessage *pMsg, uint32_t uid) {
     } else if (TP == PTP_TP_802_3) {
         // destination address
         const uint8_t *ethaddr = (DM == PTP_DM_E2E) ? PTP_ETHERNET_PRIMARY : PTP_ETHERNET_PEER_DELAY; // select destination address by delmech.
+        if (pMsg->addr.valid) {
+            ethaddr = pMsg->addr.hw; // unicast destination
+        }
 
         // prepare address object
         struct sockaddr_ll addr;
@@ -598,14 +637,27 @@ void ptp_nsd_transmit_msg(RawPtpMessage *pMsg, uint32_t uid) {
         struct timespec now;
         clock_gettime(CLOCK_REALTIME, &now);
         CLILOG(LINUX_NSD_TX_ENQUEUE_DEBUG, "[%lu.%09lu] TX enqueue! %u\n", now.tv_sec, now.tv_nsec, uid);
-        if (mc == PTP_MC_EVENT) {
+#ifdef PTP_HW_ONE_STEP_SYNC
+        bool ts_expected = (mc == PTP_MC_EVENT) && (!pMsg->tx_1step); // one-step Syncs are not timestamped into the error queue
+#else
+        bool ts_expected = (mc == PTP_MC_EVENT);
+#endif
+        if (ts_expected) {
             write(matching_q[1], &uid, sizeof(uint32_t));
-        } else if (mc == PTP_MC_GENERAL) {
+        } else {
             ptp_transmit_timestamp_cb(uid, 0, 0);
         }
     }
 }
 
+#ifdef PTP_HW_ONE_STEP_SYNC
+void ptp_nsd_set_one_step_sync(bool en) {
+    if (event_fd > 0) {
+        configure_hw_timestamping(event_fd, en);
+    }
+}
+#endif
+
 void ptp_nsd_get_interface_address(uint8_t *hwa) {
     memcpy(hwa, if_hwaddr, IFHWADDRLEN);
 }
@@ -636,6 +688,25 @@ void linux_set_time(uint32_t seconds, uint32_t nanoseconds) {
     }
 }
 
+/* man 2 clock_adjtime (ADJ_SETOFFSET) */
+void linux_step_clock(int64_t delta_ns) {
+    struct timex tx;
+    memset(&tx, 0, sizeof(struct timex));
+    tx.modes = ADJ_SETOFFSET | ADJ_NANO;
+    tx.time.tv_sec = delta_ns / NANO_PREFIX;
+    tx.time.tv_usec = delta_ns % NANO_PREFIX; // holds nanoseconds due to ADJ_NANO
+
+    // the fractional part must be non-negative
+    if (tx.time.tv_usec < 0) {
+        tx.time.tv_sec -= 1;
+        tx.time.tv_usec += NANO_PREFIX;
+    }
+
+    if (clock_adjtime(phc_clkid, &tx) < 0) {
+        MSG("Failed to step the PHC!\n");
+    }
+}
+
 void linux_get_time(TimestampU *pTime) {
     struct timespec ts;
     if (clock_gettime(phc_clkid, &ts) < 0) {
@@ -38,6 +38,13 @@ void linux_set_time(uint32_t seconds, uint32_t nanoseconds);
  */
 void linux_adjust_clock(double tuning_ppb);
 
+/**
+ * Step the PHC by a relative amount in a single, atomic operation.
+ *
+ * @param delta_ns time step in nanoseconds (negative values step backward)
+ */
+void linux_step_clock(int64_t delta_ns);
+
 /**
  * Query PHC time.
  *
@@ -67,7 +67,8 @@ void ptp_nsd_init(PtpTransportType tp, PtpDelayMechanism dm) {
     // open only the necessary ones
     if (tp == PTP_TP_IPv4) {
         // open event and general connections
-        ip_addr_t addr = (dm == PTP_DM_E2E) ? PTP_IGMP_PRIMARY : PTP_IGMP_PEER_DELAY;
+        // bind to any address to receive unicast messages as well
+        ip_addr_t addr = *IP_ADDR_ANY;
         PTP_L4_EVENT = udp_new();
         udp_bind(PTP_L4_EVENT, &addr, PTP_PORT_EVENT);
         udp_recv(PTP_L4_EVENT, ptp_receive_cb, NULL);
@@ -89,8 +90,14 @@ void ptp_nsd_init(PtpTransportType tp, PtpDelayMechanism dm) {
 }
 
 static void ptp_receive_cb(void *pArg, struct udp_pcb *pPCB, struct pbuf *pP, const ip_addr_t *pAddr, uint16_t port) {
+    // store the source address
+    PtpNetAddr src;
+    memset(&src, 0, sizeof(PtpNetAddr));
+    src.ip = ip4_addr_get_u32(ip_2_ip4(pAddr));
+    src.valid = true;
+
     // put msg into the queue
-    ptp_receive_enqueue(pP->payload, pP->len, pP->time_s, pP->time_ns, PTP_TP_IPv4);
+    ptp_receive_enqueue_from(pP->payload, pP->len, pP->time_s, pP->time_ns, PTP_TP_IPv4, &src);
 
     // release pbuf resources
     pbuf_free(pP);
@@ -127,9 +134,15 @@ void ptp_nsd_transmit_msg(RawPtpMessage *pMsg, uint32_t uid) {
         struct udp_pcb *conn = (mc == PTP_MC_EVENT) ? PTP_L4_EVENT : PTP_L4_GENERAL;    // select connection by message type
         uint16_t port = (mc == PTP_MC_EVENT) ? PTP_PORT_EVENT : PTP_PORT_GENERAL;       // select port by message class
         ip_addr_t ipaddr = (DM == PTP_DM_E2E) ? PTP_IGMP_PRIMARY : PTP_IGMP_PEER_DELAY; // select destination IP-address by delmech.
+        if (pMsg->addr.valid) {
+            ip_addr_set_ip4_u32(&ipaddr, pMsg->addr.ip); // unicast destination
+        }
         udp_sendto(conn, p, &ipaddr, port);                                             // send packet
     } else if (TP == PTP_TP_802_3) {
         const uint8_t *ethaddr = (DM == PTP_DM_E2E) ? PTP_ETHERNET_PRIMARY : PTP_ETHERNET_PEER_DELAY; // select destination address by delmech.
+        if (pMsg->addr.valid) {
+            ethaddr = pMsg->addr.hw; // unicast destination
+        }
         ethernet_output(netif_default, p, (struct eth_addr *)netif_default->hwaddr, (struct eth_addr *)ethaddr, ETHERTYPE_PTP);
     }
 
@@ -156,9 +169,15 @@ err_t hook_unknown_ethertype(struct pbuf *pbuf, struct netif *netif) {
     memcpy(&etherType, ((uint8_t *)pbuf->payload) + 12, 2);
     etherType = FLEXPTP_ntohs(etherType);
     if (etherType == ETHERTYPE_PTP) {
-        // verify Ethernet address
-        if (!memcmp(PTP_ETHERNET_PRIMARY, pbuf->payload, 6) || !memcmp(PTP_ETHERNET_PEER_DELAY, pbuf->payload, 6)) { //
-            ptp_receive_enqueue(((uint8_t *)pbuf->payload) + ETHERNET_HEADER_LENGTH, pbuf->len - ETHERNET_HEADER_LENGTH, pbuf->time_s, pbuf->time_ns, PTP_TP_802_3);
+        // verify Ethernet address (PTP multicast or our own unicast address)
+        if (!memcmp(PTP_ETHERNET_PRIMARY, pbuf->payload, 6) || !memcmp(PTP_ETHERNET_PEER_DELAY, pbuf->payload, 6) || !memcmp(netif->hwaddr, pbuf->payload, 6)) { //
+            // store the source address
+            PtpNetAddr src;
+            memset(&src, 0, sizeof(PtpNetAddr));
+            memcpy(src.hw, ((uint8_t *)pbuf->payload) + 6, 6);
+            src.valid = true;
+
+            ptp_receive_enqueue_from(((uint8_t *)pbuf->payload) + ETHERNET_HEADER_LENGTH, pbuf->len - ETHERNET_HEADER_LENGTH, pbuf->time_s, pbuf->time_ns, PTP_TP_802_3, &src);
         }
     }
 
@@ -38,19 +38,11 @@
 #define PTP_SET_TUNING(tuning) ethernetif_ptp_set_tuning(PTP_CONFIG_LEADING_PARAMS, tuning)
 #define PTP_HW_GET_TIME(pt) ptphw_gettime(pt)
 
-// Include the clock servo (controller) and define the following:
-// - PTP_SERVO_INIT(): function initializing clock servo
-// - PTP_SERVO_DEINIT(): function deinitializing clock servo
-// - PTP_SERVO_RESET(): function reseting clock servo
-// - PTP_SERVO_RUN(d): function running the servo, input: master-slave time difference (error), return: clock tuning value in PPB
+// Optionally select the clock servo activated on startup (pid, kalman or debug):
+// - PTP_SERVO_DEFAULT: name of the servo, the servo can be changed in runtime as well
 //
 
-#include <flexptp/servo/pid_controller.h>
-
-#define PTP_SERVO_INIT() pid_ctrl_init()
-#define PTP_SERVO_DEINIT() pid_ctrl_deinit()
-#define PTP_SERVO_RESET() pid_ctrl_reset()
-#define PTP_SERVO_RUN(d, pscd) pid_ctrl_run(d, pscd)
+//#define PTP_SERVO_DEFAULT ("pid")
 
 // Optionally add interactive, tokenizing CLI-support
 // - CLI_REG_CMD(cmd_hintline,n_cmd,n_min_arg,cb): function for registering CLI-commands
@@ -29,7 +29,7 @@
 // - PTP_HW_INIT(increment, addend): function initializing timestamping hardware
 // - PTP_MAIN_OSCILLATOR_FREQ_HZ: clock frequency fed into the timestamp unit [Hz]
 // - PTP_INCREMENT_NSEC: hardware clock increment [ns]
-// - PTP_UPDATE_CLOCK(s,ns): function jumping clock by defined value (negative time value means jumping backward)
+// - PTP_HW_STEP_CLOCK(delta): function stepping the clock by a relative value in nanoseconds (negative value means stepping backward), optional
 // - PTP_SET_ADDEND(addend): function writing hardware clock addend register
 
 #include "Drivers/EthDrv/mac_drv.h"
@@ -43,20 +43,13 @@
 #define PTP_SET_CLOCK(s,ns) ETHHW_InitPTPTime(ETH, labs(s), abs(ns))
 #define PTP_SET_ADDEND(addend) ETHHW_SetPTPAddend(ETH, addend)
 #define PTP_HW_GET_TIME(pt) ptphw_gettime(pt)
+#define PTP_HW_STEP_CLOCK(delta) ptphw_step_clock(delta)
 
-// Include the clock servo (controller) and define the following:
-// - PTP_SERVO_INIT(): function initializing clock servo
-// - PTP_SERVO_DEINIT(): function deinitializing clock servo
-// - PTP_SERVO_RESET(): function reseting clock servo
-// - PTP_SERVO_RUN(d): function running the servo, input: master-slave time difference (error), return: clock tuning value in PPB
+// Optionally select the clock servo activated on startup (pid, kalman or debug):
+// - PTP_SERVO_DEFAULT: name of the servo, the servo can be changed in runtime as well
 //
 
-#include <flexptp/servo/pid_controller.h>
-
-#define PTP_SERVO_INIT() pd_ctrl_init()
-#define PTP_SERVO_DEINIT() pd_ctrl_deinit()
-#define PTP_SERVO_RESET() pd_ctrl_reset()
-#define PTP_SERVO_RUN(d,pscd) pd_ctrl_run(d,pscd)
+//#define PTP_SERVO_DEFAULT ("pid")
 
 // Optionally add interactive, tokenizing CLI-support
 // - CLI_REG_CMD(cmd_hintline,n_cmd,n_min_arg,cb): function for registering CLI-commands
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    ptp_port_step_clock.h
+  * @copyright András Wiesner, 2026-\showdate "%Y"
+  * @brief   Common helper of the ports stepping the clock by the time update
+  * registers of the Synopsys Ethernet MAC (STM32F4 and STM32H7).
+  ******************************************************************************
+  */
+
+#ifndef FLEXPTP_PTP_PORT_STEP_CLOCK_H_
+#define FLEXPTP_PTP_PORT_STEP_CLOCK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../timeutils.h"
+
+/**
+ * @brief Values to be loaded into the time update registers.
+ */
+typedef struct {
+    bool sub;         ///< Subtract the update from the current time
+    uint32_t sec;     ///< Seconds update register value
+    uint32_t nanosec; ///< Nanoseconds update register value (without the ADDSUB flag)
+} PtpHwStepUpdate;
+
+/**
+ * Compute the time update register values of a relative clock step in digital rollover mode.
+ * On subtraction, the nanoseconds part is always loaded as its complement. The seconds
+ * part has to be complemented as well on the GMAC4/QoS core (e.g. STM32H7), but not on
+ * the earlier MAC cores (e.g. STM32F4).
+ *
+ * @param delta_ns step in nanoseconds
+ * @param complementSec the MAC expects the complement of the seconds part on subtraction
+ * @param pUpdate pointer to the output object
+ */
+static inline void ptphw_compute_step_update(int64_t delta_ns, bool complementSec, PtpHwStepUpdate *pUpdate) {
+    bool sub = delta_ns < 0;
+    uint64_t adelta = sub ? -delta_ns : delta_ns;
+    uint32_t s = adelta / NANO_PREFIX;
+    uint32_t ns = adelta % NANO_PREFIX;
+
+    if (sub) {
+        ns = (ns != 0) ? (NANO_PREFIX - ns) : 0;
+        s = complementSec ? (uint32_t)(0 - s) : s;
+    }
+
+    pUpdate->sub = sub;
+    pUpdate->sec = s;
+    pUpdate->nanosec = ns;
+}
+
+#endif /* FLEXPTP_PTP_PORT_STEP_CLOCK_H_ */
@@ -1,4 +1,5 @@
 #include "ptp_port_stm32f407_lwip.h"
+#include "ptp_port_step_clock.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -134,3 +135,17 @@ void ptphw_gettime(TimestampU *pTime) {
         pTime->nanosec = ETH->PTPTSLR;
     } while (pTime->sec != ETH->PTPTSHR);
 }
+
+void ptphw_step_clock(int64_t delta_ns) {
+    PtpHwStepUpdate u;
+    ptphw_compute_step_update(delta_ns, false, &u); // the seconds are loaded as they are on subtraction
+
+    // wait for any previous update to complete
+    while (ETH->PTPTSCR & ETH_PTPTSCR_TSSTU) {
+    }
+
+    // load update registers and trigger the update
+    ETH->PTPTSHUR = u.sec;
+    ETH->PTPTSLUR = (u.sub ? ETH_PTPTSLUR_TSUPNS : 0) | (u.nanosec & ETH_PTPTSLUR_TSUSS);
+    ETH->PTPTSCR |= ETH_PTPTSCR_TSSTU;
+}
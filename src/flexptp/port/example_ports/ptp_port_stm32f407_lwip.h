@@ -22,6 +22,13 @@ void ptphw_init(uint32_t increment, uint32_t addend);
  */
 void ptphw_gettime(TimestampU * pTime);
 
+/**
+ * Step the hardware clock by a relative amount using the time update registers.
+ *
+ * @param delta_ns time step in nanoseconds (negative values step backward)
+ */
+void ptphw_step_clock(int64_t delta_ns);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,5 @@
 #include "ptp_port_stm32h743_etherlib.h"
+#include "ptp_port_step_clock.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -147,3 +148,17 @@ void ptphw_gettime(TimestampU *pTime) {
         pTime->nanosec = ETH->MACSTNR & ETH_MACSTNR_TSSS;
     } while (pTime->sec != ETH->MACSTSR);
 }
+
+void ptphw_step_clock(int64_t delta_ns) {
+    PtpHwStepUpdate u;
+    ptphw_compute_step_update(delta_ns, true, &u); // the GMAC4/QoS core expects the complement of the seconds on subtraction
+
+    // wait for any previous update to complete
+    while (ETH->MACTSCR & ETH_MACTSCR_TSUPDT) {
+    }
+
+    // load update registers and trigger the update
+    ETH->MACSTSUR = u.sec;
+    ETH->MACSTNUR = (u.sub ? ETH_MACSTNUR_ADDSUB : 0) | (u.nanosec & ETH_MACSTNUR_TSSS);
+    ETH->MACTSCR |= ETH_MACTSCR_TSUPDT;
+}
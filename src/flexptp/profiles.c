@@ -8,7 +8,7 @@
 char *PTP_TRANSPEC_HINT[] = { "unknown (default) [0]", "gPTP (802.1AS) [1]" }; ///< Hint on transport specific field
 char *PTP_TRANSPORT_TYPE_HINT[] = { "IPv4", "802.3" }; ///< Hint on transport types
 char *PTP_DELMECH_HINT[] = { "E2E", "P2P" }; ///< Hint on delay mechanism
-char *PTP_FLAGS_HINT[] = { "Sync (and Follow_Up) messages will only be issued if the peer slave proves compliant", "This node is SLAVE-ONLY" }; ///< Hints for 
+char *PTP_FLAGS_HINT[] = { "Sync (and Follow_Up) messages will only be issued if the peer slave proves compliant", "This node is SLAVE-ONLY", "Delay_Req messages are sent to the master directly (hybrid mode)" }; ///< Hints for 
 
 void ptp_print_profile() {
     MSG(PTP_COLOR_BGREEN "---- PTP PROFILE ----\n"
@@ -16,14 +16,18 @@
 #include "cli_cmds.h"
 #include "clock_utils.h"
 #include "format_utils.h"
+#include "holdover.h"
 #include "msg_utils.h"
 #include "network_stack_driver.h"
 #include "ptp_defs.h"
 #include "ptp_types.h"
+#include "servo_registry.h"
+#include "session.h"
 #include "settings_interface.h"
 #include "stats.h"
 #include "task_ptp.h"
 #include "timeutils.h"
+#include "unicast.h"
 
 #include <flexptp_options.h>
 
@@ -48,6 +52,9 @@ static void ptp_common_init(void) {
 
     // reset options
     nsToTsI(&S.hwoptions.offset, PTP_DEFAULT_SERVO_OFFSET);
+    nsToTsI(&S.hwoptions.delayAsymmetry, PTP_DEFAULT_DELAY_ASYMMETRY_NS);
+    memset(&S.hwoptions.latencies, 0, sizeof(PtpPortLatencies));
+    S.hwoptions.linkSpeed = PTP_DEFAULT_LINK_SPEED;
 
     // initialize hardware
 #ifdef PTP_ADDEND_INTERFACE
@@ -64,7 +71,7 @@ static void ptp_common_init(void) {
     ptp_create_clock_identity(hwa);
 
     // initialize controller
-    PTP_SERVO_INIT();
+    ptp_servo_init();
 }
 
 // initialize PTP module
@@ -89,6 +96,9 @@ void ptp_init(void) {
     /* ---- MASTER --- */
     ptp_master_init();
 
+    /* ---- UNICAST --- */
+    ptp_unicast_init();
+
     // ---------------------
 
     ptp_reset(); // reset all PTP systems
@@ -106,7 +116,7 @@ void ptp_deinit() {
 #endif // CLI_REG_CMD
 
     // deinitialize controller
-    PTP_SERVO_DEINIT();
+    ptp_servo_deinit();
 
     /* ----- SBMC ------ */
     ptp_bmca_destroy();
@@ -144,6 +154,9 @@ static void ptp_core_reset() {
     /* ---- MASTER --- */
     ptp_master_reset();
 
+    /* ---- UNICAST --- */
+    ptp_unicast_reset();
+
     // ------------------------
 
     // resume the heartbeat timer
@@ -153,6 +166,23 @@ static void ptp_core_reset() {
     PTP_IUEV(PTP_UEV_RESET_DONE);
 }
 
+// switch the Sync transmission mode
+static void ptp_core_change_sync_mode(bool oneStep) {
+    if (S.master.oneStepSync == oneStep) {
+        return;
+    }
+
+    S.master.oneStepSync = oneStep;
+
+#ifdef PTP_HW_ONE_STEP_SYNC
+    // reconfigure the timestamping before any Sync of the new mode gets transmitted
+    ptp_nsd_set_one_step_sync(oneStep);
+#endif
+
+    // rebuild the Sync header and drop the Syncs of the former mode
+    ptp_core_reset();
+}
+
 // packet processing
 void ptp_process_packet(RawPtpMessage *pRawMsg) {
     PtpHeader header;
@@ -171,11 +201,17 @@ void ptp_process_packet(RawPtpMessage *pRawMsg) {
     if (mt == PTP_MT_Announce) {
         PtpMasterProperties newMstProp;
         ptp_extract_announce_message(&newMstProp, pRawMsg->data);
-        ptp_handle_announce_msg(&newMstProp, &header);
+        ptp_handle_announce_msg(&newMstProp, &header, &pRawMsg->addr);
         PTP_IUEV(PTP_UEV_ANNOUNCE_RECVED); // dispatch ANNOUNCE_RECVED event
         return;
     }
 
+    // process Signaling messages (unicast negotiation)
+    if (mt == PTP_MT_Signaling) {
+        ptp_unicast_process_signaling(pRawMsg, &header);
+        return;
+    }
+
     // PDelay_Req messages should always be processed
     if ((header.messageType == PTP_MT_PDelay_Req) && (S.profile.delayMechanism == PTP_DM_P2P)) {
         PTP_IUEV(PTP_UEV_PDELAY_REQ_RECVED); // dispatch PDELAY_REQ_RECVED event
@@ -201,6 +237,8 @@ void ptp_process_event(const PtpCoreEvent *event) {
         S.ticks++;
         ptp_bmca_tick();
         ptp_slave_tick();
+        ptp_holdover_tick();
+        ptp_unicast_tick();
         ptp_master_tick();
     } break;
     case PTP_CEV_BMCA_STATE_CHANGED: {
@@ -209,6 +247,9 @@ void ptp_process_event(const PtpCoreEvent *event) {
             ptp_slave_enable();
         } else if (bmcaState == PTP_BMCA_MASTER) {
             ptp_master_enable();
+        } else if (bmcaState == PTP_BMCA_UNCALIBRATED) { // switching over to another master, no holdover
+            ptp_slave_switch_master();
+            ptp_master_disable();
         } else {
             ptp_slave_disable();
             ptp_master_disable();
@@ -220,6 +261,12 @@ void ptp_process_event(const PtpCoreEvent *event) {
     case PTP_CEV_RESET: {
         ptp_core_reset();
     } break;
+    case PTP_CEV_UNICAST_REMOVE_MASTER: {
+        ptp_unicast_process_remove_master(event->w.w, event->dw.dw);
+    } break;
+    case PTP_CEV_SYNC_MODE_CHANGE: {
+        ptp_core_change_sync_mode(event->w.w != 0);
+    } break;
     default:
         break;
     }
@@ -231,6 +278,13 @@ uint32_t ptp_get_tick() {
     return S.ticks;
 }
 
+void ptp_transmit_slot_released() {
+    // pending Delay_Resps are waiting for free transmit slots
+    if (S.master.enabled && (S.profile.delayMechanism == PTP_DM_E2E)) {
+        ptp_session_flush();
+    }
+}
+
 void ptp_reset() {
     PtpCoreEvent event = { .code = PTP_CEV_RESET, .w = 0, .dw = 0 };
     ptp_event_enqueue(&event);
@@ -54,6 +54,12 @@ void ptp_process_packet(RawPtpMessage *pRawMsg);
  */
 void ptp_process_event(const PtpCoreEvent * event);
 
+/**
+ * Notify the core that a transmit buffer slot has been released,
+ * so that queued messages waiting for a free slot can be passed on.
+ */
+void ptp_transmit_slot_released();
+
 /**
  * Get current PTP tick.
  *
@@ -128,6 +128,28 @@ extern const uint8_t PTP_ETHERNET_PEER_DELAY[6]; ///< PTP's L2 Peer_Delay Ethern
 #define PTP_HEARTBEAT_TICKRATE_MS (31) ///< Heartbeat ticking period
 #endif
 
+// at most one Sync is sent per heartbeat tick to keep the Syncs evenly spaced,
+// so the Sync period must not be shorter than the heartbeat period
+#if PTP_HEARTBEAT_TICKRATE_MS <= 7
+#define PTP_LOGPER_SYNC_MIN (-7) ///< Shortest Sync log. period that is not shorter than the heartbeat
+#elif PTP_HEARTBEAT_TICKRATE_MS <= 15
+#define PTP_LOGPER_SYNC_MIN (-6)
+#elif PTP_HEARTBEAT_TICKRATE_MS <= 31
+#define PTP_LOGPER_SYNC_MIN (-5)
+#elif PTP_HEARTBEAT_TICKRATE_MS <= 62
+#define PTP_LOGPER_SYNC_MIN (-4)
+#elif PTP_HEARTBEAT_TICKRATE_MS <= 125
+#define PTP_LOGPER_SYNC_MIN (-3)
+#elif PTP_HEARTBEAT_TICKRATE_MS <= 250
+#define PTP_LOGPER_SYNC_MIN (-2)
+#elif PTP_HEARTBEAT_TICKRATE_MS <= 500
+#define PTP_LOGPER_SYNC_MIN (-1)
+#elif PTP_HEARTBEAT_TICKRATE_MS <= 1000
+#define PTP_LOGPER_SYNC_MIN (0)
+#else
+#error "PTP_HEARTBEAT_TICKRATE_MS must not be longer than a second!"
+#endif
+
 #ifndef PTP_PORT_ID
 #define PTP_PORT_ID (1) ///< PTP port ID on the device
 #endif
@@ -140,6 +162,30 @@ extern const uint8_t PTP_ETHERNET_PEER_DELAY[6]; ///< PTP's L2 Peer_Delay Ethern
 #define PTP_DEFAULT_SERVO_OFFSET (0) ///< Default servo offset in nanoseconds
 #endif
 
+#ifndef PTP_SERVO_DEFAULT
+#ifdef PTP_SERVO_RUN
+#define PTP_SERVO_DEFAULT ("custom") ///< Name of the clock servo selected on startup (a custom servo is bound)
+#else
+#define PTP_SERVO_DEFAULT ("pid") ///< Name of the clock servo selected on startup
+#endif
+#endif
+
+#ifndef PTP_SERVO_FIXED_POINT
+#define PTP_SERVO_FIXED_POINT (0) ///< Register the fixed-point variants of the PID and Kalman-filter servos instead of the floating point ones
+#endif
+
+#ifndef PTP_SERVO_SHADOW_SLOTS
+#define PTP_SERVO_SHADOW_SLOTS (2) ///< Number of servo instances that can be evaluated in shadow
+#endif
+
+#ifndef PTP_DEFAULT_DELAY_ASYMMETRY_NS
+#define PTP_DEFAULT_DELAY_ASYMMETRY_NS (0) ///< Default link delay asymmetry in nanoseconds
+#endif
+
+#ifndef PTP_DEFAULT_LINK_SPEED
+#define PTP_DEFAULT_LINK_SPEED (PTP_LS_100M) ///< Link speed assumed until the port reports the actual one
+#endif
+
 #ifndef PTP_DEFAULT_COARSE_TRIGGER_NS
 #define PTP_DEFAULT_COARSE_TRIGGER_NS (20000000) ///< Coarse correction kick-in threshold
 #endif
@@ -168,6 +214,114 @@ extern const uint8_t PTP_ETHERNET_PEER_DELAY[6]; ///< PTP's L2 Peer_Delay Ethern
 #define PTP_CLOCK_PRIORITY2 (128) ///< Clock priority2
 #endif
 
+// ---- STABILITY STATISTICS -------
+
+#ifndef PTP_STABILITY_OCTAVES
+#define PTP_STABILITY_OCTAVES (14) ///< Number of octave-spaced observation intervals ADEV, TDEV and MTIE are computed at, starting at the Sync period
+#endif
+
+// ---- DISTRIBUTION STATISTICS -------
+
+#ifndef PTP_HIST_OCTAVES
+#define PTP_HIST_OCTAVES (24) ///< Number of octaves the log-scale histograms span, values above 2^PTP_HIST_OCTAVES units fall into the last bucket
+#endif
+
+#ifndef PTP_HIST_SUB_BUCKETS
+#define PTP_HIST_SUB_BUCKETS (4) ///< Number of linear buckets an octave of the histograms is divided into
+#endif
+
+#ifndef PTP_HIST_WINDOW_S
+#define PTP_HIST_WINDOW_S (60) ///< Length of the windows the streaming percentiles are computed over (s)
+#endif
+
+// ---- FAST COMPENSATION -------
+
+#ifndef PTP_FC_SKEW_MAX_SAMPLES
+#define PTP_FC_SKEW_MAX_SAMPLES (8) ///< Maximum number of Sync samples collected for skew estimation (can be changed in runtime)
+#endif
+
+#ifndef PTP_FC_SKEW_CI_LIMIT_PPB
+#define PTP_FC_SKEW_CI_LIMIT_PPB (20.0) ///< Skew estimation terminates early if the confidence interval is narrower than this (can be changed in runtime)
+#endif
+
+#ifndef PTP_FC_TIME_CORRECTION_CYCLES
+#define PTP_FC_TIME_CORRECTION_CYCLES (1) ///< Number of time correction cycles (can be changed in runtime)
+#endif
+
+#ifndef PTP_FC_TIME_PROPAGATION_CYCLES
+#ifdef PTP_HW_STEP_CLOCK
+#define PTP_FC_TIME_PROPAGATION_CYCLES (1) ///< Number of time propagation cycles, relative steps are atomic, only the cycle in flight is dropped (can be changed in runtime)
+#else
+#define PTP_FC_TIME_PROPAGATION_CYCLES (2) ///< Number of time propagation cycles (can be changed in runtime)
+#endif
+#endif
+
+// ---- ADAPTIVE DELAY_REQ RATE -------
+
+#ifndef PTP_ADAPTIVE_DELAY_REQ
+#define PTP_ADAPTIVE_DELAY_REQ (0) ///< Enable the adaptive (P)Delay_Req rate by default
+#endif
+
+#ifndef PTP_ADAPTIVE_DELAY_REQ_MAX_BACKOFF
+#define PTP_ADAPTIVE_DELAY_REQ_MAX_BACKOFF (3) ///< Maximum number of log. period steps the (P)Delay_Req rate may back off from the profile's period
+#endif
+
+#ifndef PTP_ADAPTIVE_DELAY_REQ_STABLE_CYCLES
+#define PTP_ADAPTIVE_DELAY_REQ_STABLE_CYCLES (8) ///< Number of (P)Delay_Req periods spent in stable conditions before backing off one step
+#endif
+
+#ifndef PTP_ADAPTIVE_DELAY_REQ_MPD_STD_LIMIT_NS
+#define PTP_ADAPTIVE_DELAY_REQ_MPD_STD_LIMIT_NS (50.0) ///< Path delay standard deviation above which the (P)Delay_Req rate is restored to the profile's rate (ns)
+#endif
+
+// ---- HOLDOVER -------
+
+#ifndef PTP_HOLDOVER_MIN_SAMPLES
+#define PTP_HOLDOVER_MIN_SAMPLES (16) ///< Minimum number of locked servo cycles before the frequency memory is considered valid
+#endif
+
+#ifndef PTP_HOLDOVER_FREQ_AVG_TAU_S
+#define PTP_HOLDOVER_FREQ_AVG_TAU_S (60.0) ///< Time constant of frequency averaging (s)
+#endif
+
+#ifndef PTP_HOLDOVER_AGING_TAU_S
+#define PTP_HOLDOVER_AGING_TAU_S (900.0) ///< Time constant of the aging (frequency drift) estimation (s)
+#endif
+
+#ifndef PTP_HOLDOVER_AGING_COMPENSATION
+#define PTP_HOLDOVER_AGING_COMPENSATION (0) ///< Apply the linear aging model during holdover by default
+#endif
+
+#ifndef PTP_WARM_START_MAX_AGE_S
+#define PTP_WARM_START_MAX_AGE_S (86400) ///< Maximum age of a frequency memory restored from a stored configuration (s)
+#endif
+
+// ---- UNICAST NEGOTIATION -------
+
+#ifndef PTP_UNICAST_NEGOTIATION
+#define PTP_UNICAST_NEGOTIATION (0) ///< Enable unicast negotiation by default
+#endif
+
+#ifndef PTP_UNICAST_MASTER_TABLE_SIZE
+#define PTP_UNICAST_MASTER_TABLE_SIZE (4) ///< Number of entries in the unicast master table (slave side)
+#endif
+
+#ifndef PTP_UNICAST_GRANT_TABLE_SIZE
+#define PTP_UNICAST_GRANT_TABLE_SIZE (16) ///< Number of grantees the master can serve
+#endif
+
+#ifndef PTP_UNICAST_GRANT_DURATION_S
+#define PTP_UNICAST_GRANT_DURATION_S (60) ///< Grant duration requested by the slave (can be changed in runtime) (s)
+#endif
+
+#ifndef PTP_UNICAST_MAX_GRANT_DURATION_S
+#define PTP_UNICAST_MAX_GRANT_DURATION_S (300) ///< Longest grant duration issued by the master (s)
+#endif
+
+#ifndef PTP_UNICAST_REQUEST_RETRY_MS
+#define PTP_UNICAST_REQUEST_RETRY_MS (2000) ///< Minimum time between repeated requests of the same grant (ms)
+#endif
+
 // ---- CAPABILITIES AND ANNOUNCE DATASET -------
 
 #ifndef PTP_BEST_CLOCK_CLASS
@@ -186,6 +340,30 @@ extern const uint8_t PTP_ETHERNET_PEER_DELAY[6]; ///< PTP's L2 Peer_Delay Ethern
 #define PTP_FALLBACK_UTC_OFFSET (37) ///< UTC offset caused by the accumulated leap seconds
 #endif
 
+// ---- FOREIGN MASTER DATASET -----
+
+#ifndef PTP_FOREIGN_MASTER_TABLE_SIZE
+#define PTP_FOREIGN_MASTER_TABLE_SIZE (5) ///< Maximum number of foreign masters tracked simultaneously
+#endif
+
+#ifndef PTP_FOREIGN_MASTER_TIME_WINDOW
+#define PTP_FOREIGN_MASTER_TIME_WINDOW (4) ///< Qualification window of foreign masters in Announce intervals
+#endif
+
+#ifndef PTP_FOREIGN_MASTER_THRESHOLD
+#define PTP_FOREIGN_MASTER_THRESHOLD (2) ///< Number of Announces within the window needed to qualify a foreign master
+#endif
+
+// ---- HOT-STANDBY MASTER -----
+
+#ifndef PTP_HOT_STANDBY
+#define PTP_HOT_STANDBY (0) ///< Track the second-best master by default
+#endif
+
+#ifndef PTP_HOT_STANDBY_MAX_AGE_SYNC_PERIODS
+#define PTP_HOT_STANDBY_MAX_AGE_SYNC_PERIODS (4) ///< Age limit of the standby estimate (in the standby's Sync periods) usable on failover
+#endif
+
 // ---- MASTER P2P SLAVE HANDLING -----
 
 #ifndef PTP_PDELAY_SLAVE_QUALIFICATION
@@ -196,6 +374,56 @@ extern const uint8_t PTP_ETHERNET_PEER_DELAY[6]; ///< PTP's L2 Peer_Delay Ethern
 #define PTP_PDELAY_DROPOUT PTP_PDELAY_SLAVE_QUALIFICATION ///< Maximum number of failed PDelReq-PDelResp cycles before the MASTER drops the SLAVE
 #endif
 
+#ifndef PTP_MASTER_P2P_PEER_TABLE_SIZE
+#define PTP_MASTER_P2P_PEER_TABLE_SIZE (4) ///< Number of peers responding to the MASTER's PDelay_Reqs tracked at once
+#endif
+
+// ---- MASTER SYNC SLOTS -----
+
+#ifndef PTP_MASTER_SYNC_SLOTS
+#define PTP_MASTER_SYNC_SLOTS (8) ///< Number of two-step Syncs that may await their transmit timestamps at once
+#endif
+
+#ifndef PTP_MASTER_SYNC_SLOT_TIMEOUT_TICKS
+#define PTP_MASTER_SYNC_SLOT_TIMEOUT_TICKS (FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS + 2) ///< A Sync slot is released if no transmit timestamp has arrived within this many ticks
+#endif
+
+// ---- ONE-STEP SYNC -----
+
+#ifndef PTP_ONE_STEP_SYNC
+#define PTP_ONE_STEP_SYNC (0) ///< Transmit one-step Sync messages by default (can be changed in runtime)
+#endif
+
+#ifndef PTP_ONE_STEP_SW_TX_LATENCY_NS
+#define PTP_ONE_STEP_SW_TX_LATENCY_NS (0) ///< Estimated delay between reading the clock and the Sync leaving the timestamping point, added to software-inserted origin timestamps (ns)
+#endif
+
+// ---- MASTER E2E SLAVE SESSIONS -----
+
+#ifndef PTP_MASTER_SESSION_TABLE_SIZE
+#define PTP_MASTER_SESSION_TABLE_SIZE (64) ///< Number of slaves tracked by the master (size it for the expected number of slaves)
+#endif
+
+#ifndef PTP_MASTER_SESSION_TIMEOUT_MS
+#define PTP_MASTER_SESSION_TIMEOUT_MS (60000) ///< A slave session is dropped if no Delay_Req has arrived for this long (ms)
+#endif
+
+#ifndef PTP_MASTER_DELAY_RESP_QUEUE_LENGTH
+#define PTP_MASTER_DELAY_RESP_QUEUE_LENGTH (32) ///< Number of Delay_Resps awaiting transmission
+#endif
+
+#ifndef PTP_MASTER_DELAY_RESP_BATCH
+#define PTP_MASTER_DELAY_RESP_BATCH (8) ///< Maximum number of Delay_Resps passed to the transmit queue at once
+#endif
+
+#ifndef PTP_MASTER_TX_RESERVE
+#define PTP_MASTER_TX_RESERVE (4) ///< Number of transmit buffer slots kept free from Delay_Resps (for Sync, Follow_Up and Announce)
+#endif
+
+#ifndef PTP_ENABLE_MASTER_LOAD_GENERATOR
+#define PTP_ENABLE_MASTER_LOAD_GENERATOR (0) ///< Compile the synthetic Delay_Req load generator for benchmarking the master
+#endif
+
 // ---- TERMINAL COLORS -----
 
 // clang-format off
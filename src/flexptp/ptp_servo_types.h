@@ -9,6 +9,10 @@
 #ifndef FLEXPTP_SIM_PTP_SERVO_TYPES_H_
 #define FLEXPTP_SIM_PTP_SERVO_TYPES_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "ptp_sync_cycle_data.h"
 
 #ifdef __cplusplus
@@ -27,6 +31,49 @@ typedef struct {
     int64_t measSyncPeriodNs; ///< Measured synchronization period (t1->t1)
 } PtpServoAuxInput;
 
+/**
+ * @brief Clock servo descriptor. A servo is accessed through these functions only.
+ *
+ * Instantiable servos keep their whole state in an instance object of stateSize bytes,
+ * so that several instances can run side by side (see shadow servos). The module-level
+ * functions (init, deinit) operate on the default instance that is driven by the servo's CLI commands.
+ */
+typedef struct {
+    const char *name;                                                         ///< Name of the servo (used on the CLI)
+    size_t stateSize;                                                         ///< Size of an instance, 0 if the servo cannot be instantiated
+    void (*init)();                                                           ///< Initialize the servo module (default instance, CLI commands)
+    void (*deinit)();                                                         ///< Deinitialize the servo module (remove CLI commands)
+    void *(*instance)();                                                      ///< Get the default instance
+    void (*create)(void *pState);                                             ///< Initialize an instance with the default parameters (may be NULL)
+    void (*reset)(void *pState);                                              ///< Reset an instance, parameters are retained
+    float (*run)(void *pState, int32_t dt, PtpServoAuxInput *pAux);           ///< Run an instance, returns the clock tuning in PPB
+    void (*params)(const void *pState);                                       ///< Print the parameters of an instance (may be NULL)
+    bool (*setParams)(void *pState, const double *pParams, uint8_t paramCnt); ///< Set the parameters of an instance (may be NULL)
+    uint8_t (*getParams)(const void *pState, double *pParams);                ///< Get the parameters of an instance in the order of setParams, returns their number (may be NULL)
+} PtpServo;
+
+/**
+ * @brief Closed-loop performance figures of a servo instance.
+ */
+typedef struct {
+    uint32_t cycles;    ///< Number of evaluated synchronization cycles
+    float lastTuning;   ///< Last clock tuning (PPB)
+    double lastError;   ///< Last time error (ns)
+    double sumSqError;  ///< Sum of the squared time errors (ns^2)
+    double maxAbsError; ///< Largest absolute time error (ns)
+} PtpServoEvalStats;
+
+/**
+ * @brief Shadow servo: a servo instance fed with the live measurements, but not driving the clock.
+ */
+typedef struct {
+    bool used;               ///< The slot is in use
+    uint8_t servoId;         ///< Identifier of the servo in the registry
+    double clockOffset;      ///< Time offset of the simulated clock relative to the real one (ns)
+    double freqOffset;       ///< Frequency offset of the simulated clock relative to the real one (PPB)
+    PtpServoEvalStats stats; ///< Performance figures on the simulated clock
+} PtpServoShadow;
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,7 +42,8 @@ typedef enum PTPMessageType {
     PTP_MT_Follow_Up = 8,              ///< Follow Up
     PTP_MT_Delay_Resp = 9,             ///< Delay Response
     PTP_MT_PDelay_Resp_Follow_Up = 10, ///< Peer Delay Response Follow Up
-    PTP_MT_Announce = 11               ///< Announce
+    PTP_MT_Announce = 11,              ///< Announce
+    PTP_MT_Signaling = 12              ///< Signaling
 } PtpMessageType;
 
 /**
@@ -164,6 +165,15 @@ typedef enum {
 
 #define MAX_PTP_MSG_SIZE (128) ///< Maximum PTP message size
 
+/**
+ * @brief Network address of a PTP port, used for unicast messaging.
+ */
+typedef struct {
+    bool valid;    ///< The address is valid (if not, the multicast group is addressed)
+    uint32_t ip;   ///< IPv4 address in network byte order (IPv4 transport)
+    uint8_t hw[6]; ///< Ethernet hardware address (802.3 transport)
+} PtpNetAddr;
+
 /**
  * @brief Raw PTP message structure.
  */
@@ -193,6 +203,11 @@ typedef struct RawPtpMessage_ {
     TxCb *pTxCb;             ///< transmit callback function
     PtpDelayMechanism tx_dm; ///< transmit transport type
     PtpMessageClass tx_mc;   ///< transmit message class
+    bool tx_1step;           ///< one-step message, the origin timestamp gets inserted on transmission
+    bool tx_drop;            ///< released by the transmit path instead of being passed to the network stack driver (load generator)
+
+    // --- addressing ---
+    PtpNetAddr addr; ///< unicast destination (transmit) or source address (receive)
 
     // --- data ---
     uint8_t data[MAX_PTP_MSG_SIZE]; ///< raw packet data
@@ -301,7 +316,7 @@ typedef enum {
  * @brief Enumeration for logarithmic message period boundaries.
  */
 typedef enum {
-    PTP_LOGPER_MIN = -3,         ///< Minimal logarithmic messaging period
+    PTP_LOGPER_MIN = -7,         ///< Minimal logarithmic messaging period
     PTP_LOGPER_MAX = 4,          ///< Maximal logarithmic messaging period
     PTP_LOGPER_SYNCMATCHED = 127 ///< Messaging occurs whenever a Sync arrives
 } PtpLogMsgPeriods;
@@ -318,16 +333,63 @@ typedef enum {
     PTP_BMCA_DISABLED
 } PtpBmcaFsmState;
 
+/**
+ * @brief Data set compared by the BMCA: an Announce body (or the default data set of this clock)
+ * completed with the identities of the sending and the receiving ports.
+ */
+typedef struct {
+    const PtpAnnounceBody *pAnn;    ///< Announce body
+    uint64_t senderClockIdentity;   ///< Clock identity of the port the Announce has been sent by
+    uint16_t senderPortNumber;      ///< Port number of the port the Announce has been sent by
+    uint64_t receiverClockIdentity; ///< Clock identity of the port the Announce has been received on
+    uint16_t receiverPortNumber;    ///< Port number of the port the Announce has been received on
+} PtpBmcaDataset;
+
+/**
+ * @brief Result of the data set comparison.
+ */
+typedef enum {
+    PTP_BMCA_A_BETTER = 0,         ///< A is better than B
+    PTP_BMCA_A_BETTER_BY_TOPOLOGY, ///< A is better than B by topology
+    PTP_BMCA_B_BETTER,             ///< B is better than A
+    PTP_BMCA_B_BETTER_BY_TOPOLOGY, ///< B is better than A by topology
+    PTP_BMCA_ERROR_1,              ///< The receiver and the sender of the data set are the same (the Announce has been looped back)
+    PTP_BMCA_ERROR_2               ///< A and B are the same (the Announce has been received twice)
+} PtpBmcaCompResult;
+
+/**
+ * @brief Foreign master record (an entry of the foreignMasterDS).
+ */
+typedef struct {
+    bool valid;                                      ///< The entry is in use
+    uint64_t clockIdentity;                          ///< Clock identity of the Announcing port
+    uint16_t portNumber;                             ///< Port number of the Announcing port
+    PtpNetAddr addr;                                 ///< Source address of the last Announce
+    PtpAnnounceBody announce;                        ///< Body of the last Announce
+    int8_t logAnnPeriod;                             ///< Announce period signalled by the foreign master
+    uint32_t annTicks[PTP_FOREIGN_MASTER_THRESHOLD]; ///< Reception ticks of the most recent Announces (ring)
+    uint8_t annIdx;                                  ///< Next write position in annTicks
+    uint8_t annCnt;                                  ///< Number of valid entries in annTicks
+    uint32_t annTotal;                               ///< Total number of Announces received from this source
+    uint32_t lastSeen;                               ///< Tick of the last Announce
+    bool qualified;                                  ///< Enough Announces have been received within the qualification window
+} PtpForeignMaster;
+
 /**
  * @brief BMCA state.
  */
 typedef struct {
-    PtpBmcaFsmState state;           ///< BMCA state
-    PtpMasterProperties masterProps; ///< Master clock properties
-    uint16_t masterAnnPer_ms;        ///< Message period of current master
-    uint16_t masterTOCntr;           ///< Current master announce dropout counter
-    uint32_t stateDuration;          ///< Heartbeat cycles since last state transition
-    bool preventMasterSwitchOver;    ///< Set if master switchover is prohibited
+    PtpBmcaFsmState state;                                          ///< BMCA state
+    PtpMasterProperties masterProps;                                ///< Master clock properties
+    uint16_t masterAnnPer_ms;                                       ///< Message period of current master
+    uint16_t masterTOCntr;                                          ///< Current master announce dropout counter
+    uint32_t stateDuration;                                         ///< Heartbeat cycles since last state transition
+    bool preventMasterSwitchOver;                                   ///< Set if master switchover is prohibited
+    PtpNetAddr masterAddr;                                          ///< Address of the current master (learnt from its Announce messages)
+    uint64_t masterPortClockIdentity;                               ///< Clock identity of the port of the current master, 0 if unknown
+    uint16_t masterPortNumber;                                      ///< Port number of the port of the current master
+    PtpForeignMaster foreignMasters[PTP_FOREIGN_MASTER_TABLE_SIZE]; ///< Foreign master dataset
+    int8_t bestForeignMaster;                                       ///< Index of the best qualified foreign master, -1 if none
 } PtpBmcaState;
 
 /**
@@ -347,7 +409,8 @@ typedef enum {
     PTP_PF_NO_FLAGS = 0x00,                                   ///< Empty profile flags
     PTP_PF_ISSUE_SYNC_FOR_COMPLIANT_SLAVE_ONLY_IN_P2P = 0x01, ///< Send Sync messages only for a compliant peer in P2P mode
     PTP_PF_SLAVE_ONLY = 0x02,                                 ///< Operating only in SLAVE mode
-    PTP_PF_N                                                  ///< Number of available PTP profile flags
+    PTP_PF_HYBRID = 0x04,                                     ///< Hybrid mode: multicast Sync, unicast Delay_Req and Delay_Resp in E2E mode
+    PTP_PF_N = 4                                              ///< Number of available PTP profile flags (plus one)
 } PtpProfileFlags;
 
 /**
@@ -406,6 +469,57 @@ typedef struct {
     PTP_TLV_HEADER
 } PtpTlvHeader;
 
+/**
+ * @brief Message types that can be negotiated for unicast transmission.
+ */
+typedef enum {
+    PTP_UCM_ANNOUNCE = 0, ///< Announce
+    PTP_UCM_SYNC,         ///< Sync (and Follow_Up)
+    PTP_UCM_DELAY_RESP,   ///< Delay_Resp
+    PTP_UCM_N             ///< Number of negotiable message types
+} PtpUnicastMsg;
+
+/**
+ * @brief Unicast transmission grant (requested by the slave or issued by the master).
+ */
+typedef struct {
+    uint32_t remTicks;    ///< Ticks remaining until the grant expires (0: no grant)
+    uint32_t tmr;         ///< Request retry timer (slave) or transmission timer (master)
+    uint32_t periodTicks; ///< Transmission period in ticks (master)
+    uint32_t acc_us;      ///< Time accumulated towards the next Sync transmission in microseconds (master)
+    uint16_t sequenceID;  ///< Sequence ID of the next message sent to the grantee (master)
+    int8_t logPeriod;     ///< Granted log. message period
+} PtpUnicastGrant;
+
+/**
+ * @brief Entry of the unicast master table (slave side).
+ */
+typedef struct {
+    PtpNetAddr addr;                   ///< Address of the master
+    PtpUnicastGrant grants[PTP_UCM_N]; ///< Grants received from the master
+} PtpUnicastMasterEntry;
+
+/**
+ * @brief Entry of the grant table (master side).
+ */
+typedef struct {
+    PtpNetAddr addr;                   ///< Address of the grantee
+    uint64_t clockIdentity;            ///< Clock identity of the grantee
+    uint16_t portNumber;               ///< Port number of the grantee
+    PtpUnicastGrant grants[PTP_UCM_N]; ///< Grants issued to the grantee
+} PtpUnicastGrantee;
+
+/**
+ * @brief Unicast negotiation state.
+ */
+typedef struct {
+    bool enabled;                                                 ///< Unicast negotiation is enabled
+    uint32_t grantDuration_s;                                     ///< Duration requested in REQUEST_UNICAST_TRANSMISSION TLVs (s)
+    uint16_t signalingSequenceID;                                 ///< Sequence ID of the next Signaling message
+    PtpUnicastMasterEntry masters[PTP_UNICAST_MASTER_TABLE_SIZE]; ///< Unicast master table (slave side)
+    PtpUnicastGrantee grantees[PTP_UNICAST_GRANT_TABLE_SIZE];     ///< Grant table (master side)
+} PtpUnicastState;
+
 /**
  * @brief PTP slave messaging state structure.
  */
@@ -415,8 +529,30 @@ typedef struct {
     PtpM2SState m2sState;                     ///< Sync-FollowUp state
     int8_t logSyncPeriod;                     ///< logarithm of Sync interval
     uint16_t syncPeriodMs;                    ///< Sync interval in milliseconds
+    uint16_t delReqTsSequenceID;              ///< Sequence ID of the (P)Delay_Req whose transmit timestamp has been fetched
+    bool delReqTsFetched;                     ///< The transmit timestamp of a (P)Delay_Req has been fetched
 } PtpSlaveMessagingState;
 
+/**
+ * @brief Hot-standby master tracking state.
+ */
+typedef struct {
+    bool enabled;             ///< Hot-standby tracking is enabled
+    uint64_t clockIdentity;   ///< Clock identity of the port of the tracked standby master, 0 if none
+    uint16_t portNumber;      ///< Port number of the port of the tracked standby master
+    PtpM2SState m2sState;     ///< Sync-FollowUp state of the standby
+    uint16_t sequenceID;      ///< Sequence ID of the last Sync of the standby
+    uint16_t syncPeriodMs;    ///< Sync interval of the standby in milliseconds
+    PtpSyncCycleData scd;     ///< Sync cycle data of the standby
+    TimestampI meanPathDelay; ///< Mean path delay towards the standby (E2E only)
+    bool mpdValid;            ///< The mean path delay towards the standby has been measured
+    TimestampI offset;        ///< Time error of our clock relative to the standby
+    bool offsetValid;         ///< The time error has been measured
+    uint32_t lastSyncTick;    ///< Tick of the last completed Sync cycle of the standby
+    uint32_t syncCycles;      ///< Number of completed Sync cycles of the standby
+    uint32_t failovers;       ///< Number of failovers onto the tracked standby
+} PtpSlaveStandbyState;
+
 /**
  * @brief PTP master messaging state structure.
  */
@@ -425,6 +561,86 @@ typedef struct {
     uint16_t announceSequenceID; ///< Sequence ID of the next Announce message
 } PtpMasterMessagingState;
 
+/**
+ * @brief E2E slave session tracked by the master.
+ */
+typedef struct {
+    uint64_t clockIdentity; ///< Clock identity of the slave
+    uint16_t portNumber;    ///< Port number of the slave
+    uint16_t pendingSlot;   ///< Index of the pending Delay_Resp in the response queue (PTP_SESSION_NO_SLOT if none)
+    uint32_t lastSeen;      ///< Tick of the last Delay_Req reception
+    uint32_t delReqCnt;     ///< Number of Delay_Reqs received
+    PtpNetAddr addr;        ///< Source address of the last Delay_Req
+    bool used;              ///< This entry is occupied
+} PtpMasterSession;
+
+/**
+ * @brief Delay_Resp awaiting transmission.
+ */
+typedef struct {
+    uint64_t clockIdentity;    ///< Requesting clock identity
+    uint64_t correction_ns;    ///< Correction field of the Delay_Req (ns part)
+    uint32_t correction_subns; ///< Correction field of the Delay_Req (sub-ns part)
+    TimestampI t4;             ///< Delay_Req reception timestamp
+    PtpNetAddr addr;           ///< Unicast destination (if valid)
+    uint16_t portNumber;       ///< Requesting port number
+    uint16_t sequenceID;       ///< Sequence ID of the Delay_Req
+    int8_t logMessagePeriod;   ///< Log. message period field of the Delay_Req
+    bool synthetic;            ///< Response to a load generator Delay_Req, dropped by the transmit path
+} PtpPendingDelayResp;
+
+/**
+ * @brief Master E2E slave session state.
+ */
+typedef struct {
+    PtpMasterSession table[PTP_MASTER_SESSION_TABLE_SIZE];         ///< Session hash table (open addressing)
+    uint16_t active;                                               ///< Number of active sessions
+    PtpPendingDelayResp queue[PTP_MASTER_DELAY_RESP_QUEUE_LENGTH]; ///< Delay_Resp queue
+    uint16_t queueHead;                                            ///< Index of the oldest pending Delay_Resp
+    uint16_t queueLevel;                                           ///< Number of pending Delay_Resps
+    uint32_t delayRespSent;                                        ///< Number of Delay_Resps sent
+    uint32_t delayRespDropped;                                     ///< Number of Delay_Resps dropped on queue overflow
+    uint32_t delayRespCoalesced;                                   ///< Number of Delay_Resps superseded by a newer Delay_Req of the same slave
+    uint32_t delayRespConsumed;                                    ///< Number of synthetic Delay_Resps passed to the transmit queue (load generator)
+    uint32_t respRate;                                             ///< Delay_Resps sent in the last second
+    uint32_t prevSent;                                             ///< Sent counter at the beginning of the current second
+    uint16_t maxQueueLevel;                                        ///< Highest queue level observed
+} PtpMasterSessionState;
+
+/**
+ * @brief Result of a load generator run.
+ */
+typedef struct {
+    uint32_t duration_ms; ///< Length of the run
+    uint32_t offered;     ///< Number of synthetic Delay_Reqs fed into the session table
+    uint32_t served;      ///< Number of synthetic Delay_Resps passed to the transmit queue
+    uint32_t coalesced;   ///< Number of Delay_Resps coalesced during the run
+    uint32_t dropped;     ///< Number of Delay_Resps dropped during the run
+    uint32_t respRate;    ///< Average number of served Delay_Resps per second
+} PtpLoadGenResult;
+
+/**
+ * @brief Two-step Sync awaiting its transmit timestamp and Follow_Up.
+ */
+typedef struct {
+    PtpNetAddr addr;      ///< Destination of the Sync (invalid if multicast)
+    uint32_t enqueueTick; ///< Tick the Sync was passed to the transmit queue
+    uint16_t sequenceID;  ///< Sequence ID of the Sync
+    bool used;            ///< This slot is occupied
+} PtpMasterSyncSlot;
+
+/**
+ * @brief Ring of outstanding two-step Syncs.
+ */
+typedef struct {
+    PtpMasterSyncSlot slots[PTP_MASTER_SYNC_SLOTS]; ///< Sync slots
+    uint8_t next;                                   ///< Index of the next slot to be allocated
+    uint8_t outstanding;                            ///< Number of occupied slots
+    uint8_t maxOutstanding;                         ///< Highest number of occupied slots observed
+    uint32_t skipped;                               ///< Number of Syncs not sent since all slots were occupied
+    uint32_t expired;                               ///< Number of Syncs whose transmit timestamp has never arrived
+} PtpMasterSyncSlotState;
+
 /**
  * @brief PTP P2P slave state viewed from the MASTER.
  */
@@ -435,13 +651,18 @@ typedef enum {
 } PtpP2PSlaveState;
 
 /**
- * @brief PTP P2P slave info structure;
+ * @brief PTP P2P slave (peer) info structure.
  */
 typedef struct {
-    PtpP2PSlaveState state; ///< Indicates that a slave is responding to our PDELAY_REQ messages
-    uint64_t identity;      ///< The clock identity of the connected, operating P2P slave
-    uint16_t reportCount;   ///< Number of times the slave had reported in
-    uint16_t dropoutCntr;   ///< Dropout watchdog counter for resetting the state machine if the slave went silent
+    PtpP2PSlaveState state;   ///< Indicates that the peer is responding to our PDELAY_REQ messages (PTP_P2PSS_NONE: free entry)
+    uint64_t identity;        ///< The clock identity of the peer
+    uint16_t portNumber;      ///< The port number of the peer
+    uint16_t reportCount;     ///< Number of times the peer had reported in
+    uint16_t dropoutCntr;     ///< Dropout watchdog counter for dropping the peer if it went silent
+    bool expectFollowUp;      ///< Expect a PDelay_Resp_Follow_Up from this peer
+    bool linkDelayValid;      ///< The link delay has been measured at least once
+    PtpSyncCycleData scd;     ///< Timestamps of the current PDelay_Req...PDelay_Resp(_Follow_Up) cycle
+    TimestampI linkDelay;     ///< Last measured mean link delay to the peer
 } PtpP2PSlaveInfo;
 
 /**
@@ -455,6 +676,24 @@ typedef struct {
 #endif
 } PtpHWClockState;
 
+/**
+ * @brief Link speeds distinguished when compensating ingress/egress latencies.
+ */
+typedef enum {
+    PTP_LS_10M = 0, ///< 10 Mbps
+    PTP_LS_100M,    ///< 100 Mbps
+    PTP_LS_1G,      ///< 1 Gbps
+    PTP_LS_N        ///< Number of distinguished link speeds
+} PtpLinkSpeed;
+
+/**
+ * @brief Ingress and egress latencies between the timestamping point and the reference plane.
+ */
+typedef struct {
+    int32_t ingress_ns[PTP_LS_N]; ///< Ingress latencies per link speed (ns)
+    int32_t egress_ns[PTP_LS_N];  ///< Egress latencies per link speed (ns)
+} PtpPortLatencies;
+
 /**
  * @brief Network state.
  */
@@ -462,14 +701,139 @@ typedef struct {
     TimestampI meanPathDelay; ///< mean path delay
 } PtpNetworkState;
 
+/**
+ * @brief State of a frequency memory restored from a stored configuration.
+ */
+typedef enum {
+    PTP_WS_NONE = 0, ///< No frequency memory has been restored
+    PTP_WS_PENDING,  ///< Frequency memory restored, its age is not yet checked against the master's time
+    PTP_WS_ACCEPTED, ///< Frequency memory accepted, the next fast compensation may skip the skew estimation
+} PtpWarmStartState;
+
+/**
+ * @brief Frequency memory stored in the configuration.
+ */
+typedef struct {
+    uint64_t savedAt_s; ///< PTP time of storing the frequency memory (s)
+    uint32_t samples;   ///< Number of samples the frequency memory is built of, 0 if not stored
+    double freq_ppb;    ///< Averaged frequency tuning
+    double freqVar;     ///< Variance of the frequency tuning (ppb^2)
+    double aging_ppbps; ///< Estimated linear frequency drift (ppb/s)
+} PtpWarmStart;
+
+/**
+ * @brief Holdover state and frequency memory.
+ */
+typedef struct {
+    bool active;                 ///< Holdover is running
+    bool agingEn;                ///< Apply the linear aging model during holdover
+    uint32_t samples;            ///< Number of samples the frequency memory is built of
+    double freq_ppb;             ///< Averaged frequency tuning
+    double freqVar;              ///< Variance of the frequency tuning (ppb^2)
+    double aging_ppbps;          ///< Estimated linear frequency drift (ppb/s)
+    uint32_t startTick;          ///< Tick at which the holdover has been entered
+    double startTimeError;       ///< Filtered time error at entering the holdover (ns)
+    PtpWarmStartState warmStart; ///< State of the frequency memory restored from a stored configuration
+    uint64_t savedAt_s;          ///< PTP time of storing the restored frequency memory (s)
+} PtpHoldoverState;
+
 /**
  * @brief Structure for statistics.
  */
 typedef struct {
-    double filtTimeErr; ///< 0.1Hz lowpass-filtered time error
-    bool locked;        ///< is the PTP locked to defined limit?
+    double filtTimeErr;          ///< 0.1Hz lowpass-filtered time error
+    bool locked;                 ///< is the PTP locked to defined limit?
+    bool holdover;               ///< is the clock in holdover?
+    uint32_t holdoverDuration_s; ///< time spent in holdover (s)
+    double holdoverTimeErrEst;   ///< estimated time error bound accumulated during holdover (ns)
+    uint32_t timeToLock_ms;      ///< duration of the last acquisition until reaching the LOCKED state (ms)
 } PtpStats;
 
+/**
+ * @brief Octave of the stability statistics: the time error decimated into blocks of 2^k samples.
+ */
+typedef struct {
+    double mean[2];  ///< Mean time error of the previous two blocks, the latter is the most recent (ns)
+    double last[2];  ///< Last time error of the previous two blocks (ns)
+    double max, min; ///< Extremes of the most recent block (ns)
+    uint32_t blocks; ///< Number of blocks since the last discontinuity
+    uint32_t n;      ///< Number of second differences accumulated
+    double adevSum;  ///< Sum of the squared second differences of the decimated time error (ns^2)
+    double tdevSum;  ///< Sum of the squared second differences of the block means (ns^2)
+    double mtie;     ///< Maximum time interval error over the octave's observation interval (ns)
+} PtpStabilityOctave;
+
+/**
+ * @brief Streaming stability statistics (ADEV, TDEV and MTIE) with fixed memory.
+ */
+typedef struct {
+    int8_t logPeriod;                                  ///< Logarithmic sampling period, the observation intervals are its octaves
+    bool continuous;                                   ///< The next sample directly follows the previous one
+    uint32_t samples;                                  ///< Number of samples fed
+    PtpStabilityOctave octaves[PTP_STABILITY_OCTAVES]; ///< Octaves of the observation interval
+} PtpStabilityState;
+
+/**
+ * @brief Stability figures at a single observation interval.
+ */
+typedef struct {
+    double tau_s;   ///< Observation interval (s)
+    uint32_t n;     ///< Number of second differences ADEV and TDEV are estimated from
+    double adev;    ///< Allan deviation (dimensionless)
+    double tdev_ns; ///< Time deviation (ns)
+    double mtie_ns; ///< Maximum time interval error (ns)
+} PtpStabilityPoint;
+
+/**
+ * @brief Quantities whose distribution is collected.
+ */
+typedef enum {
+    PTP_HQ_TIME_ERROR = 0, ///< Absolute time error (ns)
+    PTP_HQ_PATH_DELAY,     ///< Mean path delay (ns)
+    PTP_HQ_CORRECTION,     ///< Absolute servo correction (PPB)
+    PTP_HQ_N               ///< Number of collected quantities
+} PtpHistQuantity;
+
+#define PTP_HIST_BUCKETS (PTP_HIST_OCTAVES * PTP_HIST_SUB_BUCKETS + 1) ///< Number of histogram buckets: [0, 1) unit and the divided octaves above
+#define PTP_HIST_QUANTILES (3)                                          ///< Number of streaming percentiles (p50, p99, p99.9)
+
+/**
+ * @brief Log-scale histogram with fixed buckets.
+ */
+typedef struct {
+    uint32_t count;                     ///< Number of samples
+    double max;                         ///< Largest sample
+    uint32_t buckets[PTP_HIST_BUCKETS]; ///< Sample counts of the buckets
+} PtpHistogram;
+
+/**
+ * @brief Streaming quantile estimator (P-square algorithm) with five markers.
+ */
+typedef struct {
+    double q[5];  ///< Marker heights
+    double np[5]; ///< Desired marker positions
+    int32_t n[5]; ///< Actual marker positions
+} PtpQuantileSketch;
+
+/**
+ * @brief Percentiles over a window.
+ */
+typedef struct {
+    uint32_t count;               ///< Number of samples in the window
+    double p[PTP_HIST_QUANTILES]; ///< p50, p99 and p99.9
+    double max;                   ///< Largest sample in the window
+} PtpHistWindow;
+
+/**
+ * @brief Distribution of a quantity: histogram since the last clearing and percentiles over windows.
+ */
+typedef struct {
+    PtpHistogram hist;                            ///< Histogram since the last clearing
+    PtpQuantileSketch sketch[PTP_HIST_QUANTILES]; ///< Estimators of the current window
+    PtpHistWindow window;                         ///< Current window (percentiles are filled on window completion)
+    PtpHistWindow last;                           ///< Last completed window
+} PtpDistribution;
+
 /**
  * Sync callback type prototype.
  */
@@ -495,6 +859,43 @@ typedef enum { PTP_FC_IDLE = 0,                    ///< Fast correction algorith
                PTP_FC_TIME_CORRECTION_PROPAGATION, ///< Waiting for the effects of time correction to propagate
 } PtpFastCompState;
 
+/**
+ * @brief Fast compensation parameters.
+ */
+typedef struct {
+    uint8_t skewMaxSamples; ///< Maximum number of Sync samples collected for skew estimation
+    uint8_t timeCorrCycles; ///< Number of time correction cycles
+    uint8_t propCycles;     ///< Number of cycles to wait for the time correction to propagate
+    float skewCiLimit_ppb;  ///< Skew estimation terminates once the confidence interval gets narrower than this
+} PtpFastCompParams;
+
+/**
+ * @brief Adaptive (P)Delay_Req rate state.
+ */
+typedef struct {
+    bool enabled;        ///< Adaptive (P)Delay_Req rate is enabled
+    uint8_t maxBackoff;  ///< Maximum number of log. period steps the rate may back off from the profile's period
+    int8_t logPeriod;    ///< Current log. period of (P)Delay_Req transmissions
+    uint16_t stableCntr; ///< Number of consecutive (P)Delay_Req periods spent in stable conditions
+    uint16_t mpdSamples; ///< Number of path delay samples the filter has been fed with
+    double mpdMean;      ///< Filtered mean path delay (ns)
+    double mpdVar;       ///< Variance of the mean path delay (ns^2)
+} PtpAdaptiveDelReqState;
+
+/**
+ * @brief Least squares skew estimator state.
+ */
+typedef struct {
+    uint8_t n;         ///< Number of collected samples
+    TimestampI t1_0;   ///< Master time of the first sample
+    TimestampI d_0;    ///< Time offset of the first sample
+    double sx, sy;     ///< Sums of the sample coordinates
+    double sxx, sxy;   ///< Sums of the second order products
+    double syy;        ///< Sum of the squared offsets
+    double skew;       ///< Last skew estimate
+    double ci_ppb;     ///< Half-width of the confidence interval of the last skew estimate (PPB)
+} PtpSkewEstimator;
+
 /**
  * @brief Giant PTP core state object.
  */
@@ -505,9 +906,12 @@ typedef struct {
     PtpHWClockState hwclock; ///< Hardware clock state
 
     struct {
-        TimestampI offset;      ///< PPS signal offset
-        uint64_t clockIdentity; ///< clockIdentity calculated from MAC address
-    } hwoptions;                ///< Hardware options
+        TimestampI offset;          ///< PPS signal offset
+        TimestampI delayAsymmetry;  ///< Link delay asymmetry (master-to-slave delay minus the mean path delay)
+        PtpPortLatencies latencies; ///< Ingress and egress latencies
+        PtpLinkSpeed linkSpeed;     ///< Current link speed, selects the latencies to be applied
+        uint64_t clockIdentity;     ///< clockIdentity calculated from MAC address
+    } hwoptions;                    ///< Hardware options
 
     PtpBmcaState bmca;       ///< BMCA state
     PtpNetworkState network; ///< Network state
@@ -526,6 +930,10 @@ typedef struct {
     } logging;             ///< Logging
 
     PtpStats stats;                   ///< Statistics
+    PtpStabilityState stability;      ///< Stability statistics
+    PtpDistribution dist[PTP_HQ_N];   ///< Distribution statistics
+    PtpHoldoverState holdover;        ///< Holdover state
+    PtpUnicastState unicast;          ///< Unicast negotiation state
     PtpUserEventCallback userEventCb; ///< User event callback pointer
 
     /* ---- SLAVE ----- */
@@ -538,13 +946,21 @@ typedef struct {
         bool expectPDelRespFollowUp;      ///< Expect a PDelay_Resp_Follow_Up message
         PtpFastCompState fastCompState;   ///< State of fast compensation
         uint8_t fastCompCntr;             ///< Cycle counter for fast compensation
+        PtpFastCompParams fastCompParams; ///< Fast compensation parameters
+        PtpSkewEstimator skewEst;         ///< Skew estimator of the fast compensation
+        bool acquiring;                   ///< An acquisition (cold start or coarse correction) is in progress
+        uint32_t acqStartTick;            ///< Tick at which the current acquisition has started
         TimestampI prevSyncMa;            ///< T1 from the previous cycle
         TimestampI prevSyncSl;            ///< T2 from the previous cycle
         TimestampI prevTimeError;         ///< Time error in the previous cycle
         uint64_t coarseLimit;             ///< time error limit above coarse correction is engaged
 
-        uint32_t delReqTickPeriod; ///< ticks between Delay_Req transmissions
-        uint32_t delReqTmr;        ///< Timer counting ticks for Delay_Req transmissions
+        uint32_t delReqTickPeriod;          ///< ticks between Delay_Req transmissions (at least one)
+        uint32_t delReqPeriod_us;           ///< Delay_Req transmission period in microseconds
+        uint32_t delReqAcc_us;              ///< Time accumulated towards the next Delay_Req transmission in microseconds
+        PtpAdaptiveDelReqState adaptDelReq; ///< Adaptive (P)Delay_Req rate state
+
+        PtpSlaveStandbyState standby; ///< Hot-standby master tracking state
 
         PtpSyncCallback syncCb; ///< Sync callback invoked in every synchronization cycle
     } slave;
@@ -552,21 +968,26 @@ typedef struct {
     /* ---- MASTER ----- */
 
     struct {
-        bool enabled; ///< Master module is enabled
+        bool enabled;     ///< Master module is enabled
+        bool oneStepSync; ///< Transmit one-step Sync messages
 
-        PtpP2PSlaveInfo p2pSlave;      ///< Information on the connected P2P slave (only used in P2P modes)
-        uint32_t pdelay_reqSequenceID; ///< Sequence number of the last PDelay_Request sent
-        PtpSyncCycleData scd;          ///< Sync cycle data
-        bool expectPDelRespFollowUp;   ///< Expect a PDelay_Resp_Follow_Up message
+        PtpP2PSlaveInfo p2pPeers[PTP_MASTER_P2P_PEER_TABLE_SIZE]; ///< Peers responding to our PDelay_Reqs (only used in P2P modes)
+        uint32_t pdelay_reqSequenceID;                            ///< Sequence number of the last PDelay_Request sent
+        TimestampI pdelayReqT1;                                   ///< Transmission time of the last PDelay_Req
+        bool pdelayReqT1Valid;                                    ///< The transmission time of the last PDelay_Req has been fetched
 
         PtpMasterMessagingState messaging; ///< Messaging state
-
-        uint32_t syncTickPeriod;      ///< Sync transmission period in ticks
-        uint32_t syncTmr;             ///< Counter for scheduling Sync transmission
-        uint32_t announceTickPeriod;  ///< Announce transmission in ticks
-        uint32_t announceTmr;         ///< Counter to schedule Announce transmission
-        uint32_t pdelayReqTickPeriod; ///< PDelayReq transmission period in ticks
-        uint32_t pdelayReqTmr;        ///< Counter for PDelayReq transmission scheduling
+        PtpMasterSessionState sessions;    ///< E2E slave sessions and pending Delay_Resps
+        PtpMasterSyncSlotState syncSlots;  ///< Outstanding two-step Syncs
+
+        int8_t logSyncPeriod;         ///< Sync log. period in effect (not shorter than PTP_LOGPER_SYNC_MIN)
+        uint32_t syncPeriod_us;       ///< Sync transmission period in microseconds
+        uint32_t syncAcc_us;          ///< Time accumulated towards the next Sync transmission in microseconds
+        uint32_t announcePeriod_us;   ///< Announce transmission period in microseconds
+        uint32_t announceAcc_us;      ///< Time accumulated towards the next Announce transmission in microseconds
+        uint32_t pdelayReqPeriod_us;  ///< PDelayReq transmission period in microseconds
+        uint32_t pdelayReqAcc_us;     ///< Time accumulated towards the next PDelayReq transmission in microseconds
+        uint32_t pdelayReqTickPeriod; ///< PDelayReq transmission period in ticks (at least one)
     } master;
 } PtpCoreState;
 
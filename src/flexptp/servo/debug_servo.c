@@ -75,7 +75,7 @@ static void register_cli_cmds() {
 #ifdef CLI_REMOVE_CMD
 static void remove_cli_cmds() {
     for (uint8_t i = 0; i < DS_CMDH_N; i++) {
-        CLI_REMOVE_CMD(i);
+        CLI_REMOVE_CMD(cmd_handles[i]);
     }
 }
 #endif
@@ -96,6 +96,10 @@ void debug_servo_deinit() {
 #endif
 }
 
+void debug_servo_print_params() {
+    MSG("Skew offset: %.4f ppb, time offset: %i ns\n", skew0, dt0);
+}
+
 void debug_servo_reset() {
     skew0 = 0.0;
     dt0 = 0.0;
@@ -136,4 +140,39 @@ retain_cycle_data:
     }
 
     return tuning_ppb;
-}
\ No newline at end of file
+}
+
+// ---------------
+
+static void debug_servo_reset_inst(void *pState) {
+    (void)pState;
+    debug_servo_reset();
+}
+
+static float debug_servo_run_inst(void *pState, int32_t dt, PtpServoAuxInput *pAux) {
+    (void)pState;
+    return debug_servo_run(dt, pAux);
+}
+
+static void debug_servo_print_params_inst(const void *pState) {
+    (void)pState;
+    debug_servo_print_params();
+}
+
+static void *debug_servo_get_default() {
+    return NULL;
+}
+
+const PtpServo gDebugServo = {
+    "debug",
+    0,
+    debug_servo_init,
+    debug_servo_deinit,
+    debug_servo_get_default,
+    NULL,
+    debug_servo_reset_inst,
+    debug_servo_run_inst,
+    debug_servo_print_params_inst,
+    NULL,
+    NULL,
+};
@@ -9,6 +9,8 @@
 extern "C" {
 #endif
 
+extern const PtpServo gDebugServo; ///< Debug servo descriptor (cannot be instantiated)
+
 /**
  * Initialize the debug servo.
  */
@@ -32,6 +34,11 @@ void debug_servo_reset();
  */
 float debug_servo_run(int32_t dt, PtpServoAuxInput * pAux);
 
+/**
+ * Print the debug servo parameters.
+ */
+void debug_servo_print_params();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,232 @@
+/**
+ ******************************************************************************
+ * @file    fixed_point.h
+ * @copyright András Wiesner, 2026-\showdate "%Y"
+ * @brief   Q-format fixed-point arithmetic on 64-bit integers for the
+ * fixed-point servo variants. Multiplication is carried out on 32-bit partial
+ * products, so no 128-bit type or floating point unit is needed.
+ ******************************************************************************
+ */
+
+#ifndef SERVO_FIXED_POINT_H_
+#define SERVO_FIXED_POINT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int64_t fxp_t; ///< Fixed-point number (the position of the binary point depends on the quantity)
+
+#define FXP_MAX (INT64_MAX) ///< Largest fixed-point number
+#define FXP_MIN (-INT64_MAX) ///< Smallest fixed-point number
+
+#define FXP_FRAC_SIG (32) ///< Fractional bits of signals (time error in ns, frequency in ppb): Q32.32
+#define FXP_FRAC_COEF (40) ///< Fractional bits of coefficients (gains, durations in s, covariances): Q24.40
+
+#define FXP_ONE(frac) ((fxp_t)1 << (frac)) ///< One in a given format
+
+#define FXP_CONST(x, frac) ((fxp_t)((x) * (double)FXP_ONE(frac) + 0.5)) ///< Convert a non-negative constant in compile time
+
+/**
+ * Convert a floating point number to fixed-point. Only to be used on the parameter setting paths.
+ *
+ * @param x number to convert
+ * @param frac number of fractional bits
+ * @return fixed-point number
+ */
+static inline fxp_t fxp_from_double(double x, uint8_t frac) {
+    double r = x * (double)FXP_ONE(frac);
+    if (r >= 9.2E+18) {
+        return FXP_MAX;
+    } else if (r <= -9.2E+18) {
+        return FXP_MIN;
+    }
+    return (fxp_t)((r >= 0.0) ? (r + 0.5) : (r - 0.5));
+}
+
+/**
+ * Convert a fixed-point number to floating point.
+ *
+ * @param a number to convert
+ * @param frac number of fractional bits
+ * @return floating point number
+ */
+static inline double fxp_to_double(fxp_t a, uint8_t frac) {
+    return (double)a / (double)FXP_ONE(frac);
+}
+
+/**
+ * Saturating addition.
+ *
+ * @param a first term
+ * @param b second term
+ * @return a + b
+ */
+static inline fxp_t fxp_add(fxp_t a, fxp_t b) {
+    if ((b > 0) && (a > FXP_MAX - b)) {
+        return FXP_MAX;
+    } else if ((b < 0) && (a < FXP_MIN - b)) {
+        return FXP_MIN;
+    }
+    return a + b;
+}
+
+/**
+ * Saturating subtraction.
+ *
+ * @param a minuend
+ * @param b subtrahend
+ * @return a - b
+ */
+static inline fxp_t fxp_sub(fxp_t a, fxp_t b) {
+    return fxp_add(a, -b);
+}
+
+/**
+ * Saturating multiplication: (a * b) >> shift, rounded towards zero.
+ * The 128-bit product is assembled from four 32x32->64 bit partial products.
+ *
+ * @param a first factor
+ * @param b second factor
+ * @param shift number of bits the product is shifted right (1...63)
+ * @return product
+ */
+static inline fxp_t fxp_mul(fxp_t a, fxp_t b, uint8_t shift) {
+    bool neg = (a < 0) != (b < 0);
+    uint64_t ua = (a < 0) ? -(uint64_t)a : (uint64_t)a;
+    uint64_t ub = (b < 0) ? -(uint64_t)b : (uint64_t)b;
+
+    // partial products
+    uint64_t al = (uint32_t)ua, ah = ua >> 32;
+    uint64_t bl = (uint32_t)ub, bh = ub >> 32;
+    uint64_t p0 = al * bl;
+    uint64_t p1 = al * bh;
+    uint64_t p2 = ah * bl;
+    uint64_t p3 = ah * bh;
+
+    // assemble the 128-bit product
+    uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+    uint64_t lo = (uint32_t)p0 | (mid << 32);
+    uint64_t hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+
+    // shift and saturate
+    if ((hi >> shift) != 0) {
+        return neg ? FXP_MIN : FXP_MAX;
+    }
+    uint64_t r = (hi << (64 - shift)) | (lo >> shift);
+    if (r > (uint64_t)FXP_MAX) {
+        return neg ? FXP_MIN : FXP_MAX;
+    }
+    return neg ? -(fxp_t)r : (fxp_t)r;
+}
+
+/**
+ * Saturating division: (a << shift) / b. Both operands are normalized before the 64-bit division,
+ * so the quotient keeps about 31 significant bits independently of the magnitudes.
+ *
+ * @param a dividend
+ * @param b divisor
+ * @param shift number of bits the dividend is shifted left (0...63)
+ * @return quotient
+ */
+static inline fxp_t fxp_div(fxp_t a, fxp_t b, uint8_t shift) {
+    bool neg = (a < 0) != (b < 0);
+    uint64_t ua = (a < 0) ? -(uint64_t)a : (uint64_t)a;
+    uint64_t ub = (b < 0) ? -(uint64_t)b : (uint64_t)b;
+
+    if (ub == 0) {
+        return neg ? FXP_MIN : FXP_MAX;
+    } else if (ua == 0) {
+        return 0;
+    }
+
+    // move the dividend to the top, keep the divisor on 32 bits
+    int8_t sa = __builtin_clzll(ua) - 1;
+    ua <<= sa;
+    int8_t sb = 32 - __builtin_clzll(ub);
+    if (sb > 0) {
+        ub >>= sb;
+    } else {
+        sb = 0;
+    }
+
+    uint64_t q = ua / ub;
+
+    // undo the normalization
+    int8_t e = shift - sa - sb;
+    if (e >= 0) {
+        if ((e > 62) || ((q >> (63 - e)) != 0)) {
+            return neg ? FXP_MIN : FXP_MAX;
+        }
+        q <<= e;
+    } else {
+        q = (e < -63) ? 0 : (q >> -e);
+    }
+
+    return neg ? -(fxp_t)q : (fxp_t)q;
+}
+
+/**
+ * Exponential function.
+ *
+ * @param x exponent in Q24.40, must be less than ln(2^23)
+ * @return e^x in Q24.40
+ */
+static inline fxp_t fxp_exp(fxp_t x) {
+    // 1/k! in Q24.40
+    static const fxp_t c[] = {
+        0x10000000000LL, 0x10000000000LL, 0x8000000000LL, 0x2AAAAAAAABLL, 0xAAAAAAAABLL,
+        0x222222222LL, 0x5B05B05BLL, 0xD00D00DLL, 0x1A01A02LL, 0x2E3BC7LL};
+    const fxp_t log2e = 0x171547652B8LL; // log2(e) in Q24.40
+    const fxp_t ln2 = 0xB17217F7D2LL;    // ln(2) in Q24.40
+
+    // e^x = 2^(x * log2(e)) = 2^k * 2^f, where k is an integer and 0 <= f < 1
+    fxp_t y = fxp_mul(x, log2e, FXP_FRAC_COEF);
+    int32_t k = (int32_t)(y >> FXP_FRAC_COEF); // floor
+    fxp_t f = y - ((fxp_t)k << FXP_FRAC_COEF);
+
+    // 2^f = e^(f * ln2) by the Taylor polynomial in Horner's form (the remainder is below 1E-8 in [0, ln2))
+    fxp_t t = fxp_mul(f, ln2, FXP_FRAC_COEF);
+    fxp_t sum = c[9];
+    for (int8_t i = 8; i >= 0; i--) {
+        sum = c[i] + fxp_mul(sum, t, FXP_FRAC_COEF);
+    }
+
+    // scale by 2^k
+    if (k >= 0) {
+        return (k >= 23) ? FXP_MAX : (sum << k);
+    } else {
+        return (k <= -63) ? 0 : (sum >> -k);
+    }
+}
+
+/**
+ * Convert a duration in nanoseconds to seconds.
+ *
+ * @param ns duration in nanoseconds
+ * @return duration in seconds in Q24.40
+ */
+static inline fxp_t fxp_ns_to_s(int64_t ns) {
+    const fxp_t nsInS = 0x44B82FA09B5A5400LL; // 1E-09 in Q.92
+    return fxp_mul(ns, nsInS, 92 - FXP_FRAC_COEF);
+}
+
+/**
+ * Convert a fixed-point number to single precision floating point.
+ *
+ * @param a number to convert
+ * @param frac number of fractional bits
+ * @return floating point number
+ */
+static inline float fxp_to_float(fxp_t a, uint8_t frac) {
+    return (float)a / (float)FXP_ONE(frac);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVO_FIXED_POINT_H_ */
@@ -4,6 +4,7 @@
  */
 
 #include "kalman_filter.h"
+#include "../minmax.h"
 #include "../ptp_defs.h"
 
 #include <math.h>
@@ -13,20 +14,6 @@
 
 #include <flexptp_options.h>
 
-/* ---- DEFAULT PARAMETERS ---- */
-
-#ifndef SIGMA_THETA_SQUARED
-#define SIGMA_THETA_SQUARED (1E-16)
-#endif
-
-#ifndef SIGMA_GAMMA_SQUARED
-#define SIGMA_GAMMA_SQUARED (1E-12)
-#endif
-
-#ifndef SIGMA_CT_SQUARED
-#define SIGMA_CT_SQUARED (1E-10)
-#endif
-
 /* ---- FAST TUNING PARAMETERS ---- */
 
 #define FAST_TUNING_THRESHOLD (500E-09)
@@ -35,19 +22,20 @@
 
 // ----------------
 
-typedef double mtx[2][2];
-typedef double vec[2];
+typedef double mtx[KALMAN_STATES][KALMAN_STATES];
+typedef double vec[KALMAN_STATES];
+typedef double mtx2[2][2]; // innovation covariance (offset and skew measurements)
 
-#define MTX_ELEMENTWISE(ctx)              \
-    for (uint8_t i = 0; i < 2; i++) {     \
-        for (uint8_t j = 0; j < 2; j++) { \
-            ctx                           \
-        }                                 \
+#define MTX_ELEMENTWISE(ctx)                          \
+    for (uint8_t i = 0; i < KALMAN_STATES; i++) {     \
+        for (uint8_t j = 0; j < KALMAN_STATES; j++) { \
+            ctx                                       \
+        }                                             \
     }
 
-#define VEC_ELEMENTWISE(ctx)          \
-    for (uint8_t i = 0; i < 2; i++) { \
-        ctx                           \
+#define VEC_ELEMENTWISE(ctx)                      \
+    for (uint8_t i = 0; i < KALMAN_STATES; i++) { \
+        ctx                                       \
     }
 
 static void mtx_copy(mtx dst, mtx src) {
@@ -60,26 +48,14 @@ static void mtx_add(mtx r, mtx a, mtx b) {
         r[i][j] = a[i][j] + b[i][j];)
 }
 
-static void mtx_sub(mtx r, mtx a, mtx b) {
-    MTX_ELEMENTWISE(
-        r[i][j] = a[i][j] - b[i][j];)
-}
-
-static void mtx_scale(mtx r, double c, mtx a) {
-    MTX_ELEMENTWISE(
-        r[i][j] = c * a[i][j];)
-}
-
 static void mtx_dot(vec r, mtx m, vec v) {
     VEC_ELEMENTWISE(
-        r[i] = m[i][0] * v[0] + m[i][1] * v[1];)
+        r[i] = m[i][0] * v[0] + m[i][1] * v[1] + m[i][2] * v[2];)
 }
 
 static void mtx_mul(mtx r, mtx a, mtx b) {
-    r[0][0] = a[0][0] * b[0][0] + a[0][1] * b[1][0];
-    r[0][1] = a[0][0] * b[0][1] + a[0][1] * b[1][1];
-    r[1][0] = a[1][0] * b[0][0] + a[1][1] * b[1][0];
-    r[1][1] = a[1][0] * b[0][1] + a[1][1] * b[1][1];
+    MTX_ELEMENTWISE(
+        r[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];)
 }
 
 static void mtx_transp(mtx r, mtx m) {
@@ -87,23 +63,6 @@ static void mtx_transp(mtx r, mtx m) {
         r[i][j] = m[j][i];)
 }
 
-static double mtx_det(mtx m) {
-    return m[0][0] * m[1][1] - m[0][1] * m[1][0];
-}
-
-static void mtx_inverse(mtx r, mtx m) {
-    r[0][0] = m[1][1];
-    r[0][1] = -m[0][1];
-    r[1][0] = -m[1][0];
-    r[1][1] = m[0][0];
-
-    mtx_scale(r, 1 / mtx_det(m), r);
-}
-
-static void mtx_print(mtx m) {
-    MSG("%.4f   %.4f\n%.4f   %.4f\n", m[0][0], m[0][1], m[1][0], m[1][1]);
-}
-
 static void mtx_zero(mtx m) {
     MTX_ELEMENTWISE(
         m[i][j] = 0;)
@@ -119,49 +78,34 @@ static void vec_copy(vec r, vec v) {
         r[i] = v[i];)
 }
 
-static void vec_add(vec r, vec a, vec b) {
-    VEC_ELEMENTWISE(
-        r[i] = a[i] + b[i];)
-}
-
-static void vec_sub(vec r, vec a, vec b) {
-    VEC_ELEMENTWISE(
-        r[i] = a[i] - b[i];)
-}
-
 static void vec_zero(vec v) {
     VEC_ELEMENTWISE(
         v[i] = 0;)
 }
 
+static void mtx2_inverse(mtx2 r, mtx2 m) {
+    double rdet = 1 / (m[0][0] * m[1][1] - m[0][1] * m[1][0]);
+    r[0][0] = rdet * m[1][1];
+    r[0][1] = rdet * -m[0][1];
+    r[1][0] = rdet * -m[1][0];
+    r[1][1] = rdet * m[0][0];
+}
+
 #define SQR(x) ((x) * (x))
 
 // ----------------
 
-/* ---- KALMAN FILTER VARIABLES ---- */
+static KalmanFilterState sDefault; ///< Default instance driven by the CLI commands
 
-static mtx A;     // system matrix
-static mtx B;     // input matrix
-static mtx H;     // output matrix
-static vec u;     // control input
-static mtx Q;     // process noise covariance
-static mtx K;     // Kalman gain
-static mtx P;     // a posteriori error covariance matrix
-static mtx P_pri; // a priori P error covariance matrix
-static mtx R;     // measurement covariance matrix
-static mtx I;     // identity matrix
-static vec z;     // measurements
-static vec x_pri; // a priori state estimator
-static vec x;     // a posteriori state estimator
-
-static double sigma_theta_squared;   // offset process variance (normalized)
-static double sigma_gamma_squared;   // skew process variance (normalized)
-static double sigma_theta_m_squared; // measurement variance (normalized)
-
-/* ---- OTHER VARIABLES ---- */
-
-static uint64_t cycle;  // cycle counter
-static int32_t dt_prev; // previous time error
+/**
+ * Print the innovation gating counters and the estimated measurement noise.
+ *
+ * @param pS pointer to the filter instance
+ */
+static void kalman_filter_print_gating(const KalmanFilterState *pS) {
+    MSG("gating: %u rejected, %u down-weighted, %u restarts, measurement variance: %e (x%.4f)\n",
+        pS->rejected, pS->downweighted, pS->restarts, pS->r_scale * pS->sigma_theta_m_squared, pS->r_scale);
+}
 
 // --------------
 
@@ -173,42 +117,68 @@ static int32_t dt_prev; // previous time error
 
 static CMD_FUNCTION(sts) {
     if (argc > 0) {
-        if (!strcat("default", ppArgs[0])) {
-            sigma_theta_squared = SIGMA_THETA_SQUARED;
+        if (!strcmp("default", ppArgs[0])) {
+            sDefault.sigma_theta_squared = SIGMA_THETA_SQUARED;
         } else {
-            sigma_theta_squared = atof(ppArgs[0]);
+            sDefault.sigma_theta_squared = atof(ppArgs[0]);
         }
     }
 
-    MSG("sigma_theta^2 = %e\n", sigma_theta_squared);
+    MSG("sigma_theta^2 = %e\n", sDefault.sigma_theta_squared);
 
     return 0;
 }
 
 static CMD_FUNCTION(sgs) {
     if (argc > 0) {
-        if (!strcat("default", ppArgs[0])) {
-            sigma_gamma_squared = SIGMA_GAMMA_SQUARED;
+        if (!strcmp("default", ppArgs[0])) {
+            sDefault.sigma_gamma_squared = SIGMA_GAMMA_SQUARED;
         } else {
-            sigma_gamma_squared = atof(ppArgs[0]);
+            sDefault.sigma_gamma_squared = atof(ppArgs[0]);
         }
     }
 
-    MSG("sigma_gamma^2 = %e\n", sigma_gamma_squared);
+    MSG("sigma_gamma^2 = %e\n", sDefault.sigma_gamma_squared);
 
     return 0;
 }
 
 static CMD_FUNCTION(stms) {
     if (argc > 0) {
-        if (!strcat("default", ppArgs[0])) {
-            sigma_theta_m_squared = SIGMA_CT_SQUARED;
+        if (!strcmp("default", ppArgs[0])) {
+            sDefault.sigma_theta_m_squared = SIGMA_CT_SQUARED;
+        } else {
+            sDefault.sigma_theta_m_squared = atof(ppArgs[0]);
+        }
+    }
+
+    MSG("sigma_theta_m^2 = %e\n", sDefault.sigma_theta_m_squared);
+
+    return 0;
+}
+
+static CMD_FUNCTION(sds) {
+    if (argc > 0) {
+        if (!strcmp("default", ppArgs[0])) {
+            sDefault.sigma_delta_squared = SIGMA_DELTA_SQUARED;
         } else {
-            sigma_theta_m_squared = atof(ppArgs[0]);
+            sDefault.sigma_delta_squared = atof(ppArgs[0]);
         }
     }
 
-    MSG("sigma_theta_m^2 = %e\n", sigma_theta_m_squared);
+    MSG("sigma_delta^2 = %e\n", sDefault.sigma_delta_squared);
+
+    return 0;
+}
+
+static CMD_FUNCTION(gate) {
+    if ((argc > 0) && !strcmp("clear", ppArgs[0])) {
+        sDefault.rejected = 0;
+        sDefault.downweighted = 0;
+        sDefault.restarts = 0;
+    }
+
+    kalman_filter_print_gating(&sDefault);
 
     return 0;
 }
@@ -218,7 +188,9 @@ static CMD_FUNCTION(stms) {
 typedef enum {
     KF_CMDH_SIGMA_THETA_SQ = 0,
     KF_CMDH_SIGMA_GAMMA_SQ,
+    KF_CMDH_SIGMA_DELTA_SQ,
     KF_CMDH_SIGMA_THETA_M_SQ,
+    KF_CMDH_GATE,
     KF_CMDH_N
 } KalmanFilterCmdHandle;
 
@@ -227,13 +199,15 @@ static int cmd_handles[KF_CMDH_N];
 static void register_cmd_commands() {
     cmd_handles[KF_CMDH_SIGMA_THETA_SQ] = CLI_REG_CMD("ptp servo st [var|default] \t\t\t Set or get sigma_theta^2 (s^2)", 3, 0, sts);
     cmd_handles[KF_CMDH_SIGMA_GAMMA_SQ] = CLI_REG_CMD("ptp servo sg [var|default] \t\t\t Set or get sigma_gamma^2 (s^2)", 3, 0, sgs);
+    cmd_handles[KF_CMDH_SIGMA_DELTA_SQ] = CLI_REG_CMD("ptp servo sd [var|default] \t\t\t Set or get sigma_delta^2 (1/s^2)", 3, 0, sds);
     cmd_handles[KF_CMDH_SIGMA_THETA_M_SQ] = CLI_REG_CMD("ptp servo stm [var|default] \t\t\t Set or get sigma_theta_m^2 (s^2)", 3, 0, stms);
+    cmd_handles[KF_CMDH_GATE] = CLI_REG_CMD("ptp servo gate [clear] \t\t\t Print or clear the innovation gating counters", 3, 0, gate);
 }
 
 #ifdef CLI_REMOVE_CMD
 static void remove_cmd_commands() {
     for (uint8_t i = 0; i < KF_CMDH_N; i++) {
-        CLI_REMOVE_CMD(i);
+        CLI_REMOVE_CMD(cmd_handles[i]);
     }
 }
 #endif
@@ -242,141 +216,285 @@ static void remove_cmd_commands() {
 
 // --------------
 
-static void init_variances() {
-    sigma_theta_squared = SIGMA_THETA_SQUARED;
-    sigma_gamma_squared = SIGMA_GAMMA_SQUARED;
-    sigma_theta_m_squared = 0.5 * SIGMA_CT_SQUARED;
-}
-
-void kalman_filter_init() {
-#ifdef CLI_REG_CMD
-    register_cmd_commands();
-#endif
-
-    kalman_filter_reset();
-    init_variances();
-}
+static void kalman_filter_reset_inst(void *pState) {
+    KalmanFilterState *pS = (KalmanFilterState *)pState;
 
-void kalman_filter_deinit() {
-#ifdef CLI_REMOVE_CMD
-    remove_cmd_commands();
-#endif
-}
-
-void kalman_filter_reset() {
     // reset matrices and vectors
-    mtx_unit(A);
-    mtx_unit(B);
-    mtx_unit(H);
-    vec_zero(u);
-    mtx_zero(Q);
-    mtx_zero(K);
-    mtx_copy(P_pri, Q);
-    mtx_zero(P);
-    mtx_unit(I);
-    vec_zero(z);
-    vec_zero(x_pri);
-    vec_zero(x);
-
-    // reset cycle count and previous time error
-    cycle = 0;
-    dt_prev = 0;
+    mtx_zero(pS->P);
+    vec_zero(pS->x);
+    pS->u = 0;
+
+    // reset cycle count, previous time error and the rejection run (the noise estimate and the counters are kept)
+    pS->rejectRun = 0;
+    pS->cycle = 0;
+    pS->dt_prev = 0;
 }
 
-static void insert_DT(double DT) {
-    A[0][1] = DT;
-    B[0][1] = -DT;
+static void kalman_filter_create(void *pState) {
+    KalmanFilterState *pS = (KalmanFilterState *)pState;
 
-    Q[0][0] = DT * sigma_theta_squared;
-    Q[1][1] = DT * sigma_gamma_squared;
+    kalman_filter_reset_inst(pS);
 
-    R[0][0] = sigma_theta_m_squared;
-    R[0][1] = R[1][0] = sigma_theta_m_squared / DT;
-    R[1][1] = 2.0 * sigma_theta_m_squared / SQR(DT);
+    // initialize variances
+    pS->sigma_theta_squared = SIGMA_THETA_SQUARED;
+    pS->sigma_gamma_squared = SIGMA_GAMMA_SQUARED;
+    pS->sigma_delta_squared = SIGMA_DELTA_SQUARED;
+    pS->sigma_theta_m_squared = 0.5 * SIGMA_CT_SQUARED;
+
+    // initialize the noise estimate and the counters
+    pS->r_scale = 1.0;
+    pS->rejected = 0;
+    pS->downweighted = 0;
+    pS->restarts = 0;
 }
 
-float kalman_filter_run(int32_t dt, PtpServoAuxInput *pAux) {
+static float kalman_filter_run_inst(void *pState, int32_t dt, PtpServoAuxInput *pAux) {
+    KalmanFilterState *pS = (KalmanFilterState *)pState;
     double tuning_ppb = 0.0;
+    int32_t dt_retained = dt;
 
     // in the very first cycle skip running the filter
-    if (cycle == 0) {
+    if (pS->cycle == 0) {
         goto retain_cycle_data;
     }
 
     /* ---- PREPARE THE PARAMETERS ---- */
 
     // calculate input data
-    double skew = ((double)(dt - dt_prev)) / ((double)pAux->measSyncPeriodNs); // skew
-    double offset = ((double)dt) * 1E-09;                                      // offset in seconds
+    double skew = ((double)(dt - pS->dt_prev)) / ((double)pAux->measSyncPeriodNs); // skew
+    double offset = ((double)dt) * 1E-09;                                          // offset in seconds
 
     // compose measurement vector
-    z[0] = offset;
-    z[1] = skew;
+    double z[2] = {offset, skew};
 
-    // inject DT into relevant places
+    // inject DT into the system, process noise and measurement covariance matrices
     double DT = ((double)pAux->measSyncPeriodNs) * 1E-09;
-    insert_DT(DT);
+
+    mtx A;
+    mtx_unit(A);
+    A[0][1] = DT;
+    A[0][2] = 0.5 * SQR(DT);
+    A[1][2] = DT;
+
+    mtx Q;
+    mtx_zero(Q);
+    Q[0][0] = DT * pS->sigma_theta_squared;
+    Q[1][1] = DT * pS->sigma_gamma_squared;
+    Q[2][2] = DT * pS->sigma_delta_squared;
+
+    mtx2 R;
+    R[0][0] = pS->r_scale * pS->sigma_theta_m_squared;
+    R[0][1] = R[1][0] = R[0][0] / DT;
+    R[1][1] = 2.0 * R[0][0] / SQR(DT);
 
     /* ---- RUN THE FILTER ---- */
 
-    if (cycle == 1) {
-        mtx_copy(P, Q); // P(1|0) = Q
-        vec_copy(x, z); // x = z
+    if (pS->cycle == 1) {
+        goto restart_filter;
     }
 
     // prediction equations
 
-    // (27)
-    vec Ax, Bu;
-    mtx_dot(Ax, A, x);      // Ax = A * x(n-1)
-    mtx_dot(Bu, B, u);      // Bu = B * u(n-1)
-    vec_add(x_pri, Ax, Bu); // x(n|n-1) = Ax + Bu
+    // (27) x(n|n-1) = A * x(n-1) + B * u(n-1), the tuning acts on the skew over the whole period: B = [DT 1 0]'
+    vec x_pri;
+    mtx_dot(x_pri, A, pS->x);
+    x_pri[0] += DT * pS->u;
+    x_pri[1] += pS->u;
+
+    // (28) P(n|n-1) = A * P * A' + Q
+    mtx AP, At, APAt, P_pri;
+    mtx_mul(AP, A, pS->P);
+    mtx_transp(At, A);
+    mtx_mul(APAt, AP, At);
+    mtx_add(P_pri, APAt, Q);
+
+    // innovation and its covariance (only the offset and the skew are measured: H = [I 0])
+    double y[2] = {z[0] - x_pri[0], z[1] - x_pri[1]};
+    mtx2 S, Sinv;
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint8_t j = 0; j < 2; j++) {
+            S[i][j] = P_pri[i][j] + R[i][j];
+        }
+    }
+    mtx2_inverse(Sinv, S);
+
+    // normalized innovation squared, chi-square distributed with 2 degrees of freedom
+    double d2 = y[0] * (Sinv[0][0] * y[0] + Sinv[0][1] * y[1]) + y[1] * (Sinv[1][0] * y[0] + Sinv[1][1] * y[1]);
+
+    // measurement noise sample from the offset innovation: E{y0^2} = P(n|n-1)[0][0] + R[0][0]
+    double r_sample = (SQR(y[0]) - P_pri[0][0]) / pS->sigma_theta_m_squared;
+
+    // innovation gating
+    if ((KALMAN_GATE_REJECT > 0) && (d2 > KALMAN_GATE_REJECT)) {
+        pS->rejectRun++;
+        if (pS->rejectRun > KALMAN_GATE_MAX_REJECTS) {
+            // the measurements have moved for real (the path has changed or the noise has grown):
+            // raise the noise estimate and restart the offset from the measurement, keep the skew and the drift
+            pS->restarts++;
+            pS->rejectRun = 0;
+            pS->r_scale = MIN(MAX(pS->r_scale, r_sample), KALMAN_R_SCALE_MAX);
+            vec_copy(pS->x, x_pri);
+            mtx_copy(pS->P, P_pri);
+            pS->x[0] = z[0];
+            pS->P[0][0] += pS->r_scale * pS->sigma_theta_m_squared;
+            goto determine_tuning;
+        }
+
+        // keep the prediction, substitute the predicted offset for the next skew measurement
+        pS->rejected++;
+        vec_copy(pS->x, x_pri);
+        mtx_copy(pS->P, P_pri);
+        dt_retained = (int32_t)lround(x_pri[0] * 1E+09);
+        goto determine_tuning;
+    }
+    pS->rejectRun = 0;
+
+    // estimate the measurement noise (the configured variance is the lower limit by default)
+    if (KALMAN_R_ADAPT_RATE > 0) {
+        pS->r_scale = (1.0 - KALMAN_R_ADAPT_RATE) * pS->r_scale + KALMAN_R_ADAPT_RATE * r_sample;
+        pS->r_scale = MIN(MAX(pS->r_scale, KALMAN_R_SCALE_MIN), KALMAN_R_SCALE_MAX);
+    }
 
-    // (28)
-    mtx AP, At, APAt;
-    mtx_mul(AP, A, P);       // AP = A * P
-    mtx_transp(At, A);       // At = A'
-    mtx_mul(APAt, AP, At);   // APAt = AP * At
-    mtx_add(P_pri, APAt, Q); // P(n|n-1) = APAt + Q
+    // down-weight suspicious measurements by inflating their covariance
+    if ((KALMAN_GATE_REJECT > 0) && (d2 > KALMAN_GATE_SOFT)) {
+        pS->downweighted++;
+        double w = d2 / KALMAN_GATE_SOFT;
+        for (uint8_t i = 0; i < 2; i++) {
+            for (uint8_t j = 0; j < 2; j++) {
+                S[i][j] = P_pri[i][j] + w * R[i][j];
+            }
+        }
+        mtx2_inverse(Sinv, S);
+    }
 
     // correction equations
 
-    // (30)
-    mtx P_priR, P_priRinv;
-    mtx_add(P_priR, P_pri, R);      // P_priR = P(n|n-1) + R
-    mtx_inverse(P_priRinv, P_priR); // P_priRinv = (P_priR)^(-1)
-    mtx_mul(K, P_pri, P_priRinv);   // K = P(n|n-1) * P_priRinv
+    // (30) K = P(n|n-1) * H' * S^(-1)
+    double K[KALMAN_STATES][2];
+    for (uint8_t i = 0; i < KALMAN_STATES; i++) {
+        for (uint8_t j = 0; j < 2; j++) {
+            K[i][j] = P_pri[i][0] * Sinv[0][j] + P_pri[i][1] * Sinv[1][j];
+        }
+    }
+
+    // (31) x = x(n|n-1) + K * y
+    VEC_ELEMENTWISE(
+        pS->x[i] = x_pri[i] + K[i][0] * y[0] + K[i][1] * y[1];)
+
+    // (32) P = (I - K * H) * P(n|n-1)
+    MTX_ELEMENTWISE(
+        pS->P[i][j] = P_pri[i][j] - (K[i][0] * P_pri[0][j] + K[i][1] * P_pri[1][j]);)
 
-    // (31)
-    vec zxpri, Kzxpri;
-    vec_sub(zxpri, z, x_pri);  // zxpri = z - x(n|n-1)
-    mtx_dot(Kzxpri, K, zxpri); // Kzxpri = K * zxpri
-    vec_add(x, x_pri, Kzxpri); // x = x(n|n-1) + Kzxpri
+    goto determine_tuning;
 
-    // (32)
-    mtx IK;
-    mtx_sub(IK, I, K);     // IK = I - K
-    mtx_mul(P, IK, P_pri); // P = IK * P(n|n-1)
+    // start the filter from the measurement, the offset and the skew are as uncertain as the measurement itself
+restart_filter:
+    mtx_copy(pS->P, Q); // P(1|0) = [R 0; 0 Q]
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint8_t j = 0; j < 2; j++) {
+            pS->P[i][j] = R[i][j];
+        }
+    }
+    pS->x[0] = z[0]; // x = [z 0]'
+    pS->x[1] = z[1];
+    pS->x[2] = 0;
 
     /* ---- TUNING ---- */
 
-    // determine tuning
-    double tuning_coefficient = (fabs(x[0]) > FAST_TUNING_THRESHOLD) ? FAST_TUNING_COEFFICIENT : CALM_TUNING_COEFFICIENT;
-    double tuning = -x[1] + ((-x[0] * 1E+09 / pAux->measSyncPeriodNs) * tuning_coefficient);
+determine_tuning:;
+    // cancel the skew expected over the next period, remove a portion of the offset
+    double tuning_coefficient = (fabs(pS->x[0]) > FAST_TUNING_THRESHOLD) ? FAST_TUNING_COEFFICIENT : CALM_TUNING_COEFFICIENT;
+    double tuning = -(pS->x[1] + 0.5 * DT * pS->x[2]) + ((-pS->x[0] / DT) * tuning_coefficient);
     tuning_ppb = tuning * 1E+09;
 
     // feed back tuning
-    u[0] = 0;
-    u[1] = tuning;
-
-    //MSG(PTP_COLOR_YELLOW "%12f" PTP_COLOR_BGREEN " %12f\n" PTP_COLOR_RESET, x[0] * 1E+09, x[1] * 1E+09);
+    pS->u = tuning;
 
     /* ---- DATA RETENTION ---- */
 
 retain_cycle_data:
-    dt_prev = dt;
+    pS->dt_prev = dt_retained;
 
-    cycle++;
+    pS->cycle++;
 
     return tuning_ppb;
-}
\ No newline at end of file
+}
+
+static void kalman_filter_print_params_inst(const void *pState) {
+    const KalmanFilterState *pS = (const KalmanFilterState *)pState;
+    MSG("sigma_theta^2 = %e\n", pS->sigma_theta_squared);
+    MSG("sigma_gamma^2 = %e\n", pS->sigma_gamma_squared);
+    MSG("sigma_delta^2 = %e\n", pS->sigma_delta_squared);
+    MSG("sigma_theta_m^2 = %e\n", pS->sigma_theta_m_squared);
+    kalman_filter_print_gating(pS);
+}
+
+static bool kalman_filter_set_params_inst(void *pState, const double *pParams, uint8_t paramCnt) {
+    if ((paramCnt < 3) || (paramCnt > 4)) {
+        return false;
+    }
+
+    KalmanFilterState *pS = (KalmanFilterState *)pState;
+    pS->sigma_theta_squared = pParams[0];
+    pS->sigma_gamma_squared = pParams[1];
+    pS->sigma_theta_m_squared = pParams[2];
+    if (paramCnt > 3) {
+        pS->sigma_delta_squared = pParams[3];
+    }
+    return true;
+}
+
+static uint8_t kalman_filter_get_params_inst(const void *pState, double *pParams) {
+    const KalmanFilterState *pS = (const KalmanFilterState *)pState;
+    pParams[0] = pS->sigma_theta_squared;
+    pParams[1] = pS->sigma_gamma_squared;
+    pParams[2] = pS->sigma_theta_m_squared;
+    pParams[3] = pS->sigma_delta_squared;
+    return 4;
+}
+
+static void *kalman_filter_get_default() {
+    return &sDefault;
+}
+
+// --------------
+
+void kalman_filter_init() {
+#ifdef CLI_REG_CMD
+    register_cmd_commands();
+#endif
+
+    kalman_filter_create(&sDefault);
+}
+
+void kalman_filter_deinit() {
+#ifdef CLI_REMOVE_CMD
+    remove_cmd_commands();
+#endif
+}
+
+void kalman_filter_print_params() {
+    kalman_filter_print_params_inst(&sDefault);
+}
+
+void kalman_filter_reset() {
+    kalman_filter_reset_inst(&sDefault);
+}
+
+float kalman_filter_run(int32_t dt, PtpServoAuxInput *pAux) {
+    return kalman_filter_run_inst(&sDefault, dt, pAux);
+}
+
+const PtpServo gKalmanFilterServo = {
+    "kalman",
+    sizeof(KalmanFilterState),
+    kalman_filter_init,
+    kalman_filter_deinit,
+    kalman_filter_get_default,
+    kalman_filter_create,
+    kalman_filter_reset_inst,
+    kalman_filter_run_inst,
+    kalman_filter_print_params_inst,
+    kalman_filter_set_params_inst,
+    kalman_filter_get_params_inst,
+};
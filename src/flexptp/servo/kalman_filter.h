@@ -11,9 +11,81 @@ extern "C" {
 
 /** A Kalman-filter based servo. This module implements the Kalman-filter introduced in the paper: 
  * 'Performance Analysis of Kalman-Filter-Based Clock Synchronization in IEEE 1588 Networks' by 
- * Giada Gorgi and Claudio Narduzzi (https://ieeexplore.ieee.org/document/5934411)
+ * Giada Gorgi and Claudio Narduzzi (https://ieeexplore.ieee.org/document/5934411), extended by
+ * a frequency drift state, chi-square innovation gating and online estimation of the measurement noise.
  */
 
+/* ---- DEFAULT PARAMETERS ---- */
+
+#ifndef SIGMA_THETA_SQUARED
+#define SIGMA_THETA_SQUARED (1E-16) ///< Offset process variance
+#endif
+
+#ifndef SIGMA_GAMMA_SQUARED
+#define SIGMA_GAMMA_SQUARED (1E-12) ///< Skew process variance
+#endif
+
+#ifndef SIGMA_DELTA_SQUARED
+#define SIGMA_DELTA_SQUARED (1E-18) ///< Drift process variance
+#endif
+
+#ifndef SIGMA_CT_SQUARED
+#define SIGMA_CT_SQUARED (1E-10) ///< Measurement variance (twice the variance of a single timestamp difference)
+#endif
+
+/* ---- INNOVATION GATING AND NOISE ESTIMATION ---- */
+
+#ifndef KALMAN_GATE_SOFT
+#define KALMAN_GATE_SOFT (5.991) ///< Chi-square (2 DoF) limit above which a measurement gets down-weighted (95%)
+#endif
+
+#ifndef KALMAN_GATE_REJECT
+#define KALMAN_GATE_REJECT (13.816) ///< Chi-square (2 DoF) limit above which a measurement gets rejected (99.9%), 0 disables the gating
+#endif
+
+#ifndef KALMAN_GATE_MAX_REJECTS
+#define KALMAN_GATE_MAX_REJECTS (4) ///< Number of consecutive rejections after which the filter restarts from the measurement
+#endif
+
+#ifndef KALMAN_R_ADAPT_RATE
+#define KALMAN_R_ADAPT_RATE (0.01) ///< Smoothing factor of the measurement noise estimation, 0 disables the estimation
+#endif
+
+#ifndef KALMAN_R_SCALE_MIN
+#define KALMAN_R_SCALE_MIN (1.0) ///< Lower limit of the estimated measurement variance relative to the configured one
+#endif
+
+#ifndef KALMAN_R_SCALE_MAX
+#define KALMAN_R_SCALE_MAX (1E+02) ///< Upper limit of the estimated measurement variance relative to the configured one
+#endif
+
+#define KALMAN_STATES (3) ///< Number of states: offset, skew and drift
+
+/**
+ * @brief Kalman-filter instance.
+ */
+typedef struct {
+    double P[KALMAN_STATES][KALMAN_STATES]; ///< A posteriori error covariance matrix
+    double x[KALMAN_STATES];                ///< A posteriori state estimator: offset (s), skew, drift (1/s)
+    double u;                               ///< Control input: last tuning
+
+    double sigma_theta_squared;   ///< Offset process variance (normalized)
+    double sigma_gamma_squared;   ///< Skew process variance (normalized)
+    double sigma_delta_squared;   ///< Drift process variance (normalized)
+    double sigma_theta_m_squared; ///< Measurement variance (normalized)
+
+    double r_scale;        ///< Estimated measurement variance relative to the configured one
+    uint32_t rejected;     ///< Number of measurements rejected by the innovation gate
+    uint32_t downweighted; ///< Number of measurements down-weighted by the innovation gate
+    uint32_t restarts;     ///< Number of restarts after consecutive rejections
+    uint8_t rejectRun;     ///< Number of consecutive rejections
+
+    uint64_t cycle;  ///< Cycle counter
+    int32_t dt_prev; ///< Previous time error
+} KalmanFilterState;
+
+extern const PtpServo gKalmanFilterServo; ///< Kalman-filter servo descriptor
+
 /**
  * Initialize the Kalman-filter.
  */
@@ -37,6 +109,11 @@ void kalman_filter_reset();
  */
 float kalman_filter_run(int32_t dt, PtpServoAuxInput * pAux);
 
+/**
+ * Print the Kalman-filter parameters.
+ */
+void kalman_filter_print_params();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,520 @@
+/** Fixed-point variant of the Kalman-filter servo. The filter equations are the same as the ones
+ * of the floating point servo, but the offset, skew and drift are expressed in nanoseconds, PPB and PPB/s, and the
+ * covariances are divided by the measurement variance. Floating point arithmetic is only used
+ * when the parameters are set or printed.
+ */
+
+#include "kalman_filter_fxp.h"
+#include "../minmax.h"
+#include "../ptp_defs.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <flexptp_options.h>
+
+/* ---- FAST TUNING PARAMETERS ---- */
+
+#define FAST_TUNING_THRESHOLD (FXP_CONST(500, FXP_FRAC_SIG))
+#define FAST_TUNING_COEFFICIENT (FXP_CONST(0.2, FXP_FRAC_COEF))
+#define CALM_TUNING_COEFFICIENT (FXP_CONST(0.01, FXP_FRAC_COEF))
+
+/* ---- INNOVATION GATING AND NOISE ESTIMATION ---- */
+
+#define GATE_SOFT (FXP_CONST(KALMAN_GATE_SOFT, FXP_FRAC_SIG))
+#define GATE_REJECT (FXP_CONST(KALMAN_GATE_REJECT, FXP_FRAC_SIG))
+#define R_ADAPT_RATE (FXP_CONST(KALMAN_R_ADAPT_RATE, FXP_FRAC_COEF))
+#define R_SCALE_MIN (FXP_CONST(KALMAN_R_SCALE_MIN, FXP_FRAC_COEF))
+#define R_SCALE_MAX (FXP_CONST(KALMAN_R_SCALE_MAX, FXP_FRAC_COEF))
+
+// the drift is stored scaled up by 2^DRIFT_SHIFT, otherwise its covariances would lose their precision in Q24.40
+#define DRIFT_SHIFT (10)
+
+// ----------------
+
+typedef fxp_t mtx[KALMAN_STATES][KALMAN_STATES]; // Q24.40
+typedef fxp_t vec[KALMAN_STATES];                // Q32.32
+typedef fxp_t mtx2[2][2];                        // innovation covariance (offset and skew measurements), Q24.40
+
+#define ONE (FXP_ONE(FXP_FRAC_COEF))
+
+#define MTX_ELEMENTWISE(ctx)                          \
+    for (uint8_t i = 0; i < KALMAN_STATES; i++) {     \
+        for (uint8_t j = 0; j < KALMAN_STATES; j++) { \
+            ctx                                       \
+        }                                             \
+    }
+
+#define VEC_ELEMENTWISE(ctx)                      \
+    for (uint8_t i = 0; i < KALMAN_STATES; i++) { \
+        ctx                                       \
+    }
+
+#define MUL(a, b) (fxp_mul((a), (b), FXP_FRAC_COEF))
+
+static void mtx_copy(mtx dst, mtx src) {
+    MTX_ELEMENTWISE(
+        dst[i][j] = src[i][j];)
+}
+
+static void mtx_add(mtx r, mtx a, mtx b) {
+    MTX_ELEMENTWISE(
+        r[i][j] = fxp_add(a[i][j], b[i][j]);)
+}
+
+static void mtx_mul(mtx r, mtx a, mtx b) {
+    MTX_ELEMENTWISE(
+        r[i][j] = fxp_add(fxp_add(MUL(a[i][0], b[0][j]), MUL(a[i][1], b[1][j])), MUL(a[i][2], b[2][j]));)
+}
+
+static void mtx_transp(mtx r, mtx m) {
+    MTX_ELEMENTWISE(
+        r[i][j] = m[j][i];)
+}
+
+static void mtx_zero(mtx m) {
+    MTX_ELEMENTWISE(
+        m[i][j] = 0;)
+}
+
+static void vec_copy(vec r, vec v) {
+    VEC_ELEMENTWISE(
+        r[i] = v[i];)
+}
+
+static void vec_zero(vec v) {
+    VEC_ELEMENTWISE(
+        v[i] = 0;)
+}
+
+// inverse of a symmetric 2x2 matrix through the Schur complement, the determinant would overflow at high message rates
+static void mtx2_inverse(mtx2 r, mtx2 m) {
+    fxp_t g = fxp_div(m[0][1], m[0][0], FXP_FRAC_COEF);
+    fxp_t rsc = fxp_div(ONE, fxp_sub(m[1][1], MUL(g, m[0][1])), FXP_FRAC_COEF);
+    r[0][0] = fxp_add(fxp_div(ONE, m[0][0], FXP_FRAC_COEF), MUL(MUL(g, g), rsc));
+    r[0][1] = r[1][0] = -MUL(g, rsc);
+    r[1][1] = rsc;
+}
+
+// round a time error in ns (Q32.32) to an integer
+static int32_t fxp_round_ns(fxp_t a) {
+    a = fxp_add(a, FXP_ONE(FXP_FRAC_SIG - 1)) >> FXP_FRAC_SIG;
+    return (int32_t)MIN(MAX(a, INT32_MIN), INT32_MAX);
+}
+
+// ----------------
+
+static KalmanFilterFxpState sDefault; ///< Default instance driven by the CLI commands
+
+/**
+ * Recalculate the process variances normalized by the measurement variance.
+ *
+ * @param pS pointer to the filter instance
+ */
+static void kalman_filter_fxp_normalize(KalmanFilterFxpState *pS) {
+    pS->q_theta = fxp_from_double(pS->sigma_theta_squared / pS->sigma_theta_m_squared, FXP_FRAC_COEF);
+    pS->q_gamma = fxp_from_double(pS->sigma_gamma_squared / pS->sigma_theta_m_squared, FXP_FRAC_COEF);
+    pS->q_delta = fxp_from_double(pS->sigma_delta_squared / pS->sigma_theta_m_squared * (1 << (2 * DRIFT_SHIFT)), FXP_FRAC_COEF);
+    pS->inv_sigma_m = fxp_from_double(1E-09 / sqrt(pS->sigma_theta_m_squared), FXP_FRAC_COEF);
+}
+
+/**
+ * Print the innovation gating counters and the estimated measurement noise.
+ *
+ * @param pS pointer to the filter instance
+ */
+static void kalman_filter_fxp_print_gating(const KalmanFilterFxpState *pS) {
+    double r_scale = fxp_to_double(pS->r_scale, FXP_FRAC_COEF);
+    MSG("gating: %u rejected, %u down-weighted, %u restarts, measurement variance: %e (x%.4f)\n",
+        pS->rejected, pS->downweighted, pS->restarts, r_scale * pS->sigma_theta_m_squared, r_scale);
+}
+
+// --------------
+
+#ifdef CLI_REG_CMD
+
+#ifndef CMD_FUNCTION
+#error "No CMD_FUNCTION macro has been defined, cannot register CLI functions!"
+#endif
+
+static CMD_FUNCTION(sts) {
+    if (argc > 0) {
+        if (!strcmp("default", ppArgs[0])) {
+            sDefault.sigma_theta_squared = SIGMA_THETA_SQUARED;
+        } else {
+            sDefault.sigma_theta_squared = atof(ppArgs[0]);
+        }
+        kalman_filter_fxp_normalize(&sDefault);
+    }
+
+    MSG("sigma_theta^2 = %e\n", sDefault.sigma_theta_squared);
+
+    return 0;
+}
+
+static CMD_FUNCTION(sgs) {
+    if (argc > 0) {
+        if (!strcmp("default", ppArgs[0])) {
+            sDefault.sigma_gamma_squared = SIGMA_GAMMA_SQUARED;
+        } else {
+            sDefault.sigma_gamma_squared = atof(ppArgs[0]);
+        }
+        kalman_filter_fxp_normalize(&sDefault);
+    }
+
+    MSG("sigma_gamma^2 = %e\n", sDefault.sigma_gamma_squared);
+
+    return 0;
+}
+
+static CMD_FUNCTION(stms) {
+    if (argc > 0) {
+        double var = !strcmp("default", ppArgs[0]) ? SIGMA_CT_SQUARED : atof(ppArgs[0]);
+        if (var <= 0.0) {
+            return -1;
+        }
+        sDefault.sigma_theta_m_squared = var;
+        kalman_filter_fxp_normalize(&sDefault);
+    }
+
+    MSG("sigma_theta_m^2 = %e\n", sDefault.sigma_theta_m_squared);
+
+    return 0;
+}
+
+static CMD_FUNCTION(sds) {
+    if (argc > 0) {
+        if (!strcmp("default", ppArgs[0])) {
+            sDefault.sigma_delta_squared = SIGMA_DELTA_SQUARED;
+        } else {
+            sDefault.sigma_delta_squared = atof(ppArgs[0]);
+        }
+        kalman_filter_fxp_normalize(&sDefault);
+    }
+
+    MSG("sigma_delta^2 = %e\n", sDefault.sigma_delta_squared);
+
+    return 0;
+}
+
+static CMD_FUNCTION(gate) {
+    if ((argc > 0) && !strcmp("clear", ppArgs[0])) {
+        sDefault.rejected = 0;
+        sDefault.downweighted = 0;
+        sDefault.restarts = 0;
+    }
+
+    kalman_filter_fxp_print_gating(&sDefault);
+
+    return 0;
+}
+
+// --------------
+
+typedef enum {
+    KF_CMDH_SIGMA_THETA_SQ = 0,
+    KF_CMDH_SIGMA_GAMMA_SQ,
+    KF_CMDH_SIGMA_DELTA_SQ,
+    KF_CMDH_SIGMA_THETA_M_SQ,
+    KF_CMDH_GATE,
+    KF_CMDH_N
+} KalmanFilterCmdHandle;
+
+static int cmd_handles[KF_CMDH_N];
+
+static void register_cmd_commands() {
+    cmd_handles[KF_CMDH_SIGMA_THETA_SQ] = CLI_REG_CMD("ptp servo st [var|default] \t\t\t Set or get sigma_theta^2 (s^2)", 3, 0, sts);
+    cmd_handles[KF_CMDH_SIGMA_GAMMA_SQ] = CLI_REG_CMD("ptp servo sg [var|default] \t\t\t Set or get sigma_gamma^2 (s^2)", 3, 0, sgs);
+    cmd_handles[KF_CMDH_SIGMA_DELTA_SQ] = CLI_REG_CMD("ptp servo sd [var|default] \t\t\t Set or get sigma_delta^2 (1/s^2)", 3, 0, sds);
+    cmd_handles[KF_CMDH_SIGMA_THETA_M_SQ] = CLI_REG_CMD("ptp servo stm [var|default] \t\t\t Set or get sigma_theta_m^2 (s^2)", 3, 0, stms);
+    cmd_handles[KF_CMDH_GATE] = CLI_REG_CMD("ptp servo gate [clear] \t\t\t Print or clear the innovation gating counters", 3, 0, gate);
+}
+
+#ifdef CLI_REMOVE_CMD
+static void remove_cmd_commands() {
+    for (uint8_t i = 0; i < KF_CMDH_N; i++) {
+        CLI_REMOVE_CMD(cmd_handles[i]);
+    }
+}
+#endif
+
+#endif
+
+// --------------
+
+static void kalman_filter_fxp_reset_inst(void *pState) {
+    KalmanFilterFxpState *pS = (KalmanFilterFxpState *)pState;
+
+    // reset matrices and vectors
+    mtx_zero(pS->P);
+    vec_zero(pS->x);
+    pS->u = 0;
+
+    // reset cycle count, previous time error and the rejection run (the noise estimate and the counters are kept)
+    pS->rejectRun = 0;
+    pS->cycle = 0;
+    pS->dt_prev = 0;
+}
+
+static void kalman_filter_fxp_create(void *pState) {
+    KalmanFilterFxpState *pS = (KalmanFilterFxpState *)pState;
+
+    kalman_filter_fxp_reset_inst(pS);
+
+    // initialize variances
+    pS->sigma_theta_squared = SIGMA_THETA_SQUARED;
+    pS->sigma_gamma_squared = SIGMA_GAMMA_SQUARED;
+    pS->sigma_delta_squared = SIGMA_DELTA_SQUARED;
+    pS->sigma_theta_m_squared = 0.5 * SIGMA_CT_SQUARED;
+    kalman_filter_fxp_normalize(pS);
+
+    // initialize the noise estimate and the counters
+    pS->r_scale = ONE;
+    pS->rejected = 0;
+    pS->downweighted = 0;
+    pS->restarts = 0;
+}
+
+static float kalman_filter_fxp_run_inst(void *pState, int32_t dt, PtpServoAuxInput *pAux) {
+    KalmanFilterFxpState *pS = (KalmanFilterFxpState *)pState;
+    fxp_t tuning_ppb = 0;
+    int32_t dt_retained = dt;
+
+    // in the very first cycle skip running the filter
+    if (pS->cycle == 0) {
+        goto retain_cycle_data;
+    }
+
+    /* ---- PREPARE THE PARAMETERS ---- */
+
+    // synchronization period and its reciprocal
+    fxp_t DT = fxp_ns_to_s(pAux->measSyncPeriodNs);
+    fxp_t DTinv = fxp_div(1000000000, pAux->measSyncPeriodNs, FXP_FRAC_COEF);
+
+    // compose measurement vector
+    fxp_t z[2];
+    z[0] = (fxp_t)dt << FXP_FRAC_SIG;                                                               // offset in ns
+    z[1] = fxp_div(((int64_t)dt - pS->dt_prev) * 1000000000, pAux->measSyncPeriodNs, FXP_FRAC_SIG); // skew in PPB
+
+    // system matrix and (normalized) covariances with DT injected
+    mtx A = {{ONE, DT, MUL(DT, DT) >> (DRIFT_SHIFT + 1)}, {0, ONE, DT >> DRIFT_SHIFT}, {0, 0, ONE}};
+    mtx Q = {{MUL(DT, pS->q_theta), 0, 0}, {0, MUL(DT, pS->q_gamma), 0}, {0, 0, MUL(DT, pS->q_delta)}};
+    mtx2 R;
+    R[0][0] = pS->r_scale;
+    R[0][1] = R[1][0] = MUL(pS->r_scale, DTinv);
+    R[1][1] = 2 * MUL(R[0][1], DTinv);
+
+    /* ---- RUN THE FILTER ---- */
+
+    if (pS->cycle == 1) {
+        goto restart_filter;
+    }
+
+    // prediction equations
+
+    // (27) x(n|n-1) = A * x(n-1) + B * u(n-1), B = [DT 1 0]'
+    vec x_pri;
+    x_pri[0] = fxp_add(fxp_add(fxp_add(pS->x[0], MUL(DT, pS->x[1])), MUL(A[0][2], pS->x[2])), MUL(DT, pS->u));
+    x_pri[1] = fxp_add(fxp_add(pS->x[1], MUL(A[1][2], pS->x[2])), pS->u);
+    x_pri[2] = pS->x[2];
+
+    // (28) P(n|n-1) = A * P * A' + Q
+    mtx AP, At, APAt, P_pri;
+    mtx_mul(AP, A, pS->P);
+    mtx_transp(At, A);
+    mtx_mul(APAt, AP, At);
+    mtx_add(P_pri, APAt, Q);
+
+    // innovation, its covariance and the innovation normalized by the measurement standard deviation
+    fxp_t y[2] = {fxp_sub(z[0], x_pri[0]), fxp_sub(z[1], x_pri[1])};
+    fxp_t yn[2] = {MUL(y[0], pS->inv_sigma_m), MUL(y[1], pS->inv_sigma_m)};
+    mtx2 S, Sinv;
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint8_t j = 0; j < 2; j++) {
+            S[i][j] = fxp_add(P_pri[i][j], R[i][j]);
+        }
+    }
+    mtx2_inverse(Sinv, S);
+
+    // normalized innovation squared (Q32.32)
+    fxp_t d2 = fxp_add(fxp_mul(yn[0], fxp_add(MUL(Sinv[0][0], yn[0]), MUL(Sinv[0][1], yn[1])), FXP_FRAC_SIG),
+                       fxp_mul(yn[1], fxp_add(MUL(Sinv[1][0], yn[0]), MUL(Sinv[1][1], yn[1])), FXP_FRAC_SIG));
+
+    // measurement noise sample from the offset innovation (Q24.40)
+    fxp_t r_sample = fxp_sub(fxp_mul(yn[0], yn[0], 2 * FXP_FRAC_SIG - FXP_FRAC_COEF), P_pri[0][0]);
+
+    // innovation gating
+    if ((KALMAN_GATE_REJECT > 0) && (d2 > GATE_REJECT)) {
+        pS->rejectRun++;
+        if (pS->rejectRun > KALMAN_GATE_MAX_REJECTS) {
+            // raise the noise estimate and restart the offset from the measurement, keep the skew and the drift
+            pS->restarts++;
+            pS->rejectRun = 0;
+            pS->r_scale = MIN(MAX(pS->r_scale, r_sample), R_SCALE_MAX);
+            vec_copy(pS->x, x_pri);
+            mtx_copy(pS->P, P_pri);
+            pS->x[0] = z[0];
+            pS->P[0][0] = fxp_add(pS->P[0][0], pS->r_scale);
+            goto determine_tuning;
+        }
+
+        // keep the prediction, substitute the predicted offset for the next skew measurement
+        pS->rejected++;
+        vec_copy(pS->x, x_pri);
+        mtx_copy(pS->P, P_pri);
+        dt_retained = fxp_round_ns(x_pri[0]);
+        goto determine_tuning;
+    }
+    pS->rejectRun = 0;
+
+    // estimate the measurement noise
+    if (KALMAN_R_ADAPT_RATE > 0) {
+        pS->r_scale = fxp_add(pS->r_scale, MUL(R_ADAPT_RATE, fxp_sub(r_sample, pS->r_scale)));
+        pS->r_scale = MIN(MAX(pS->r_scale, R_SCALE_MIN), R_SCALE_MAX);
+    }
+
+    // down-weight suspicious measurements by inflating their covariance
+    if ((KALMAN_GATE_REJECT > 0) && (d2 > GATE_SOFT)) {
+        pS->downweighted++;
+        fxp_t w = fxp_div(d2, GATE_SOFT, FXP_FRAC_COEF);
+        for (uint8_t i = 0; i < 2; i++) {
+            for (uint8_t j = 0; j < 2; j++) {
+                S[i][j] = fxp_add(P_pri[i][j], MUL(w, R[i][j]));
+            }
+        }
+        mtx2_inverse(Sinv, S);
+    }
+
+    // correction equations
+
+    // (30) K = P(n|n-1) * H' * S^(-1)
+    fxp_t K[KALMAN_STATES][2];
+    for (uint8_t i = 0; i < KALMAN_STATES; i++) {
+        for (uint8_t j = 0; j < 2; j++) {
+            K[i][j] = fxp_add(MUL(P_pri[i][0], Sinv[0][j]), MUL(P_pri[i][1], Sinv[1][j]));
+        }
+    }
+
+    // (31) x = x(n|n-1) + K * y
+    VEC_ELEMENTWISE(
+        pS->x[i] = fxp_add(fxp_add(x_pri[i], MUL(K[i][0], y[0])), MUL(K[i][1], y[1]));)
+
+    // (32) P = (I - K * H) * P(n|n-1)
+    MTX_ELEMENTWISE(
+        pS->P[i][j] = fxp_sub(P_pri[i][j], fxp_add(MUL(K[i][0], P_pri[0][j]), MUL(K[i][1], P_pri[1][j])));)
+
+    goto determine_tuning;
+
+    // start the filter from the measurement, the offset and the skew are as uncertain as the measurement itself
+restart_filter:
+    mtx_copy(pS->P, Q); // P(1|0) = [R 0; 0 Q]
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint8_t j = 0; j < 2; j++) {
+            pS->P[i][j] = R[i][j];
+        }
+    }
+    pS->x[0] = z[0]; // x = [z 0]'
+    pS->x[1] = z[1];
+    pS->x[2] = 0;
+
+    /* ---- TUNING ---- */
+
+determine_tuning:;
+    // cancel the skew expected over the next period, remove a portion of the offset
+    fxp_t tuning_coefficient = (llabs(pS->x[0]) > FAST_TUNING_THRESHOLD) ? FAST_TUNING_COEFFICIENT : CALM_TUNING_COEFFICIENT;
+    tuning_ppb = fxp_sub(-fxp_add(pS->x[1], MUL(DT >> (DRIFT_SHIFT + 1), pS->x[2])), fxp_mul(pS->x[0], MUL(DTinv, tuning_coefficient), FXP_FRAC_COEF));
+
+    // feed back tuning
+    pS->u = tuning_ppb;
+
+    /* ---- DATA RETENTION ---- */
+
+retain_cycle_data:
+    pS->dt_prev = dt_retained;
+
+    pS->cycle++;
+
+    return fxp_to_float(tuning_ppb, FXP_FRAC_SIG);
+}
+
+static void kalman_filter_fxp_print_params_inst(const void *pState) {
+    const KalmanFilterFxpState *pS = (const KalmanFilterFxpState *)pState;
+    MSG("sigma_theta^2 = %e\n", pS->sigma_theta_squared);
+    MSG("sigma_gamma^2 = %e\n", pS->sigma_gamma_squared);
+    MSG("sigma_delta^2 = %e\n", pS->sigma_delta_squared);
+    MSG("sigma_theta_m^2 = %e\n", pS->sigma_theta_m_squared);
+    kalman_filter_fxp_print_gating(pS);
+}
+
+static bool kalman_filter_fxp_set_params_inst(void *pState, const double *pParams, uint8_t paramCnt) {
+    if ((paramCnt < 3) || (paramCnt > 4) || (pParams[2] <= 0.0)) {
+        return false;
+    }
+
+    KalmanFilterFxpState *pS = (KalmanFilterFxpState *)pState;
+    pS->sigma_theta_squared = pParams[0];
+    pS->sigma_gamma_squared = pParams[1];
+    pS->sigma_theta_m_squared = pParams[2];
+    if (paramCnt > 3) {
+        pS->sigma_delta_squared = pParams[3];
+    }
+    kalman_filter_fxp_normalize(pS);
+    return true;
+}
+
+static uint8_t kalman_filter_fxp_get_params_inst(const void *pState, double *pParams) {
+    const KalmanFilterFxpState *pS = (const KalmanFilterFxpState *)pState;
+    pParams[0] = pS->sigma_theta_squared;
+    pParams[1] = pS->sigma_gamma_squared;
+    pParams[2] = pS->sigma_theta_m_squared;
+    pParams[3] = pS->sigma_delta_squared;
+    return 4;
+}
+
+static void *kalman_filter_fxp_get_default() {
+    return &sDefault;
+}
+
+// --------------
+
+void kalman_filter_fxp_init() {
+#ifdef CLI_REG_CMD
+    register_cmd_commands();
+#endif
+
+    kalman_filter_fxp_create(&sDefault);
+}
+
+void kalman_filter_fxp_deinit() {
+#ifdef CLI_REMOVE_CMD
+    remove_cmd_commands();
+#endif
+}
+
+void kalman_filter_fxp_print_params() {
+    kalman_filter_fxp_print_params_inst(&sDefault);
+}
+
+void kalman_filter_fxp_reset() {
+    kalman_filter_fxp_reset_inst(&sDefault);
+}
+
+float kalman_filter_fxp_run(int32_t dt, PtpServoAuxInput *pAux) {
+    return kalman_filter_fxp_run_inst(&sDefault, dt, pAux);
+}
+
+const PtpServo gKalmanFilterFxpServo = {
+    "kalman",
+    sizeof(KalmanFilterFxpState),
+    kalman_filter_fxp_init,
+    kalman_filter_fxp_deinit,
+    kalman_filter_fxp_get_default,
+    kalman_filter_fxp_create,
+    kalman_filter_fxp_reset_inst,
+    kalman_filter_fxp_run_inst,
+    kalman_filter_fxp_print_params_inst,
+    kalman_filter_fxp_set_params_inst,
+    kalman_filter_fxp_get_params_inst,
+};
@@ -0,0 +1,82 @@
+#ifndef SERVO_KALMAN_FILTER_FXP
+#define SERVO_KALMAN_FILTER_FXP
+
+#include <stdint.h>
+
+#include "../ptp_servo_types.h"
+#include "fixed_point.h"
+#include "kalman_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Fixed-point variant of the Kalman-filter servo for MCUs without a double precision FPU.
+ * The state is kept in nanoseconds and PPB (Q32.32), the covariances are normalized by the
+ * measurement variance (Q24.40). The normalization leaves the Kalman gain unchanged, but brings
+ * all covariances into a range that a 64-bit fixed-point number can represent.
+ */
+
+/**
+ * @brief Fixed-point Kalman-filter instance.
+ */
+typedef struct {
+    fxp_t P[KALMAN_STATES][KALMAN_STATES]; ///< A posteriori error covariance matrix (normalized, Q24.40)
+    fxp_t x[KALMAN_STATES];                ///< A posteriori state estimator: offset in ns, skew in PPB, drift in 2^-10 PPB/s (Q32.32)
+    fxp_t u;                               ///< Control input: last tuning in PPB (Q32.32)
+
+    fxp_t q_theta;     ///< Offset process variance over measurement variance (Q24.40)
+    fxp_t q_gamma;     ///< Skew process variance over measurement variance (Q24.40)
+    fxp_t q_delta;     ///< Drift process variance over measurement variance (Q24.40)
+    fxp_t inv_sigma_m; ///< Reciprocal of the measurement standard deviation in 1/ns (Q24.40)
+
+    double sigma_theta_squared;   ///< Offset process variance (normalized)
+    double sigma_gamma_squared;   ///< Skew process variance (normalized)
+    double sigma_delta_squared;   ///< Drift process variance (normalized)
+    double sigma_theta_m_squared; ///< Measurement variance (normalized)
+
+    fxp_t r_scale;         ///< Estimated measurement variance relative to the configured one (Q24.40)
+    uint32_t rejected;     ///< Number of measurements rejected by the innovation gate
+    uint32_t downweighted; ///< Number of measurements down-weighted by the innovation gate
+    uint32_t restarts;     ///< Number of restarts after consecutive rejections
+    uint8_t rejectRun;     ///< Number of consecutive rejections
+
+    uint64_t cycle;  ///< Cycle counter
+    int32_t dt_prev; ///< Previous time error
+} KalmanFilterFxpState;
+
+extern const PtpServo gKalmanFilterFxpServo; ///< Fixed-point Kalman-filter servo descriptor
+
+/**
+ * Initialize the fixed-point Kalman-filter.
+ */
+void kalman_filter_fxp_init();
+
+/**
+ * Deinitialize the fixed-point Kalman-filter.
+ */
+void kalman_filter_fxp_deinit();
+
+/**
+ * Reset the fixed-point Kalman-filter.
+ */
+void kalman_filter_fxp_reset();
+
+/**
+ * Run the fixed-point Kalman-filter.
+ *
+ * @param dt time error in nanoseconds
+ * @param pAux auxiliary synchronization cycle context data
+ */
+float kalman_filter_fxp_run(int32_t dt, PtpServoAuxInput *pAux);
+
+/**
+ * Print the fixed-point Kalman-filter parameters.
+ */
+void kalman_filter_fxp_print_params();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVO_KALMAN_FILTER_FXP */
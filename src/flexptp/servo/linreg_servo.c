@@ -0,0 +1,210 @@
+/** A linear-regression servo. Points of a sliding window are fitted with a line using least squares,
+ * the window size is adapted to the noise: a larger window averages out more packet delay variation,
+ * a smaller one follows the wander of the oscillator faster.
+ */
+
+#include "linreg_servo.h"
+#include "../ptp_defs.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <flexptp_options.h>
+
+/* ---- PARAMETERS ---- */
+
+#if (LINREG_MAX_POINTS < LINREG_MIN_POINTS) || (LINREG_MAX_POINTS > 128) || ((LINREG_MAX_POINTS & (LINREG_MAX_POINTS - 1)) != 0)
+#error "LINREG_MAX_POINTS must be a power of two between 4 and 128!"
+#endif
+
+#ifndef LINREG_ERR_SMOOTH
+#define LINREG_ERR_SMOOTH (0.02) ///< Smoothing factor of the prediction errors
+#endif
+
+#ifndef LINREG_ERR_INITIAL_UPDATES
+#define LINREG_ERR_INITIAL_UPDATES (10) ///< Number of prediction error updates before a window can be selected
+#endif
+
+#ifndef LINREG_OFFSET_GAIN
+#define LINREG_OFFSET_GAIN (1.0) ///< Portion of the estimated time error removed over the next synchronization period
+#endif
+
+// ----------------
+
+static LinregServoState sDefault; ///< Default instance
+
+// --------------
+
+/**
+ * Fit a line onto the newest points.
+ *
+ * @param pS pointer to the servo instance
+ * @param pW pointer to the window
+ * @param n number of points
+ */
+static void linreg_fit(LinregServoState *pS, LinregWindow *pW, uint8_t n) {
+    // calculate means
+    double xm = 0.0, ym = 0.0;
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t idx = (pS->head - 1 - i) & (LINREG_MAX_POINTS - 1);
+        xm += pS->x[idx];
+        ym += pS->y[idx];
+    }
+    xm /= n;
+    ym /= n;
+
+    // calculate (co)variances
+    double sxx = 0.0, sxy = 0.0;
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t idx = (pS->head - 1 - i) & (LINREG_MAX_POINTS - 1);
+        double dx = pS->x[idx] - xm;
+        sxx += dx * dx;
+        sxy += dx * (pS->y[idx] - ym);
+    }
+
+    // the line is evaluated at the newest point
+    pW->slope = (sxx > 0.0) ? (sxy / sxx) : 0.0;
+    pW->intercept = ym + pW->slope * (pS->t - xm);
+    pW->valid = true;
+}
+
+/**
+ * Pick the window predicting the points the best.
+ *
+ * @param pS pointer to the servo instance
+ * @return index of the window or -1 if no regression is available yet
+ */
+static int8_t linreg_select_window(const LinregServoState *pS) {
+    int8_t best = -1, largest = -1;
+    for (uint8_t i = 0; i < LINREG_MAX_WINDOWS; i++) {
+        const LinregWindow *w = &pS->windows[i];
+        if (!w->valid) {
+            continue;
+        }
+
+        largest = i;
+        if ((w->errUpdates >= LINREG_ERR_INITIAL_UPDATES) && ((best < 0) || (w->err < pS->windows[best].err))) {
+            best = i;
+        }
+    }
+
+    // until the prediction errors settle, average as much as possible
+    return (best >= 0) ? best : largest;
+}
+
+// --------------
+
+static void linreg_servo_reset_inst(void *pState) {
+    memset(pState, 0, sizeof(LinregServoState));
+}
+
+static float linreg_servo_run_inst(void *pState, int32_t dt, PtpServoAuxInput *pAux) {
+    LinregServoState *pS = (LinregServoState *)pState;
+
+    // without a usable Sync period neither the time axis nor the offset correction can be computed
+    if (pAux->measSyncPeriodNs <= 0) {
+        return 0.0;
+    }
+
+    double period = pAux->measSyncPeriodNs * 1E-09;
+
+    // advance time and the time error accumulated by our own tuning
+    if (pS->count > 0) {
+        pS->t += period;
+        pS->phase += pS->freq * period; // ppb * s = ns
+    }
+
+    // time error of the clock as if it was not tuned by this servo
+    double y = dt - pS->phase;
+
+    // update the prediction errors
+    for (uint8_t i = 0; i < LINREG_MAX_WINDOWS; i++) {
+        LinregWindow *w = &pS->windows[i];
+        if (w->valid) {
+            double err = y - (w->intercept + w->slope * period);
+            w->err = (w->errUpdates == 0) ? (err * err) : ((1.0 - LINREG_ERR_SMOOTH) * w->err + LINREG_ERR_SMOOTH * err * err);
+            if (w->errUpdates < UINT16_MAX) {
+                w->errUpdates++;
+            }
+        }
+    }
+
+    // store the point
+    pS->x[pS->head] = pS->t;
+    pS->y[pS->head] = y;
+    pS->head = (pS->head + 1) & (LINREG_MAX_POINTS - 1);
+    if (pS->count < LINREG_MAX_POINTS) {
+        pS->count++;
+    }
+
+    // fit the lines onto the full windows
+    uint8_t n = LINREG_MIN_POINTS;
+    for (uint8_t i = 0; (i < LINREG_MAX_WINDOWS) && (n <= pS->count); i++, n <<= 1) {
+        linreg_fit(pS, &pS->windows[i], n);
+    }
+
+    int8_t best = linreg_select_window(pS);
+    if (best < 0) {
+        return 0.0; // collecting the first points
+    }
+    pS->bestWindow = best;
+
+    // compensate the frequency error and remove the estimated time error over the next period
+    const LinregWindow *w = &pS->windows[best];
+    double timeError = w->intercept + pS->phase;
+    double freq = -w->slope - LINREG_OFFSET_GAIN * timeError / period;
+
+    // tuning is relative to the previous one
+    double tuning_ppb = freq - pS->freq;
+    pS->freq = freq;
+
+    return tuning_ppb;
+}
+
+static void linreg_servo_print_params_inst(const void *pState) {
+    const LinregServoState *pS = (const LinregServoState *)pState;
+    const LinregWindow *w = &pS->windows[pS->bestWindow];
+    MSG("window: %u points (max. %u), frequency error: %.3f ppb, prediction RMS: %.1f ns\n",
+        LINREG_MIN_POINTS << pS->bestWindow, LINREG_MAX_POINTS, w->slope, sqrt(w->err));
+}
+
+static void *linreg_servo_get_default() {
+    return &sDefault;
+}
+
+// --------------
+
+void linreg_servo_init() {
+    linreg_servo_reset();
+}
+
+void linreg_servo_deinit() {
+}
+
+void linreg_servo_reset() {
+    linreg_servo_reset_inst(&sDefault);
+}
+
+float linreg_servo_run(int32_t dt, PtpServoAuxInput *pAux) {
+    return linreg_servo_run_inst(&sDefault, dt, pAux);
+}
+
+void linreg_servo_print_params() {
+    linreg_servo_print_params_inst(&sDefault);
+}
+
+const PtpServo gLinregServo = {
+    "linreg",
+    sizeof(LinregServoState),
+    linreg_servo_init,
+    linreg_servo_deinit,
+    linreg_servo_get_default,
+    linreg_servo_reset_inst,
+    linreg_servo_reset_inst,
+    linreg_servo_run_inst,
+    linreg_servo_print_params_inst,
+    NULL,
+    NULL,
+};
@@ -0,0 +1,91 @@
+#ifndef SERVO_LINREG_SERVO
+#define SERVO_LINREG_SERVO
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../ptp_servo_types.h"
+
+#include <flexptp_options.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** A linear-regression servo. A line is fitted onto the (T1, time error) points of a sliding window,
+ * where the time error is the one the clock would have without the servo's own corrections. The slope
+ * of the line is the frequency error of the clock, the line's value at the newest point is a smoothed
+ * time error estimate. Windows of 4, 8, 16... points are evaluated in parallel, the window size
+ * predicting the incoming points the best is used (similarly to the linreg servo of linuxptp).
+ */
+
+#ifndef LINREG_MAX_POINTS
+#define LINREG_MAX_POINTS (64) ///< Size of the largest window, power of two between 4 and 128
+#endif
+
+#define LINREG_MIN_POINTS (4) ///< Size of the smallest window
+#define LINREG_MAX_WINDOWS (6) ///< Maximum number of windows (4...128 points)
+
+/**
+ * @brief Regression over a window.
+ */
+typedef struct {
+    double slope;        ///< Slope of the fitted line (PPB)
+    double intercept;    ///< Value of the fitted line at the newest point (ns)
+    double err;          ///< Smoothed squared prediction error (ns^2)
+    uint16_t errUpdates; ///< Number of prediction error updates
+    bool valid;          ///< The window is full and the regression is valid
+} LinregWindow;
+
+/**
+ * @brief Linear-regression servo instance.
+ */
+typedef struct {
+    double x[LINREG_MAX_POINTS]; ///< Time of the points relative to the first one (s)
+    double y[LINREG_MAX_POINTS]; ///< Time error of the uncorrected clock (ns)
+    uint8_t head;                ///< Index of the next point to be written
+    uint8_t count;               ///< Number of points stored
+
+    LinregWindow windows[LINREG_MAX_WINDOWS]; ///< Regressions over the windows
+    uint8_t bestWindow;                       ///< Index of the window used for the last correction
+
+    double t;     ///< Time of the newest point (s)
+    double phase; ///< Time error accumulated by the servo's own tuning (ns)
+    double freq;  ///< Sum of the tunings issued by the servo (PPB)
+} LinregServoState;
+
+extern const PtpServo gLinregServo; ///< Linear-regression servo descriptor
+
+/**
+ * Initialize the linear-regression servo.
+ */
+void linreg_servo_init();
+
+/**
+ * Deinitialize the linear-regression servo.
+ */
+void linreg_servo_deinit();
+
+/**
+ * Reset the linear-regression servo.
+ */
+void linreg_servo_reset();
+
+/**
+ * Run the linear-regression servo.
+ *
+ * @param dt time error in nanoseconds
+ * @param pAux auxiliary synchronization cycle context data
+ */
+float linreg_servo_run(int32_t dt, PtpServoAuxInput *pAux);
+
+/**
+ * Print the linear-regression servo state.
+ */
+void linreg_servo_print_params();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVO_LINREG_SERVO */
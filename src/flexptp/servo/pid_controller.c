@@ -25,22 +25,13 @@
 // ----------------------------------
 
 static bool logInternals = false; ///< Decides if servo's internal operation shoud be reported or not
-static bool firstRun = true;      ///< Indicates if first run did not occur yet
 
 // ----------------------------------
 
 // static float P_FACTOR = 0.5 * 0.476;
 // static float D_FACTOR = 2.0 * 0.476;
 
-// PID servo coefficients
-static float Kp = K_P; ///< Proportional factor
-static float Ki = K_I;           ///< Integrating factor
-static float Kd = K_D;         ///< Differentiating factor
-
-// ----------------------------------
-
-static double rd_prev_ppb; ///< relative frequency error measured in previous iteration
-static double integrator_value; ///< value stored in the integrator
+static PidCtrlState sDefault; ///< Default instance driven by the CLI commands
 
 // ----------------------------------
 
@@ -53,12 +44,12 @@ static double integrator_value; ///< value stored in the integrator
 static CMD_FUNCTION(CB_params) {
     // set if parameters passed after command
     if (argc >= 3) {
-        Kp = atof(ppArgs[0]);
-        Ki = atof(ppArgs[1]);
-        Kd = atof(ppArgs[2]);
+        sDefault.Kp = atof(ppArgs[0]);
+        sDefault.Ki = atof(ppArgs[1]);
+        sDefault.Kd = atof(ppArgs[2]);
     }
 
-    MSG("> PTP params: K_p = %.3f, K_i = %.3f, K_d = %.3f\n", Kp, Ki, Kd);
+    pid_ctrl_print_params();
 
     return 0;
 }
@@ -101,30 +92,28 @@ static void pid_ctrl_remove_cli_commands() {
 
 #endif // CLI_REG_CMD
 
-void pid_ctrl_init() {
-    pid_ctrl_reset();
-
-#ifdef CLI_REG_CMD
-    pid_ctrl_register_cli_commands();
-#endif // CLI_REG_CMD
+static void pid_ctrl_create(void *pState) {
+    PidCtrlState *pS = (PidCtrlState *)pState;
+    pS->Kp = K_P;
+    pS->Ki = K_I;
+    pS->Kd = K_D;
+    pS->firstRun = true;
+    pS->integrator_value = 0;
 }
 
-void pid_ctrl_deinit() {
-#ifdef CLI_REMOVE_CMD
-    pid_ctrl_remove_cli_commands();
-#endif // CLI_REMOVE_CMD
+static void pid_ctrl_reset_inst(void *pState) {
+    PidCtrlState *pS = (PidCtrlState *)pState;
+    pS->firstRun = true;
+    pS->integrator_value = 0;
 }
 
-void pid_ctrl_reset() {
-    firstRun = true;
-    integrator_value = 0;
-}
+static float pid_ctrl_run_inst(void *pState, int32_t dt, PtpServoAuxInput *pAux) {
+    PidCtrlState *pS = (PidCtrlState *)pState;
 
-float pid_ctrl_run(int32_t dt, PtpServoAuxInput *pAux) {
-    if (firstRun) {
-        firstRun = false;
-        rd_prev_ppb = dt;
-        integrator_value = 0;
+    if (pS->firstRun) {
+        pS->firstRun = false;
+        pS->rd_prev_ppb = dt;
+        pS->integrator_value = 0;
         return 0;
     }
 
@@ -132,20 +121,91 @@ float pid_ctrl_run(int32_t dt, PtpServoAuxInput *pAux) {
     double rd_ppb = ((double)dt) / (pAux->measSyncPeriodNs) * 1E+09;
 
     // calculate difference
-    double rd_D_ppb = Kd * (rd_ppb - rd_prev_ppb);
+    double rd_D_ppb = pS->Kd * (rd_ppb - pS->rd_prev_ppb);
 
     // calculate output (run the PD controller)
-    double corr_ppb = -(Kp * (rd_ppb + rd_D_ppb) + integrator_value) * exp((pAux->measSyncPeriodNs * 1E-09) - 1.0);
+    double corr_ppb = -(pS->Kp * (rd_ppb + rd_D_ppb) + pS->integrator_value) * exp((pAux->measSyncPeriodNs * 1E-09) - 1.0);
 
     // update integrator
-    integrator_value += Ki * rd_ppb;
+    pS->integrator_value += pS->Ki * rd_ppb;
 
     // store error value (time difference) for use in next iteration
-    rd_prev_ppb = rd_ppb;
+    pS->rd_prev_ppb = rd_ppb;
 
-    CLILOG(logInternals, "%d %f\n", dt, rd_ppb);
+    CLILOG(logInternals && (pS == &sDefault), "%d %f\n", dt, rd_ppb);
 
     return corr_ppb;
 }
 
+static void pid_ctrl_print_params_inst(const void *pState) {
+    const PidCtrlState *pS = (const PidCtrlState *)pState;
+    MSG("> PTP params: K_p = %.3f, K_i = %.3f, K_d = %.3f\n", pS->Kp, pS->Ki, pS->Kd);
+}
+
+static bool pid_ctrl_set_params_inst(void *pState, const double *pParams, uint8_t paramCnt) {
+    if (paramCnt != 3) {
+        return false;
+    }
+
+    PidCtrlState *pS = (PidCtrlState *)pState;
+    pS->Kp = pParams[0];
+    pS->Ki = pParams[1];
+    pS->Kd = pParams[2];
+    return true;
+}
+
+static uint8_t pid_ctrl_get_params_inst(const void *pState, double *pParams) {
+    const PidCtrlState *pS = (const PidCtrlState *)pState;
+    pParams[0] = pS->Kp;
+    pParams[1] = pS->Ki;
+    pParams[2] = pS->Kd;
+    return 3;
+}
+
+static void *pid_ctrl_get_default() {
+    return &sDefault;
+}
+
+// ----------------------------------
+
+void pid_ctrl_init() {
+    pid_ctrl_create(&sDefault);
+
+#ifdef CLI_REG_CMD
+    pid_ctrl_register_cli_commands();
+#endif // CLI_REG_CMD
+}
+
+void pid_ctrl_deinit() {
+#ifdef CLI_REMOVE_CMD
+    pid_ctrl_remove_cli_commands();
+#endif // CLI_REMOVE_CMD
+}
+
+void pid_ctrl_print_params() {
+    pid_ctrl_print_params_inst(&sDefault);
+}
+
+void pid_ctrl_reset() {
+    pid_ctrl_reset_inst(&sDefault);
+}
+
+float pid_ctrl_run(int32_t dt, PtpServoAuxInput *pAux) {
+    return pid_ctrl_run_inst(&sDefault, dt, pAux);
+}
+
+const PtpServo gPidCtrlServo = {
+    "pid",
+    sizeof(PidCtrlState),
+    pid_ctrl_init,
+    pid_ctrl_deinit,
+    pid_ctrl_get_default,
+    pid_ctrl_create,
+    pid_ctrl_reset_inst,
+    pid_ctrl_run_inst,
+    pid_ctrl_print_params_inst,
+    pid_ctrl_set_params_inst,
+    pid_ctrl_get_params_inst,
+};
+
 // ----------------------------------
@@ -3,6 +3,7 @@
 #ifndef SERVO_PD_CONTROLLER_H_
 #define SERVO_PD_CONTROLLER_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "../ptp_servo_types.h"
@@ -11,6 +12,20 @@
 extern "C" {
 #endif
 
+/**
+ * @brief PID controller instance.
+ */
+typedef struct {
+    float Kp;                ///< Proportional factor
+    float Ki;                ///< Integrating factor
+    float Kd;                ///< Differentiating factor
+    bool firstRun;           ///< Indicates if first run did not occur yet
+    double rd_prev_ppb;      ///< Relative frequency error measured in previous iteration
+    double integrator_value; ///< Value stored in the integrator
+} PidCtrlState;
+
+extern const PtpServo gPidCtrlServo; ///< PID controller servo descriptor
+
 /**
  * Initialize PID controller.
  */
@@ -34,6 +49,11 @@ void pid_ctrl_reset();
  */
 float pid_ctrl_run(int32_t dt, PtpServoAuxInput * pAux);
 
+/**
+ * Print the PID controller parameters.
+ */
+void pid_ctrl_print_params();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,210 @@
+/** Fixed-point variant of the PID controller. Each step of the floating point controller is carried out
+ * on Q-format numbers, floating point arithmetic is only used when the parameters are set or printed.
+ */
+
+#include "pid_controller_fxp.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <flexptp_options.h>
+
+// ----------------------------------
+
+#ifndef K_P
+#define K_P (0.5 * 0.476) ///< Default Kp parameter value
+#endif
+
+#ifndef K_I
+#define K_I (0) ///< Default Ki parameters value
+#endif
+
+#ifndef K_D
+#define K_D (3.0) ///< Default Kd parameter value
+#endif
+
+// ----------------------------------
+
+static bool logInternals = false; ///< Decides if servo's internal operation shoud be reported or not
+
+static PidCtrlFxpState sDefault; ///< Default instance driven by the CLI commands
+
+// ----------------------------------
+
+#ifdef CLI_REG_CMD
+
+#ifndef CMD_FUNCTION
+#error "No CMD_FUNCTION macro has been defined, cannot register CLI functions!"
+#endif
+
+static CMD_FUNCTION(CB_params) {
+    // set if parameters passed after command
+    if (argc >= 3) {
+        sDefault.Kp = fxp_from_double(atof(ppArgs[0]), FXP_FRAC_COEF);
+        sDefault.Ki = fxp_from_double(atof(ppArgs[1]), FXP_FRAC_COEF);
+        sDefault.Kd = fxp_from_double(atof(ppArgs[2]), FXP_FRAC_COEF);
+    }
+
+    pid_ctrl_fxp_print_params();
+
+    return 0;
+}
+
+static CMD_FUNCTION(CB_logInternals) {
+    if (argc >= 1) {
+        int en = ONOFF(ppArgs[0]);
+        if (en >= 0) {
+            if (en && !logInternals) {
+                MSG("\nSyncIntv. [ns] | dt [ns] | gamma [ppb]\n\n");
+            }
+            logInternals = en;
+            return 0;
+        } else {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+}
+
+static struct {
+    int params;
+    int internals;
+} sCliCmdIdx = {0};
+
+static void pid_ctrl_fxp_register_cli_commands() {
+    sCliCmdIdx.params = CLI_REG_CMD("ptp servo params [Kp Ki Kd] \t\t\tSet or query Kp, Ki, and Kd servo parameters", 3, 0, CB_params);
+    sCliCmdIdx.internals = CLI_REG_CMD("ptp servo log internals {on|off} \t\t\tEnable or disable logging of servo internals", 4, 1, CB_logInternals);
+}
+
+#ifdef CLI_REMOVE_CMD
+static void pid_ctrl_fxp_remove_cli_commands() {
+    CLI_REMOVE_CMD(sCliCmdIdx.params);
+    CLI_REMOVE_CMD(sCliCmdIdx.internals);
+}
+#endif
+
+#endif // CLI_REG_CMD
+
+static void pid_ctrl_fxp_create(void *pState) {
+    PidCtrlFxpState *pS = (PidCtrlFxpState *)pState;
+    pS->Kp = fxp_from_double(K_P, FXP_FRAC_COEF);
+    pS->Ki = fxp_from_double(K_I, FXP_FRAC_COEF);
+    pS->Kd = fxp_from_double(K_D, FXP_FRAC_COEF);
+    pS->firstRun = true;
+    pS->integrator_value = 0;
+}
+
+static void pid_ctrl_fxp_reset_inst(void *pState) {
+    PidCtrlFxpState *pS = (PidCtrlFxpState *)pState;
+    pS->firstRun = true;
+    pS->integrator_value = 0;
+}
+
+static float pid_ctrl_fxp_run_inst(void *pState, int32_t dt, PtpServoAuxInput *pAux) {
+    PidCtrlFxpState *pS = (PidCtrlFxpState *)pState;
+
+    if (pS->firstRun) {
+        pS->firstRun = false;
+        pS->rd_prev_ppb = (fxp_t)dt << FXP_FRAC_SIG;
+        pS->integrator_value = 0;
+        return 0;
+    }
+
+    // calculate relative time error
+    fxp_t rd_ppb = fxp_div((fxp_t)dt * 1000000000, pAux->measSyncPeriodNs, FXP_FRAC_SIG);
+
+    // calculate difference
+    fxp_t rd_D_ppb = fxp_mul(pS->Kd, fxp_sub(rd_ppb, pS->rd_prev_ppb), FXP_FRAC_COEF);
+
+    // scale the output by e^(T - 1), where T is the synchronization period in seconds
+    fxp_t scale = fxp_exp(fxp_ns_to_s(pAux->measSyncPeriodNs) - FXP_ONE(FXP_FRAC_COEF));
+
+    // calculate output (run the PD controller)
+    fxp_t corr_ppb = fxp_add(fxp_mul(pS->Kp, fxp_add(rd_ppb, rd_D_ppb), FXP_FRAC_COEF), pS->integrator_value);
+    corr_ppb = -fxp_mul(corr_ppb, scale, FXP_FRAC_COEF);
+
+    // update integrator
+    pS->integrator_value = fxp_add(pS->integrator_value, fxp_mul(pS->Ki, rd_ppb, FXP_FRAC_COEF));
+
+    // store error value (time difference) for use in next iteration
+    pS->rd_prev_ppb = rd_ppb;
+
+    CLILOG(logInternals && (pS == &sDefault), "%d %f\n", dt, fxp_to_double(rd_ppb, FXP_FRAC_SIG));
+
+    return fxp_to_float(corr_ppb, FXP_FRAC_SIG);
+}
+
+static void pid_ctrl_fxp_print_params_inst(const void *pState) {
+    const PidCtrlFxpState *pS = (const PidCtrlFxpState *)pState;
+    MSG("> PTP params: K_p = %.3f, K_i = %.3f, K_d = %.3f (fixed-point)\n",
+        fxp_to_double(pS->Kp, FXP_FRAC_COEF), fxp_to_double(pS->Ki, FXP_FRAC_COEF), fxp_to_double(pS->Kd, FXP_FRAC_COEF));
+}
+
+static bool pid_ctrl_fxp_set_params_inst(void *pState, const double *pParams, uint8_t paramCnt) {
+    if (paramCnt != 3) {
+        return false;
+    }
+
+    PidCtrlFxpState *pS = (PidCtrlFxpState *)pState;
+    pS->Kp = fxp_from_double(pParams[0], FXP_FRAC_COEF);
+    pS->Ki = fxp_from_double(pParams[1], FXP_FRAC_COEF);
+    pS->Kd = fxp_from_double(pParams[2], FXP_FRAC_COEF);
+    return true;
+}
+
+static uint8_t pid_ctrl_fxp_get_params_inst(const void *pState, double *pParams) {
+    const PidCtrlFxpState *pS = (const PidCtrlFxpState *)pState;
+    pParams[0] = fxp_to_double(pS->Kp, FXP_FRAC_COEF);
+    pParams[1] = fxp_to_double(pS->Ki, FXP_FRAC_COEF);
+    pParams[2] = fxp_to_double(pS->Kd, FXP_FRAC_COEF);
+    return 3;
+}
+
+static void *pid_ctrl_fxp_get_default() {
+    return &sDefault;
+}
+
+// ----------------------------------
+
+void pid_ctrl_fxp_init() {
+    pid_ctrl_fxp_create(&sDefault);
+
+#ifdef CLI_REG_CMD
+    pid_ctrl_fxp_register_cli_commands();
+#endif // CLI_REG_CMD
+}
+
+void pid_ctrl_fxp_deinit() {
+#ifdef CLI_REMOVE_CMD
+    pid_ctrl_fxp_remove_cli_commands();
+#endif // CLI_REMOVE_CMD
+}
+
+void pid_ctrl_fxp_print_params() {
+    pid_ctrl_fxp_print_params_inst(&sDefault);
+}
+
+void pid_ctrl_fxp_reset() {
+    pid_ctrl_fxp_reset_inst(&sDefault);
+}
+
+float pid_ctrl_fxp_run(int32_t dt, PtpServoAuxInput *pAux) {
+    return pid_ctrl_fxp_run_inst(&sDefault, dt, pAux);
+}
+
+const PtpServo gPidCtrlFxpServo = {
+    "pid",
+    sizeof(PidCtrlFxpState),
+    pid_ctrl_fxp_init,
+    pid_ctrl_fxp_deinit,
+    pid_ctrl_fxp_get_default,
+    pid_ctrl_fxp_create,
+    pid_ctrl_fxp_reset_inst,
+    pid_ctrl_fxp_run_inst,
+    pid_ctrl_fxp_print_params_inst,
+    pid_ctrl_fxp_set_params_inst,
+    pid_ctrl_fxp_get_params_inst,
+};
+
+// ----------------------------------
@@ -0,0 +1,65 @@
+#ifndef SERVO_PID_CONTROLLER_FXP_H_
+#define SERVO_PID_CONTROLLER_FXP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../ptp_servo_types.h"
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Fixed-point variant of the PID controller for MCUs without a double precision FPU.
+ * It follows the floating point controller step by step, signals are stored in Q32.32,
+ * gains in Q24.40.
+ */
+
+/**
+ * @brief Fixed-point PID controller instance.
+ */
+typedef struct {
+    fxp_t Kp;               ///< Proportional factor (Q24.40)
+    fxp_t Ki;               ///< Integrating factor (Q24.40)
+    fxp_t Kd;               ///< Differentiating factor (Q24.40)
+    bool firstRun;          ///< Indicates if first run did not occur yet
+    fxp_t rd_prev_ppb;      ///< Relative frequency error measured in previous iteration (Q32.32)
+    fxp_t integrator_value; ///< Value stored in the integrator (Q32.32)
+} PidCtrlFxpState;
+
+extern const PtpServo gPidCtrlFxpServo; ///< Fixed-point PID controller servo descriptor
+
+/**
+ * Initialize the fixed-point PID controller.
+ */
+void pid_ctrl_fxp_init();
+
+/**
+ * Deinitialize the fixed-point PID controller.
+ */
+void pid_ctrl_fxp_deinit();
+
+/**
+ * Reset the fixed-point PID controller.
+ */
+void pid_ctrl_fxp_reset();
+
+/**
+ * Run the fixed-point PID controller.
+ *
+ * @param dt time error in nanoseconds
+ * @param pAux auxiliary synchronization cycle context data
+ */
+float pid_ctrl_fxp_run(int32_t dt, PtpServoAuxInput *pAux);
+
+/**
+ * Print the fixed-point PID controller parameters.
+ */
+void pid_ctrl_fxp_print_params();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVO_PID_CONTROLLER_FXP_H_ */
@@ -0,0 +1,312 @@
+#include "servo_registry.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "ptp_defs.h"
+
+#include "servo/debug_servo.h"
+#include "servo/kalman_filter.h"
+#include "servo/kalman_filter_fxp.h"
+#include "servo/linreg_servo.h"
+#include "servo/pid_controller.h"
+#include "servo/pid_controller_fxp.h"
+
+#include <flexptp_options.h>
+
+// --------------------------------------
+
+#ifdef PTP_SERVO_RUN
+// servo bound through the PTP_SERVO_XXX() macros of flexptp_options.h
+
+static void custom_servo_init() {
+    PTP_SERVO_INIT();
+}
+
+static void custom_servo_deinit() {
+    PTP_SERVO_DEINIT();
+}
+
+static void custom_servo_reset() {
+    PTP_SERVO_RESET();
+}
+
+static float custom_servo_run(int32_t dt, PtpServoAuxInput *pAux) {
+    return PTP_SERVO_RUN(dt, pAux);
+}
+
+static void custom_servo_reset_inst(void *pState) {
+    (void)pState;
+    custom_servo_reset();
+}
+
+static float custom_servo_run_inst(void *pState, int32_t dt, PtpServoAuxInput *pAux) {
+    (void)pState;
+    return custom_servo_run(dt, pAux);
+}
+
+static void *custom_servo_get_default() {
+    return NULL;
+}
+
+static const PtpServo sCustomServo = {
+    "custom",
+    0,
+    custom_servo_init,
+    custom_servo_deinit,
+    custom_servo_get_default,
+    NULL,
+    custom_servo_reset_inst,
+    custom_servo_run_inst,
+    NULL,
+    NULL,
+    NULL,
+};
+#endif
+
+static const PtpServo *sServos[] = {
+#if PTP_SERVO_FIXED_POINT
+    &gPidCtrlFxpServo,
+    &gKalmanFilterFxpServo,
+#else
+    &gPidCtrlServo,
+    &gKalmanFilterServo,
+#endif
+    &gDebugServo,
+    &gLinregServo,
+#ifdef PTP_SERVO_RUN
+    &sCustomServo,
+#endif
+};
+
+#define PTP_SERVO_N (sizeof(sServos) / sizeof(PtpServo *)) ///< Number of registered servos
+
+/**
+ * @brief Storage of a servo instance, large enough to hold any instantiable servo.
+ */
+typedef union {
+#if PTP_SERVO_FIXED_POINT
+    PidCtrlFxpState pid;         ///< Fixed-point PID controller instance
+    KalmanFilterFxpState kalman; ///< Fixed-point Kalman-filter instance
+#else
+    PidCtrlState pid;         ///< PID controller instance
+    KalmanFilterState kalman; ///< Kalman-filter instance
+#endif
+    LinregServoState linreg; ///< Linear-regression servo instance
+} PtpServoInstance;
+
+static uint8_t sActiveId = PTP_SERVO_INVALID_ID; ///< Identifier of the active servo
+static bool sInitialized = false;                ///< The active servo has been initialized
+static PtpServoEvalStats sActiveStats;           ///< Performance figures of the active servo
+
+static PtpServoShadow sShadows[PTP_SERVO_SHADOW_SLOTS];           ///< Shadow servos
+static PtpServoInstance sShadowInstances[PTP_SERVO_SHADOW_SLOTS]; ///< Instances of the shadow servos
+
+// --------------------------------------
+
+/**
+ * Register a time error and a tuning in a performance figure set.
+ *
+ * @param pStats pointer to the performance figures
+ * @param err time error in nanoseconds
+ * @param tuning tuning in PPB
+ */
+static void ptp_servo_eval_update(PtpServoEvalStats *pStats, double err, float tuning) {
+    pStats->cycles++;
+    pStats->lastTuning = tuning;
+    pStats->lastError = err;
+    pStats->sumSqError += err * err;
+    if (fabs(err) > pStats->maxAbsError) {
+        pStats->maxAbsError = fabs(err);
+    }
+}
+
+/**
+ * Run the shadow servos on the measurement the active servo has just processed.
+ * Each shadow drives a simulated clock that differs from the real clock only in the
+ * tunings applied: the difference of the shadow's and the active servo's tunings accumulates
+ * into a frequency offset, the frequency offset integrates into a time offset. The shadow
+ * gets the measured time error shifted by the time offset of its simulated clock, so it runs
+ * in a closed loop as if it was driving the clock.
+ *
+ * @param dt measured time error in nanoseconds
+ * @param pAux auxiliary synchronization cycle context data
+ * @param tuning tuning of the active servo in PPB
+ */
+static void ptp_servo_run_shadows(int32_t dt, PtpServoAuxInput *pAux, float tuning) {
+    for (uint8_t i = 0; i < PTP_SERVO_SHADOW_SLOTS; i++) {
+        PtpServoShadow *sh = &sShadows[i];
+        if (!sh->used) {
+            continue;
+        }
+
+        // advance the simulated clock over the last synchronization period (ppb * s = ns)
+        sh->clockOffset += sh->freqOffset * pAux->measSyncPeriodNs * 1E-09;
+        double err = dt + sh->clockOffset;
+
+        // run the shadow on the simulated clock
+        const PtpServo *servo = sServos[sh->servoId];
+        float shadowTuning = servo->run(&sShadowInstances[i], (int32_t)err, pAux);
+        sh->freqOffset += shadowTuning - tuning;
+
+        ptp_servo_eval_update(&sh->stats, err, shadowTuning);
+    }
+}
+
+// --------------------------------------
+
+void ptp_servo_init() {
+    // pick the default servo on the first initialization, keep the selection afterwards
+    if (sActiveId == PTP_SERVO_INVALID_ID) {
+        sActiveId = ptp_servo_find(PTP_SERVO_DEFAULT);
+        if (sActiveId == PTP_SERVO_INVALID_ID) {
+            MSG("Unknown default servo '%s', falling back to '%s'!\n", PTP_SERVO_DEFAULT, sServos[0]->name);
+            sActiveId = 0;
+        }
+    }
+
+    sServos[sActiveId]->init();
+    sInitialized = true;
+}
+
+void ptp_servo_deinit() {
+    if (sInitialized) {
+        sServos[sActiveId]->deinit();
+        sInitialized = false;
+    }
+}
+
+void ptp_servo_reset() {
+    const PtpServo *servo = sServos[sActiveId];
+    servo->reset(servo->instance());
+
+    // the clock might have been stepped or retuned, restart the simulated clocks from the real one
+    for (uint8_t i = 0; i < PTP_SERVO_SHADOW_SLOTS; i++) {
+        PtpServoShadow *sh = &sShadows[i];
+        if (sh->used) {
+            sServos[sh->servoId]->reset(&sShadowInstances[i]);
+            sh->clockOffset = 0.0;
+            sh->freqOffset = 0.0;
+        }
+    }
+}
+
+float ptp_servo_run(int32_t dt, PtpServoAuxInput *pAux) {
+    const PtpServo *servo = sServos[sActiveId];
+    float tuning = servo->run(servo->instance(), dt, pAux);
+    ptp_servo_eval_update(&sActiveStats, dt, tuning);
+
+    ptp_servo_run_shadows(dt, pAux, tuning);
+
+    return tuning;
+}
+
+bool ptp_servo_select(uint8_t id) {
+    if (id >= PTP_SERVO_N) {
+        return false;
+    }
+
+    if (sInitialized) {
+        if (id == sActiveId) {
+            return true;
+        }
+
+        // swap servos, the clock keeps running on its current tuning
+        sServos[sActiveId]->deinit();
+        sServos[id]->init();
+    }
+    sActiveId = id;
+    memset(&sActiveStats, 0, sizeof(PtpServoEvalStats));
+
+    return true;
+}
+
+uint8_t ptp_servo_find(const char *name) {
+    for (uint8_t i = 0; i < PTP_SERVO_N; i++) {
+        if (!strcmp(sServos[i]->name, name)) {
+            return i;
+        }
+    }
+    return PTP_SERVO_INVALID_ID;
+}
+
+uint8_t ptp_servo_get_id() {
+    return sActiveId;
+}
+
+uint8_t ptp_servo_get_count() {
+    return PTP_SERVO_N;
+}
+
+const PtpServo *ptp_servo_get(uint8_t id) {
+    return (id < PTP_SERVO_N) ? sServos[id] : NULL;
+}
+
+const void *ptp_servo_get_instance() {
+    return sServos[sActiveId]->instance();
+}
+
+bool ptp_servo_set_params(const double *pParams, uint8_t paramCnt) {
+    const PtpServo *servo = sServos[sActiveId];
+    return (servo->setParams != NULL) && (paramCnt > 0) && servo->setParams(servo->instance(), pParams, paramCnt);
+}
+
+uint8_t ptp_servo_get_params(double *pParams) {
+    const PtpServo *servo = sServos[sActiveId];
+    return (servo->getParams != NULL) ? servo->getParams(servo->instance(), pParams) : 0;
+}
+
+const PtpServoEvalStats *ptp_servo_get_stats() {
+    return &sActiveStats;
+}
+
+int8_t ptp_servo_shadow_add(uint8_t id, const double *pParams, uint8_t paramCnt) {
+    const PtpServo *servo = ptp_servo_get(id);
+    if ((servo == NULL) || (servo->stateSize == 0) || (servo->stateSize > sizeof(PtpServoInstance))) {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < PTP_SERVO_SHADOW_SLOTS; i++) {
+        PtpServoShadow *sh = &sShadows[i];
+        if (sh->used) {
+            continue;
+        }
+
+        void *pState = &sShadowInstances[i];
+        servo->create(pState);
+        if ((paramCnt > 0) && ((servo->setParams == NULL) || !servo->setParams(pState, pParams, paramCnt))) {
+            return -1;
+        }
+
+        memset(sh, 0, sizeof(PtpServoShadow));
+        sh->servoId = id;
+        sh->used = true;
+        return i;
+    }
+
+    return -1;
+}
+
+bool ptp_servo_shadow_remove(uint8_t slot) {
+    if ((slot >= PTP_SERVO_SHADOW_SLOTS) || !sShadows[slot].used) {
+        return false;
+    }
+
+    sShadows[slot].used = false;
+    return true;
+}
+
+void ptp_servo_clear_stats() {
+    memset(&sActiveStats, 0, sizeof(PtpServoEvalStats));
+    for (uint8_t i = 0; i < PTP_SERVO_SHADOW_SLOTS; i++) {
+        memset(&sShadows[i].stats, 0, sizeof(PtpServoEvalStats));
+    }
+}
+
+const PtpServoShadow *ptp_servo_get_shadow(uint8_t slot) {
+    return (slot < PTP_SERVO_SHADOW_SLOTS) ? &sShadows[slot] : NULL;
+}
+
+const void *ptp_servo_get_shadow_instance(uint8_t slot) {
+    return (slot < PTP_SERVO_SHADOW_SLOTS) ? &sShadowInstances[slot] : NULL;
+}
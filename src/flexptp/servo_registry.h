@@ -0,0 +1,163 @@
+/**
+  ******************************************************************************
+  * @file    servo_registry.h
+  * @copyright András Wiesner, 2026-\showdate "%Y"
+  * @brief   This module implements the clock servo registry: all bundled
+  * servos are linked in and the active one can be changed in runtime.
+  * Further servo instances can be evaluated in shadow on the live measurements.
+  ******************************************************************************
+  */
+
+#ifndef FLEXPTP_SERVO_REGISTRY_H_
+#define FLEXPTP_SERVO_REGISTRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ptp_servo_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PTP_SERVO_INVALID_ID (0xFF) ///< Servo identifier returned if a servo could not be found
+#define PTP_SERVO_MAX_PARAMS (4)    ///< Maximum number of parameters passed to a servo instance
+
+/**
+ * Initialize the servo selected by PTP_SERVO_DEFAULT.
+ */
+void ptp_servo_init();
+
+/**
+ * Deinitialize the active servo.
+ */
+void ptp_servo_deinit();
+
+/**
+ * Reset the active servo.
+ */
+void ptp_servo_reset();
+
+/**
+ * Run the active servo.
+ *
+ * @param dt time error in nanoseconds
+ * @param pAux auxiliary synchronization cycle context data
+ * @return clock tuning in PPB
+ */
+float ptp_servo_run(int32_t dt, PtpServoAuxInput *pAux);
+
+/**
+ * Select the active servo. The previous servo gets deinitialized, the new one gets initialized.
+ *
+ * @param id identifier of the servo
+ * @return the identifier is valid
+ */
+bool ptp_servo_select(uint8_t id);
+
+/**
+ * Look up a servo by its name.
+ *
+ * @param name name of the servo
+ * @return identifier of the servo or PTP_SERVO_INVALID_ID if not found
+ */
+uint8_t ptp_servo_find(const char *name);
+
+/**
+ * Get the identifier of the active servo.
+ *
+ * @return identifier of the active servo
+ */
+uint8_t ptp_servo_get_id();
+
+/**
+ * Get the number of registered servos.
+ *
+ * @return number of servos
+ */
+uint8_t ptp_servo_get_count();
+
+/**
+ * Get a servo descriptor.
+ *
+ * @param id identifier of the servo
+ * @return pointer to the servo descriptor or NULL if the identifier is invalid
+ */
+const PtpServo *ptp_servo_get(uint8_t id);
+
+/**
+ * Get the instance of the active servo.
+ *
+ * @return pointer to the instance or NULL if the servo cannot be instantiated
+ */
+const void *ptp_servo_get_instance();
+
+/**
+ * Set the parameters of the active servo.
+ *
+ * @param pParams parameters (servo specific, in the order of the shadow parameters)
+ * @param paramCnt number of parameters
+ * @return the servo accepted the parameters
+ */
+bool ptp_servo_set_params(const double *pParams, uint8_t paramCnt);
+
+/**
+ * Get the parameters of the active servo.
+ *
+ * @param pParams array of PTP_SERVO_MAX_PARAMS elements the parameters are written into
+ * @return number of parameters, 0 if the servo has no readable parameters
+ */
+uint8_t ptp_servo_get_params(double *pParams);
+
+/**
+ * Get the performance figures of the active servo.
+ *
+ * @return pointer to the performance figures
+ */
+const PtpServoEvalStats *ptp_servo_get_stats();
+
+/**
+ * Start evaluating a servo in shadow. The shadow gets the same measurements as the active servo,
+ * but its tuning is only applied onto a simulated clock.
+ *
+ * @param id identifier of the servo
+ * @param pParams parameters of the instance (servo specific)
+ * @param paramCnt number of parameters, 0 to use the default ones
+ * @return slot of the shadow or -1 if the servo cannot be instantiated, the parameters are invalid or no free slot is left
+ */
+int8_t ptp_servo_shadow_add(uint8_t id, const double *pParams, uint8_t paramCnt);
+
+/**
+ * Stop evaluating a shadow servo.
+ *
+ * @param slot slot of the shadow
+ * @return the slot was in use
+ */
+bool ptp_servo_shadow_remove(uint8_t slot);
+
+/**
+ * Clear the performance figures of the active and the shadow servos.
+ */
+void ptp_servo_clear_stats();
+
+/**
+ * Get a shadow servo.
+ *
+ * @param slot slot of the shadow
+ * @return pointer to the shadow or NULL if the slot is invalid
+ */
+const PtpServoShadow *ptp_servo_get_shadow(uint8_t slot);
+
+/**
+ * Get the instance of a shadow servo.
+ *
+ * @param slot slot of the shadow
+ * @return pointer to the instance or NULL if the slot is invalid
+ */
+const void *ptp_servo_get_shadow_instance(uint8_t slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLEXPTP_SERVO_REGISTRY_H_ */
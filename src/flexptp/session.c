@@ -0,0 +1,393 @@
+#include "session.h"
+
+#include <string.h>
+
+#include "event.h"
+#include "msg_utils.h"
+#include "ptp_core.h"
+#include "ptp_defs.h"
+#include "task_ptp.h"
+
+#include "minmax.h"
+
+///\cond 0
+#define S (gPtpCoreState)
+///\endcond
+
+#define SS (S.master.sessions) ///< Shorthand for the session state
+
+#define PTP_SESSION_SWEEP_PERIOD_TICKS FLEXPTP_MS_TO_TICKS(1000) ///< Period of expiring sessions and updating the response rate
+
+// ---------------------------
+
+/**
+ * Get the home slot of a session in the hash table.
+ */
+static uint16_t ptp_session_home(uint64_t clockIdentity, uint16_t portNumber) {
+    uint64_t h = (clockIdentity ^ (clockIdentity >> 29) ^ ((uint64_t)portNumber << 48)) * 0x9E3779B97F4A7C15ULL;
+    return (uint16_t)((h >> 32) % PTP_MASTER_SESSION_TABLE_SIZE);
+}
+
+/**
+ * Look up a session.
+ *
+ * @return index of the session or -1 if not found
+ */
+static int32_t ptp_session_find(uint64_t clockIdentity, uint16_t portNumber) {
+    uint16_t i = ptp_session_home(clockIdentity, portNumber);
+    for (uint32_t n = 0; n < PTP_MASTER_SESSION_TABLE_SIZE; n++) {
+        const PtpMasterSession *s = &SS.table[i];
+        if (!s->used) {
+            return -1;
+        } else if ((s->clockIdentity == clockIdentity) && (s->portNumber == portNumber)) {
+            return i;
+        }
+        i = (i + 1) % PTP_MASTER_SESSION_TABLE_SIZE;
+    }
+    return -1;
+}
+
+/**
+ * Create a new session.
+ *
+ * @return index of the new session or -1 if the table is full
+ */
+static int32_t ptp_session_insert(uint64_t clockIdentity, uint16_t portNumber) {
+    if (SS.active >= PTP_MASTER_SESSION_TABLE_SIZE) {
+        return -1;
+    }
+
+    uint16_t i = ptp_session_home(clockIdentity, portNumber);
+    while (SS.table[i].used) {
+        i = (i + 1) % PTP_MASTER_SESSION_TABLE_SIZE;
+    }
+
+    PtpMasterSession *s = &SS.table[i];
+    memset(s, 0, sizeof(PtpMasterSession));
+    s->clockIdentity = clockIdentity;
+    s->portNumber = portNumber;
+    s->pendingSlot = PTP_SESSION_NO_SLOT;
+    s->used = true;
+    SS.active++;
+    return i;
+}
+
+/**
+ * Remove a session. Following entries of the probe sequence are shifted back
+ * to keep lookups terminating on the first empty slot.
+ */
+static void ptp_session_remove(uint16_t i) {
+    uint16_t j = i;
+    while (true) {
+        SS.table[i].used = false;
+
+        // find an entry that can fill the hole
+        uint16_t k;
+        do {
+            j = (j + 1) % PTP_MASTER_SESSION_TABLE_SIZE;
+            if (!SS.table[j].used) {
+                SS.active--;
+                return;
+            }
+            k = ptp_session_home(SS.table[j].clockIdentity, SS.table[j].portNumber);
+        } while ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))); // home slot cyclically in (i, j]: must stay
+
+        SS.table[i] = SS.table[j];
+        i = j;
+    }
+}
+
+/**
+ * Transmit a Delay_Resp.
+ *
+ * @return the Delay_Resp could be put into the transmit queue
+ */
+static bool ptp_session_send_delay_resp(const PtpPendingDelayResp *pResp) {
+    RawPtpMessage delRespMsg = {0};
+
+    // assemble the header
+    PtpHeader header;
+    memset(&header, 0, sizeof(PtpHeader));
+    header.messageType = PTP_MT_Delay_Resp;
+    header.transportSpecific = (uint8_t)S.profile.transportSpecific;
+    header.versionPTP = 2;
+    header.messageLength = PTP_PCKT_SIZE_DELAY_RESP;
+    header.domainNumber = S.profile.domainNumber;
+    header.flags.PTP_TWO_STEP = true;                  // set TWO_STEP flag
+    header.flags.PTP_UNICAST = pResp->addr.valid;      // set UNICAST flag if responding directly
+    header.correction_ns = pResp->correction_ns;       // the correction field of the Delay_Req is returned
+    header.correction_subns = pResp->correction_subns; // ...
+    header.clockIdentity = S.hwoptions.clockIdentity;
+    header.sourcePortID = PTP_PORT_ID;
+    header.sequenceID = pResp->sequenceID;
+    header.control = PTP_CON_Delay_Resp;
+    header.logMessagePeriod = pResp->logMessagePeriod;
+
+    // create requestingSourcePortIdentity
+    PtpDelay_RespIdentification reqDelRespId = {pResp->clockIdentity, pResp->portNumber};
+
+    // write fields
+    ptp_construct_binary_header(delRespMsg.data, &header);        // HEADER
+    ptp_write_binary_timestamps(delRespMsg.data, &pResp->t4, 1);  // t4 TIMESTAMP
+    ptp_write_delay_resp_id_data(delRespMsg.data, &reqDelRespId); // REQ.SRC.PORT.ID
+
+    // setup packet
+    delRespMsg.tag = RPMT_RANDOM;
+    delRespMsg.size = PTP_PCKT_SIZE_DELAY_RESP;
+    delRespMsg.pTxCb = NULL;
+    delRespMsg.tx_dm = PTP_DM_E2E;
+    delRespMsg.tx_mc = PTP_MC_GENERAL;
+    delRespMsg.ttl = FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS;
+    delRespMsg.tx_drop = pResp->synthetic; // responses to the load generator pass the transmit queue but are not put on the wire
+    delRespMsg.addr = pResp->addr;
+
+    // send packet
+    return ptp_transmit_enqueue(&delRespMsg);
+}
+
+// ---------------------------
+
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+static void ptp_session_loadgen_rebase();
+#endif
+
+void ptp_session_reset() {
+    memset(&SS, 0, sizeof(PtpMasterSessionState));
+
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+    ptp_session_loadgen_rebase();
+#endif
+}
+
+/**
+ * Record a Delay_Req and schedule its response.
+ *
+ * @param pHeader pointer to the header of the Delay_Req
+ * @param pT4 pointer to the reception timestamp
+ * @param pAddr address to send the response to, NULL if the response should be multicast
+ * @param synthetic the Delay_Req comes from the load generator, its response must not be put on the wire
+ */
+static void ptp_session_record_delay_req(const PtpHeader *pHeader, const TimestampI *pT4, const PtpNetAddr *pAddr, bool synthetic) {
+    // find or open the session
+    int32_t idx = ptp_session_find(pHeader->clockIdentity, pHeader->sourcePortID);
+    if (idx < 0) {
+        idx = ptp_session_insert(pHeader->clockIdentity, pHeader->sourcePortID); // might fail, the slave is still served
+    }
+
+    PtpMasterSession *s = (idx >= 0) ? &SS.table[idx] : NULL;
+    if (s != NULL) {
+        s->lastSeen = S.ticks;
+        s->delReqCnt++;
+        if (pAddr != NULL) {
+            s->addr = *pAddr;
+        } else {
+            s->addr.valid = false;
+        }
+    }
+
+    // select the queue slot: replace the slave's pending response or append a new one
+    PtpPendingDelayResp *p;
+    if ((s != NULL) && (s->pendingSlot != PTP_SESSION_NO_SLOT)) {
+        p = &SS.queue[s->pendingSlot];
+        SS.delayRespCoalesced++;
+    } else if (SS.queueLevel < PTP_MASTER_DELAY_RESP_QUEUE_LENGTH) {
+        uint16_t slot = (SS.queueHead + SS.queueLevel) % PTP_MASTER_DELAY_RESP_QUEUE_LENGTH;
+        SS.queueLevel++;
+        SS.maxQueueLevel = MAX(SS.maxQueueLevel, SS.queueLevel);
+        p = &SS.queue[slot];
+        if (s != NULL) {
+            s->pendingSlot = slot;
+        }
+    } else {
+        SS.delayRespDropped++;
+        return;
+    }
+
+    // store the response data
+    p->clockIdentity = pHeader->clockIdentity;
+    p->portNumber = pHeader->sourcePortID;
+    p->sequenceID = pHeader->sequenceID;
+    p->logMessagePeriod = pHeader->logMessagePeriod;
+    p->correction_ns = pHeader->correction_ns;
+    p->correction_subns = pHeader->correction_subns;
+    p->t4 = *pT4;
+    p->synthetic = synthetic;
+    if (pAddr != NULL) {
+        p->addr = *pAddr;
+    } else {
+        memset(&p->addr, 0, sizeof(PtpNetAddr));
+    }
+
+    // respond right away if possible
+    ptp_session_flush();
+}
+
+void ptp_session_delay_req(const PtpHeader *pHeader, const TimestampI *pT4, const PtpNetAddr *pAddr) {
+    ptp_session_record_delay_req(pHeader, pT4, pAddr, false);
+}
+
+void ptp_session_flush() {
+    // respect the transmit buffer reserve
+    uint32_t free = ptp_transmit_get_free_slots();
+    uint32_t budget = (free > PTP_MASTER_TX_RESERVE) ? (free - PTP_MASTER_TX_RESERVE) : 0;
+    uint32_t n = MIN(MIN(PTP_MASTER_DELAY_RESP_BATCH, SS.queueLevel), budget);
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint16_t slot = SS.queueHead;
+        const PtpPendingDelayResp *p = &SS.queue[slot];
+
+        if (!ptp_session_send_delay_resp(p)) {
+            break; // keep the response, it is retried on the next flush
+        }
+
+        // the session has no pending response anymore
+        int32_t idx = ptp_session_find(p->clockIdentity, p->portNumber);
+        if ((idx >= 0) && (SS.table[idx].pendingSlot == slot)) {
+            SS.table[idx].pendingSlot = PTP_SESSION_NO_SLOT;
+        }
+
+        if (p->synthetic) {
+            SS.delayRespConsumed++;
+        } else {
+            SS.delayRespSent++;
+
+            // dispatch DELAY_RESP_SENT user event
+            PTP_IUEV(PTP_UEV_DELAY_RESP_SENT);
+        }
+
+        SS.queueHead = (SS.queueHead + 1) % PTP_MASTER_DELAY_RESP_QUEUE_LENGTH;
+        SS.queueLevel--;
+    }
+}
+
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+static void ptp_session_loadgen_tick();
+#endif
+
+void ptp_session_tick() {
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+    ptp_session_loadgen_tick();
+#endif
+
+    // drain the queue
+    ptp_session_flush();
+
+    if ((S.ticks % PTP_SESSION_SWEEP_PERIOD_TICKS) != 0) {
+        return;
+    }
+
+    // update the response rate
+    SS.respRate = SS.delayRespSent - SS.prevSent;
+    SS.prevSent = SS.delayRespSent;
+
+    // expire silent sessions
+    uint32_t timeout = FLEXPTP_MS_TO_TICKS(PTP_MASTER_SESSION_TIMEOUT_MS);
+    for (uint16_t i = 0; i < PTP_MASTER_SESSION_TABLE_SIZE;) {
+        const PtpMasterSession *s = &SS.table[i];
+        if (s->used && ((S.ticks - s->lastSeen) > timeout)) {
+            ptp_session_remove(i); // another entry might have been shifted here, check it again
+        } else {
+            i++;
+        }
+    }
+}
+
+const PtpMasterSessionState *ptp_session_get_state() {
+    return &SS;
+}
+
+// ---------------------------
+
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+
+#define PTP_LOADGEN_CLOCK_IDENTITY_BASE (0xFEFF000000000000ULL) ///< Clock identities of the virtual slaves begin here
+
+static struct {
+    bool running;           ///< The generator is running
+    uint16_t slaves;        ///< Number of virtual slaves
+    uint32_t rate;          ///< Delay_Reqs per second
+    uint32_t acc;           ///< Accumulator for fractional Delay_Reqs per tick (in thousandths)
+    uint16_t next;          ///< Index of the next virtual slave
+    uint16_t sequence;      ///< Sequence ID of the next Delay_Req
+    uint32_t startTick;     ///< Tick the run was started at
+    uint32_t stopTick;      ///< Tick the run was stopped at
+    uint32_t offered;       ///< Number of Delay_Reqs fed into the session table
+    uint32_t baseConsumed;  ///< Consumed counter at the beginning of the run
+    uint32_t baseCoalesced; ///< Coalesced counter at the beginning of the run
+    uint32_t baseDropped;   ///< Dropped counter at the beginning of the run
+} sLoadGen;
+
+/**
+ * Take the session counters as the base of the run's result.
+ */
+static void ptp_session_loadgen_rebase() {
+    sLoadGen.baseConsumed = SS.delayRespConsumed;
+    sLoadGen.baseCoalesced = SS.delayRespCoalesced;
+    sLoadGen.baseDropped = SS.delayRespDropped;
+}
+
+void ptp_session_loadgen_start(uint16_t slaves, uint32_t rate) {
+    memset(&sLoadGen, 0, sizeof(sLoadGen));
+    sLoadGen.slaves = MAX(slaves, 1);
+    sLoadGen.rate = rate;
+    sLoadGen.startTick = S.ticks;
+    ptp_session_loadgen_rebase();
+    sLoadGen.running = true;
+}
+
+void ptp_session_loadgen_stop() {
+    if (!sLoadGen.running) {
+        return;
+    }
+
+    sLoadGen.stopTick = S.ticks;
+    sLoadGen.running = false;
+
+    // report the result of the run
+    PtpLoadGenResult result;
+    ptp_session_loadgen_get_result(&result);
+    CLILOG(S.logging.info, "Load generator: %u Delay_Reqs of %u slaves in %u ms, %u responses served (%u/s), %u coalesced, %u dropped\n",
+           result.offered, sLoadGen.slaves, result.duration_ms, result.served, result.respRate, result.coalesced, result.dropped);
+}
+
+bool ptp_session_loadgen_is_running() {
+    return sLoadGen.running;
+}
+
+void ptp_session_loadgen_get_result(PtpLoadGenResult *pResult) {
+    uint32_t end = sLoadGen.running ? S.ticks : sLoadGen.stopTick;
+    pResult->duration_ms = (end - sLoadGen.startTick) * PTP_HEARTBEAT_TICKRATE_MS;
+    pResult->offered = sLoadGen.offered;
+    pResult->served = SS.delayRespConsumed - sLoadGen.baseConsumed;
+    pResult->coalesced = SS.delayRespCoalesced - sLoadGen.baseCoalesced;
+    pResult->dropped = SS.delayRespDropped - sLoadGen.baseDropped;
+    pResult->respRate = (pResult->duration_ms > 0) ? (uint32_t)(((uint64_t)pResult->served * 1000) / pResult->duration_ms) : 0;
+}
+
+static void ptp_session_loadgen_tick() {
+    if (!sLoadGen.running) {
+        return;
+    }
+
+    // determine the number of Delay_Reqs due in this tick
+    sLoadGen.acc += sLoadGen.rate * PTP_HEARTBEAT_TICKRATE_MS;
+    uint32_t n = sLoadGen.acc / 1000;
+    sLoadGen.acc %= 1000;
+
+    // synthesize the Delay_Reqs of the virtual slaves
+    PtpHeader header;
+    memset(&header, 0, sizeof(PtpHeader));
+    header.messageType = PTP_MT_Delay_Req;
+    header.sourcePortID = PTP_PORT_ID;
+    header.logMessagePeriod = 0x7F;
+    TimestampI t4 = {0, 0};
+    for (uint32_t i = 0; i < n; i++) {
+        header.clockIdentity = PTP_LOADGEN_CLOCK_IDENTITY_BASE | sLoadGen.next;
+        header.sequenceID = sLoadGen.sequence++;
+        ptp_session_record_delay_req(&header, &t4, NULL, true);
+        sLoadGen.offered++;
+        sLoadGen.next = (sLoadGen.next + 1) % sLoadGen.slaves;
+    }
+}
+
+#endif
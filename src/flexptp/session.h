@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    session.h
+  * @copyright András Wiesner, 2026-\showdate "%Y"
+  * @brief   This module implements the master's E2E slave session table and
+  * the batched Delay_Resp generation: Delay_Reqs are recorded into a bounded
+  * response queue and drained into the transmit buffer as free slots allow.
+  ******************************************************************************
+  */
+
+#ifndef FLEXPTP_SESSION_H_
+#define FLEXPTP_SESSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ptp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PTP_SESSION_NO_SLOT (0xFFFF) ///< Session has no pending Delay_Resp
+
+/**
+ * Drop all sessions and pending Delay_Resps, clear the statistics.
+ */
+void ptp_session_reset();
+
+/**
+ * Record a Delay_Req and schedule the Delay_Resp. If the slave already has
+ * a Delay_Resp waiting in the queue, it gets replaced by the response to the newer Delay_Req.
+ *
+ * @param pHeader pointer to the header of the Delay_Req
+ * @param pT4 pointer to the reception timestamp
+ * @param pAddr address to send the response to, NULL if the response should be multicast
+ */
+void ptp_session_delay_req(const PtpHeader *pHeader, const TimestampI *pT4, const PtpNetAddr *pAddr);
+
+/**
+ * Pass pending Delay_Resps to the transmit queue, keeping some slots free for other messages.
+ * Called on each tick, on each received Delay_Req and whenever a transmit slot gets released.
+ */
+void ptp_session_flush();
+
+/**
+ * Tick the session module: drain the response queue, expire silent sessions and update the statistics.
+ */
+void ptp_session_tick();
+
+/**
+ * Get the session state.
+ *
+ * @return pointer to the session state
+ */
+const PtpMasterSessionState *ptp_session_get_state();
+
+#if PTP_ENABLE_MASTER_LOAD_GENERATOR
+/**
+ * Start the synthetic Delay_Req load generator. Delay_Reqs of virtual slaves are fed into
+ * the session table as if they had been received. Their responses go through the same queue,
+ * coalescing, batching and transmit queue as the real ones, but the transmit path drops them
+ * instead of passing them to the network stack driver, so nothing is put on the wire. The result
+ * of the run is logged when the generator is stopped.
+ *
+ * @param slaves number of virtual slaves
+ * @param rate total number of Delay_Reqs per second
+ */
+void ptp_session_loadgen_start(uint16_t slaves, uint32_t rate);
+
+/**
+ * Stop the load generator.
+ */
+void ptp_session_loadgen_stop();
+
+/**
+ * Is the load generator running?
+ *
+ * @return the load generator is running
+ */
+bool ptp_session_loadgen_is_running();
+
+/**
+ * Get the result of the current (or the last) load generator run.
+ *
+ * @param pResult pointer to the object the result is written into
+ */
+void ptp_session_loadgen_get_result(PtpLoadGenResult *pResult);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLEXPTP_SESSION_H_ */
@@ -4,10 +4,16 @@
 #include "timeutils.h"
 #include "ptp_types.h"
 #include "ptp_core.h"
+#include "servo_registry.h"
+#include "slave.h"
+#include "task_ptp.h"
+#include "unicast.h"
 #include <string.h>
 
 #include <flexptp_options.h>
 
+#include "minmax.h"
+
 ///\cond 0
 extern PtpCoreState gPtpCoreState;
 #define S (gPtpCoreState)
@@ -21,6 +27,38 @@ int32_t ptp_get_clock_offset() {
     return nsI(&S.hwoptions.offset);
 }
 
+void ptp_set_delay_asymmetry(int32_t asym) {
+    nsToTsI(&S.hwoptions.delayAsymmetry, asym);
+}
+
+int32_t ptp_get_delay_asymmetry() {
+    return nsI(&S.hwoptions.delayAsymmetry);
+}
+
+void ptp_set_port_latency(PtpLinkSpeed ls, int32_t ingress, int32_t egress) {
+    if (ls < PTP_LS_N) {
+        S.hwoptions.latencies.ingress_ns[ls] = ingress;
+        S.hwoptions.latencies.egress_ns[ls] = egress;
+    }
+}
+
+void ptp_get_port_latency(PtpLinkSpeed ls, int32_t *pIngress, int32_t *pEgress) {
+    if (ls < PTP_LS_N) {
+        *pIngress = S.hwoptions.latencies.ingress_ns[ls];
+        *pEgress = S.hwoptions.latencies.egress_ns[ls];
+    }
+}
+
+void ptp_set_link_speed(PtpLinkSpeed ls) {
+    if (ls < PTP_LS_N) {
+        S.hwoptions.linkSpeed = ls;
+    }
+}
+
+PtpLinkSpeed ptp_get_link_speed() {
+    return S.hwoptions.linkSpeed;
+}
+
 void ptp_prefer_master_clock(uint64_t clockId) {
     S.bmca.preventMasterSwitchOver = true;
     S.bmca.masterProps.grandmasterClockIdentity = clockId;
@@ -127,7 +165,7 @@ int8_t ptp_get_sync_log_period() {
 }
 
 void ptp_set_sync_log_period(int8_t slp) {
-    S.profile.logSyncPeriod = slp;
+    S.profile.logSyncPeriod = MAX(slp, PTP_LOGPER_SYNC_MIN); // at most one Sync is sent per tick
     ptp_reset();
 }
 
@@ -148,6 +186,95 @@ uint64_t ptp_get_coarse_threshold() {
     return S.slave.coarseLimit;
 }
 
+void ptp_set_fast_comp_cycles(uint8_t skewMaxSamples, uint8_t timeCorrCycles, uint8_t propCycles) {
+    S.slave.fastCompParams.skewMaxSamples = MAX(skewMaxSamples, 3); // at least 3 samples are needed for a confidence interval
+    S.slave.fastCompParams.timeCorrCycles = MAX(timeCorrCycles, 1);
+    S.slave.fastCompParams.propCycles = propCycles;
+}
+
+void ptp_set_fast_comp_skew_ci_limit(float ppb) {
+    S.slave.fastCompParams.skewCiLimit_ppb = ppb;
+}
+
+const PtpFastCompParams *ptp_get_fast_comp_params() {
+    return &S.slave.fastCompParams;
+}
+
+void ptp_enable_adaptive_delay_req(bool en) {
+    S.slave.adaptDelReq.enabled = en;
+    ptp_slave_restart_delay_req_rate();
+}
+
+bool ptp_is_adaptive_delay_req_enabled() {
+    return S.slave.adaptDelReq.enabled;
+}
+
+void ptp_set_adaptive_delay_req_max_backoff(uint8_t steps) {
+    S.slave.adaptDelReq.maxBackoff = steps;
+}
+
+uint8_t ptp_get_adaptive_delay_req_max_backoff() {
+    return S.slave.adaptDelReq.maxBackoff;
+}
+
+int8_t ptp_get_current_delay_req_log_period() {
+    return (S.profile.logDelayReqPeriod == PTP_LOGPER_SYNCMATCHED) ? PTP_LOGPER_SYNCMATCHED : S.slave.adaptDelReq.logPeriod;
+}
+
+void ptp_enable_unicast_negotiation(bool en) {
+    if (S.unicast.enabled != en) {
+        S.unicast.enabled = en;
+        ptp_unicast_reset(); // drop the grants of the former mode
+    }
+}
+
+bool ptp_is_unicast_negotiation_enabled() {
+    return S.unicast.enabled;
+}
+
+void ptp_set_unicast_grant_duration(uint32_t duration_s) {
+    S.unicast.grantDuration_s = MAX(duration_s, 1);
+}
+
+uint32_t ptp_get_unicast_grant_duration() {
+    return S.unicast.grantDuration_s;
+}
+
+void ptp_enable_one_step_sync(bool en) {
+    // the mode is switched in the PTP task, so that the timestamping mode of the NSD and the Syncs never disagree
+    PtpCoreEvent event = {.code = PTP_CEV_SYNC_MODE_CHANGE, .w = {en}, .dw = {0}};
+    ptp_event_enqueue(&event);
+}
+
+bool ptp_is_one_step_sync_enabled() {
+    return S.master.oneStepSync;
+}
+
+void ptp_enable_hot_standby(bool en) {
+    ptp_slave_enable_standby(en);
+}
+
+bool ptp_is_hot_standby_enabled() {
+    return S.slave.standby.enabled;
+}
+
+bool ptp_set_servo(const char *name) {
+    uint8_t id = ptp_servo_find(name);
+    if (id == PTP_SERVO_INVALID_ID) {
+        return false;
+    }
+    return ptp_servo_select(id);
+}
+
+bool ptp_set_servo_params(const double *pParams, uint8_t paramCnt) {
+    return ptp_servo_set_params(pParams, paramCnt);
+}
+
+const char *ptp_get_servo() {
+    const PtpServo *servo = ptp_servo_get(ptp_servo_get_id());
+    return (servo != NULL) ? servo->name : "";
+}
+
 void ptp_set_priority1(uint8_t p1) {
     S.capabilities.priority1 = p1;
     ptp_reset();
@@ -207,6 +334,9 @@ void ptp_set_time(TimestampU * pT) {
 }
 
 void ptp_update_time(TimestampI * dt) {
+#ifdef PTP_HW_STEP_CLOCK
+    PTP_HW_STEP_CLOCK(nsI(dt));
+#else
     TimestampU tu;
     ptp_time(&tu);
     TimestampI ti;
@@ -214,4 +344,5 @@ void ptp_update_time(TimestampI * dt) {
     addTime(&ti, &ti, dt);
     tsIToU(&tu, &ti);
     ptp_set_time(&tu);
+#endif
 }
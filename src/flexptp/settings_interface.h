@@ -33,6 +33,53 @@ void ptp_set_clock_offset(int32_t offset); // set clock offset in nanoseconds
  */
 int32_t ptp_get_clock_offset();
 
+/**
+ * Set link delay asymmetry in nanoseconds. Positive values mean
+ * the master-to-slave delay is longer than the slave-to-master one.
+ * 
+ * @param asym delay asymmetry (master-to-slave delay minus the mean path delay) in nanoseconds
+ */
+void ptp_set_delay_asymmetry(int32_t asym);
+
+/**
+ * Get link delay asymmetry in nanoseconds.
+ * 
+ * @return delay asymmetry in nanoseconds
+ */
+int32_t ptp_get_delay_asymmetry();
+
+/**
+ * Set ingress and egress latencies (between the timestamping point and the reference plane) for a given link speed.
+ * 
+ * @param ls link speed
+ * @param ingress ingress latency in nanoseconds
+ * @param egress egress latency in nanoseconds
+ */
+void ptp_set_port_latency(PtpLinkSpeed ls, int32_t ingress, int32_t egress);
+
+/**
+ * Get ingress and egress latencies for a given link speed.
+ * 
+ * @param ls link speed
+ * @param pIngress pointer to where the ingress latency is written
+ * @param pEgress pointer to where the egress latency is written
+ */
+void ptp_get_port_latency(PtpLinkSpeed ls, int32_t *pIngress, int32_t *pEgress);
+
+/**
+ * Set the current link speed. Should be called by the port on link status changes.
+ * 
+ * @param ls link speed
+ */
+void ptp_set_link_speed(PtpLinkSpeed ls);
+
+/**
+ * Get the current link speed.
+ * 
+ * @return link speed
+ */
+PtpLinkSpeed ptp_get_link_speed();
+
 /**
  * Make the PTP engine to expect messages from a particular master.
  * 
@@ -200,7 +247,8 @@ void ptp_set_delay_req_log_period(int8_t drlp);
 int8_t ptp_get_sync_log_period();
 
 /**
- * Set the logarithmic Sync period code.
+ * Set the logarithmic Sync period code. Periods shorter than the heartbeat
+ * are raised to PTP_LOGPER_SYNC_MIN.
  * 
  * @param slp logarithmic period code
  */
@@ -234,6 +282,157 @@ void ptp_set_coarse_threshold(uint64_t ns);
  */
 uint64_t ptp_get_coarse_threshold(); 
 
+/**
+ * Set fast compensation cycle counts.
+ * 
+ * @param skewMaxSamples maximum number of Sync samples collected for skew estimation (at least 3)
+ * @param timeCorrCycles number of time correction cycles (at least 1)
+ * @param propCycles number of cycles waiting for the time correction to propagate
+ */
+void ptp_set_fast_comp_cycles(uint8_t skewMaxSamples, uint8_t timeCorrCycles, uint8_t propCycles);
+
+/**
+ * Set the confidence interval limit of the fast compensation skew estimation.
+ * The estimation terminates as soon as the confidence interval of the skew gets narrower than this value.
+ * 
+ * @param ppb confidence interval half-width in PPB
+ */
+void ptp_set_fast_comp_skew_ci_limit(float ppb);
+
+/**
+ * Get fast compensation parameters.
+ * 
+ * @return pointer to the fast compensation parameters
+ */
+const PtpFastCompParams *ptp_get_fast_comp_params();
+
+/**
+ * Enable or disable the adaptive (P)Delay_Req rate. If enabled, (P)Delay_Reqs are
+ * issued on the profile's rate while the clock is not locked or the path delay
+ * is noisy, and the rate is gradually reduced once the synchronization is stable.
+ * 
+ * @param en enable adaptive rate
+ */
+void ptp_enable_adaptive_delay_req(bool en);
+
+/**
+ * Is the adaptive (P)Delay_Req rate enabled?
+ * 
+ * @return adaptive rate is enabled
+ */
+bool ptp_is_adaptive_delay_req_enabled();
+
+/**
+ * Set the maximum number of log. period steps the adaptive (P)Delay_Req rate may back off from the profile's period.
+ * 
+ * @param steps maximum number of backoff steps
+ */
+void ptp_set_adaptive_delay_req_max_backoff(uint8_t steps);
+
+/**
+ * Get the maximum number of log. period steps the adaptive (P)Delay_Req rate may back off.
+ * 
+ * @return maximum number of backoff steps
+ */
+uint8_t ptp_get_adaptive_delay_req_max_backoff();
+
+/**
+ * Get the log. period (P)Delay_Reqs are currently issued with.
+ * 
+ * @return current logarithmic period code
+ */
+int8_t ptp_get_current_delay_req_log_period();
+
+/**
+ * Enable or disable unicast negotiation. If enabled, the slave requests Announce, Sync and
+ * Delay_Resp messages from the masters of the unicast master table and the master only transmits
+ * messages to the granted slaves. Negotiation is only in effect with the E2E delay mechanism.
+ * 
+ * @param en enable unicast negotiation
+ */
+void ptp_enable_unicast_negotiation(bool en);
+
+/**
+ * Is unicast negotiation enabled?
+ * 
+ * @return unicast negotiation is enabled
+ */
+bool ptp_is_unicast_negotiation_enabled();
+
+/**
+ * Set the duration requested in unicast transmission requests.
+ * 
+ * @param duration_s grant duration in seconds
+ */
+void ptp_set_unicast_grant_duration(uint32_t duration_s);
+
+/**
+ * Get the duration requested in unicast transmission requests.
+ * 
+ * @return grant duration in seconds
+ */
+uint32_t ptp_get_unicast_grant_duration();
+
+/**
+ * Enable or disable one-step Sync transmission. In one-step mode the origin timestamp is inserted
+ * into the Sync on transmission and no Follow_Up is sent. The timestamp is inserted by the port if it
+ * defines PTP_HW_ONE_STEP_SYNC, otherwise the clock is read right before the message is passed to the NSD.
+ * The change is carried out asynchronously in the PTP task: the timestamping mode of the NSD is switched
+ * (by calling ptp_nsd_set_one_step_sync() if PTP_HW_ONE_STEP_SYNC is defined), then the PTP subsystem is reset.
+ * 
+ * @param en enable one-step Sync transmission
+ */
+void ptp_enable_one_step_sync(bool en);
+
+/**
+ * Is one-step Sync transmission enabled?
+ * 
+ * @return one-step Sync transmission is enabled
+ */
+bool ptp_is_one_step_sync_enabled();
+
+/**
+ * Enable or disable the hot-standby master tracking. If enabled, the slave also timestamps the
+ * Syncs of the second-best master and keeps a separate time error and path delay estimate of it,
+ * so that a failover onto the standby does not need a full re-acquisition.
+ * 
+ * @param en enable hot-standby tracking
+ */
+void ptp_enable_hot_standby(bool en);
+
+/**
+ * Is the hot-standby master tracking enabled?
+ * 
+ * @return hot-standby tracking is enabled
+ */
+bool ptp_is_hot_standby_enabled();
+
+/**
+ * Select the clock servo by its name. The switch takes effect in the next synchronization cycle,
+ * the hardware clock keeps its current tuning.
+ * 
+ * @param name name of the servo
+ * @return the servo has been found and selected
+ */
+bool ptp_set_servo(const char *name);
+
+/**
+ * Set the parameters of the active clock servo. The parameters are
+ * servo specific, they are passed in the same order as to a shadow servo.
+ *
+ * @param pParams parameters
+ * @param paramCnt number of parameters
+ * @return the servo accepted the parameters
+ */
+bool ptp_set_servo_params(const double *pParams, uint8_t paramCnt);
+
+/**
+ * Get the name of the active clock servo.
+ * 
+ * @return name of the servo
+ */
+const char *ptp_get_servo();
+
 /**
  * Set master dataset Priority1 field.
  */
@@ -322,7 +521,8 @@ void ptp_set_time(TimestampU * pT);
 
 /**
  * Roughly update time.
- * CAUTION: Update will not be accurate, some software processing is involved!
+ * CAUTION: Update will not be accurate, some software processing is involved,
+ * unless the port provides the PTP_HW_STEP_CLOCK() relative stepping hook!
  * 
  * @param dt pointer to a TimestampI object holding the time offset
  */
@@ -7,9 +7,12 @@
 
 #include "common.h"
 
+#include "bmca.h"
 #include "format_utils.h"
+#include "holdover.h"
 #include "msg_utils.h"
 #include "ptp_types.h"
+#include "servo_registry.h"
 #include "settings_interface.h"
 #include "stats.h"
 #include "task_ptp.h"
@@ -42,9 +45,127 @@ static void ptp_tune_clock(float tuning_ppb) {
 #endif
 }
 
-#define PTP_FC_SKEW_CORRECTION_CYCLES (4)  ///< Fast compensation: no. of skew correction cycles
-#define PTP_FC_TIME_CORRECTION_CYCLES (1)  ///< Fast compensation: no. of time correction cycles
-#define PTP_FC_TIME_PROPAGATION_CYCLES (2) //< Fast compensation: no. of time propagation cycles
+#define PTP_FC_SKEW_MIN_SAMPLES (3) ///< Minimum number of samples a skew estimate with a confidence interval can be computed from
+#define PTP_FC_CI_Z_FACTOR (1.96)   ///< Multiplier of the standard deviation to get the 95% confidence interval of a long-term estimate
+
+/**
+ * Two-sided 95% quantiles of Student's t-distribution for 1...30 degrees of freedom.
+ */
+static const double T_QUANTILE_975[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+/**
+ * Get the multiplier of the standard error to get the 95% confidence interval.
+ *
+ * @param df degrees of freedom (at least 1)
+ * @return the t-quantile
+ */
+static double ptp_t_quantile_975(uint32_t df) {
+    uint32_t tableLen = sizeof(T_QUANTILE_975) / sizeof(T_QUANTILE_975[0]);
+    if (df <= tableLen) {
+        return T_QUANTILE_975[MAX(df, 1) - 1];
+    } else {
+        return PTP_FC_CI_Z_FACTOR + 2.4 / df; // within 0.002 of the exact value above 30 degrees of freedom
+    }
+}
+
+/**
+ * Reset the skew estimator.
+ */
+static void ptp_skew_est_reset() {
+    memset(&S.slave.skewEst, 0, sizeof(PtpSkewEstimator));
+}
+
+/**
+ * Feed the skew estimator with a new Sync sample.
+ * The estimator fits a line onto the (t1, t2 - t1) points using least squares, the slope of the line is the skew.
+ *
+ * @param pT1 pointer to the master timestamp
+ * @param pT2 pointer to the slave timestamp
+ * @return the estimate is complete
+ */
+static bool ptp_skew_est_add_sample(const TimestampI *pT1, const TimestampI *pT2) {
+    PtpSkewEstimator *e = &S.slave.skewEst;
+
+    // compute sample coordinates relative to the first sample to retain precision
+    TimestampI d, x, y;
+    subTime(&d, pT2, pT1);
+    if (e->n == 0) {
+        e->t1_0 = *pT1;
+        e->d_0 = d;
+    }
+    subTime(&x, pT1, &e->t1_0);
+    subTime(&y, &d, &e->d_0);
+    double xs = nsI(&x) * 1E-09, yns = nsI(&y);
+
+    // accumulate sums
+    e->n++;
+    e->sx += xs;
+    e->sy += yns;
+    e->sxx += xs * xs;
+    e->sxy += xs * yns;
+    e->syy += yns * yns;
+
+    if (e->n < 2) {
+        return false;
+    }
+
+    // compute the slope and its confidence interval
+    double n = e->n;
+    double Sxx = e->sxx - e->sx * e->sx / n;
+    double Sxy = e->sxy - e->sx * e->sy / n;
+    double Syy = e->syy - e->sy * e->sy / n;
+    if (Sxx <= 0.0) {
+        return false;
+    }
+
+    e->skew = Sxy / Sxx; // ns/s = ppb
+    if (e->n >= PTP_FC_SKEW_MIN_SAMPLES) {
+        double sse = MAX(Syy - e->skew * Sxy, 0.0);
+        e->ci_ppb = ptp_t_quantile_975(e->n - 2) * sqrt(sse / (n - 2) / Sxx);
+    } else {
+        e->ci_ppb = INFINITY;
+    }
+
+    return ((e->n >= PTP_FC_SKEW_MIN_SAMPLES) && (e->ci_ppb < S.slave.fastCompParams.skewCiLimit_ppb)) ||
+           (e->n >= S.slave.fastCompParams.skewMaxSamples);
+}
+
+/**
+ * Start measuring the acquisition time.
+ */
+static void ptp_start_acquisition() {
+    S.slave.acquiring = true;
+    S.slave.acqStartTick = S.ticks;
+}
+
+/**
+ * Compute the time error of our clock relative to a master.
+ *
+ * @param pD pointer to the time error object to be filled
+ * @param pScd pointer to the Sync cycle data holding T1, T2 and the correction fields of the Sync and the Follow_Up
+ * @param pMPD pointer to the mean path delay towards the master
+ */
+static void ptp_compute_time_error(TimestampI *pD, const PtpSyncCycleData *pScd, const TimestampI *pMPD) {
+    // variable for later substraction of summed correction fields
+    TimestampI cf = {0, 0};
+    nsToTsI(&cf, pScd->cf[T1] + pScd->cf[T2]);
+
+    // compute difference between master and slave clocks
+    subTime(pD, &pScd->t[T2], &pScd->t[T1]); // t2 - t1 ...
+    subTime(pD, pD, pMPD);                    // - MPD
+    subTime(pD, pD, &cf);                     // - CF of (Sync + Follow_Up)
+
+    // substract delay asymmetry (master-to-slave delay = MPD + asymmetry), the MPD itself is not affected
+    subTime(pD, pD, &S.hwoptions.delayAsymmetry);
+
+    // substract offset
+    subTime(pD, pD, &S.hwoptions.offset);
+
+    // normalize time difference (eliminate malformed time value issues)
+    normTime(pD);
+}
 
 /**
  * Perform clock correction based on gathered timestamps.
@@ -97,20 +218,11 @@ static void ptp_perform_correction() {
 
     // ------------------------------
 
-    // variable for later substraction of summed correction fields
-    TimestampI cf = {0, 0};
-    nsToTsI(&cf, S.slave.scd.cf[T1] + S.slave.scd.cf[T2]);
-
     // compute difference between master and slave clocks
-    subTime(&d, &syncSl, &syncMa);             // t2 - t1 ...
-    subTime(&d, &d, &S.network.meanPathDelay); // - MPD
-    subTime(&d, &d, &cf);                      // - CF of (Sync + Follow_Up)
+    ptp_compute_time_error(&d, &S.slave.scd, &S.network.meanPathDelay);
 
-    // substract offset
-    subTime(&d, &d, &S.hwoptions.offset);
-
-    // normalize time difference (eliminate malformed time value issues)
-    normTime(&d);
+    // check the age of a frequency memory restored from the configuration against the master's time
+    ptp_holdover_check_warm_start(syncMa.sec);
 
     // ------------------------------
 
@@ -132,55 +244,53 @@ static void ptp_perform_correction() {
     int64_t d_ns = nsI(&d);
     PtpFastCompState fcs = S.slave.fastCompState;
     if ((llabs(d_ns) > S.slave.coarseLimit) || (fcs != PTP_FC_IDLE)) {
+        const PtpFastCompParams *fcp = &S.slave.fastCompParams;
+        uint8_t fccntr = S.slave.fastCompCntr;
+
         if (fcs == PTP_FC_IDLE) {
             // reset the servo
-            PTP_SERVO_RESET();
+            ptp_servo_reset();
 
             // print info
             CLILOG(S.logging.info, "Time difference has exceeded the coarse correction threshold [%" __PRI64_PREFIX "dns], compensation commenced!\n", d_ns);
-        }
 
-        uint8_t fccntr = S.slave.fastCompCntr;
-        switch (fcs) {
-        case PTP_FC_IDLE:
+            // start skew estimation, the previous cycle is the first sample
+            ptp_skew_est_reset();
+            ptp_skew_est_add_sample(&S.slave.prevSyncMa, &S.slave.prevSyncSl);
+            ptp_start_acquisition();
+
             fcs = PTP_FC_SKEW_CORRECTION;
             fccntr = 0;
-        case PTP_FC_SKEW_CORRECTION:
-            if (fccntr == PTP_FC_SKEW_CORRECTION_CYCLES) {
+
+            // warm start: the restored frequency memory is already loaded, skip the skew estimation if it is accurate enough
+            const PtpHoldoverState *h = ptp_holdover_get_state();
+            if (ptp_holdover_take_warm_start() && ((PTP_FC_CI_Z_FACTOR * sqrt(h->freqVar)) < fcp->skewCiLimit_ppb)) {
+                CLILOG(S.logging.info, "Skew estimation skipped, running on the restored frequency.\n");
                 fcs = PTP_FC_TIME_CORRECTION;
-                fccntr = 0;
-            }
-            break;
-        case PTP_FC_TIME_CORRECTION:
-            if (fccntr == PTP_FC_TIME_CORRECTION_CYCLES) {
-                fcs = PTP_FC_TIME_CORRECTION_PROPAGATION;
-                fccntr = 0;
-            }
-            break;
-        case PTP_FC_TIME_CORRECTION_PROPAGATION:
-            if (fccntr == PTP_FC_TIME_PROPAGATION_CYCLES) {
-                fcs = PTP_FC_IDLE;
-                fccntr = 0;
             }
-            break;
         }
 
-        // skew correction
-        if (fcs == PTP_FC_SKEW_CORRECTION) {
-            // calculate clock skew
-            TimestampI dt2;
-            subTime(&dt2, &syncSl, &S.slave.prevSyncSl);
-            int64_t dt2_ns = nsI(&dt2);
-            double skew = (double)(dt2_ns - measSyncPeriod_ns) / (double)(measSyncPeriod_ns);
-            double skew_compensation_ppb = -skew * 1E+09;
+        if (fcs == PTP_FC_SKEW_CORRECTION) { // skew correction
+            bool done = ptp_skew_est_add_sample(&syncMa, &syncSl);
+            const PtpSkewEstimator *e = &S.slave.skewEst;
 
-            // compensate the clock skew
-            ptp_tune_clock(skew_compensation_ppb);
+            // log skew estimation
+            CLILOG(S.logging.info, "[%u/%u] Skew estimate: % 6.4f ppb (+-%.4f ppb)\n", e->n, fcp->skewMaxSamples, e->skew, e->ci_ppb);
 
-            // log skew compensation
-            CLILOG(S.logging.info, "[%u/%u] Skew compensation: % 6.4f ppb\n", fccntr + 1, PTP_FC_SKEW_CORRECTION_CYCLES, skew_compensation_ppb);
+            // compensate the clock skew once the estimate is settled
+            if (done) {
+                double skew_compensation_ppb = -e->skew;
+                ptp_tune_clock(skew_compensation_ppb);
+                CLILOG(S.logging.info, "Skew compensation: % 6.4f ppb\n", skew_compensation_ppb);
+
+                fcs = PTP_FC_TIME_CORRECTION;
+                fccntr = 0;
+            }
         } else if (fcs == PTP_FC_TIME_CORRECTION) { // time correction
             // compensate time error
+#ifdef PTP_HW_STEP_CLOCK
+            PTP_HW_STEP_CLOCK(-d_ns);
+#else
             TimestampU tu;
             PTP_HW_GET_TIME(&tu);
             uint64_t t_ns = nsU(&tu);
@@ -188,16 +298,27 @@ static void ptp_perform_correction() {
             TimestampI ti;
             nsToTsI(&ti, t_ns);
             PTP_SET_CLOCK((uint32_t)ti.sec, ti.nanosec);
+#endif
 
             // log time compensation
-            CLILOG(S.logging.info, "[%u/%u] Time compensation: %" __PRI64_PREFIX "d ns\n", fccntr + 1, PTP_FC_TIME_CORRECTION_CYCLES, d_ns);
+            CLILOG(S.logging.info, "[%u/%u] Time compensation: %" __PRI64_PREFIX "d ns\n", fccntr + 1, fcp->timeCorrCycles, d_ns);
+
+            if (++fccntr >= fcp->timeCorrCycles) {
+                fcs = (fcp->propCycles > 0) ? PTP_FC_TIME_CORRECTION_PROPAGATION : PTP_FC_IDLE;
+                fccntr = 0;
+            }
         } else if (fcs == PTP_FC_TIME_CORRECTION_PROPAGATION) {
-            CLILOG(S.logging.info, "[%u/%u] Waiting for time compensation to propagate.\n", fccntr + 1, PTP_FC_TIME_PROPAGATION_CYCLES);
+            CLILOG(S.logging.info, "[%u/%u] Waiting for time compensation to propagate.\n", fccntr + 1, fcp->propCycles);
+
+            if (++fccntr >= fcp->propCycles) {
+                fcs = PTP_FC_IDLE;
+                fccntr = 0;
+            }
         }
 
         // maintain FC state
         S.slave.fastCompState = fcs;
-        S.slave.fastCompCntr = fccntr + 1;
+        S.slave.fastCompCntr = fccntr;
 
         // retain sync cycle data
         goto retain_cycle_data;
@@ -212,13 +333,26 @@ static void ptp_perform_correction() {
                              measSyncPeriod_ns};
 
     // run controller
-    float corr_ppb = PTP_SERVO_RUN(nsI(&d), &saux);
+    float corr_ppb = ptp_servo_run(nsI(&d), &saux);
 
     // set clock tuning
     ptp_tune_clock(corr_ppb);
 
     // collect statistics
-    ptp_collect_stats(nsI(&d));
+    bool wasLocked = S.stats.locked;
+    ptp_collect_stats(nsI(&d), corr_ppb);
+
+    // register the time to lock
+    if (S.slave.acquiring && !wasLocked && S.stats.locked) {
+        S.slave.acquiring = false;
+        S.stats.timeToLock_ms = (S.ticks - S.slave.acqStartTick) * PTP_HEARTBEAT_TICKRATE_MS;
+        CLILOG(S.logging.info, "Time to lock: %u ms\n", S.stats.timeToLock_ms);
+    }
+
+    // feed the frequency memory only with the tuning of a locked clock
+    if (S.stats.locked) {
+        ptp_holdover_update(measSyncPeriod_ns * 1E-09);
+    }
 
     // log on cli (if enabled)
 #ifdef PTP_ADDEND_INTERFACE
@@ -251,6 +385,81 @@ retain_cycle_data:
     S.slave.prevTimeError = d;
 }
 
+#define PTP_ADAPTIVE_DELAY_REQ_MPD_FILT_COEFF (0.875) ///< Coefficient of the exponential path delay filter
+
+/**
+ * Feed the path delay filter of the adaptive (P)Delay_Req rate.
+ */
+static void ptp_adapt_track_mpd() {
+    PtpAdaptiveDelReqState *a = &S.slave.adaptDelReq;
+    double mpd = nsI(&S.network.meanPathDelay);
+
+    if (a->mpdSamples == 0) {
+        a->mpdMean = mpd;
+        a->mpdVar = 0.0;
+    } else {
+        double c = PTP_ADAPTIVE_DELAY_REQ_MPD_FILT_COEFF;
+        double e = mpd - a->mpdMean;
+        a->mpdMean += (1 - c) * e;
+        a->mpdVar = c * (a->mpdVar + (1 - c) * e * e);
+    }
+
+    if (a->mpdSamples < UINT16_MAX) {
+        a->mpdSamples++;
+    }
+}
+
+/**
+ * Apply a (P)Delay_Req log. period.
+ *
+ * @param lp logarithmic period
+ */
+static void ptp_apply_delay_req_period(int8_t lp) {
+    S.slave.adaptDelReq.logPeriod = lp;
+    S.slave.delReqPeriod_us = ptp_logi2us(lp);
+    S.slave.delReqTickPeriod = MAX(S.slave.delReqPeriod_us / (PTP_HEARTBEAT_TICKRATE_MS * 1000), 1);
+    if (S.slave.delReqPeriod_us < (PTP_HEARTBEAT_TICKRATE_MS * 1000)) {
+        CLILOG(S.logging.info, "(P)Delay_Req period 2^%d s is shorter than the heartbeat, one (P)Delay_Req is sent per %u ms\n", lp, PTP_HEARTBEAT_TICKRATE_MS);
+    }
+}
+
+/**
+ * Adapt the (P)Delay_Req rate to the synchronization state: stay on the profile's rate
+ * while not locked or the path delay is noisy, back off step-by-step otherwise.
+ */
+static void ptp_adapt_delay_req_period() {
+    PtpAdaptiveDelReqState *a = &S.slave.adaptDelReq;
+    int8_t lpMin = S.profile.logDelayReqPeriod; // the profile defines the shortest permitted period
+    int8_t lpMax = MIN(lpMin + a->maxBackoff, PTP_LOGPER_MAX);
+
+    bool stable = S.stats.locked && (S.slave.fastCompState == PTP_FC_IDLE) &&
+                  (a->mpdSamples > 1) && (sqrt(a->mpdVar) < PTP_ADAPTIVE_DELAY_REQ_MPD_STD_LIMIT_NS);
+
+    int8_t lp = a->logPeriod;
+    if (!stable) {
+        lp = lpMin;
+        a->stableCntr = 0;
+    } else if (++a->stableCntr >= PTP_ADAPTIVE_DELAY_REQ_STABLE_CYCLES) {
+        lp = MIN(lp + 1, lpMax);
+        a->stableCntr = 0;
+    }
+
+    if (lp != a->logPeriod) {
+        ptp_apply_delay_req_period(lp);
+        CLILOG(S.logging.info, "(P)Delay_Req log. period: %d\n", lp);
+    }
+}
+
+void ptp_slave_restart_delay_req_rate() {
+    PtpAdaptiveDelReqState *a = &S.slave.adaptDelReq;
+    a->stableCntr = 0;
+    a->mpdSamples = 0;
+
+    if (S.profile.logDelayReqPeriod != PTP_LOGPER_SYNCMATCHED) {
+        ptp_apply_delay_req_period(S.profile.logDelayReqPeriod);
+    }
+}
+
 /**
  * Initiate the E2E correction.
  * This piece of code has been extracted from the ptp_slave_process_message() to prevent code duplication.
@@ -269,7 +478,11 @@ static void ptp_commence_e2e_correction() {
     TimestampI d;
     subTime(&d, &S.slave.scd.t[T2], &S.slave.scd.t[T1]);
     if (d.sec != 0) {
+#ifdef PTP_HW_STEP_CLOCK
+        PTP_HW_STEP_CLOCK(-nsI(&d));
+#else
         PTP_SET_CLOCK((int32_t)S.slave.scd.t[T1].sec, S.slave.scd.t[T1].nanosec);
+#endif
     }
 
     // run servo only if issuing Delay_Requests is not syncmatched
@@ -287,6 +500,7 @@ static void ptp_commence_e2e_correction() {
 static void ptp_commence_p2p_correction(uint32_t pdelRespSeqId) {
     // compute mean path delay
     ptp_compute_mean_path_delay_p2p(S.slave.scd.t + 2, S.slave.scd.cf + 2, &S.network.meanPathDelay);
+    ptp_adapt_track_mpd();
 
     // store last response ID
     S.slave.messaging.lastRespondedDelReqId = pdelRespSeqId;
@@ -296,11 +510,213 @@ static void ptp_commence_p2p_correction(uint32_t pdelRespSeqId) {
     }
 }
 
+/**
+ * Fetch the transmit timestamp of the last (P)Delay_Req into the Sync cycle data. The timestamp
+ * is retained, since the Delay_Resps of both the master and the hot-standby refer to it.
+ *
+ * @return the timestamp is available
+ */
+static bool ptp_fetch_delay_req_timestamp() {
+    PtpSlaveMessagingState *m = &S.slave.messaging;
+    if (m->delReqTsFetched && (m->delReqTsSequenceID == m->delay_reqSequenceID)) {
+        return true;
+    }
+
+    if (!ptp_read_and_clear_transmit_timestamp(RPMT_DELAY_REQ, &S.slave.scd.t[T3])) {
+        return false;
+    }
+
+    m->delReqTsFetched = true;
+    m->delReqTsSequenceID = m->delay_reqSequenceID;
+    return true;
+}
+
+/**
+ * Is the message sent by the port of the current master? If the port is unknown, every master is accepted.
+ *
+ * @param pHeader pointer to the message header
+ * @return the message is originating from the master
+ */
+static bool ptp_is_from_master(const PtpHeader *pHeader) {
+    return (S.bmca.masterPortClockIdentity == 0) ||
+           ((pHeader->clockIdentity == S.bmca.masterPortClockIdentity) && (pHeader->sourcePortID == S.bmca.masterPortNumber));
+}
+
+/**
+ * Is the message sent by the port of the tracked hot-standby master?
+ *
+ * @param pHeader pointer to the message header
+ * @return the message is originating from the standby
+ */
+static bool ptp_is_from_standby(const PtpHeader *pHeader) {
+    const PtpSlaveStandbyState *sb = &S.slave.standby;
+    return sb->enabled && (sb->clockIdentity != 0) &&
+           (pHeader->clockIdentity == sb->clockIdentity) && (pHeader->sourcePortID == sb->portNumber);
+}
+
+/**
+ * Drop the measurements of the hot-standby master. The settings and the failover counter are retained.
+ */
+static void ptp_standby_clear() {
+    PtpSlaveStandbyState *sb = &S.slave.standby;
+    bool enabled = sb->enabled;
+    uint32_t failovers = sb->failovers;
+    memset(sb, 0, sizeof(PtpSlaveStandbyState));
+    sb->enabled = enabled;
+    sb->failovers = failovers;
+}
+
+/**
+ * Process a Sync or Follow_Up message of the hot-standby master and update its time error.
+ *
+ * @param pRawMsg pointer to the raw message
+ * @param pHeader pointer to the extracted header
+ */
+static void ptp_standby_process_sync(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
+    PtpSlaveStandbyState *sb = &S.slave.standby;
+    PtpMessageType mt = pHeader->messageType;
+    bool complete = false;
+
+    if (mt == PTP_MT_Sync) {
+        sb->scd.t[T2] = pRawMsg->ts;
+        sb->scd.cf[T1] = pHeader->correction_ns;
+        sb->sequenceID = pHeader->sequenceID;
+        sb->syncPeriodMs = ptp_logi2ms(pHeader->logMessagePeriod);
+
+        // handle two step/one step messaging
+        if (pHeader->flags.PTP_TWO_STEP) {
+            sb->m2sState = SWaitFollowUp;
+        } else {
+            ptp_extract_timestamps(&sb->scd.t[T1], pRawMsg->data, 1);
+            sb->scd.cf[T2] = 0;
+            sb->m2sState = SIdle;
+            complete = true;
+        }
+    } else if ((mt == PTP_MT_Follow_Up) && (sb->m2sState == SWaitFollowUp)) {
+        if (pHeader->sequenceID == sb->sequenceID) {
+            ptp_extract_timestamps(&sb->scd.t[T1], pRawMsg->data, 1);
+            sb->scd.cf[T2] = pHeader->correction_ns;
+            complete = true;
+        }
+        sb->m2sState = SIdle;
+    }
+
+    if (!complete) {
+        return;
+    }
+
+    sb->syncCycles++;
+    sb->lastSyncTick = S.ticks;
+
+    // the peer delay is measured towards the link partner, hence it is shared with the master in P2P mode
+    bool p2p = S.profile.delayMechanism == PTP_DM_P2P;
+    const TimestampI *pMPD = p2p ? &S.network.meanPathDelay : &sb->meanPathDelay;
+    if (p2p ? nonZeroI(pMPD) : sb->mpdValid) {
+        ptp_compute_time_error(&sb->offset, &sb->scd, pMPD);
+        sb->offsetValid = true;
+    }
+}
+
+/**
+ * Process a Delay_Resp of the hot-standby master responding to our (multicast) Delay_Req.
+ *
+ * @param pRawMsg pointer to the raw message
+ * @param pHeader pointer to the extracted header
+ */
+static void ptp_standby_process_delay_resp(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
+    PtpSlaveStandbyState *sb = &S.slave.standby;
+
+    // a complete Sync cycle of the standby and the Delay_Req timestamp are needed
+    if ((sb->syncCycles == 0) || (pHeader->sequenceID != S.slave.messaging.delay_reqSequenceID) || !ptp_fetch_delay_req_timestamp()) {
+        return;
+    }
+
+    PtpDelay_RespIdentification delay_respID;
+    ptp_read_delay_resp_id_data(&delay_respID, pRawMsg->data);
+    if (delay_respID.requestingSourceClockIdentity == S.hwoptions.clockIdentity &&
+        delay_respID.requestingSourcePortIdentity == PTP_PORT_ID) {
+        sb->scd.t[T3] = S.slave.scd.t[T3];                        // the Delay_Req is shared with the master
+        ptp_extract_timestamps(&sb->scd.t[T4], pRawMsg->data, 1); // store t4
+        sb->scd.cf[T4] = pHeader->correction_ns;                  // store correction field
+        ptp_compute_mean_path_delay_e2e(sb->scd.t, sb->scd.cf, &sb->meanPathDelay);
+        sb->mpdValid = true;
+    }
+}
+
+/**
+ * Follow the selection of the standby master.
+ */
+static void ptp_standby_tick() {
+    PtpSlaveStandbyState *sb = &S.slave.standby;
+    if (!sb->enabled) {
+        return;
+    }
+
+    const PtpForeignMaster *pFM = ptp_bmca_get_standby_master();
+    uint64_t clockIdentity = (pFM != NULL) ? pFM->clockIdentity : 0;
+    uint16_t portNumber = (pFM != NULL) ? pFM->portNumber : 0;
+    if ((clockIdentity != sb->clockIdentity) || (portNumber != sb->portNumber)) {
+        ptp_standby_clear();
+        sb->clockIdentity = clockIdentity;
+        sb->portNumber = portNumber;
+        CLILOG(S.logging.info, (clockIdentity != 0) ? "Hot-standby master selected\n" : "No hot-standby master\n");
+    }
+}
+
+/**
+ * Continue with the measurements of the hot-standby if it has become the master, so that
+ * no full re-acquisition is needed.
+ */
+static void ptp_standby_take_over() {
+    PtpSlaveStandbyState *sb = &S.slave.standby;
+    if (!sb->enabled || !sb->offsetValid ||
+        (sb->clockIdentity != S.bmca.masterPortClockIdentity) || (sb->portNumber != S.bmca.masterPortNumber)) {
+        return;
+    }
+
+    // the estimate is too old to rely on
+    if ((S.ticks - sb->lastSyncTick) * PTP_HEARTBEAT_TICKRATE_MS > PTP_HOT_STANDBY_MAX_AGE_SYNC_PERIODS * (uint32_t)sb->syncPeriodMs) {
+        return;
+    }
+
+    // seed the cycle data with the last Sync cycle of the standby
+    S.slave.scd = sb->scd;
+    S.slave.prevSyncMa = sb->scd.t[T1];
+    S.slave.prevSyncSl = sb->scd.t[T2];
+    S.slave.prevTimeError = sb->offset;
+    S.slave.messaging.m2sState = SIdle;
+    if (S.profile.delayMechanism == PTP_DM_E2E) {
+        S.network.meanPathDelay = sb->meanPathDelay;
+    }
+
+    CLILOG(S.logging.info, "Failed over to the hot-standby master, time error: %" __PRI64_PREFIX "d ns\n", nsI(&sb->offset));
+
+    // a new standby is to be selected
+    sb->failovers++;
+    ptp_standby_clear();
+}
+
 // packet processing
 void ptp_slave_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
     PtpMessageType mt = pHeader->messageType;
     PtpDelayMechanism dm = S.profile.delayMechanism;
 
+    // messages of the hot-standby master are processed separately
+    if (ptp_is_from_standby(pHeader)) {
+        if ((mt == PTP_MT_Sync) || (mt == PTP_MT_Follow_Up)) {
+            ptp_standby_process_sync(pRawMsg, pHeader);
+            return;
+        } else if ((mt == PTP_MT_Delay_Resp) && (dm == PTP_DM_E2E)) {
+            ptp_standby_process_delay_resp(pRawMsg, pHeader);
+            return;
+        }
+    }
+
+    // Sync, Follow_Up and Delay_Resp messages of other masters are ignored
+    if (((mt == PTP_MT_Sync) || (mt == PTP_MT_Follow_Up) || (mt == PTP_MT_Delay_Resp)) && !ptp_is_from_master(pHeader)) {
+        return;
+    }
+
     // process non-Announce messages
     if (mt == PTP_MT_Sync || mt == PTP_MT_Follow_Up) {
         switch (S.slave.messaging.m2sState) {
@@ -317,6 +733,11 @@ void ptp_slave_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
                 // save reception time
                 S.slave.scd.t[T2] = pRawMsg->ts;
 
+                // learn the address of the master (if not known from its Announce messages)
+                if ((!S.bmca.masterAddr.valid) && pRawMsg->addr.valid) {
+                    S.bmca.masterAddr = pRawMsg->addr;
+                }
+
                 // switch to next syncState
                 S.slave.messaging.sequenceID = pHeader->sequenceID;
 
@@ -377,7 +798,7 @@ void ptp_slave_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
             if (mt == PTP_MT_Delay_Resp) { // Delay_Resp processing
 
                 // try fetching Delay_Req timestamp
-                if (!ptp_read_and_clear_transmit_timestamp(RPMT_DELAY_REQ, &S.slave.scd.t[T3])) {
+                if (!ptp_fetch_delay_req_timestamp()) {
                     return;
                 }
 
@@ -392,6 +813,7 @@ void ptp_slave_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
 
                     // compute mean path delay
                     ptp_compute_mean_path_delay_e2e(S.slave.scd.t, S.slave.scd.cf, &S.network.meanPathDelay);
+                    ptp_adapt_track_mpd();
 
                     // store last response ID
                     S.slave.messaging.lastRespondedDelReqId = pHeader->sequenceID;
@@ -410,7 +832,7 @@ void ptp_slave_process_message(RawPtpMessage *pRawMsg, PtpHeader *pHeader) {
 
             } else if (mt == PTP_MT_PDelay_Resp) { // PDelay_Resp processing
                 // try fetching Delay_Req timestamp
-                if (!ptp_read_and_clear_transmit_timestamp(RPMT_DELAY_REQ, &S.slave.scd.t[T3])) {
+                if (!ptp_fetch_delay_req_timestamp()) {
                     return;
                 }
 
@@ -477,6 +899,22 @@ void ptp_slave_init() {
     // initialize coarse threshold
     ptp_set_coarse_threshold(PTP_DEFAULT_COARSE_TRIGGER_NS);
 
+    // initialize the frequency memory
+    ptp_holdover_init();
+
+    // initialize the adaptive (P)Delay_Req rate
+    S.slave.adaptDelReq.enabled = PTP_ADAPTIVE_DELAY_REQ;
+    S.slave.adaptDelReq.maxBackoff = PTP_ADAPTIVE_DELAY_REQ_MAX_BACKOFF;
+
+    // initialize the hot-standby master tracking
+    S.slave.standby.enabled = PTP_HOT_STANDBY;
+
+    // initialize fast compensation parameters
+    S.slave.fastCompParams.skewMaxSamples = PTP_FC_SKEW_MAX_SAMPLES;
+    S.slave.fastCompParams.timeCorrCycles = PTP_FC_TIME_CORRECTION_CYCLES;
+    S.slave.fastCompParams.propCycles = PTP_FC_TIME_PROPAGATION_CYCLES;
+    S.slave.fastCompParams.skewCiLimit_ppb = PTP_FC_SKEW_CI_LIMIT_PPB;
+
     // reset the slave module
     ptp_slave_reset();
 }
@@ -497,24 +935,32 @@ void ptp_slave_reset() {
     // reset messaging state
     memset(&S.slave.messaging, 0, sizeof(PtpSlaveMessagingState));
 
-    // reset addend/tuning
+    // reset addend/tuning, start from the memorized frequency if one is present
+    ptp_holdover_leave();
+    if (!ptp_holdover_restore_frequency()) {
 #ifdef PTP_ADDEND_INTERFACE
-    S.hwclock.addend = PTP_ADDEND_INIT; // HW clock state
-    PTP_SET_ADDEND(S.hwclock.addend);
+        S.hwclock.addend = PTP_ADDEND_INIT; // HW clock state
+        PTP_SET_ADDEND(S.hwclock.addend);
 #elif defined(PTP_HLT_INTERFACE)
-    S.hwclock.tuning_ppb = 0.0;
-    PTP_SET_TUNING(0.0);
+        S.hwclock.tuning_ppb = 0.0;
+        PTP_SET_TUNING(0.0);
 #endif
+    }
 
     // reset the controller
-    PTP_SERVO_RESET();
+    ptp_servo_reset();
 
     // reset fast correction state
     S.slave.fastCompState = PTP_FC_IDLE;
     S.slave.fastCompCntr = 0;
+    ptp_skew_est_reset();
+    S.slave.acquiring = false;
 
     // don't expect a Delay_Resp_Follow_Up message
     S.slave.expectPDelRespFollowUp = false;
+
+    // forget the hot-standby master
+    ptp_standby_clear();
 }
 
 void ptp_slave_tick() {
@@ -522,10 +968,12 @@ void ptp_slave_tick() {
         return;
     }
 
-    // Delay_Req transmission
+    // follow the selection of the hot-standby master
+    ptp_standby_tick();
+
+    // Delay_Req transmission (only a single exchange can be in progress, at most one is sent per tick)
     if (S.profile.logDelayReqPeriod != PTP_LOGPER_SYNCMATCHED) {
-        if (++S.slave.delReqTmr > S.slave.delReqTickPeriod) {
-            S.slave.delReqTmr = 0;
+        if (ptp_schedule_advance(&S.slave.delReqAcc_us, S.slave.delReqPeriod_us) > 0) {
 
             // check that our last Delay_Req has been responded
             if (S.profile.logDelayReqPeriod != PTP_LOGPER_SYNCMATCHED) {
@@ -539,19 +987,67 @@ void ptp_slave_tick() {
 
                 // dispatch (P)DELAY_REQ_SENT message
                 PTP_IUEV((S.profile.delayMechanism == PTP_DM_E2E) ? PTP_UEV_DELAY_REQ_SENT : PTP_UEV_PDELAY_REQ_SENT);
+
+                // adapt the rate of the following (P)Delay_Reqs
+                if (S.slave.adaptDelReq.enabled) {
+                    ptp_adapt_delay_req_period();
+                }
             }
         }
     }
 }
 
 void ptp_slave_enable() {
-    S.slave.enabled = true;
+    // resuming from holdover: the clock is running on the memorized frequency,
+    // drop the stale cycle data and restart the servo without touching the tuning
+    if (ptp_holdover_is_active()) {
+        S.slave.prevSyncMa = zeroTs;
+        S.slave.prevSyncSl = zeroTs;
+        S.slave.prevTimeError = zeroTs;
+        S.slave.messaging.m2sState = SIdle;
+        ptp_servo_reset();
+        ptp_holdover_leave();
+    }
 
-    if (S.profile.logDelayReqPeriod != PTP_LOGPER_SYNCMATCHED) {
-        S.slave.delReqTickPeriod = ptp_logi2ms(S.profile.logDelayReqPeriod) / PTP_HEARTBEAT_TICKRATE_MS;
+    // the new master is the tracked hot-standby: continue with its known time error and path delay
+    ptp_standby_take_over();
+
+    // time to lock is measured from the moment of starting to follow a master
+    if (!S.stats.locked) {
+        ptp_start_acquisition();
     }
+
+    S.slave.enabled = true;
+
+    // start on the profile's (P)Delay_Req rate
+    ptp_slave_restart_delay_req_rate();
 }
 
 void ptp_slave_disable() {
+    // the master has been lost while we were synchronized to it
+    if (S.slave.enabled) {
+        ptp_holdover_enter();
+    }
+
     S.slave.enabled = false;
 }
+
+void ptp_slave_switch_master() {
+    // the cycle data of the former master must not be mixed with the new master's,
+    // but the servo keeps tracking the clock (the hot-standby may seed the cycle data on enabling)
+    S.slave.prevSyncMa = zeroTs;
+    S.slave.prevSyncSl = zeroTs;
+    S.slave.prevTimeError = zeroTs;
+    S.slave.messaging.m2sState = SIdle;
+
+    S.slave.enabled = false;
+}
+
+const PtpSlaveStandbyState *ptp_slave_get_standby_state() {
+    return &S.slave.standby;
+}
+
+void ptp_slave_enable_standby(bool en) {
+    S.slave.standby.enabled = en;
+    ptp_standby_clear();
+}
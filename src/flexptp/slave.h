@@ -43,15 +43,40 @@ void ptp_slave_destroy();
 void ptp_slave_enable();
 
 /**
- * Stop PTP slave (autonomous) operation.
+ * Stop PTP slave (autonomous) operation. If the master has been lost while following it, holdover is entered.
  */
 void ptp_slave_disable();
 
+/**
+ * Suspend PTP slave operation while switching over to another master (BMCA state UNCALIBRATED).
+ * The servo and the clock tuning are retained, holdover is not entered.
+ */
+void ptp_slave_switch_master();
+
+/**
+ * Restart the (P)Delay_Req transmission on the profile's rate (relevant only if the adaptive rate is enabled).
+ */
+void ptp_slave_restart_delay_req_rate();
+
 /**
  * Tick the slave module.
  */
 void ptp_slave_tick();
 
+/**
+ * Enable or disable tracking the hot-standby master. The measurements of the standby are dropped.
+ *
+ * @param en enable tracking
+ */
+void ptp_slave_enable_standby(bool en);
+
+/**
+ * Get the hot-standby master tracking state.
+ *
+ * @return pointer to the hot-standby state
+ */
+const PtpSlaveStandbyState *ptp_slave_get_standby_state();
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,9 @@
 #include "ptp_core.h"
 #include "ptp_defs.h"
 #include "settings_interface.h"
+#include "timeutils.h"
+
+#include "minmax.h"
 
 
 ///\cond 0
@@ -17,19 +20,324 @@
 void ptp_clear_stats() {
 	memset(&S.stats, 0, sizeof(PtpStats));
 	S.stats.filtTimeErr = 100 * PTP_ACCURACY_LIMIT_NS; // prevent strange LOCKED-UNLOCKED-LOCKED series when starting up
+	ptp_clear_stability();
+	ptp_clear_histograms();
 }
 
 // get statistics
 const PtpStats* ptp_get_stats() {
 	return &S.stats;
 }
+
+// clear stability statistics
+void ptp_clear_stability() {
+	memset(&S.stability, 0, sizeof(PtpStabilityState));
+}
+
+// feed a time error sample into the stability statistics
+static void ptp_stability_add(double x) {
+	PtpStabilityState *st = &S.stability;
+
+	// a discontinuity restarts the decimation, the accumulated figures are kept
+	if (!st->continuous) {
+		for (uint8_t k = 0; k < PTP_STABILITY_OCTAVES; k++) {
+			st->octaves[k].blocks = 0;
+		}
+		st->continuous = true;
+	}
+	st->samples++;
+
+	// the sample is a block of the first octave, every second block of an octave completes a block of the next one
+	double mean = x, max = x, min = x, last = x;
+	for (uint8_t k = 0; k < PTP_STABILITY_OCTAVES; k++) {
+		PtpStabilityOctave *o = &st->octaves[k];
+
+		// MTIE of the first octave: window of the previous and the current sample
+		if ((k == 0) && (o->blocks >= 1)) {
+			o->mtie = MAX(o->mtie, MAX(max, o->last[1]) - MIN(min, o->last[1]));
+		}
+
+		// MTIE of the next octave: window of the last two blocks (and the sample preceding them), sliding by a single block
+		if (((k + 1) < PTP_STABILITY_OCTAVES) && (o->blocks >= 2)) {
+			double wmax = MAX(MAX(max, o->max), o->last[0]);
+			double wmin = MIN(MIN(min, o->min), o->last[0]);
+			st->octaves[k + 1].mtie = MAX(st->octaves[k + 1].mtie, wmax - wmin);
+		}
+
+		// second differences of the decimated time error (ADEV) and of the block means (TDEV)
+		if (o->blocks >= 2) {
+			double dx = last - 2.0 * o->last[1] + o->last[0];
+			double dm = mean - 2.0 * o->mean[1] + o->mean[0];
+			o->adevSum += dx * dx;
+			o->tdevSum += dm * dm;
+			o->n++;
+		}
+
+		// shift the block history
+		double prevMax = o->max, prevMin = o->min;
+		o->mean[0] = o->mean[1];
+		o->mean[1] = mean;
+		o->last[0] = o->last[1];
+		o->last[1] = last;
+		o->max = max;
+		o->min = min;
+		o->blocks++;
+
+		// only every second block is propagated to the next octave
+		if ((o->blocks % 2) != 0) {
+			break;
+		}
+
+		// merge the last two blocks
+		mean = 0.5 * (o->mean[0] + o->mean[1]);
+		max = MAX(max, prevMax);
+		min = MIN(min, prevMin);
+	}
+}
+
+// get stability statistics
+bool ptp_get_stability(uint8_t octave, PtpStabilityPoint *pPoint) {
+	const PtpStabilityState *st = &S.stability;
+
+	// at least a single MTIE window must have been covered (the windows of the higher octaves start at the third block of the previous one)
+	if ((octave >= PTP_STABILITY_OCTAVES) || (st->samples < ((octave == 0) ? 2 : ((uint32_t)3 << (octave - 1))))) {
+		return false;
+	}
+
+	const PtpStabilityOctave *o = &st->octaves[octave];
+	pPoint->tau_s = pow(2.0, st->logPeriod + octave);
+	pPoint->n = o->n;
+	pPoint->adev = (o->n > 0) ? (sqrt(o->adevSum / (2.0 * o->n)) / pPoint->tau_s * 1E-09) : 0.0;
+	pPoint->tdev_ns = (o->n > 0) ? sqrt(o->tdevSum / (6.0 * o->n)) : 0.0;
+	pPoint->mtie_ns = o->mtie;
+	return true;
+}
+
+#if PTP_HIST_BUCKETS > 256
+#error "The histogram buckets must be indexable by a single byte (PTP_HIST_OCTAVES * PTP_HIST_SUB_BUCKETS < 256)!"
+#endif
+
+#define PTP_HIST_EXPORT_VERSION (1) ///< Version of the binary histogram format
+
+static const double sHistUnits[PTP_HQ_N] = {1.0, 1.0, 1E-03};                 ///< Bucket units of the quantities (ns, ns, PPB)
+static const double sHistQuantiles[PTP_HIST_QUANTILES] = {0.5, 0.99, 0.999}; ///< Streaming percentiles
+
+// clear histograms and windowed percentiles
+void ptp_clear_histograms() {
+	memset(S.dist, 0, sizeof(S.dist));
+}
+
+// get the bucket index of a value given in bucket units
+static uint16_t ptp_hist_bucket(double v) {
+	if (!(v >= 1.0)) {
+		return 0;
+	}
+
+	int e;
+	double m = frexp(v, &e); // v = m * 2^e, 0.5 <= m < 1
+	uint32_t octave = e - 1;
+	if (octave >= PTP_HIST_OCTAVES) {
+		return PTP_HIST_BUCKETS - 1;
+	}
+
+	return 1 + octave * PTP_HIST_SUB_BUCKETS + (uint32_t)((2.0 * m - 1.0) * PTP_HIST_SUB_BUCKETS);
+}
+
+// get the lower bound of a bucket in bucket units
+static double ptp_hist_bucket_low(uint16_t idx) {
+	if (idx == 0) {
+		return 0.0;
+	}
+
+	idx--;
+	return ldexp(1.0 + (double)(idx % PTP_HIST_SUB_BUCKETS) / PTP_HIST_SUB_BUCKETS, idx / PTP_HIST_SUB_BUCKETS);
+}
+
+// feed a quantile estimator (P-square algorithm), count is the number of samples fed before
+static void ptp_sketch_add(PtpQuantileSketch *pK, double p, uint32_t count, double x) {
+	double *q = pK->q, *np = pK->np;
+	int32_t *n = pK->n;
+
+	// the first five samples are collected in order
+	if (count < 5) {
+		uint8_t i = count;
+		while ((i > 0) && (q[i - 1] > x)) {
+			q[i] = q[i - 1];
+			i--;
+		}
+		q[i] = x;
+
+		if (count == 4) {
+			for (i = 0; i < 5; i++) {
+				n[i] = i;
+			}
+			np[0] = 0.0;
+			np[1] = 2.0 * p;
+			np[2] = 4.0 * p;
+			np[3] = 2.0 + 2.0 * p;
+			np[4] = 4.0;
+		}
+		return;
+	}
+
+	// find the cell of the sample, extend the extremes
+	uint8_t c = 0;
+	if (x < q[0]) {
+		q[0] = x;
+	} else if (x >= q[4]) {
+		q[4] = x;
+		c = 3;
+	} else {
+		while (x >= q[c + 1]) {
+			c++;
+		}
+	}
+
+	// shift the marker positions
+	for (uint8_t i = c + 1; i < 5; i++) {
+		n[i]++;
+	}
+	np[1] += p / 2.0;
+	np[2] += p;
+	np[3] += (1.0 + p) / 2.0;
+	np[4] += 1.0;
+
+	// move the middle markers towards their desired positions
+	for (uint8_t i = 1; i <= 3; i++) {
+		double d = np[i] - n[i];
+		if (((d >= 1.0) && ((n[i + 1] - n[i]) > 1)) || ((d <= -1.0) && ((n[i - 1] - n[i]) < -1))) {
+			int32_t s = (d > 0.0) ? 1 : -1;
+
+			// piecewise parabolic prediction, linear if it would break the ordering
+			double qp = q[i] + (double)s / (n[i + 1] - n[i - 1]) *
+			                       ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+			                        (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+			if (!((q[i - 1] < qp) && (qp < q[i + 1]))) {
+				qp = q[i] + s * (q[i + s] - q[i]) / (n[i + s] - n[i]);
+			}
+
+			q[i] = qp;
+			n[i] += s;
+		}
+	}
+}
+
+// get the estimate of a quantile estimator, count is the number of samples fed
+static double ptp_sketch_get(const PtpQuantileSketch *pK, double p, uint32_t count) {
+	if (count == 0) {
+		return 0.0;
+	} else if (count < 5) {
+		return pK->q[(uint8_t)lround(p * (count - 1))];
+	} else {
+		return pK->q[2];
+	}
+}
+
+// feed a sample into the distribution of a quantity
+static void ptp_hist_add(PtpHistQuantity quantity, double v, uint32_t windowLen) {
+	PtpDistribution *pD = &S.dist[quantity];
+
+	// histogram
+	PtpHistogram *h = &pD->hist;
+	h->buckets[ptp_hist_bucket(v / sHistUnits[quantity])]++;
+	h->count++;
+	h->max = MAX(h->max, v);
+
+	// percentiles of the current window
+	PtpHistWindow *w = &pD->window;
+	for (uint8_t i = 0; i < PTP_HIST_QUANTILES; i++) {
+		ptp_sketch_add(&pD->sketch[i], sHistQuantiles[i], w->count, v);
+		w->p[i] = ptp_sketch_get(&pD->sketch[i], sHistQuantiles[i], w->count + 1);
+	}
+	w->max = MAX(w->max, v);
+	w->count++;
+
+	// the window is complete, start a new one
+	if (w->count >= windowLen) {
+		pD->last = *w;
+		memset(w, 0, sizeof(PtpHistWindow));
+	}
+}
+
+// get a percentile from the histogram
+double ptp_get_hist_percentile(PtpHistQuantity quantity, double p) {
+	const PtpHistogram *h = &S.dist[quantity].hist;
+	double rank = p * h->count;
+	uint32_t cum = 0;
+
+	// interpolate linearly inside the bucket containing the rank
+	for (uint16_t i = 0; i < PTP_HIST_BUCKETS; i++) {
+		uint32_t c = h->buckets[i];
+		if ((c > 0) && ((cum + c) >= rank)) {
+			double low = ptp_hist_bucket_low(i), high = ptp_hist_bucket_low(i + 1);
+			double v = (low + (high - low) * (rank - cum) / c) * sHistUnits[quantity];
+			return MIN(v, h->max);
+		}
+		cum += c;
+	}
+
+	return h->max;
+}
+
+// get distribution statistics
+const PtpDistribution *ptp_get_distribution(PtpHistQuantity quantity) {
+	return &S.dist[quantity];
+}
+
+// export a histogram in binary form
+uint32_t ptp_export_histogram(PtpHistQuantity quantity, uint8_t *pBuf, uint32_t size) {
+	const PtpHistogram *h = &S.dist[quantity].hist;
+
+	// header: version, quantity, octaves, sub-buckets, sample count (LE), max. (IEEE-754 single, LE)
+	if (size < 12) {
+		return 0;
+	}
+
+	float max = h->max;
+	uint32_t maxBits;
+	memcpy(&maxBits, &max, sizeof(uint32_t));
+
+	uint32_t len = 0;
+	pBuf[len++] = PTP_HIST_EXPORT_VERSION;
+	pBuf[len++] = quantity;
+	pBuf[len++] = PTP_HIST_OCTAVES;
+	pBuf[len++] = PTP_HIST_SUB_BUCKETS;
+	for (uint8_t i = 0; i < 4; i++) {
+		pBuf[len++] = (h->count >> (8 * i)) & 0xFF;
+	}
+	for (uint8_t i = 0; i < 4; i++) {
+		pBuf[len++] = (maxBits >> (8 * i)) & 0xFF;
+	}
+
+	// non-empty buckets: index, count (LEB128)
+	for (uint16_t i = 0; i < PTP_HIST_BUCKETS; i++) {
+		uint32_t c = h->buckets[i];
+		if (c == 0) {
+			continue;
+		}
+
+		if ((size - len) < 6) { // index and at most five bytes of count
+			return 0;
+		}
+
+		pBuf[len++] = i;
+		do {
+			uint8_t b = c & 0x7F;
+			c >>= 7;
+			pBuf[len++] = b | ((c != 0) ? 0x80 : 0x00);
+		} while (c != 0);
+	}
+
+	return len;
+}
+
 // filter parameters for statistics calculation
 // WARNING: Data calculation won't be totally accurate due to unvertain sampling time!
 
 #define PTP_TE_FILT_Fc_HZ (0.1) ///< Cutoff frequency (Hz)
 
 // collect statistics
-void ptp_collect_stats(int64_t d) {
+void ptp_collect_stats(int64_t d, float corr_ppb) {
 	double a = exp(-PTP_TE_FILT_Fc_HZ * 2 * M_PI * (S.slave.messaging.syncPeriodMs / 1000.0));
 
 	// performing time error filtering
@@ -47,4 +355,21 @@ void ptp_collect_stats(int64_t d) {
 	}
 
 	S.stats.locked = locked;
+
+	// feed the stability and distribution statistics with the samples of the locked clock, a change of the Sync period restarts the stability statistics
+	if (locked) {
+		if (S.stability.logPeriod != S.slave.messaging.logSyncPeriod) {
+			ptp_clear_stability();
+			S.stability.logPeriod = S.slave.messaging.logSyncPeriod;
+		}
+		ptp_stability_add(d);
+
+		// feed the distributions
+		uint32_t windowLen = (uint32_t)ceil(ldexp(PTP_HIST_WINDOW_S, -S.slave.messaging.logSyncPeriod));
+		ptp_hist_add(PTP_HQ_TIME_ERROR, fabs((double)d), windowLen);
+		ptp_hist_add(PTP_HQ_PATH_DELAY, fabs((double)nsI(&S.network.meanPathDelay)), windowLen);
+		ptp_hist_add(PTP_HQ_CORRECTION, fabs(corr_ppb), windowLen);
+	} else {
+		S.stability.continuous = false;
+	}
 }
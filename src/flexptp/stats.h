@@ -35,8 +35,63 @@ const PtpStats* ptp_get_stats();
  * Collect statistics.
  * 
  * @param d time error in nanoseconds.
+ * @param corr_ppb servo correction in PPB
  */
-void ptp_collect_stats(int64_t d);
+void ptp_collect_stats(int64_t d, float corr_ppb);
+
+/**
+ * Clear the stability statistics.
+ */
+void ptp_clear_stability();
+
+/**
+ * Get the stability statistics at an observation interval. ADEV and TDEV are estimated from
+ * non-overlapping second differences, MTIE from windows sliding by half the observation interval.
+ * Only the time error of the locked clock is taken into account.
+ *
+ * @param octave index of the observation interval: tau = 2^octave * Sync period
+ * @param pPoint pointer to the output object
+ * @return the observation interval is valid and has already been covered by the samples
+ */
+bool ptp_get_stability(uint8_t octave, PtpStabilityPoint *pPoint);
+
+/**
+ * Clear the histograms and the windowed percentiles.
+ */
+void ptp_clear_histograms();
+
+/**
+ * Get the distribution statistics of a quantity: the histogram since the last clearing, the
+ * streaming percentiles of the current window and those of the last completed window.
+ * Only the samples of the locked clock are collected.
+ *
+ * @param quantity quantity
+ * @return pointer to the distribution statistics
+ */
+const PtpDistribution *ptp_get_distribution(PtpHistQuantity quantity);
+
+/**
+ * Get a percentile from the histogram of a quantity (interpolated inside the bucket).
+ *
+ * @param quantity quantity
+ * @param p percentile as a fraction (e.g. 0.99)
+ * @return value of the percentile, 0 if the histogram is empty
+ */
+double ptp_get_hist_percentile(PtpHistQuantity quantity, double p);
+
+#define PTP_HIST_EXPORT_MAX_SIZE (12 + 6 * PTP_HIST_BUCKETS) ///< Size of a buffer any exported histogram fits in
+
+/**
+ * Export the histogram of a quantity in compact binary form: version, quantity, octaves
+ * and sub-buckets on a byte each, sample count (uint32, LE), largest sample (float, LE),
+ * then the index (byte) and the LEB128-coded count of every non-empty bucket.
+ *
+ * @param quantity quantity
+ * @param pBuf output buffer
+ * @param size size of the output buffer
+ * @return number of bytes written, 0 if the buffer is too small
+ */
+uint32_t ptp_export_histogram(PtpHistQuantity quantity, uint8_t *pBuf, uint32_t size);
 
 /**
  * Expression to test if the clock could be considered locked measuring agains a specific filtered PTP time error
@@ -6,6 +6,7 @@
 #include "event.h"
 #include "flexptp/port/osless/fifo.h"
 #include "msg_buf.h"
+#include "msg_utils.h"
 #include "network_stack_driver.h"
 #include "profiles.h"
 #include "ptp_core.h"
@@ -38,6 +39,14 @@ void task_ptp(void); // osless task function
 
 static bool sPTP_operating = false; // does the PTP subsystem operate?
 
+#ifdef FLEXPTP_LINUX
+#define CPU_USAGE_WINDOW_TICKS FLEXPTP_MS_TO_TICKS(1000) ///< Length of the CPU usage measurement window
+
+static uint32_t sCpuWindowTicks;  // ticks elapsed in the current measurement window
+static uint64_t sCpuTimeMark_ns;  // thread CPU time at the beginning of the window
+static uint32_t sCpuUsage_usps;   // CPU time consumed in the last window normalized to one second
+#endif
+
 // ---------------------------
 
 ///\cond 0
@@ -46,14 +55,19 @@ static bool sPTP_operating = false; // does the PTP subsystem operate?
 
 // ---------------------------
 
+#ifndef RX_PACKET_FIFO_LENGTH
 #define RX_PACKET_FIFO_LENGTH (16) ///< Receive packet FIFO length
+#endif
+
+#ifndef TX_PACKET_FIFO_LENGTH
 #define TX_PACKET_FIFO_LENGTH (16) ///< Transmit packet FIFO length
+#endif
 
 // FIFO for incoming packets
 #if defined(FLEXPTP_NON_LINUX_OS) || defined(FLEXPTP_OSLESS)
-#define EVENT_FIFO_LENGTH (16)        ///< Event FIFO length
-#define NOTIFICATION_FIFO_LENGTH (16) ///< Notification FIFO length
-#define TX_CALLBACK_FIFO_LENGTH (10)  ///< Transmit callback FIFO length
+#define EVENT_FIFO_LENGTH (16)                                                  ///< Event FIFO length
+#define NOTIFICATION_FIFO_LENGTH (RX_PACKET_FIFO_LENGTH + TX_PACKET_FIFO_LENGTH) ///< Notification FIFO length (every packet might post a notification)
+#define TX_CALLBACK_FIFO_LENGTH (10)                                            ///< Transmit callback FIFO length
 #endif
 
 #define TX_TTL_MS (2000) ///< TTL for outbound packets
@@ -453,8 +467,84 @@ bool ptp_event_enqueue(const PtpCoreEvent *event) {
     return ok;
 }
 
+/**
+ * Move a timestamp from the timestamping point to the reference plane.
+ *
+ * @param pTs pointer to the timestamp
+ * @param ingress the timestamp belongs to a received message
+ */
+static void ptp_apply_port_latency(TimestampI *pTs, bool ingress) {
+    PtpLinkSpeed ls = S.hwoptions.linkSpeed;
+    int32_t lat = ingress ? -S.hwoptions.latencies.ingress_ns[ls] : S.hwoptions.latencies.egress_ns[ls];
+    if (lat != 0) {
+        TimestampI l;
+        nsToTsI(&l, lat);
+        addTime(pTs, pTs, &l);
+        normTime(pTs);
+    }
+}
+
+#ifndef PTP_HW_ONE_STEP_SYNC
+/**
+ * Insert the origin timestamp into a one-step message right before it gets passed to the NSD.
+ * This is the software emulation of the hardware timestamp insertion, its accuracy is bounded by
+ * the jitter of the delay between reading the clock and the actual transmission.
+ *
+ * @param pMsg pointer to the message
+ */
+static void ptp_insert_origin_timestamp(RawPtpMessage *pMsg) {
+    TimestampU now;
+    ptp_time(&now);
+
+    TimestampI ts = {.sec = now.sec, .nanosec = now.nanosec};
+    TimestampI l;
+    nsToTsI(&l, PTP_ONE_STEP_SW_TX_LATENCY_NS);
+    addTime(&ts, &ts, &l);
+    normTime(&ts);
+    ptp_apply_port_latency(&ts, false);
+
+    ptp_write_binary_timestamps(pMsg->data, &ts, 1);
+}
+#endif
+
+#ifdef FLEXPTP_LINUX
+/**
+ * Measure the CPU time consumed by the flexPTP thread. Called on every heartbeat.
+ */
+static void ptp_measure_cpu_usage() {
+    if (++sCpuWindowTicks < CPU_USAGE_WINDOW_TICKS) {
+        return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    uint64_t now_ns = (uint64_t)ts.tv_sec * NANO_PREFIX + ts.tv_nsec;
+    uint64_t window_ms = (uint64_t)sCpuWindowTicks * PTP_HEARTBEAT_TICKRATE_MS;
+
+    // the first window only sets the mark
+    if (sCpuTimeMark_ns != 0) {
+        sCpuUsage_usps = (uint32_t)((now_ns - sCpuTimeMark_ns) / window_ms);
+    }
+
+    sCpuTimeMark_ns = now_ns;
+    sCpuWindowTicks = 0;
+}
+#endif
+
+uint32_t ptp_get_task_cpu_usage() {
+#ifdef FLEXPTP_LINUX
+    return sCpuUsage_usps;
+#else
+    return 0;
+#endif
+}
+
 // put ptp message onto processing queue
 void ptp_receive_enqueue(const void *pPayload, uint32_t len, uint32_t ts_sec, uint32_t ts_ns, int tp) {
+    ptp_receive_enqueue_from(pPayload, len, ts_sec, ts_ns, tp, NULL);
+}
+
+void ptp_receive_enqueue_from(const void *pPayload, uint32_t len, uint32_t ts_sec, uint32_t ts_ns, int tp, const PtpNetAddr *pSrcAddr) {
     // only consider messages received on the matching transport layer
     if ((!sPTP_operating) || (tp != ptp_get_transport_type())) {
         return;
@@ -469,9 +559,17 @@ void ptp_receive_enqueue(const void *pPayload, uint32_t len, uint32_t ts_sec, ui
         pMsgAlloc->size = copyLen;
         pMsgAlloc->ts.sec = ts_sec;
         pMsgAlloc->ts.nanosec = ts_ns;
+        ptp_apply_port_latency(&pMsgAlloc->ts, true);
         pMsgAlloc->tag = RPMT_RANDOM;
         pMsgAlloc->pTxCb = NULL; // not meaningful...
 
+        // store the source address (if known)
+        if (pSrcAddr != NULL) {
+            pMsgAlloc->addr = *pSrcAddr;
+        } else {
+            memset(&pMsgAlloc->addr, 0, sizeof(PtpNetAddr));
+        }
+
         // commit the allocation
         msgb_commit(&sRawRxMsgBuf, pMsgAlloc);
 
@@ -534,6 +632,10 @@ bool ptp_transmit_enqueue(const RawPtpMessage *pMsg) {
     }
 }
 
+uint32_t ptp_transmit_get_free_slots() {
+    return msgb_get_free(&sRawTxMsgBuf);
+}
+
 void ptp_transmit_timestamp_cb(uint32_t uid, uint32_t seconds, uint32_t nanoseconds) {
     // create timestamp association object
     TxTs ts = {.uid = uid, .seconds = seconds, .nanoseconds = nanoseconds};
@@ -662,6 +764,7 @@ void task_ptp(void) {
                 // insert the timestamp
                 pRawMsg->ts.sec = ts.seconds;
                 pRawMsg->ts.nanosec = ts.nanoseconds;
+                ptp_apply_port_latency(&pRawMsg->ts, false);
 
                 // set the 'sent' flag
                 msgb_set_sent(&sRawTxMsgBuf, pRawMsg);
@@ -675,6 +778,7 @@ void task_ptp(void) {
                 if ((pRawMsg->tag == RPMT_RANDOM) || (pRawMsg->pTxCb != NULL)) {
                     msgb_free(&sRawTxMsgBuf, pRawMsg);
                     CLILOG(S.logging.transmission, "[% 8u] %u AUTOFREE\n", S.ticks, ts.uid);
+                    ptp_transmit_slot_released();
                 }
             } else {
                 // null messages
@@ -703,10 +807,23 @@ void task_ptp(void) {
             RawPtpMessage *pRawMsg = msgb_get_by_uid(&sRawTxMsgBuf, uid);
             if (pRawMsg != NULL) {
                 CLILOG(S.logging.transmission, "[% 8u] %u (%u) --->\n", S.ticks, uid, pRawMsg->tag & (~((uint32_t)MSGBUF_TAG_OVERWRITE)));
-                ptp_nsd_transmit_msg(pRawMsg, uid);
+
+                if (pRawMsg->tx_drop) {
+                    // messages of the load generator are not put on the wire
+                    msgb_free(&sRawTxMsgBuf, pRawMsg);
+                    CLILOG(S.logging.transmission, "[% 8u] %u DROP\n", S.ticks, uid);
+                    ptp_transmit_slot_released();
+                } else {
+#ifndef PTP_HW_ONE_STEP_SYNC
+                    if (pRawMsg->tx_1step) {
+                        ptp_insert_origin_timestamp(pRawMsg);
+                    }
+#endif
+                    ptp_nsd_transmit_msg(pRawMsg, uid);
 #ifdef FLEXPTP_LINUX
-                sem_wait(&sTxCbSem);
+                    sem_wait(&sTxCbSem);
 #endif
+                }
             }
         }
 
@@ -764,6 +881,9 @@ void task_ptp(void) {
             if (event.code == PTP_CEV_HEARTBEAT) {
                 msgb_tick(&sRawRxMsgBuf);
                 msgb_tick(&sRawTxMsgBuf);
+#ifdef FLEXPTP_LINUX
+                ptp_measure_cpu_usage();
+#endif
             }
 
             // handle peaceful termination
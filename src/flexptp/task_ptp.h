@@ -48,6 +48,14 @@ void unreg_task_ptp();
  */
 bool is_flexPTP_operating();
 
+/**
+ * Get the CPU time consumed by the PTP task in the last second. Only measured in
+ * FLEXPTP_LINUX mode (the NSD's transceiver thread is not included), returns 0 otherwise.
+ *
+ * @return CPU time in microseconds per second
+ */
+uint32_t ptp_get_task_cpu_usage();
+
 /**
  * Enqueue PTP message.
  * 
@@ -59,6 +67,19 @@ bool is_flexPTP_operating();
  */
 void ptp_receive_enqueue(const void *pPayload, uint32_t len, uint32_t ts_sec, uint32_t ts_ns, int tp);
 
+/**
+ * Enqueue PTP message along with its source address. Unicast negotiation
+ * requires the source address of the received messages.
+ * 
+ * @param pPayload message payload
+ * @param len message length
+ * @param ts_sec reception timestamp seconds part
+ * @param ts_ns reception timestamp nanoseconds part
+ * @param tp transport protocol (L2/L4)
+ * @param pSrcAddr source address of the message, NULL if unknown
+ */
+void ptp_receive_enqueue_from(const void *pPayload, uint32_t len, uint32_t ts_sec, uint32_t ts_ns, int tp, const PtpNetAddr *pSrcAddr);
+
 /**
  * Put a PTP message into the transmit queue.
  * 
@@ -67,6 +88,13 @@ void ptp_receive_enqueue(const void *pPayload, uint32_t len, uint32_t ts_sec, ui
  */
 bool ptp_transmit_enqueue(const RawPtpMessage * pMsg);
 
+/**
+ * Get the number of free slots in the transmit buffer.
+ * 
+ * @return number of messages that can be enqueued for transmission
+ */
+uint32_t ptp_transmit_get_free_slots();
+
 /**
  * Transmit timestamp callback handler.
  * 
@@ -0,0 +1,583 @@
+#include "unicast.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "event.h"
+#include "format_utils.h"
+#include "master.h"
+#include "msg_utils.h"
+#include "ptp_core.h"
+#include "ptp_defs.h"
+#include "task_ptp.h"
+
+#include "minmax.h"
+
+///\cond 0
+#define S (gPtpCoreState)
+///\endcond
+
+#define PTP_SIGNALING_TARGET_PORT_ID_OFFSET (PTP_HEADER_LENGTH)                         ///< Offset of the targetPortIdentity field
+#define PTP_SIGNALING_TLV_OFFSET (PTP_SIGNALING_TARGET_PORT_ID_OFFSET + PTP_PORT_ID_LENGTH) ///< Offset of the first TLV
+#define PTP_TLV_HEADER_LENGTH (4)                                                        ///< Length of the TLV type and length fields
+
+#define PTP_TLV_LENGTH_REQUEST_UNICAST (6) ///< Length of the REQUEST_UNICAST_TRANSMISSION TLV value
+#define PTP_TLV_LENGTH_GRANT_UNICAST (8)   ///< Length of the GRANT_UNICAST_TRANSMISSION TLV value
+#define PTP_TLV_LENGTH_CANCEL_UNICAST (2)  ///< Length of the (ACKNOWLEDGE_)CANCEL_UNICAST_TRANSMISSION TLV value
+
+#define PTP_TLV_GRANT_RENEWAL_INVITED (0x01) ///< Renewal invited flag of the GRANT_UNICAST_TRANSMISSION TLV
+
+#define PTP_WILDCARD_CLOCK_IDENTITY (~((uint64_t)0)) ///< Wildcard clock identity
+#define PTP_WILDCARD_PORT_NUMBER (0xFFFF)            ///< Wildcard port number
+
+/**
+ * Message types belonging to the negotiable message indices.
+ */
+static const PtpMessageType sUnicastMsgTypes[PTP_UCM_N] = {PTP_MT_Announce, PTP_MT_Sync, PTP_MT_Delay_Resp};
+
+/**
+ * Message names for logging.
+ */
+static const char *sUnicastMsgNames[PTP_UCM_N] = {"Announce", "Sync", "Delay_Resp"};
+
+static RawPtpMessage sSignaling; ///< Signaling message being compiled
+
+// ---------------------------
+
+/**
+ * Look up the negotiable message index of a message type.
+ *
+ * @param mt message type
+ * @return message index or PTP_UCM_N if the message type cannot be negotiated
+ */
+static PtpUnicastMsg ptp_unicast_msg_index(uint8_t mt) {
+    PtpUnicastMsg ucm;
+    for (ucm = 0; ucm < PTP_UCM_N; ucm++) {
+        if (sUnicastMsgTypes[ucm] == mt) {
+            break;
+        }
+    }
+    return ucm;
+}
+
+static bool ptp_unicast_addr_equal(const PtpNetAddr *pA, const PtpNetAddr *pB) {
+    return (pA->valid == pB->valid) && (pA->ip == pB->ip) && (!memcmp(pA->hw, pB->hw, 6));
+}
+
+static uint32_t ptp_unicast_duration_to_ticks(uint32_t duration_s) {
+    return FLEXPTP_MS_TO_TICKS(MIN(duration_s, 0xFFFFFFFF / 1000) * 1000);
+}
+
+// ---------------------------
+
+/**
+ * Begin compiling a Signaling message.
+ *
+ * @param targetClockIdentity clock identity of the target port
+ * @param targetPortNumber number of the target port
+ */
+static void ptp_signaling_begin(uint64_t targetClockIdentity, uint16_t targetPortNumber) {
+    uint8_t *p = sSignaling.data + PTP_SIGNALING_TARGET_PORT_ID_OFFSET;
+    uint16_t portNumber = FLEXPTP_htons(targetPortNumber);
+    memcpy(p, &targetClockIdentity, 8);
+    memcpy(p + 8, &portNumber, 2);
+    sSignaling.size = PTP_SIGNALING_TLV_OFFSET;
+}
+
+/**
+ * Append a unicast negotiation TLV to the Signaling message under compilation.
+ *
+ * @param type TLV type
+ * @param ucm negotiated message
+ * @param logPeriod log. inter message period (REQUEST and GRANT only)
+ * @param duration_s duration (REQUEST and GRANT only)
+ */
+static void ptp_signaling_add_tlv(PtpTlvType type, PtpUnicastMsg ucm, int8_t logPeriod, uint32_t duration_s) {
+    uint16_t len = (type == PTP_TLV_REQUEST_UNICAST_TRANSMISSION) ? PTP_TLV_LENGTH_REQUEST_UNICAST : ((type == PTP_TLV_GRANT_UNICAST_TRANSMISSION) ? PTP_TLV_LENGTH_GRANT_UNICAST : PTP_TLV_LENGTH_CANCEL_UNICAST);
+    if ((sSignaling.size + PTP_TLV_HEADER_LENGTH + len) > MAX_PTP_MSG_SIZE) {
+        return;
+    }
+
+    uint8_t *p = sSignaling.data + sSignaling.size;
+    memset(p, 0, PTP_TLV_HEADER_LENGTH + len);
+
+    uint16_t tlvType = FLEXPTP_htons((uint16_t)type);
+    uint16_t tlvLen = FLEXPTP_htons(len);
+    memcpy(p, &tlvType, 2);
+    memcpy(p + 2, &tlvLen, 2);
+    p[4] = ((uint8_t)sUnicastMsgTypes[ucm]) << 4; // messageType occupies the upper nibble
+
+    if (type != PTP_TLV_CANCEL_UNICAST_TRANSMISSION && type != PTP_TLV_ACKNOWLEDGE_CANCEL_UNICAST_TRANSMISSION) {
+        uint32_t duration = FLEXPTP_htonl(duration_s);
+        p[5] = (uint8_t)logPeriod;
+        memcpy(p + 6, &duration, 4);
+        if (type == PTP_TLV_GRANT_UNICAST_TRANSMISSION) {
+            p[11] = PTP_TLV_GRANT_RENEWAL_INVITED;
+        }
+    }
+
+    sSignaling.size += PTP_TLV_HEADER_LENGTH + len;
+}
+
+/**
+ * Send the compiled Signaling message if it carries any TLVs.
+ *
+ * @param pAddr destination address
+ */
+static void ptp_signaling_send(const PtpNetAddr *pAddr) {
+    if (sSignaling.size <= PTP_SIGNALING_TLV_OFFSET) {
+        return;
+    }
+
+    PtpHeader header;
+    memset(&header, 0, sizeof(PtpHeader));
+    header.messageType = PTP_MT_Signaling;
+    header.transportSpecific = (uint8_t)S.profile.transportSpecific;
+    header.versionPTP = 2;
+    header.messageLength = sSignaling.size;
+    header.domainNumber = S.profile.domainNumber;
+    header.flags.PTP_UNICAST = true;
+    header.clockIdentity = S.hwoptions.clockIdentity;
+    header.sourcePortID = PTP_PORT_ID;
+    header.sequenceID = S.unicast.signalingSequenceID++;
+    header.control = PTP_CON_Other;
+    header.logMessagePeriod = 0x7F;
+    ptp_construct_binary_header(sSignaling.data, &header);
+
+    sSignaling.tag = RPMT_RANDOM;
+    sSignaling.pTxCb = NULL;
+    sSignaling.tx_dm = S.profile.delayMechanism;
+    sSignaling.tx_mc = PTP_MC_GENERAL;
+    sSignaling.ttl = FLEXPTP_RANDOM_TAGGED_MESSAGE_TTL_TICKS;
+    sSignaling.addr = *pAddr;
+
+    ptp_transmit_enqueue(&sSignaling);
+}
+
+// ---------------------------
+
+static PtpUnicastMasterEntry *ptp_unicast_find_master(const PtpNetAddr *pAddr) {
+    for (uint8_t i = 0; i < PTP_UNICAST_MASTER_TABLE_SIZE; i++) {
+        PtpUnicastMasterEntry *m = &S.unicast.masters[i];
+        if (m->addr.valid && ptp_unicast_addr_equal(&m->addr, pAddr)) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+static PtpUnicastGrantee *ptp_unicast_find_grantee(uint64_t clockIdentity, uint16_t portNumber) {
+    for (uint16_t i = 0; i < PTP_UNICAST_GRANT_TABLE_SIZE; i++) {
+        PtpUnicastGrantee *g = &S.unicast.grantees[i];
+        if (g->addr.valid && (g->clockIdentity == clockIdentity) && (g->portNumber == portNumber)) {
+            return g;
+        }
+    }
+    return NULL;
+}
+
+static PtpUnicastGrantee *ptp_unicast_alloc_grantee() {
+    for (uint16_t i = 0; i < PTP_UNICAST_GRANT_TABLE_SIZE; i++) {
+        PtpUnicastGrantee *g = &S.unicast.grantees[i];
+        if (!g->addr.valid) {
+            memset(g, 0, sizeof(PtpUnicastGrantee));
+            return g;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Serve a REQUEST_UNICAST_TRANSMISSION TLV (master side). A GRANT TLV is appended to the response.
+ */
+static void ptp_unicast_handle_request(const PtpNetAddr *pAddr, const PtpHeader *pHeader, PtpUnicastMsg ucm, int8_t logPeriod, uint32_t duration_s) {
+    bool masterEn = PTP_ENABLE_MASTER_OPERATION && (!(S.profile.flags & PTP_PF_SLAVE_ONLY));
+    bool periodOk = (logPeriod >= PTP_LOGPER_MIN) && (logPeriod <= PTP_LOGPER_MAX);
+    periodOk &= (ucm != PTP_UCM_SYNC) || (logPeriod >= PTP_LOGPER_SYNC_MIN); // at most one Sync is sent per tick
+
+    // find the grantee or allocate a new entry
+    PtpUnicastGrantee *g = NULL;
+    if (masterEn && periodOk && (duration_s > 0)) {
+        g = ptp_unicast_find_grantee(pHeader->clockIdentity, pHeader->sourcePortID);
+        if (g == NULL) {
+            g = ptp_unicast_alloc_grantee();
+            if (g != NULL) {
+                g->addr = *pAddr;
+                g->clockIdentity = pHeader->clockIdentity;
+                g->portNumber = pHeader->sourcePortID;
+            }
+        }
+    }
+
+    // deny if cannot serve
+    if (g == NULL) {
+        CLILOG(S.logging.info, "Unicast %s request denied\n", sUnicastMsgNames[ucm]);
+        ptp_signaling_add_tlv(PTP_TLV_GRANT_UNICAST_TRANSMISSION, ucm, logPeriod, 0);
+        return;
+    }
+
+    g->addr = *pAddr; // the grantee might have changed its address
+
+    // issue the grant
+    PtpUnicastGrant *gr = &g->grants[ucm];
+    duration_s = MIN(duration_s, PTP_UNICAST_MAX_GRANT_DURATION_S);
+    uint32_t periodTicks = MAX(1, FLEXPTP_MS_TO_TICKS(ptp_logi2ms(logPeriod)));
+    if ((gr->remTicks == 0) || (gr->periodTicks != periodTicks)) {
+        gr->tmr = (uint32_t)(g - S.unicast.grantees) % periodTicks; // spread the transmissions of the grantees
+        gr->acc_us = gr->tmr * PTP_HEARTBEAT_TICKRATE_MS * 1000;
+    }
+    gr->remTicks = ptp_unicast_duration_to_ticks(duration_s);
+    gr->periodTicks = periodTicks;
+    gr->logPeriod = logPeriod;
+
+    ptp_signaling_add_tlv(PTP_TLV_GRANT_UNICAST_TRANSMISSION, ucm, logPeriod, duration_s);
+}
+
+/**
+ * Process a GRANT_UNICAST_TRANSMISSION TLV (slave side).
+ */
+static void ptp_unicast_handle_grant(const PtpNetAddr *pAddr, PtpUnicastMsg ucm, int8_t logPeriod, uint32_t duration_s) {
+    PtpUnicastMasterEntry *m = ptp_unicast_find_master(pAddr);
+    if (m == NULL) {
+        return;
+    }
+
+    PtpUnicastGrant *gr = &m->grants[ucm];
+    if (duration_s == 0) {
+        CLILOG(S.logging.info, "Unicast %s grant denied by the master\n", sUnicastMsgNames[ucm]);
+        gr->remTicks = 0;
+        return;
+    }
+
+    gr->remTicks = ptp_unicast_duration_to_ticks(duration_s);
+    gr->logPeriod = logPeriod;
+}
+
+/**
+ * Process a CANCEL_UNICAST_TRANSMISSION TLV (both sides). An ACKNOWLEDGE_CANCEL TLV is appended to the response.
+ */
+static void ptp_unicast_handle_cancel(const PtpNetAddr *pAddr, const PtpHeader *pHeader, PtpUnicastMsg ucm) {
+    // cancelled by a grantee
+    PtpUnicastGrantee *g = ptp_unicast_find_grantee(pHeader->clockIdentity, pHeader->sourcePortID);
+    if (g != NULL) {
+        g->grants[ucm].remTicks = 0;
+    }
+
+    // cancelled by a master
+    PtpUnicastMasterEntry *m = ptp_unicast_find_master(pAddr);
+    if (m != NULL) {
+        m->grants[ucm].remTicks = 0;
+    }
+
+    ptp_signaling_add_tlv(PTP_TLV_ACKNOWLEDGE_CANCEL_UNICAST_TRANSMISSION, ucm, 0, 0);
+}
+
+/**
+ * Cancel the grants received from a master.
+ *
+ * @param m pointer to the master table entry
+ * @param mask bitmask of the message indices to be cancelled
+ */
+static void ptp_unicast_cancel_grants(PtpUnicastMasterEntry *m, uint8_t mask) {
+    ptp_signaling_begin(PTP_WILDCARD_CLOCK_IDENTITY, PTP_WILDCARD_PORT_NUMBER);
+    for (PtpUnicastMsg ucm = 0; ucm < PTP_UCM_N; ucm++) {
+        if ((mask & (1 << ucm)) && (m->grants[ucm].remTicks > 0)) {
+            ptp_signaling_add_tlv(PTP_TLV_CANCEL_UNICAST_TRANSMISSION, ucm, 0, 0);
+            m->grants[ucm].remTicks = 0;
+            m->grants[ucm].tmr = 0;
+        }
+    }
+    ptp_signaling_send(&m->addr);
+}
+
+/**
+ * Request a grant if it is missing or about to expire (slave side).
+ *
+ * @param m pointer to the master table entry
+ * @param ucm message index
+ * @param logPeriod log. message period to be requested
+ */
+static void ptp_unicast_maintain_grant(PtpUnicastMasterEntry *m, PtpUnicastMsg ucm, int8_t logPeriod) {
+    PtpUnicastGrant *gr = &m->grants[ucm];
+    uint32_t durTicks = ptp_unicast_duration_to_ticks(S.unicast.grantDuration_s);
+
+    // renew once less than a quarter of the duration remains or if the period has changed
+    bool renew = (gr->remTicks < (durTicks / 4)) || (gr->logPeriod != logPeriod);
+    if (renew && (gr->tmr == 0)) {
+        ptp_signaling_add_tlv(PTP_TLV_REQUEST_UNICAST_TRANSMISSION, ucm, logPeriod, S.unicast.grantDuration_s);
+        gr->tmr = FLEXPTP_MS_TO_TICKS(PTP_UNICAST_REQUEST_RETRY_MS);
+    }
+}
+
+// ---------------------------
+
+void ptp_unicast_init() {
+    memset(&S.unicast, 0, sizeof(PtpUnicastState));
+    S.unicast.enabled = PTP_UNICAST_NEGOTIATION;
+    S.unicast.grantDuration_s = PTP_UNICAST_GRANT_DURATION_S;
+}
+
+void ptp_unicast_reset() {
+    for (uint8_t i = 0; i < PTP_UNICAST_MASTER_TABLE_SIZE; i++) {
+        memset(S.unicast.masters[i].grants, 0, sizeof(S.unicast.masters[i].grants));
+    }
+    memset(S.unicast.grantees, 0, sizeof(S.unicast.grantees));
+}
+
+bool ptp_unicast_is_active() {
+    return S.unicast.enabled && (S.profile.delayMechanism == PTP_DM_E2E);
+}
+
+void ptp_unicast_tick() {
+    if (!ptp_unicast_is_active()) {
+        return;
+    }
+
+    // master side: expire grants and release the entries of silent grantees
+    for (uint16_t i = 0; i < PTP_UNICAST_GRANT_TABLE_SIZE; i++) {
+        PtpUnicastGrantee *g = &S.unicast.grantees[i];
+        if (!g->addr.valid) {
+            continue;
+        }
+
+        bool anyGrant = false;
+        for (PtpUnicastMsg ucm = 0; ucm < PTP_UCM_N; ucm++) {
+            PtpUnicastGrant *gr = &g->grants[ucm];
+            if (gr->remTicks > 0) {
+                gr->remTicks--;
+                anyGrant |= (gr->remTicks > 0);
+            }
+        }
+
+        if (!anyGrant) {
+            g->addr.valid = false;
+        }
+    }
+
+    // slave side: request and renew grants
+    for (uint8_t i = 0; i < PTP_UNICAST_MASTER_TABLE_SIZE; i++) {
+        PtpUnicastMasterEntry *m = &S.unicast.masters[i];
+        if (!m->addr.valid) {
+            continue;
+        }
+
+        for (PtpUnicastMsg ucm = 0; ucm < PTP_UCM_N; ucm++) {
+            PtpUnicastGrant *gr = &m->grants[ucm];
+            gr->remTicks = (gr->remTicks > 0) ? (gr->remTicks - 1) : 0;
+            gr->tmr = (gr->tmr > 0) ? (gr->tmr - 1) : 0;
+        }
+
+        ptp_signaling_begin(PTP_WILDCARD_CLOCK_IDENTITY, PTP_WILDCARD_PORT_NUMBER);
+
+        // Announce messages are requested from all masters to let the BMCA select
+        ptp_unicast_maintain_grant(m, PTP_UCM_ANNOUNCE, S.profile.logAnnouncePeriod);
+
+        // Sync and Delay_Resp messages are only requested from the selected master
+        bool selected = (S.bmca.state == PTP_BMCA_SLAVE) && ptp_unicast_addr_equal(&m->addr, &S.bmca.masterAddr);
+        if (selected) {
+            int8_t logDelReqPeriod = (S.profile.logDelayReqPeriod == PTP_LOGPER_SYNCMATCHED) ? S.profile.logSyncPeriod : S.profile.logDelayReqPeriod;
+            ptp_unicast_maintain_grant(m, PTP_UCM_SYNC, S.profile.logSyncPeriod);
+            ptp_unicast_maintain_grant(m, PTP_UCM_DELAY_RESP, logDelReqPeriod);
+        }
+
+        ptp_signaling_send(&m->addr);
+
+        // give back the grants of a master that is not followed anymore
+        if ((!selected) && ((m->grants[PTP_UCM_SYNC].remTicks > 0) || (m->grants[PTP_UCM_DELAY_RESP].remTicks > 0))) {
+            ptp_unicast_cancel_grants(m, (1 << PTP_UCM_SYNC) | (1 << PTP_UCM_DELAY_RESP));
+        }
+    }
+}
+
+void ptp_unicast_master_tick() {
+    for (uint16_t i = 0; i < PTP_UNICAST_GRANT_TABLE_SIZE; i++) {
+        PtpUnicastGrantee *g = &S.unicast.grantees[i];
+        if (!g->addr.valid) {
+            continue;
+        }
+
+        // Sync transmission (the granted period is not shorter than the heartbeat, so at most one Sync is due per tick)
+        PtpUnicastGrant *gr = &g->grants[PTP_UCM_SYNC];
+        if ((gr->remTicks > 0) && (ptp_schedule_advance(&gr->acc_us, ptp_logi2us(gr->logPeriod)) > 0)) {
+            ptp_master_send_unicast_sync(&g->addr, gr->sequenceID++, gr->logPeriod);
+        }
+
+        // Announce transmission
+        gr = &g->grants[PTP_UCM_ANNOUNCE];
+        if ((gr->remTicks > 0) && (++gr->tmr >= gr->periodTicks)) {
+            gr->tmr = 0;
+            ptp_master_send_unicast_announce(&g->addr, gr->sequenceID++, gr->logPeriod);
+        }
+    }
+}
+
+void ptp_unicast_process_signaling(const RawPtpMessage *pRawMsg, const PtpHeader *pHeader) {
+    // negotiation is only possible if the source is known
+    if ((!ptp_unicast_is_active()) || (!pRawMsg->addr.valid) || (pRawMsg->size < PTP_SIGNALING_TLV_OFFSET)) {
+        return;
+    }
+
+    // check the target port identity
+    const uint8_t *p = pRawMsg->data + PTP_SIGNALING_TARGET_PORT_ID_OFFSET;
+    uint64_t targetClockIdentity;
+    uint16_t targetPortNumber;
+    memcpy(&targetClockIdentity, p, 8);
+    memcpy(&targetPortNumber, p + 8, 2);
+    targetPortNumber = FLEXPTP_ntohs(targetPortNumber);
+    if (((targetClockIdentity != PTP_WILDCARD_CLOCK_IDENTITY) && (targetClockIdentity != S.hwoptions.clockIdentity)) ||
+        ((targetPortNumber != PTP_WILDCARD_PORT_NUMBER) && (targetPortNumber != PTP_PORT_ID))) {
+        return;
+    }
+
+    // responses are collected into a single Signaling message
+    ptp_signaling_begin(pHeader->clockIdentity, pHeader->sourcePortID);
+
+    // iterate over the TLVs
+    uint32_t size = MIN(pRawMsg->size, pHeader->messageLength);
+    uint32_t offset = PTP_SIGNALING_TLV_OFFSET;
+    while ((offset + PTP_TLV_HEADER_LENGTH) <= size) {
+        p = pRawMsg->data + offset;
+        uint16_t type, len;
+        memcpy(&type, p, 2);
+        memcpy(&len, p + 2, 2);
+        type = FLEXPTP_ntohs(type);
+        len = FLEXPTP_ntohs(len);
+
+        if ((offset + PTP_TLV_HEADER_LENGTH + len) > size) {
+            break;
+        }
+
+        PtpUnicastMsg ucm = ptp_unicast_msg_index(p[4] >> 4);
+        if ((ucm != PTP_UCM_N) && (len >= PTP_TLV_LENGTH_CANCEL_UNICAST)) {
+            int8_t logPeriod = (int8_t)p[5];
+            uint32_t duration_s = 0;
+            if (len >= PTP_TLV_LENGTH_REQUEST_UNICAST) {
+                memcpy(&duration_s, p + 6, 4);
+                duration_s = FLEXPTP_ntohl(duration_s);
+            }
+
+            switch (type) {
+            case PTP_TLV_REQUEST_UNICAST_TRANSMISSION:
+                if (len >= PTP_TLV_LENGTH_REQUEST_UNICAST) {
+                    ptp_unicast_handle_request(&pRawMsg->addr, pHeader, ucm, logPeriod, duration_s);
+                }
+                break;
+            case PTP_TLV_GRANT_UNICAST_TRANSMISSION:
+                if (len >= PTP_TLV_LENGTH_GRANT_UNICAST) {
+                    ptp_unicast_handle_grant(&pRawMsg->addr, ucm, logPeriod, duration_s);
+                }
+                break;
+            case PTP_TLV_CANCEL_UNICAST_TRANSMISSION:
+                ptp_unicast_handle_cancel(&pRawMsg->addr, pHeader, ucm);
+                break;
+            default: // ACKNOWLEDGE_CANCEL and unknown TLVs need no action
+                break;
+            }
+        }
+
+        offset += PTP_TLV_HEADER_LENGTH + len;
+    }
+
+    // send the responses
+    ptp_signaling_send(&pRawMsg->addr);
+}
+
+bool ptp_unicast_is_granted(uint64_t clockIdentity, uint16_t portNumber, PtpUnicastMsg ucm) {
+    PtpUnicastGrantee *g = ptp_unicast_find_grantee(clockIdentity, portNumber);
+    return (g != NULL) && (g->grants[ucm].remTicks > 0);
+}
+
+bool ptp_unicast_add_master(const PtpNetAddr *pAddr) {
+    if (ptp_unicast_find_master(pAddr) != NULL) {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < PTP_UNICAST_MASTER_TABLE_SIZE; i++) {
+        PtpUnicastMasterEntry *m = &S.unicast.masters[i];
+        if (!m->addr.valid) {
+            memset(m, 0, sizeof(PtpUnicastMasterEntry));
+            m->addr = *pAddr;
+            m->addr.valid = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// fingerprint of an address, carried by the removal event to verify the table entry
+static uint32_t ptp_unicast_addr_fingerprint(const PtpNetAddr *pAddr) {
+    return pAddr->ip ^ ((uint32_t)pAddr->hw[2] << 24 | (uint32_t)pAddr->hw[3] << 16 | (uint32_t)pAddr->hw[4] << 8 | pAddr->hw[5]);
+}
+
+bool ptp_unicast_remove_master(const PtpNetAddr *pAddr) {
+    PtpUnicastMasterEntry *m = ptp_unicast_find_master(pAddr);
+    if (m == NULL) {
+        return false;
+    }
+
+    // the cancellation is transmitted by the PTP task
+    PtpCoreEvent event = {.code = PTP_CEV_UNICAST_REMOVE_MASTER, .w = {m - S.unicast.masters}, .dw = {ptp_unicast_addr_fingerprint(pAddr)}};
+    return ptp_event_enqueue(&event);
+}
+
+void ptp_unicast_process_remove_master(uint8_t idx, uint32_t fingerprint) {
+    if (idx >= PTP_UNICAST_MASTER_TABLE_SIZE) {
+        return;
+    }
+
+    // the entry might have been changed since the removal was requested
+    PtpUnicastMasterEntry *m = &S.unicast.masters[idx];
+    if (!m->addr.valid || (ptp_unicast_addr_fingerprint(&m->addr) != fingerprint)) {
+        return;
+    }
+
+    ptp_unicast_cancel_grants(m, (1 << PTP_UCM_N) - 1);
+    m->addr.valid = false;
+}
+
+const PtpUnicastState *ptp_unicast_get_state() {
+    return &S.unicast;
+}
+
+bool ptp_unicast_parse_address(const char *str, PtpNetAddr *pAddr) {
+    memset(pAddr, 0, sizeof(PtpNetAddr));
+
+    unsigned int b[6];
+    char tail;
+    if (sscanf(str, "%x:%x:%x:%x:%x:%x%c", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &tail) == 6) {
+        for (uint8_t i = 0; i < 6; i++) {
+            if (b[i] > 0xFF) {
+                return false;
+            }
+            pAddr->hw[i] = b[i];
+        }
+    } else if (sscanf(str, "%u.%u.%u.%u%c", &b[0], &b[1], &b[2], &b[3], &tail) == 4) {
+        uint8_t ip[4];
+        for (uint8_t i = 0; i < 4; i++) {
+            if (b[i] > 0xFF) {
+                return false;
+            }
+            ip[i] = b[i];
+        }
+        memcpy(&pAddr->ip, ip, 4); // keep network byte order
+    } else {
+        return false;
+    }
+
+    pAddr->valid = true;
+    return true;
+}
+
+void ptp_unicast_print_address(const PtpNetAddr *pAddr) {
+    if (!pAddr->valid) {
+        MSG("-");
+    } else if (S.profile.transportType == PTP_TP_IPv4) {
+        const uint8_t *ip = (const uint8_t *)&pAddr->ip;
+        MSG("%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    } else {
+        const uint8_t *hw = pAddr->hw;
+        MSG("%02X:%02X:%02X:%02X:%02X:%02X", hw[0], hw[1], hw[2], hw[3], hw[4], hw[5]);
+    }
+}
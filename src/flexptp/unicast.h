@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file    unicast.h
+  * @copyright András Wiesner, 2026-\showdate "%Y"
+  * @brief   This module implements the unicast message negotiation
+  * (REQUEST/GRANT/CANCEL_UNICAST_TRANSMISSION TLVs carried by Signaling
+  * messages): the slave requests Announce, Sync and Delay_Resp grants from the
+  * masters of the unicast master table, while the master keeps a grant table
+  * and schedules transmissions per grantee.
+  ******************************************************************************
+  */
+
+#ifndef FLEXPTP_UNICAST_H_
+#define FLEXPTP_UNICAST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ptp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initialize the unicast negotiation module.
+ */
+void ptp_unicast_init();
+
+/**
+ * Drop all grants (both requested and issued ones). The unicast master table is retained.
+ */
+void ptp_unicast_reset();
+
+/**
+ * Tick the unicast negotiation: age the grants and issue requests and renewals.
+ */
+void ptp_unicast_tick();
+
+/**
+ * Schedule the per-grantee Announce and Sync transmissions. Called by the master module.
+ */
+void ptp_unicast_master_tick();
+
+/**
+ * Process a Signaling message carrying unicast negotiation TLVs.
+ *
+ * @param pRawMsg pointer to the received message
+ * @param pHeader pointer to the extracted header
+ */
+void ptp_unicast_process_signaling(const RawPtpMessage *pRawMsg, const PtpHeader *pHeader);
+
+/**
+ * Is unicast negotiation in effect? Negotiation is only applied with the E2E delay mechanism.
+ *
+ * @return unicast negotiation is enabled and applicable
+ */
+bool ptp_unicast_is_active();
+
+/**
+ * Check whether a grant for a given message type is held by a port.
+ *
+ * @param clockIdentity clock identity of the grantee
+ * @param portNumber port number of the grantee
+ * @param ucm message type
+ * @return a valid grant is present
+ */
+bool ptp_unicast_is_granted(uint64_t clockIdentity, uint16_t portNumber, PtpUnicastMsg ucm);
+
+/**
+ * Add a master to the unicast master table.
+ *
+ * @param pAddr address of the master
+ * @return the master has been added (or it was already present)
+ */
+bool ptp_unicast_add_master(const PtpNetAddr *pAddr);
+
+/**
+ * Remove a master from the unicast master table. Its grants are cancelled.
+ * Can be called from any thread: the removal is carried out by the PTP task.
+ *
+ * @param pAddr address of the master
+ * @return the master was found and its removal has been requested
+ */
+bool ptp_unicast_remove_master(const PtpNetAddr *pAddr);
+
+/**
+ * Carry out the removal of a master requested by ptp_unicast_remove_master().
+ * Called by the PTP task on processing the core event.
+ *
+ * @param idx index of the master table entry
+ * @param fingerprint fingerprint of the master's address
+ */
+void ptp_unicast_process_remove_master(uint8_t idx, uint32_t fingerprint);
+
+/**
+ * Get the unicast negotiation state.
+ *
+ * @return pointer to the unicast negotiation state
+ */
+const PtpUnicastState *ptp_unicast_get_state();
+
+/**
+ * Parse an address string: an IPv4 address in dotted decimal (IPv4 transport) or a colon
+ * separated hardware address (802.3 transport).
+ *
+ * @param str address string
+ * @param pAddr pointer to the address object to be filled
+ * @return the string could be parsed
+ */
+bool ptp_unicast_parse_address(const char *str, PtpNetAddr *pAddr);
+
+/**
+ * Print an address according to the current transport type.
+ *
+ * @param pAddr pointer to the address
+ */
+void ptp_unicast_print_address(const PtpNetAddr *pAddr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLEXPTP_UNICAST_H_ */
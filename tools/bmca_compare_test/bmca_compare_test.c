@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ * @file    bmca_compare_test.c
+ * @brief   Table-driven test of the BMCA data set comparison. Each case holds
+ * two data sets (an Announce body completed with the sending and receiving
+ * port identities) and the expected result of ptp_bmca_compare_datasets().
+ * Every case is also evaluated with A and B swapped, expecting the mirrored
+ * result, so the comparison must be antisymmetric.
+ ******************************************************************************
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <flexptp/bmca.h>
+#include <flexptp/ptp_core.h>
+#include <flexptp/task_ptp.h>
+
+PtpCoreState gPtpCoreState; ///< Core state (not used by the comparison)
+
+// the BMCA dispatches its state changes through the core event queue
+bool ptp_event_enqueue(const PtpCoreEvent *event) {
+    (void)event;
+    return true;
+}
+
+// ------------------------
+
+#define GM_1 (0x0000000000000100ULL) ///< A grandmaster identity
+#define GM_2 (0x0000000000000200ULL) ///< A grandmaster identity greater than GM_1
+
+#define PORT_LO (0x0000000000001000ULL) ///< A port clock identity
+#define PORT_HI (0x0000000000002000ULL) ///< A port clock identity greater than PORT_LO
+
+/// Announce body: priority1, clockClass, clockAccuracy, clockVariance, priority2, grandmaster identity, steps removed
+#define ANN(p1, cls, acc, var, p2, gm, steps) {0, (p1), (cls), (acc), (var), (p2), (gm), (steps), 0}
+
+/// Announce body of the default grandmaster with the given identity and steps removed
+#define ANN_DEF(gm, steps) ANN(128, 248, 0xFE, 0xFFFF, 128, (gm), (steps))
+
+/**
+ * @brief Data set of a test case.
+ */
+typedef struct {
+    PtpAnnounceBody ann;            ///< Announce body
+    uint64_t senderClockIdentity;   ///< Clock identity of the sending port
+    uint16_t senderPortNumber;      ///< Port number of the sending port
+    uint64_t receiverClockIdentity; ///< Clock identity of the receiving port
+    uint16_t receiverPortNumber;    ///< Port number of the receiving port
+} TestDataset;
+
+/**
+ * @brief Test case.
+ */
+typedef struct {
+    const char *name;           ///< Description of the case
+    TestDataset a;              ///< Data set A
+    TestDataset b;              ///< Data set B
+    PtpBmcaCompResult expected; ///< Expected result of comparing A to B
+} TestCase;
+
+static const TestCase sCases[] = {
+    // ---- part A: different grandmasters, the properties decide in order ----
+    {"priority1 lower", {ANN(127, 248, 0xFE, 0xFFFF, 128, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"priority1 higher", {ANN(129, 248, 0xFE, 0xFFFF, 128, GM_1, 0), PORT_LO, 1, PORT_LO, 1}, {ANN_DEF(GM_2, 0), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_B_BETTER},
+    {"priority1 beats clockClass", {ANN(127, 255, 0xFE, 0xFFFF, 128, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"clockClass lower", {ANN(128, 6, 0xFE, 0xFFFF, 128, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"clockClass higher", {ANN(128, 250, 0xFE, 0xFFFF, 128, GM_1, 0), PORT_LO, 1, PORT_LO, 1}, {ANN_DEF(GM_2, 0), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_B_BETTER},
+    {"clockClass beats clockAccuracy", {ANN(128, 6, 0xFE, 0xFFFF, 128, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN(128, 7, 0x20, 0xFFFF, 128, GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"clockAccuracy lower", {ANN(128, 248, 0x21, 0xFFFF, 128, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"clockAccuracy beats clockVariance", {ANN(128, 248, 0x21, 0xFFFF, 128, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN(128, 248, 0x22, 0x4000, 128, GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"clockVariance lower", {ANN(128, 248, 0xFE, 0x4000, 128, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"clockVariance beats priority2", {ANN(128, 248, 0xFE, 0x4000, 200, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN(128, 248, 0xFE, 0x4001, 0, GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"priority2 lower", {ANN(128, 248, 0xFE, 0xFFFF, 127, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"priority2 higher", {ANN(128, 248, 0xFE, 0xFFFF, 129, GM_1, 0), PORT_LO, 1, PORT_LO, 1}, {ANN_DEF(GM_2, 0), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_B_BETTER},
+    {"priority2 beats identity", {ANN(128, 248, 0xFE, 0xFFFF, 127, GM_2, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"grandmaster identity lower", {ANN_DEF(GM_1, 0), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_2, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"part A ignores steps removed", {ANN_DEF(GM_1, 10), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_2, 0), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+
+    // ---- part B: same grandmaster, steps removed differ by two or more ----
+    {"steps removed +2", {ANN_DEF(GM_1, 3), PORT_LO, 1, PORT_HI, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_B_BETTER},
+    {"steps removed -2", {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 3), PORT_LO, 1, PORT_HI, 1}, PTP_BMCA_A_BETTER},
+    {"steps removed +5", {ANN_DEF(GM_1, 5), PORT_LO, 1, PORT_LO, 2}, {ANN_DEF(GM_1, 0), PORT_HI, 1, PORT_LO, 2}, PTP_BMCA_B_BETTER},
+
+    // ---- part B: A is one step further, its receiver and sender decide ----
+    {"steps +1, receiver < sender", {ANN_DEF(GM_1, 2), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 2, PORT_LO, 1}, PTP_BMCA_B_BETTER},
+    {"steps +1, receiver > sender", {ANN_DEF(GM_1, 2), PORT_LO, 1, PORT_HI, 1}, {ANN_DEF(GM_1, 1), PORT_LO, 2, PORT_HI, 1}, PTP_BMCA_B_BETTER_BY_TOPOLOGY},
+    {"steps +1, receiver port < sender port", {ANN_DEF(GM_1, 2), PORT_LO, 2, PORT_LO, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_B_BETTER},
+    {"steps +1, receiver port > sender port", {ANN_DEF(GM_1, 2), PORT_LO, 1, PORT_LO, 2}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 2}, PTP_BMCA_B_BETTER_BY_TOPOLOGY},
+    {"steps +1, receiver = sender (looped back)", {ANN_DEF(GM_1, 2), PORT_LO, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_ERROR_1},
+
+    // ---- part B: B is one step further, its receiver and sender decide ----
+    {"steps -1, receiver < sender", {ANN_DEF(GM_1, 1), PORT_HI, 2, PORT_LO, 1}, {ANN_DEF(GM_1, 2), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_A_BETTER},
+    {"steps -1, receiver > sender", {ANN_DEF(GM_1, 1), PORT_LO, 2, PORT_HI, 1}, {ANN_DEF(GM_1, 2), PORT_LO, 1, PORT_HI, 1}, PTP_BMCA_A_BETTER_BY_TOPOLOGY},
+    {"steps -1, receiver = sender (looped back)", {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 2), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_ERROR_1},
+
+    // ---- part B: equal steps removed, the senders then the receiving ports decide ----
+    {"equal steps, sender lower", {ANN_DEF(GM_1, 1), PORT_LO, 1, PORT_HI, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_HI, 1}, PTP_BMCA_A_BETTER_BY_TOPOLOGY},
+    {"equal steps, sender higher", {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 1), PORT_LO, 1, PORT_LO, 1}, PTP_BMCA_B_BETTER_BY_TOPOLOGY},
+    {"equal steps, sender port lower", {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 2, PORT_LO, 1}, PTP_BMCA_A_BETTER_BY_TOPOLOGY},
+    {"equal steps, sender beats receiver port", {ANN_DEF(GM_1, 1), PORT_LO, 1, PORT_HI, 9}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_HI, 1}, PTP_BMCA_A_BETTER_BY_TOPOLOGY},
+    {"equal steps, same sender, receiver port lower", {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 2}, PTP_BMCA_A_BETTER_BY_TOPOLOGY},
+    {"equal steps, same sender, receiver port higher", {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 3}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 2}, PTP_BMCA_B_BETTER_BY_TOPOLOGY},
+    {"equal steps, same sender and receiver (duplicate)", {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, {ANN_DEF(GM_1, 1), PORT_HI, 1, PORT_LO, 1}, PTP_BMCA_ERROR_2},
+};
+
+static const char *sResultNames[] = {
+    "A_BETTER",
+    "A_BETTER_BY_TOPOLOGY",
+    "B_BETTER",
+    "B_BETTER_BY_TOPOLOGY",
+    "ERROR_1",
+    "ERROR_2"};
+
+// ------------------------
+
+// the result expected if A and B are swapped
+static PtpBmcaCompResult test_mirror(PtpBmcaCompResult r) {
+    switch (r) {
+    case PTP_BMCA_A_BETTER:
+        return PTP_BMCA_B_BETTER;
+    case PTP_BMCA_A_BETTER_BY_TOPOLOGY:
+        return PTP_BMCA_B_BETTER_BY_TOPOLOGY;
+    case PTP_BMCA_B_BETTER:
+        return PTP_BMCA_A_BETTER;
+    case PTP_BMCA_B_BETTER_BY_TOPOLOGY:
+        return PTP_BMCA_A_BETTER_BY_TOPOLOGY;
+    default:
+        return r; // the errors are symmetric
+    }
+}
+
+// compare two test data sets
+static PtpBmcaCompResult test_compare(const TestDataset *pA, const TestDataset *pB) {
+    PtpBmcaDataset a = {&pA->ann, pA->senderClockIdentity, pA->senderPortNumber, pA->receiverClockIdentity, pA->receiverPortNumber};
+    PtpBmcaDataset b = {&pB->ann, pB->senderClockIdentity, pB->senderPortNumber, pB->receiverClockIdentity, pB->receiverPortNumber};
+    return ptp_bmca_compare_datasets(&a, &b);
+}
+
+int main() {
+    uint32_t n = sizeof(sCases) / sizeof(sCases[0]);
+    uint32_t failures = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const TestCase *pTC = &sCases[i];
+        PtpBmcaCompResult ab = test_compare(&pTC->a, &pTC->b);
+        PtpBmcaCompResult ba = test_compare(&pTC->b, &pTC->a);
+        PtpBmcaCompResult baExpected = test_mirror(pTC->expected);
+        bool ok = (ab == pTC->expected) && (ba == baExpected);
+        failures += ok ? 0 : 1;
+
+        MSG("%-50s %-21s", pTC->name, sResultNames[pTC->expected]);
+        if (ok) {
+            MSG(" ok\n");
+        } else {
+            MSG(" FAILED: A-B: %s, B-A: %s (expected %s)\n", sResultNames[ab], sResultNames[ba], sResultNames[baExpected]);
+        }
+    }
+
+    MSG("\n%u cases, %u failed\n", n, failures);
+    MSG("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,423 @@
+/**
+ ******************************************************************************
+ * @file    bmca_sim.c
+ * @brief   In-process BMCA scale simulator. A number of nodes, each running the
+ * unmodified flexPTP BMCA, are placed onto a virtual broadcast network that
+ * carries Announce messages only. The BMCA is driven through its regular entry
+ * points (ptp_handle_announce_msg() and ptp_bmca_tick()); the state of the node
+ * being processed is swapped into the core state before each call. Convergence
+ * time, message counts and flapping are measured while the best master leaves
+ * and rejoins the network.
+ ******************************************************************************
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <flexptp/bmca.h>
+#include <flexptp/format_utils.h>
+#include <flexptp/minmax.h>
+#include <flexptp/ptp_core.h>
+#include <flexptp/ptp_defs.h>
+#include <flexptp/task_ptp.h>
+
+#include <host_rand.h>
+
+///\cond 0
+#define S (gPtpCoreState)
+///\endcond
+
+PtpCoreState gPtpCoreState; ///< Core state, holding the context of the node being processed
+
+/**
+ * @brief Kinds of grandmaster changes, by the grandmaster adopted.
+ */
+typedef enum {
+    SIM_GMC_SELF,     ///< The node assumes itself to be the grandmaster
+    SIM_GMC_NONE,     ///< A slave-only node drops its grandmaster
+    SIM_GMC_EXPECTED, ///< The node adopts the grandmaster expected in the phase
+    SIM_GMC_OTHER,    ///< The node adopts another (transient) grandmaster
+    SIM_GMC_N         ///< Number of grandmaster change kinds
+} SimGmChangeKind;
+
+/**
+ * @brief Simulated node.
+ */
+typedef struct {
+    PtpBmcaState bmca;                ///< BMCA state of the node
+    PtpMasterProperties capabilities; ///< Capabilities of the node
+    uint64_t clockIdentity;           ///< Clock identity
+    uint8_t priority1;                ///< Priority 1 assigned to the node
+    uint8_t profileFlags;             ///< Profile flags (slave-only nodes)
+    bool online;                      ///< The node is attached to the network
+    uint32_t annTmr;                  ///< Announce transmission timer (ticks)
+    uint32_t stateChanges;            ///< Number of BMCA state changes
+    uint32_t masterChanges;           ///< Number of grandmaster changes
+    uint32_t phaseMasterChanges;      ///< Number of grandmaster changes in the current phase
+} SimNode;
+
+/**
+ * @brief Announce in flight.
+ */
+typedef struct {
+    uint32_t sender;      ///< Index of the sending node
+    PtpAnnounceBody body; ///< Announce body
+} SimAnnounce;
+
+/**
+ * @brief Measurements of a simulation phase.
+ */
+typedef struct {
+    uint32_t announcesSent;        ///< Number of Announces transmitted
+    uint64_t announcesDelivered;   ///< Number of Announce receptions
+    uint64_t announcesLost;        ///< Number of Announce receptions dropped by the network
+    uint32_t stateChanges;         ///< Number of BMCA state changes across all nodes
+    uint32_t masterChanges;        ///< Number of grandmaster changes across all nodes
+    uint32_t maxNodeMasterChanges; ///< Highest number of grandmaster changes of a single node
+    uint32_t convergedSince;       ///< Tick since the network is continuously converged
+    bool converged;                ///< The network is converged
+    uint32_t convergences;         ///< Number of times the network has become converged (more than one means flapping)
+} SimPhaseStats;
+
+/**
+ * @brief Simulation parameters.
+ */
+typedef struct {
+    uint32_t nodes;         ///< Number of nodes
+    int8_t logAnnPeriod;    ///< Announce log. period
+    uint32_t masterPercent; ///< Percentage of master-capable nodes
+    uint32_t lossPermille;  ///< Announce loss probability per reception (per mille)
+    uint32_t phase_s;       ///< Duration of a phase (s)
+    uint32_t seed;          ///< Random seed
+    bool verbose;           ///< Print the BMCA state changes
+} SimParams;
+
+static SimParams sParams = {
+    .nodes = 100,
+    .logAnnPeriod = 0,
+    .masterPercent = 100,
+    .lossPermille = 0,
+    .phase_s = 60,
+    .seed = 1,
+    .verbose = false,
+};
+
+static SimNode *sNodes;                        ///< Nodes
+static SimNode *sCurrent;                      ///< Node being processed
+static SimAnnounce *sInFlight;                 ///< Announces to be delivered in the current tick
+static uint32_t sInFlightCnt;                  ///< Number of Announces in flight
+static SimAnnounce *sOutbox;                   ///< Announces transmitted in the current tick
+static uint32_t sOutboxCnt;                    ///< Number of Announces transmitted in the current tick
+static uint32_t sAnnPeriodTicks;               ///< Announce period in ticks
+static uint32_t sTicks;                        ///< Simulation time
+static uint64_t sExpectedGmId;                 ///< Clock identity of the grandmaster expected in the current phase
+static uint32_t sMasterChangeKinds[SIM_GMC_N]; ///< Grandmaster changes of the current phase by kind
+
+// ------------------------
+
+// the BMCA dispatches its state changes through the core event queue
+bool ptp_event_enqueue(const PtpCoreEvent *event) {
+    if ((sCurrent != NULL) && (event->code == PTP_CEV_BMCA_STATE_CHANGED)) {
+        sCurrent->stateChanges++;
+    }
+    return true;
+}
+
+// load the context of a node into the core state
+static void sim_node_enter(SimNode *pNode) {
+    S.bmca = pNode->bmca;
+    S.capabilities = pNode->capabilities;
+    S.hwoptions.clockIdentity = pNode->clockIdentity;
+    S.profile.flags = pNode->profileFlags;
+    S.ticks = sTicks;
+    sCurrent = pNode;
+}
+
+// store the context of a node from the core state
+static void sim_node_leave(SimNode *pNode) {
+    uint64_t gmId = S.bmca.masterProps.grandmasterClockIdentity;
+    if (gmId != pNode->bmca.masterProps.grandmasterClockIdentity) {
+        pNode->masterChanges++;
+        pNode->phaseMasterChanges++;
+
+        SimGmChangeKind kind;
+        if (gmId == pNode->clockIdentity) {
+            kind = SIM_GMC_SELF;
+        } else if (gmId == UINT64_MAX) { // worst master properties
+            kind = SIM_GMC_NONE;
+        } else if (gmId == sExpectedGmId) {
+            kind = SIM_GMC_EXPECTED;
+        } else {
+            kind = SIM_GMC_OTHER;
+        }
+        sMasterChangeKinds[kind]++;
+    }
+    pNode->bmca = S.bmca;
+    pNode->capabilities = S.capabilities;
+    sCurrent = NULL;
+}
+
+// attach a node to the network with a fresh BMCA state
+static void sim_node_start(SimNode *pNode) {
+    sim_node_enter(pNode);
+    ptp_bmca_reset();
+    ptp_bmca_init();
+    S.capabilities.priority1 = pNode->priority1;
+    sim_node_leave(pNode);
+
+    pNode->online = true;
+    pNode->annTmr = host_rand() % sAnnPeriodTicks; // Announce transmissions are not aligned
+}
+
+// find the node that should be elected: the best online master-capable one
+static int32_t sim_expected_grandmaster() {
+    int32_t best = -1;
+    for (uint32_t i = 0; i < sParams.nodes; i++) {
+        SimNode *pNode = &sNodes[i];
+        if (!pNode->online || (pNode->profileFlags & PTP_PF_SLAVE_ONLY)) {
+            continue;
+        }
+        if ((best < 0) || (ptp_select_better_master(&pNode->capabilities, &sNodes[best].capabilities) == 0)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// the network is converged if the expected grandmaster is the only MASTER and every other node is its SLAVE
+static bool sim_is_converged(int32_t gm) {
+    if (gm < 0) {
+        return false;
+    }
+
+    uint64_t gmIdentity = sNodes[gm].clockIdentity;
+    for (uint32_t i = 0; i < sParams.nodes; i++) {
+        const SimNode *pNode = &sNodes[i];
+        if (!pNode->online) {
+            continue;
+        }
+        if ((int32_t)i == gm) {
+            if (pNode->bmca.state != PTP_BMCA_MASTER) {
+                return false;
+            }
+        } else if ((pNode->bmca.state != PTP_BMCA_SLAVE) || (pNode->bmca.masterProps.grandmasterClockIdentity != gmIdentity)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// advance the simulation by one heartbeat tick
+static void sim_tick(SimPhaseStats *pStats) {
+    // deliver the Announces transmitted in the previous tick
+    PtpNetAddr noAddr = {0};
+    for (uint32_t a = 0; a < sInFlightCnt; a++) {
+        const SimAnnounce *pSA = &sInFlight[a];
+        PtpHeader header = {0};
+        header.messageType = PTP_MT_Announce;
+        header.clockIdentity = sNodes[pSA->sender].clockIdentity;
+        header.sourcePortID = PTP_PORT_ID;
+        header.logMessagePeriod = S.profile.logAnnouncePeriod;
+
+        for (uint32_t i = 0; i < sParams.nodes; i++) {
+            SimNode *pNode = &sNodes[i];
+            if (!pNode->online || (i == pSA->sender)) {
+                continue;
+            }
+            if ((host_rand() % 1000) < sParams.lossPermille) {
+                pStats->announcesLost++;
+                continue;
+            }
+
+            PtpAnnounceBody ann = pSA->body;
+            sim_node_enter(pNode);
+            ptp_handle_announce_msg(&ann, &header, &noAddr);
+            sim_node_leave(pNode);
+            pStats->announcesDelivered++;
+        }
+    }
+
+    // tick the nodes, MASTERs transmit their Announces
+    sOutboxCnt = 0;
+    for (uint32_t i = 0; i < sParams.nodes; i++) {
+        SimNode *pNode = &sNodes[i];
+        if (!pNode->online) {
+            continue;
+        }
+
+        sim_node_enter(pNode);
+        ptp_bmca_tick();
+        bool master = S.bmca.state == PTP_BMCA_MASTER;
+        sim_node_leave(pNode);
+
+        if (master && (++pNode->annTmr >= sAnnPeriodTicks)) {
+            pNode->annTmr = 0;
+            sOutbox[sOutboxCnt].sender = i;
+            sOutbox[sOutboxCnt].body = pNode->capabilities;
+            sOutboxCnt++;
+            pStats->announcesSent++;
+        }
+    }
+
+    // the transmitted Announces get delivered in the next tick
+    SimAnnounce *tmp = sInFlight;
+    sInFlight = sOutbox;
+    sInFlightCnt = sOutboxCnt;
+    sOutbox = tmp;
+
+    sTicks++;
+}
+
+// run a phase of the simulation and print its measurements
+static void sim_run_phase(const char *name) {
+    SimPhaseStats stats = {0};
+    uint32_t stateChanges0 = 0, masterChanges0 = 0;
+    for (uint32_t i = 0; i < sParams.nodes; i++) {
+        stateChanges0 += sNodes[i].stateChanges;
+        masterChanges0 += sNodes[i].masterChanges;
+        sNodes[i].phaseMasterChanges = 0;
+    }
+
+    int32_t gm = sim_expected_grandmaster();
+    sExpectedGmId = (gm >= 0) ? sNodes[gm].clockIdentity : 0;
+    memset(sMasterChangeKinds, 0, sizeof(sMasterChangeKinds));
+    uint32_t phaseStart = sTicks;
+    uint32_t phaseTicks = sParams.phase_s * 1000 / PTP_HEARTBEAT_TICKRATE_MS;
+    clock_t wallStart = clock();
+
+    for (uint32_t t = 0; t < phaseTicks; t++) {
+        sim_tick(&stats);
+
+        bool converged = sim_is_converged(gm);
+        if (converged && !stats.converged) {
+            stats.convergedSince = sTicks;
+            stats.convergences++;
+        }
+        stats.converged = converged;
+    }
+
+    for (uint32_t i = 0; i < sParams.nodes; i++) {
+        stats.stateChanges += sNodes[i].stateChanges;
+        stats.masterChanges += sNodes[i].masterChanges;
+        stats.maxNodeMasterChanges = MAX(stats.maxNodeMasterChanges, sNodes[i].phaseMasterChanges);
+    }
+    stats.stateChanges -= stateChanges0;
+    stats.masterChanges -= masterChanges0;
+
+    double wall_s = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+
+    MSG("--- %s ---\n", name);
+    if (stats.converged) {
+        MSG("Convergence time: %u ms", (stats.convergedSince - phaseStart) * PTP_HEARTBEAT_TICKRATE_MS);
+        MSG(" (converged %u time(s)%s)\n", stats.convergences, (stats.convergences > 1) ? ", flapping" : "");
+    } else {
+        MSG("Not converged within %u s\n", sParams.phase_s);
+    }
+    MSG("Announces sent: %u, delivered: %llu, lost: %llu\n", stats.announcesSent,
+        (unsigned long long)stats.announcesDelivered, (unsigned long long)stats.announcesLost);
+    MSG("BMCA state changes: %u, grandmaster changes: %u\n", stats.stateChanges, stats.masterChanges);
+    MSG("  grandmaster adopted: self: %u, none: %u, expected: %u, transient: %u (max. %u change(s) per node)\n",
+        sMasterChangeKinds[SIM_GMC_SELF], sMasterChangeKinds[SIM_GMC_NONE], sMasterChangeKinds[SIM_GMC_EXPECTED],
+        sMasterChangeKinds[SIM_GMC_OTHER], stats.maxNodeMasterChanges);
+    MSG("Simulation run time: %.2f s\n\n", wall_s);
+}
+
+static void sim_print_usage(const char *prog) {
+    MSG("Usage: %s [-n nodes] [-a log_ann_period] [-m master_capable_percent] [-l loss_permille] [-t phase_s] [-s seed] [-v]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:a:m:l:t:s:vh")) != -1) {
+        switch (opt) {
+        case 'n':
+            sParams.nodes = strtoul(optarg, NULL, 10);
+            break;
+        case 'a':
+            sParams.logAnnPeriod = (int8_t)strtol(optarg, NULL, 10);
+            break;
+        case 'm':
+            sParams.masterPercent = strtoul(optarg, NULL, 10);
+            break;
+        case 'l':
+            sParams.lossPermille = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            sParams.phase_s = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            sParams.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'v':
+            sParams.verbose = true;
+            break;
+        default:
+            sim_print_usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if ((sParams.nodes < 2) || (sParams.logAnnPeriod < PTP_LOGPER_MIN) || (sParams.logAnnPeriod > PTP_LOGPER_MAX) || (sParams.seed == 0)) {
+        sim_print_usage(argv[0]);
+        return 1;
+    }
+
+    // allocate the nodes and the message buffers
+    sNodes = calloc(sParams.nodes, sizeof(SimNode));
+    sInFlight = calloc(sParams.nodes, sizeof(SimAnnounce));
+    sOutbox = calloc(sParams.nodes, sizeof(SimAnnounce));
+    if ((sNodes == NULL) || (sInFlight == NULL) || (sOutbox == NULL)) {
+        MSG("Out of memory!\n");
+        return 1;
+    }
+
+    // settings shared by all nodes
+    memset(&S, 0, sizeof(PtpCoreState));
+    S.profile.logAnnouncePeriod = sParams.logAnnPeriod;
+    S.logging.bmca = sParams.verbose;
+    sAnnPeriodTicks = ptp_logi2ms(sParams.logAnnPeriod) / PTP_HEARTBEAT_TICKRATE_MS;
+    if (sAnnPeriodTicks == 0) {
+        sAnnPeriodTicks = 1;
+    }
+    host_rand_seed(sParams.seed);
+
+    // create the nodes: unique identities, a few distinct priorities and some slave-only nodes
+    for (uint32_t i = 0; i < sParams.nodes; i++) {
+        SimNode *pNode = &sNodes[i];
+        pNode->clockIdentity = ((uint64_t)host_rand() << 32) | (i + 1);
+        pNode->priority1 = PTP_CLOCK_PRIORITY1 - (host_rand() % 4);
+        pNode->profileFlags = ((host_rand() % 100) < sParams.masterPercent) ? 0 : PTP_PF_SLAVE_ONLY;
+    }
+
+    MSG("BMCA simulation: %u nodes, Announce log. period: %d, master-capable: %u%%, loss: %u permille, phase: %u s, seed: %u\n\n",
+        sParams.nodes, sParams.logAnnPeriod, sParams.masterPercent, sParams.lossPermille, sParams.phase_s, sParams.seed);
+
+    // phase 1: all nodes start at once
+    for (uint32_t i = 0; i < sParams.nodes; i++) {
+        sim_node_start(&sNodes[i]);
+    }
+    sim_run_phase("All nodes started");
+
+    // phase 2: the grandmaster leaves
+    int32_t gm = sim_expected_grandmaster();
+    if (gm < 0) {
+        MSG("No master-capable node!\n");
+        return 1;
+    }
+    sNodes[gm].online = false;
+    sim_run_phase("Grandmaster left");
+
+    // phase 3: the former grandmaster rejoins
+    sim_node_start(&sNodes[gm]);
+    sim_run_phase("Grandmaster rejoined");
+
+    free(sNodes);
+    free(sInFlight);
+    free(sOutbox);
+    return 0;
+}
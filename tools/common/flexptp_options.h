@@ -0,0 +1,29 @@
+#ifndef FLEXPTP_OPTIONS_TOOLS_H_
+#define FLEXPTP_OPTIONS_TOOLS_H_
+
+// Options shared by the host tools. Each tool compiles only the modules
+// it exercises (BMCA, master or servos): no hardware clock, network stack
+// driver or CLI is involved.
+
+#define FLEXPTP_LINUX     // the tools are host programs
+#define PTP_HLT_INTERFACE // selects the hardware clock state type only, the clock is never tuned
+
+#include <stdio.h>
+
+// Give a printf-like printing implementation MSG(...)
+// Give a maskable printing implementation CLILOG(en,...)
+
+#define MSG(...) printf(__VA_ARGS__)
+#define CLILOG(en, ...)       \
+    {                         \
+        if (en) {             \
+            MSG(__VA_ARGS__); \
+        }                     \
+    }
+
+#define FLEXPTP_SNPRINTF(...) snprintf(__VA_ARGS__)
+
+// The BMCA and master tools let the nodes take the MASTER role
+#define PTP_ENABLE_MASTER_OPERATION (1)
+
+#endif /* FLEXPTP_OPTIONS_TOOLS_H_ */
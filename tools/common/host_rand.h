@@ -0,0 +1,39 @@
+/**
+ ******************************************************************************
+ * @file    host_rand.h
+ * @brief   Deterministic random generator (xorshift32) shared by the host tools.
+ * Every tool is a single translation unit, so each gets its own generator state.
+ ******************************************************************************
+ */
+
+#ifndef FLEXPTP_HOST_RAND_H_
+#define FLEXPTP_HOST_RAND_H_
+
+#include <stdint.h>
+
+static uint32_t sHostRandState = 1; ///< State of the random generator (must not be zero)
+
+/**
+ * Seed the random generator.
+ *
+ * @param seed non-zero seed
+ */
+static inline void host_rand_seed(uint32_t seed) {
+    sHostRandState = seed;
+}
+
+/**
+ * Draw the next random number.
+ *
+ * @return 32-bit random number
+ */
+static inline uint32_t host_rand() {
+    uint32_t x = sHostRandState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sHostRandState = x;
+    return x;
+}
+
+#endif /* FLEXPTP_HOST_RAND_H_ */
@@ -0,0 +1,239 @@
+/**
+ ******************************************************************************
+ * @file    master_bench.c
+ * @brief   CPU cost of the master per message rate. The unmodified master is
+ * ticked through a number of simulated seconds at each log. message period,
+ * its messages are caught by a simulated transmit path which returns their
+ * transmit timestamps after each tick, so two-step Syncs get their Follow_Ups
+ * the way ptp_transmit_timestamp_cb() would trigger them. The thread CPU time
+ * spent in the library is measured and, to estimate the whole cost on the
+ * Linux port, the cost of a loopback UDP sendto() of a PTP-sized datagram is
+ * measured as well.
+ ******************************************************************************
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <flexptp/common.h>
+#include <flexptp/format_utils.h>
+#include <flexptp/master.h>
+#include <flexptp/minmax.h>
+#include <flexptp/msg_utils.h>
+#include <flexptp/ptp_core.h>
+#include <flexptp/ptp_defs.h>
+#include <flexptp/task_ptp.h>
+#include <flexptp/unicast.h>
+
+///\cond 0
+#define S (gPtpCoreState)
+///\endcond
+
+PtpCoreState gPtpCoreState;       ///< Core state of the master
+const TimestampI zeroTs = {0, 0}; ///< A zero timestamp
+
+#define BENCH_MAX_PENDING (64)      ///< Maximum number of messages awaiting their transmit timestamps
+#define BENCH_SENDTO_COUNT (100000) ///< Number of datagrams the sendto() cost is averaged over
+
+/**
+ * @brief Benchmark parameters.
+ */
+typedef struct {
+    uint32_t duration_s;    ///< Simulated duration per log. period (s)
+    PtpDelayMechanism dm;   ///< Delay mechanism
+    int8_t logAnnPeriodMin; ///< Shortest Announce log. period
+    bool measureSendto;     ///< Measure the cost of a loopback UDP sendto()
+} BenchParams;
+
+static BenchParams sParams = {
+    .duration_s = 100,
+    .dm = PTP_DM_P2P,
+    .logAnnPeriodMin = -3,
+    .measureSendto = true,
+};
+
+static RawPtpMessage sPending[BENCH_MAX_PENDING]; ///< Messages awaiting their transmit timestamps
+static uint32_t sPendingCnt;                      ///< Number of messages awaiting their transmit timestamps
+static uint32_t sSent[16];                        ///< Number of messages transmitted by message type
+
+// ------------------------
+
+// the simulated transmit path: messages requesting a transmit timestamp are held until the end of the tick
+bool ptp_transmit_enqueue(const RawPtpMessage *pMsg) {
+    sSent[pMsg->data[0] & 0x0F]++;
+    if ((pMsg->pTxCb != NULL) && (sPendingCnt < BENCH_MAX_PENDING)) {
+        sPending[sPendingCnt++] = *pMsg;
+    }
+    return true;
+}
+
+uint32_t ptp_transmit_get_free_slots() {
+    return BENCH_MAX_PENDING - sPendingCnt;
+}
+
+bool ptp_read_and_clear_transmit_timestamp(uint32_t tag, TimestampI *pTs) {
+    (void)tag;
+    (void)pTs;
+    return false;
+}
+
+void ptp_invoke_user_event_cb(PtpUserEventCode uev) {
+    (void)uev;
+}
+
+// unicast negotiation is not involved
+bool ptp_unicast_is_active() {
+    return false;
+}
+
+bool ptp_unicast_is_granted(uint64_t clockIdentity, uint16_t portNumber, PtpUnicastMsg ucm) {
+    (void)clockIdentity;
+    (void)portNumber;
+    (void)ucm;
+    return false;
+}
+
+void ptp_unicast_master_tick() {
+    return;
+}
+
+// ------------------------
+
+static uint64_t bench_thread_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// deliver the transmit timestamps of the messages sent in this tick
+static void bench_deliver() {
+    uint32_t n = sPendingCnt;
+    sPendingCnt = 0; // callbacks may enqueue further messages
+    for (uint32_t i = 0; i < n; i++) {
+        RawPtpMessage *pMsg = &sPending[i];
+        pMsg->ts.sec = S.ticks;
+        pMsg->ts.nanosec = i;
+        pMsg->pTxCb(pMsg);
+    }
+}
+
+// run the master at a log. period for the configured duration, return the library CPU time per second (us)
+static double bench_run(int8_t logPeriod) {
+    memset(&S, 0, sizeof(PtpCoreState));
+    memset(sSent, 0, sizeof(sSent));
+    sPendingCnt = 0;
+
+    S.profile.delayMechanism = sParams.dm;
+    S.profile.logSyncPeriod = logPeriod;
+    S.profile.logAnnouncePeriod = MAX(logPeriod, sParams.logAnnPeriodMin);
+    S.profile.logDelayReqPeriod = logPeriod;
+    ptp_init_delay_req_header();
+    ptp_master_init();
+    S.master.oneStepSync = false;
+    ptp_master_reset();
+    ptp_master_enable();
+
+    uint32_t ticks = sParams.duration_s * 1000 / PTP_HEARTBEAT_TICKRATE_MS;
+    uint64_t start = bench_thread_ns();
+    for (uint32_t t = 1; t <= ticks; t++) {
+        S.ticks = t;
+        ptp_master_tick();
+        bench_deliver();
+    }
+    uint64_t elapsed = bench_thread_ns() - start;
+
+    return (double)elapsed / 1000.0 / sParams.duration_s;
+}
+
+// measure the average cost of a loopback UDP sendto() of a PTP-sized datagram (us), negative if it fails
+static double bench_sendto_us() {
+    int sfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sfd < 0) {
+        return -1.0;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PTP_PORT_EVENT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    uint8_t data[PTP_PCKT_SIZE_SYNC] = {0};
+    uint32_t sent = 0;
+    uint64_t start = bench_thread_ns();
+    for (uint32_t i = 0; i < BENCH_SENDTO_COUNT; i++) {
+        sent += (sendto(sfd, data, sizeof(data), 0, (struct sockaddr *)&addr, sizeof(addr)) == sizeof(data)) ? 1 : 0;
+    }
+    uint64_t elapsed = bench_thread_ns() - start;
+    close(sfd);
+
+    return (sent == BENCH_SENDTO_COUNT) ? ((double)elapsed / 1000.0 / BENCH_SENDTO_COUNT) : -1.0;
+}
+
+static void bench_print_usage(const char *prog) {
+    MSG("Usage: %s [-t duration_s] [-m e2e|p2p] [-a min_log_ann_period] [-n (skip the sendto() measurement)]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "t:m:a:nh")) != -1) {
+        switch (opt) {
+        case 't':
+            sParams.duration_s = strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            sParams.dm = !strcmp(optarg, "e2e") ? PTP_DM_E2E : PTP_DM_P2P;
+            break;
+        case 'a':
+            sParams.logAnnPeriodMin = (int8_t)strtol(optarg, NULL, 10);
+            break;
+        case 'n':
+            sParams.measureSendto = false;
+            break;
+        default:
+            bench_print_usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if ((sParams.duration_s == 0) || (sParams.logAnnPeriodMin < PTP_LOGPER_MIN) || (sParams.logAnnPeriodMin > PTP_LOGPER_MAX)) {
+        bench_print_usage(argv[0]);
+        return 1;
+    }
+
+    double sendto_us = sParams.measureSendto ? bench_sendto_us() : -1.0;
+
+    MSG("Master CPU cost: %s, heartbeat: %u ms, %u s per period, Announce log. period >= %d\n", (sParams.dm == PTP_DM_E2E) ? "E2E" : "P2P",
+        PTP_HEARTBEAT_TICKRATE_MS, sParams.duration_s, sParams.logAnnPeriodMin);
+    if (sendto_us >= 0.0) {
+        MSG("Loopback UDP sendto(): %.2f us\n", sendto_us);
+    }
+    MSG("\nlog. period | Sync/s | Follow_Up/s | Announce/s | (P)Delay_Req/s | library [us/s] | with sendto() [us/s] | core [%%]\n");
+
+    for (int8_t lp = 0; lp >= PTP_LOGPER_MIN; lp--) {
+        double lib_us = bench_run(lp);
+        double d = sParams.duration_s;
+        double sync = sSent[PTP_MT_Sync] / d;
+        double fup = sSent[PTP_MT_Follow_Up] / d;
+        double ann = sSent[PTP_MT_Announce] / d;
+        double dreq = sSent[(sParams.dm == PTP_DM_E2E) ? PTP_MT_Delay_Req : PTP_MT_PDelay_Req] / d;
+
+        MSG("%11d | %6.1f | %11.1f | %10.1f | %14.1f | %14.1f", lp, sync, fup, ann, dreq, lib_us);
+        if (sendto_us >= 0.0) {
+            double total_us = lib_us + (sync + fup + ann + dreq) * sendto_us;
+            MSG(" | %20.1f | %8.4f\n", total_us, total_us / 1E+04);
+        } else {
+            MSG(" | %20s | %8s\n", "-", "-");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,297 @@
+/**
+ ******************************************************************************
+ * @file    servo_bench.c
+ * @brief   Equivalence check and benchmark of the fixed-point servos. A golden
+ * trace is recorded by running the floating point servo in a closed loop on a
+ * simulated clock (random walk frequency, exponential packet delay variation,
+ * lost Syncs). The trace is then replayed into the fixed-point servo and every
+ * tuning is compared against the recorded one. Finally both variants are run
+ * over the trace repeatedly to measure their execution time.
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <flexptp/servo/kalman_filter.h>
+#include <flexptp/servo/kalman_filter_fxp.h>
+#include <flexptp/servo/pid_controller.h>
+#include <flexptp/servo/pid_controller_fxp.h>
+
+#include <flexptp_options.h>
+#include <host_rand.h>
+
+// the execution time is measured in CPU cycles where a cycle counter is available
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+#define BENCH_TIMESTAMP() (__rdtsc())
+#else
+#define BENCH_UNIT "ns"
+#define BENCH_TIMESTAMP() (bench_ns())
+static uint64_t bench_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+#ifndef BENCH_TOL_ABS
+#define BENCH_TOL_ABS (0.01) ///< Absolute tolerance of the fixed-point tunings (PPB)
+#endif
+
+#ifndef BENCH_TOL_REL
+#define BENCH_TOL_REL (1E-04) ///< Relative tolerance of the fixed-point tunings
+#endif
+
+/**
+ * @brief Servo in its floating point and fixed-point variants.
+ */
+typedef struct {
+    const PtpServo *ref; ///< Floating point servo (reference)
+    const PtpServo *fxp; ///< Fixed-point servo
+} BenchServoPair;
+
+/**
+ * @brief Entry of the golden trace.
+ */
+typedef struct {
+    int32_t dt;           ///< Measured time error (ns)
+    int64_t syncPeriodNs; ///< Measured synchronization period (ns)
+    float tuning;         ///< Tuning of the floating point servo (PPB)
+} BenchTraceEntry;
+
+/**
+ * @brief Benchmark parameters.
+ */
+typedef struct {
+    uint32_t cycles;      ///< Number of synchronization cycles in a trace
+    uint32_t repetitions; ///< Number of times the trace is replayed for the timing measurement
+    double pdv_ns;        ///< Mean of the exponential packet delay variation (ns)
+    uint32_t seed;        ///< Random seed
+    bool verbose;         ///< Print every out-of-tolerance tuning
+} BenchParams;
+
+static BenchParams sParams = {
+    .cycles = 4096,
+    .repetitions = 20,
+    .pdv_ns = 200.0,
+    .seed = 1,
+    .verbose = false,
+};
+
+static const BenchServoPair sPairs[] = {
+    {&gPidCtrlServo, &gPidCtrlFxpServo},
+    {&gKalmanFilterServo, &gKalmanFilterFxpServo},
+};
+
+static const int8_t sLogSyncPeriods[] = {-7, -4, -1, 0}; ///< Synchronization periods the traces are recorded with
+
+// ------------------------
+
+// uniform random number in (0, 1)
+static double bench_rand_uniform() {
+    return (host_rand() + 1.0) / 4294967297.0;
+}
+
+// standard normal random number
+static double bench_rand_normal() {
+    return sqrt(-2.0 * log(bench_rand_uniform())) * cos(2.0 * M_PI * bench_rand_uniform());
+}
+
+/**
+ * Record a golden trace by running the floating point servo on a simulated clock.
+ *
+ * @param servo floating point servo
+ * @param pState servo instance
+ * @param logSyncPeriod logarithmic synchronization period
+ * @param pTrace trace to be filled
+ * @return RMS of the true time error of the clock over the second half of the trace (ns)
+ */
+static double bench_record_trace(const PtpServo *servo, void *pState, int8_t logSyncPeriod, BenchTraceEntry *pTrace) {
+    double T = pow(2.0, logSyncPeriod);
+    double freq = 5000.0;  // frequency error of the clock (ppb)
+    double offset = 2E+04; // time error of the clock (ns)
+    double sumSq = 0.0;
+
+    servo->create(pState);
+    for (uint32_t n = 0; n < sParams.cycles; n++) {
+        // every 50th Sync is lost on average, the measured period spans the missing one
+        uint8_t periods = ((host_rand() % 50) == 0) ? 2 : 1;
+        for (uint8_t i = 0; i < periods; i++) {
+            freq += 0.5 * sqrt(T) * bench_rand_normal(); // random walk frequency modulation
+            offset += freq * T;                         // ppb * s = ns
+        }
+
+        // measured time error with packet delay variation, measured period with timestamping jitter
+        BenchTraceEntry *e = &pTrace[n];
+        e->dt = (int32_t)(offset - sParams.pdv_ns * log(bench_rand_uniform()) - sParams.pdv_ns);
+        e->syncPeriodNs = (int64_t)(periods * T * 1E+09) + (int64_t)(20.0 * bench_rand_normal());
+
+        PtpServoAuxInput aux = {0};
+        aux.logMsgPeriod = logSyncPeriod;
+        aux.msgPeriodMs = T * 1E+03;
+        aux.measSyncPeriodNs = e->syncPeriodNs;
+        e->tuning = servo->run(pState, e->dt, &aux);
+        freq += e->tuning;
+
+        if (n >= sParams.cycles / 2) {
+            sumSq += offset * offset;
+        }
+    }
+
+    return sqrt(sumSq / (sParams.cycles - sParams.cycles / 2));
+}
+
+/**
+ * Replay a trace into the fixed-point servo and compare its tunings against the recorded ones.
+ *
+ * @param servo fixed-point servo
+ * @param pState servo instance
+ * @param logSyncPeriod logarithmic synchronization period
+ * @param pTrace golden trace
+ * @param pMaxAbsDiff maximum absolute difference (PPB)
+ * @return number of tunings out of tolerance
+ */
+static uint32_t bench_compare_trace(const PtpServo *servo, void *pState, int8_t logSyncPeriod, const BenchTraceEntry *pTrace, double *pMaxAbsDiff) {
+    uint32_t failures = 0;
+    *pMaxAbsDiff = 0.0;
+
+    servo->create(pState);
+    for (uint32_t n = 0; n < sParams.cycles; n++) {
+        const BenchTraceEntry *e = &pTrace[n];
+        PtpServoAuxInput aux = {0};
+        aux.logMsgPeriod = logSyncPeriod;
+        aux.msgPeriodMs = pow(2.0, logSyncPeriod) * 1E+03;
+        aux.measSyncPeriodNs = e->syncPeriodNs;
+        float tuning = servo->run(pState, e->dt, &aux);
+
+        double diff = fabs((double)tuning - (double)e->tuning);
+        if (diff > *pMaxAbsDiff) {
+            *pMaxAbsDiff = diff;
+        }
+        if (diff > (BENCH_TOL_ABS + BENCH_TOL_REL * fabs(e->tuning))) {
+            failures++;
+            if (sParams.verbose) {
+                MSG("  cycle %u: dt = %d ns, reference: %.6f ppb, fixed-point: %.6f ppb\n", n, e->dt, e->tuning, tuning);
+            }
+        }
+    }
+
+    return failures;
+}
+
+/**
+ * Measure the average execution time of a servo cycle over a trace.
+ *
+ * @param servo servo
+ * @param pState servo instance
+ * @param logSyncPeriod logarithmic synchronization period
+ * @param pTrace trace
+ * @return average execution time of a cycle (BENCH_UNIT)
+ */
+static double bench_time_trace(const PtpServo *servo, void *pState, int8_t logSyncPeriod, const BenchTraceEntry *pTrace) {
+    uint64_t total = 0;
+    volatile float sink = 0.0f;
+
+    for (uint32_t r = 0; r < sParams.repetitions; r++) {
+        servo->create(pState);
+        for (uint32_t n = 0; n < sParams.cycles; n++) {
+            PtpServoAuxInput aux = {0};
+            aux.logMsgPeriod = logSyncPeriod;
+            aux.measSyncPeriodNs = pTrace[n].syncPeriodNs;
+
+            uint64_t start = BENCH_TIMESTAMP();
+            sink = servo->run(pState, pTrace[n].dt, &aux);
+            total += BENCH_TIMESTAMP() - start;
+        }
+    }
+
+    (void)sink;
+    return (double)total / ((double)sParams.repetitions * sParams.cycles);
+}
+
+static void bench_print_usage(const char *prog) {
+    MSG("Usage: %s [-n cycles] [-r repetitions] [-p pdv_ns] [-s seed] [-v]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:p:s:vh")) != -1) {
+        switch (opt) {
+        case 'n':
+            sParams.cycles = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            sParams.repetitions = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            sParams.pdv_ns = strtod(optarg, NULL);
+            break;
+        case 's':
+            sParams.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'v':
+            sParams.verbose = true;
+            break;
+        default:
+            bench_print_usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if ((sParams.cycles < 2) || (sParams.repetitions == 0) || (sParams.seed == 0)) {
+        bench_print_usage(argv[0]);
+        return 1;
+    }
+
+    // allocate the trace and the instances
+    BenchTraceEntry *trace = calloc(sParams.cycles, sizeof(BenchTraceEntry));
+    size_t stateSize = 0;
+    for (uint8_t i = 0; i < sizeof(sPairs) / sizeof(BenchServoPair); i++) {
+        stateSize = (sPairs[i].ref->stateSize > stateSize) ? sPairs[i].ref->stateSize : stateSize;
+        stateSize = (sPairs[i].fxp->stateSize > stateSize) ? sPairs[i].fxp->stateSize : stateSize;
+    }
+    void *pState = malloc(stateSize);
+    if ((trace == NULL) || (pState == NULL)) {
+        MSG("Out of memory!\n");
+        return 1;
+    }
+
+    MSG("Servo equivalence check: %u cycles per trace, PDV: %.0f ns, tolerance: %g ppb + %g * |tuning|, seed: %u\n\n",
+        sParams.cycles, sParams.pdv_ns, BENCH_TOL_ABS, BENCH_TOL_REL, sParams.seed);
+    MSG("servo  | log. period | RMS TE [ns] | max. diff. [ppb] | failures | float [" BENCH_UNIT "] | fixed [" BENCH_UNIT "]\n");
+
+    uint32_t failures = 0;
+    for (uint8_t i = 0; i < sizeof(sPairs) / sizeof(BenchServoPair); i++) {
+        const BenchServoPair *pair = &sPairs[i];
+        MSG("%-6s | instance: %u bytes (fixed-point: %u bytes)\n", pair->ref->name, (unsigned)pair->ref->stateSize, (unsigned)pair->fxp->stateSize);
+
+        for (uint8_t j = 0; j < sizeof(sLogSyncPeriods); j++) {
+            int8_t logSyncPeriod = sLogSyncPeriods[j];
+            host_rand_seed(sParams.seed);
+
+            double rms = bench_record_trace(pair->ref, pState, logSyncPeriod, trace);
+            double maxAbsDiff;
+            uint32_t fails = bench_compare_trace(pair->fxp, pState, logSyncPeriod, trace, &maxAbsDiff);
+            double tRef = bench_time_trace(pair->ref, pState, logSyncPeriod, trace);
+            double tFxp = bench_time_trace(pair->fxp, pState, logSyncPeriod, trace);
+
+            MSG("%-6s | %11d | %11.1f | %16.6f | %8u | %14.0f | %14.0f\n", pair->ref->name, logSyncPeriod, rms, maxAbsDiff, fails, tRef, tFxp);
+            failures += fails;
+        }
+    }
+
+    MSG("\n%s\n", (failures == 0) ? "PASSED" : "FAILED");
+
+    free(trace);
+    free(pState);
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,665 @@
+/**
+ ******************************************************************************
+ * @file    servo_tune.c
+ * @brief   Offline servo autotuner. Traces printed by the general logging
+ * (`ptp log def on`, see manual/dumps/) are decomposed into the time error the
+ * clock would have shown without the recorded corrections: the wander of the
+ * free-running clock and the measurement noise. The traces are then replayed
+ * through the unmodified servo code in a linear clock model, while a pattern
+ * search looks for the servo parameters minimizing the RMS time error or the
+ * MTIE. The best parameter set is printed as a flexptp_options.h snippet and
+ * as a CLI command evaluating it in shadow on the target.
+ ******************************************************************************
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <flexptp/servo/kalman_filter.h>
+#include <flexptp/servo/pid_controller.h>
+
+#include <flexptp_options.h>
+#include <host_rand.h>
+
+#ifndef TUNE_MAX_PARAMS
+#define TUNE_MAX_PARAMS (4) ///< Maximum number of tuned parameters of a servo
+#endif
+
+#ifndef TUNE_MAX_TRACES
+#define TUNE_MAX_TRACES (16) ///< Maximum number of traces replayed at once
+#endif
+
+#ifndef TUNE_DIVERGENCE_NS
+#define TUNE_DIVERGENCE_NS (1E+08) ///< Time error above which a replay is considered diverged (ns)
+#endif
+
+#ifndef TUNE_LINE_LENGTH
+#define TUNE_LINE_LENGTH (512) ///< Maximum length of a trace line
+#endif
+
+/**
+ * @brief Tuned servo parameter.
+ */
+typedef struct {
+    const char *name;  ///< Name of the parameter
+    const char *macro; ///< Macro of the parameter in flexptp_options.h
+    double macroScale; ///< Macro value over the parameter value
+    double min;        ///< Lower limit of the search
+    double max;        ///< Upper limit of the search
+    double step;       ///< Initial step of the search (decades on logarithmic scale)
+    double minStep;    ///< Step at which the search stops (decades on logarithmic scale)
+    bool logScale;     ///< The parameter is searched on logarithmic scale
+} TuneParamDesc;
+
+/**
+ * @brief Tunable servo.
+ */
+typedef struct {
+    const PtpServo *servo;                 ///< Servo descriptor
+    uint8_t paramCnt;                      ///< Number of parameters passed to the servo
+    double defaults[TUNE_MAX_PARAMS];      ///< Default parameter values (start of the search)
+    TuneParamDesc params[TUNE_MAX_PARAMS]; ///< Parameter descriptors
+} TuneServoDesc;
+
+/**
+ * @brief Entry of a trace.
+ */
+typedef struct {
+    double dt;            ///< Recorded time error (ns)
+    double w;             ///< Time error with the recorded corrections removed (ns)
+    int64_t syncPeriodNs; ///< Measured synchronization period (ns)
+} TuneTraceEntry;
+
+/**
+ * @brief Trace.
+ */
+typedef struct {
+    const char *fileName;    ///< Name of the file the trace was loaded from
+    TuneTraceEntry *entries; ///< Entries
+    uint32_t length;         ///< Number of entries
+    int8_t logSyncPeriod;    ///< Logarithmic synchronization period
+} TuneTrace;
+
+/**
+ * @brief Cost functions.
+ */
+typedef enum {
+    TUNE_COST_RMS = 0, ///< RMS time error
+    TUNE_COST_MTIE,    ///< Maximum time interval error over a window
+} TuneCost;
+
+/**
+ * @brief Autotuner parameters.
+ */
+typedef struct {
+    const TuneServoDesc *servo; ///< Tuned servo
+    TuneCost cost;              ///< Cost function
+    uint32_t window;            ///< MTIE observation window (cycles)
+    int32_t skip;               ///< Number of initial cycles excluded from the cost, negative: 10% of the trace
+    uint32_t budget;            ///< Maximum number of evaluations
+    uint32_t restarts;          ///< Number of searches started from random parameters
+    uint32_t seed;              ///< Random seed
+    double freqOffset;          ///< Frequency error injected into the traces (PPB)
+    const char *outFile;        ///< File the options snippet is written to
+    bool verbose;               ///< Print every improvement
+} TuneParams;
+
+static TuneParams sParams = {
+    .servo = NULL,
+    .cost = TUNE_COST_RMS,
+    .window = 16,
+    .skip = -1,
+    .budget = 2000,
+    .restarts = 0,
+    .seed = 1,
+    .freqOffset = 0.0,
+    .outFile = NULL,
+    .verbose = false,
+};
+
+// the search starts from the built-in defaults of the servos
+static const TuneServoDesc sServos[] = {
+    {&gPidCtrlServo, 3, {0.5 * 0.476, 0.0, 3.0}, {
+                                                     {"Kp", "K_P", 1.0, 0.0, 2.0, 0.1, 0.001, false},
+                                                     {"Ki", "K_I", 1.0, 0.0, 1.0, 0.05, 0.0005, false},
+                                                     {"Kd", "K_D", 1.0, 0.0, 20.0, 1.0, 0.01, false},
+                                                 }},
+    {&gKalmanFilterServo, 4, {1E-16, 1E-12, 5E-11, 1E-18}, {
+                                                               {"sigma_theta^2", "SIGMA_THETA_SQUARED", 1.0, 1E-24, 1E-08, 1.0, 0.05, true},
+                                                               {"sigma_gamma^2", "SIGMA_GAMMA_SQUARED", 1.0, 1E-24, 1E-06, 1.0, 0.05, true},
+                                                               {"sigma_theta_m^2", "SIGMA_CT_SQUARED", 2.0, 1E-18, 1E-06, 1.0, 0.05, true},
+                                                               {"sigma_delta^2", "SIGMA_DELTA_SQUARED", 1.0, 1E-28, 1E-10, 1.0, 0.05, true},
+                                                           }},
+};
+
+static TuneTrace sTraces[TUNE_MAX_TRACES]; ///< Loaded traces
+static uint8_t sTraceCnt = 0;              ///< Number of loaded traces
+
+static void *sState = NULL;    ///< Servo instance used by the evaluations
+static double *sError = NULL;  ///< Time error of the replay in progress (ns)
+static uint32_t *sMinQ = NULL; ///< Monotonic index queue of the MTIE window minimum
+static uint32_t *sMaxQ = NULL; ///< Monotonic index queue of the MTIE window maximum
+static uint32_t sEvals = 0;    ///< Number of evaluations performed
+
+// ------------------------
+
+// uniform random number in [0, 1)
+static double tune_rand_uniform() {
+    return host_rand() / 4294967296.0;
+}
+
+static double tune_time_s() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-09;
+}
+
+/**
+ * Calculate the maximum time interval error: the largest peak-to-peak time error over any window.
+ *
+ * @param x time error series (ns)
+ * @param n length of the series
+ * @param window length of the observation window (samples)
+ * @return MTIE (ns)
+ */
+static double tune_mtie(const double *x, uint32_t n, uint32_t window) {
+    uint32_t minHead = 0, minTail = 0, maxHead = 0, maxTail = 0;
+    double mtie = 0.0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        // maintain the queues: indices of increasing minima and decreasing maxima
+        while ((minTail > minHead) && (x[sMinQ[minTail - 1]] >= x[i])) {
+            minTail--;
+        }
+        sMinQ[minTail++] = i;
+        while ((maxTail > maxHead) && (x[sMaxQ[maxTail - 1]] <= x[i])) {
+            maxTail--;
+        }
+        sMaxQ[maxTail++] = i;
+
+        // drop the samples that have left the window
+        if (sMinQ[minHead] + window <= i) {
+            minHead++;
+        }
+        if (sMaxQ[maxHead] + window <= i) {
+            maxHead++;
+        }
+
+        double pp = x[sMaxQ[maxHead]] - x[sMinQ[minHead]];
+        mtie = (pp > mtie) ? pp : mtie;
+    }
+
+    return mtie;
+}
+
+/**
+ * Calculate the cost of a time error series.
+ *
+ * @param x time error series (ns)
+ * @param n length of the series
+ * @return cost (ns)
+ */
+static double tune_series_cost(const double *x, uint32_t n) {
+    if (sParams.cost == TUNE_COST_MTIE) {
+        return tune_mtie(x, n, sParams.window);
+    }
+
+    double sumSq = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        sumSq += x[i] * x[i];
+    }
+    return sqrt(sumSq / n);
+}
+
+// number of initial cycles of a trace excluded from the cost
+static uint32_t tune_skip(const TuneTrace *pTrace) {
+    return (sParams.skip < 0) ? (pTrace->length / 10) : (uint32_t)sParams.skip;
+}
+
+/**
+ * Load a trace and remove the recorded corrections from the time error. Every line holding at least
+ * ten numeric fields is taken as a cycle: the time error is given by the 5th and 6th fields (s and ns),
+ * the correction by the third, and the synchronization period by the last field, as both the addend
+ * and the tuning-based logs end with the `corr_ppb | mpd_ns | sync_period_ns` fields.
+ *
+ * @param pTrace trace to fill
+ * @param fileName name of the trace file
+ * @return the trace could be loaded
+ */
+static bool tune_load_trace(TuneTrace *pTrace, const char *fileName) {
+    FILE *f = fopen(fileName, "r");
+    if (f == NULL) {
+        MSG("Cannot open '%s'!\n", fileName);
+        return false;
+    }
+
+    uint32_t capacity = 0;
+    double fields[TUNE_LINE_LENGTH / 2];
+    char line[TUNE_LINE_LENGTH];
+    double correction = 0.0; // sum of the recorded corrections (PPB)
+    double accumulated = 0.0; // time error accumulated due to the recorded corrections (ns)
+    memset(pTrace, 0, sizeof(TuneTrace));
+    pTrace->fileName = fileName;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        // strip the ANSI color sequences of a captured console
+        char *r = line, *w = line;
+        while (*r != '\0') {
+            if (*r == '\033') {
+                while ((*r != '\0') && !isalpha((unsigned char)*r)) {
+                    r++;
+                }
+                r += (*r != '\0');
+            } else {
+                *w++ = *r++;
+            }
+        }
+        *w = '\0';
+
+        // split the line into numeric fields
+        size_t n = 0;
+        bool numeric = true;
+        char *tok = strtok(line, " \t\r\n|");
+        while ((tok != NULL) && numeric && (n < sizeof(fields) / sizeof(double))) {
+            char *end;
+            fields[n++] = strtod(tok, &end);
+            numeric = (*end == '\0');
+            tok = strtok(NULL, " \t\r\n|");
+        }
+        if (!numeric || (n < 10)) {
+            continue;
+        }
+
+        if (pTrace->length == capacity) {
+            capacity = (capacity == 0) ? 1024 : (2 * capacity);
+            TuneTraceEntry *entries = realloc(pTrace->entries, capacity * sizeof(TuneTraceEntry));
+            if (entries == NULL) { // the previous block is still owned by the trace
+                MSG("Out of memory!\n");
+                free(pTrace->entries);
+                pTrace->entries = NULL;
+                pTrace->length = 0;
+                fclose(f);
+                return false;
+            }
+            pTrace->entries = entries;
+        }
+
+        // the correction of the previous cycle has been effective during the last period
+        TuneTraceEntry *e = &pTrace->entries[pTrace->length++];
+        e->syncPeriodNs = (int64_t)fields[n - 1];
+        if (pTrace->length > 1) {
+            accumulated += correction * e->syncPeriodNs * 1E-09;
+        }
+        e->dt = fields[4] * 1E+09 + fields[5];
+        e->w = e->dt - accumulated;
+        correction += fields[n - 3];
+    }
+    fclose(f);
+
+    if (pTrace->length < 2) {
+        MSG("No cycles found in '%s'!\n", fileName);
+        return false;
+    }
+
+    // derive the logarithmic synchronization period from the mean measured period
+    double sumPeriod = 0.0;
+    for (uint32_t i = 1; i < pTrace->length; i++) {
+        sumPeriod += pTrace->entries[i].syncPeriodNs;
+    }
+    pTrace->logSyncPeriod = (int8_t)lround(log2(sumPeriod / (pTrace->length - 1) * 1E-09));
+
+    if (tune_skip(pTrace) >= pTrace->length) {
+        MSG("Trace '%s' is not longer than the skipped cycles!\n", fileName);
+        return false;
+    }
+
+    // inject the frequency error
+    double t = 0.0;
+    for (uint32_t i = 0; i < pTrace->length; i++) {
+        if (i > 0) {
+            t += pTrace->entries[i].syncPeriodNs * 1E-09;
+        }
+        pTrace->entries[i].w += sParams.freqOffset * t;
+    }
+
+    return true;
+}
+
+/**
+ * Replay a trace through a servo instance in the clock model.
+ *
+ * @param servo servo
+ * @param pParams servo parameters
+ * @param pTrace trace
+ * @return cost of the replay (ns), infinity if the servo has diverged or rejected the parameters
+ */
+static double tune_replay(const TuneServoDesc *servo, const double *pParams, const TuneTrace *pTrace) {
+    const PtpServo *s = servo->servo;
+    s->create(sState);
+    if (!s->setParams(sState, pParams, servo->paramCnt)) {
+        return INFINITY;
+    }
+
+    PtpServoAuxInput aux = {0};
+    aux.logMsgPeriod = pTrace->logSyncPeriod;
+    aux.msgPeriodMs = pow(2.0, pTrace->logSyncPeriod) * 1E+03;
+
+    double tuning = 0.0;      // sum of the corrections (PPB)
+    double accumulated = 0.0; // time error accumulated due to the corrections (ns)
+    for (uint32_t i = 0; i < pTrace->length; i++) {
+        const TuneTraceEntry *e = &pTrace->entries[i];
+        if (i > 0) {
+            accumulated += tuning * e->syncPeriodNs * 1E-09;
+        }
+
+        double dt = e->w + accumulated;
+        if (!(fabs(dt) < TUNE_DIVERGENCE_NS)) {
+            return INFINITY;
+        }
+        sError[i] = dt;
+
+        aux.measSyncPeriodNs = e->syncPeriodNs;
+        tuning += s->run(sState, (int32_t)lround(dt), &aux);
+    }
+
+    uint32_t skip = tune_skip(pTrace);
+    return tune_series_cost(sError + skip, pTrace->length - skip);
+}
+
+/**
+ * Evaluate a parameter set over all traces.
+ *
+ * @param servo servo
+ * @param pParams servo parameters
+ * @return combined cost: RMS of the RMS errors or the largest MTIE (ns)
+ */
+static double tune_evaluate(const TuneServoDesc *servo, const double *pParams) {
+    double cost = 0.0;
+    sEvals++;
+
+    for (uint8_t i = 0; i < sTraceCnt; i++) {
+        double c = tune_replay(servo, pParams, &sTraces[i]);
+        if (sParams.cost == TUNE_COST_MTIE) {
+            cost = (c > cost) ? c : cost;
+        } else {
+            cost += c * c / sTraceCnt;
+        }
+    }
+
+    return (sParams.cost == TUNE_COST_MTIE) ? cost : sqrt(cost);
+}
+
+// move a parameter by a step, limited to the search range
+static double tune_move(const TuneParamDesc *pDesc, double value, double step) {
+    if (pDesc->logScale) {
+        value *= pow(10.0, step);
+    } else {
+        value += step;
+    }
+    return (value < pDesc->min) ? pDesc->min : (value > pDesc->max) ? pDesc->max
+                                                                    : value;
+}
+
+static void tune_print_params(const TuneServoDesc *servo, const double *pParams) {
+    for (uint8_t i = 0; i < servo->paramCnt; i++) {
+        MSG("%s%s = %.4g", (i > 0) ? ", " : "", servo->params[i].name, pParams[i]);
+    }
+}
+
+/**
+ * Run a compass search from a starting point: each parameter is stepped up and down in turn, an
+ * improving step is taken at once, the steps are halved once no step improves.
+ *
+ * @param servo servo
+ * @param pParams starting point, overwritten with the best parameters found
+ * @param budget largest number of evaluations
+ * @return cost of the best parameters (ns)
+ */
+static double tune_search(const TuneServoDesc *servo, double *pParams, uint32_t budget) {
+    double step[TUNE_MAX_PARAMS];
+    for (uint8_t i = 0; i < servo->paramCnt; i++) {
+        step[i] = servo->params[i].step;
+    }
+
+    uint32_t evals = sEvals;
+    double best = tune_evaluate(servo, pParams);
+    bool searching = true;
+    while (searching && ((sEvals - evals) < budget)) {
+        bool improved = false;
+        for (uint8_t i = 0; (i < servo->paramCnt) && ((sEvals - evals) < budget); i++) {
+            for (int8_t dir = 1; dir >= -1; dir -= 2) {
+                double cand[TUNE_MAX_PARAMS];
+                memcpy(cand, pParams, sizeof(cand));
+                cand[i] = tune_move(&servo->params[i], pParams[i], dir * step[i]);
+                if (cand[i] == pParams[i]) {
+                    continue;
+                }
+
+                double c = tune_evaluate(servo, cand);
+                if (c < best) {
+                    best = c;
+                    memcpy(pParams, cand, sizeof(cand));
+                    improved = true;
+                    if (sParams.verbose) {
+                        MSG("  %9.2f ns: ", best);
+                        tune_print_params(servo, pParams);
+                        MSG("\n");
+                    }
+                    break;
+                }
+            }
+        }
+
+        // refine the steps if no step has improved
+        if (!improved) {
+            searching = false;
+            for (uint8_t i = 0; i < servo->paramCnt; i++) {
+                step[i] *= 0.5;
+                searching |= (step[i] >= servo->params[i].minStep);
+            }
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Print (and optionally write) the configuration of the best parameter set.
+ *
+ * @param servo servo
+ * @param pParams best parameters
+ * @param cost cost of the best parameters
+ */
+static void tune_emit_config(const TuneServoDesc *servo, const double *pParams, double cost) {
+    const char *costName = (sParams.cost == TUNE_COST_MTIE) ? "MTIE" : "RMS time error";
+
+    FILE *out[2] = {stdout, NULL};
+    if (sParams.outFile != NULL) {
+        out[1] = fopen(sParams.outFile, "w");
+        if (out[1] == NULL) {
+            MSG("Cannot open '%s'!\n", sParams.outFile);
+        }
+    }
+
+    for (uint8_t k = 0; k < 2; k++) {
+        FILE *f = out[k];
+        if (f == NULL) {
+            continue;
+        }
+
+        fprintf(f, "// %s servo tuned by servo_tune on %u trace(s), %s: %.2f ns\n", servo->servo->name, sTraceCnt, costName, cost);
+        for (uint8_t i = 0; i < servo->paramCnt; i++) {
+            const TuneParamDesc *d = &servo->params[i];
+            fprintf(f, "#define %s (%.6g)\n", d->macro, pParams[i] * d->macroScale);
+        }
+    }
+
+    if (out[1] != NULL) {
+        fclose(out[1]);
+    }
+
+    MSG("\nEvaluate in shadow on the target:\nptp servo shadow add %s", servo->servo->name);
+    for (uint8_t i = 0; i < servo->paramCnt; i++) {
+        MSG(" %.6g", pParams[i]);
+    }
+    MSG("\n\nAdopt on the target (kept by the stored configuration, see ptp_store_config()):\nptp servo select %s", servo->servo->name);
+    for (uint8_t i = 0; i < servo->paramCnt; i++) {
+        MSG(" %.6g", pParams[i]);
+    }
+    MSG("\n");
+}
+
+static void tune_print_usage(const char *prog) {
+    MSG("Usage: %s [-S pid|kalman] [-c rms|mtie] [-w window] [-k skip] [-n evaluations] [-r restarts] [-s seed] [-f ppb] [-o file] [-v] trace...\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "S:c:w:k:n:r:s:f:o:vh")) != -1) {
+        switch (opt) {
+        case 'S':
+            for (uint8_t i = 0; i < sizeof(sServos) / sizeof(TuneServoDesc); i++) {
+                if (!strcmp(optarg, sServos[i].servo->name)) {
+                    sParams.servo = &sServos[i];
+                }
+            }
+            if (sParams.servo == NULL) {
+                tune_print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'c':
+            sParams.cost = !strcmp(optarg, "mtie") ? TUNE_COST_MTIE : TUNE_COST_RMS;
+            break;
+        case 'w':
+            sParams.window = strtoul(optarg, NULL, 10);
+            break;
+        case 'k':
+            sParams.skip = strtol(optarg, NULL, 10);
+            break;
+        case 'n':
+            sParams.budget = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            sParams.restarts = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            sParams.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'f':
+            sParams.freqOffset = strtod(optarg, NULL);
+            break;
+        case 'o':
+            sParams.outFile = optarg;
+            break;
+        case 'v':
+            sParams.verbose = true;
+            break;
+        default:
+            tune_print_usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if ((optind >= argc) || (sParams.window == 0) || (sParams.budget == 0) || (sParams.seed == 0)) {
+        tune_print_usage(argv[0]);
+        return 1;
+    }
+
+    const TuneServoDesc *servo = (sParams.servo != NULL) ? sParams.servo : &sServos[1];
+
+    // load the traces
+    uint32_t maxLength = 0;
+    for (int i = optind; (i < argc) && (sTraceCnt < TUNE_MAX_TRACES); i++) {
+        TuneTrace *t = &sTraces[sTraceCnt];
+        if (!tune_load_trace(t, argv[i])) {
+            return 1;
+        }
+        maxLength = (t->length > maxLength) ? t->length : maxLength;
+        sTraceCnt++;
+    }
+
+    // allocate the instance and the buffers
+    sState = malloc(servo->servo->stateSize);
+    sError = malloc(maxLength * sizeof(double));
+    sMinQ = malloc(maxLength * sizeof(uint32_t));
+    sMaxQ = malloc(maxLength * sizeof(uint32_t));
+    if ((sState == NULL) || (sError == NULL) || (sMinQ == NULL) || (sMaxQ == NULL)) {
+        MSG("Out of memory!\n");
+        return 1;
+    }
+
+    const char *costName = (sParams.cost == TUNE_COST_MTIE) ? "MTIE" : "RMS";
+    MSG("Tuning the '%s' servo for %s", servo->servo->name, costName);
+    if (sParams.cost == TUNE_COST_MTIE) {
+        MSG(" over %u cycles", sParams.window);
+    }
+    MSG(", evaluation budget: %u, random restarts: %u\n\n", sParams.budget, sParams.restarts);
+
+    // cost of the recorded time error and of the replay of the default parameters
+    for (uint8_t i = 0; i < sTraceCnt; i++) {
+        TuneTrace *t = &sTraces[i];
+        uint32_t skip = tune_skip(t);
+        for (uint32_t j = 0; j < t->length; j++) {
+            sError[j] = t->entries[j].dt;
+        }
+        double recorded = tune_series_cost(sError + skip, t->length - skip);
+        MSG("%s: %u cycles, log. period: %d, %s recorded: %.2f ns, replayed with the defaults: %.2f ns\n",
+            t->fileName, t->length, t->logSyncPeriod, costName, recorded, tune_replay(servo, servo->defaults, t));
+    }
+
+    // search from the defaults, then from random starting points
+    double start = tune_time_s();
+    double best[TUNE_MAX_PARAMS];
+    memcpy(best, servo->defaults, sizeof(best));
+    double defaultCost = tune_evaluate(servo, best);
+    uint32_t budget = sParams.budget / (sParams.restarts + 1);
+    double bestCost = tune_search(servo, best, budget);
+
+    host_rand_seed(sParams.seed);
+    for (uint32_t r = 0; r < sParams.restarts; r++) {
+        double cand[TUNE_MAX_PARAMS];
+        for (uint8_t i = 0; i < servo->paramCnt; i++) {
+            const TuneParamDesc *d = &servo->params[i];
+            double u = tune_rand_uniform();
+            cand[i] = d->logScale ? (d->min * pow(d->max / d->min, u)) : (d->min + u * (d->max - d->min));
+        }
+        double c = tune_search(servo, cand, budget);
+        if (c < bestCost) {
+            bestCost = c;
+            memcpy(best, cand, sizeof(best));
+        }
+    }
+    double elapsed = tune_time_s() - start;
+
+    MSG("\n%u evaluations in %.2f s (%.0f evaluations/min)\n", sEvals, elapsed, sEvals / elapsed * 60.0);
+    MSG("default: %.2f ns (", defaultCost);
+    tune_print_params(servo, servo->defaults);
+    MSG(")\nbest:    %.2f ns (", bestCost);
+    tune_print_params(servo, best);
+    MSG(")\n\n");
+
+    if (!isfinite(bestCost)) {
+        MSG("The servo has diverged with every evaluated parameter set!\n");
+        return 1;
+    }
+
+    tune_emit_config(servo, best, bestCost);
+
+    for (uint8_t i = 0; i < sTraceCnt; i++) {
+        free(sTraces[i].entries);
+    }
+    free(sState);
+    free(sError);
+    free(sMinQ);
+    free(sMaxQ);
+
+    return 0;
+}
@@ -0,0 +1,430 @@
+/**
+ ******************************************************************************
+ * @file    sync_slot_test.c
+ * @brief   Test of the master's two-step Sync slot ring. The unmodified master
+ * is ticked at a high Sync rate (128/s by default), its messages are caught
+ * by a simulated transmit path which returns the transmit timestamps of the
+ * Syncs late, out of order, or not at all, the way ptp_transmit_timestamp_cb()
+ * would deliver them. A model of the slot ring is maintained next to the
+ * master and each tick is checked against it: every Follow_Up must carry the
+ * sequence ID and the transmit timestamp of its Sync, no Follow_Up may be sent
+ * for a Sync whose slot has expired, and while all PTP_MASTER_SYNC_SLOTS are
+ * occupied every due Sync must be counted as skipped. The spacing of the
+ * transmitted Syncs is checked as well: at most one Sync may be sent per tick,
+ * consecutive Syncs must be a Sync period apart within a heartbeat period and
+ * carry the Sync log. period in effect.
+ ******************************************************************************
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <flexptp/format_utils.h>
+#include <flexptp/master.h>
+#include <flexptp/minmax.h>
+#include <flexptp/msg_utils.h>
+#include <flexptp/ptp_core.h>
+#include <flexptp/ptp_defs.h>
+#include <flexptp/task_ptp.h>
+#include <flexptp/unicast.h>
+
+#include <host_rand.h>
+
+///\cond 0
+#define S (gPtpCoreState)
+///\endcond
+
+PtpCoreState gPtpCoreState;       ///< Core state of the master
+const TimestampI zeroTs = {0, 0}; ///< A zero timestamp
+
+#define TEST_MAX_IN_FLIGHT (256) ///< Maximum number of Syncs the simulated transmit path holds
+#define TEST_NEVER (UINT32_MAX)  ///< Delivery tick of a Sync whose timestamp gets lost
+
+/**
+ * @brief Sync passed to the simulated transmit path.
+ */
+typedef struct {
+    RawPtpMessage msg;     ///< Copy of the message, as held by the transmit buffer
+    uint16_t sequenceID;   ///< Sequence ID of the Sync
+    uint32_t enqueueTick;  ///< Tick the Sync was enqueued in
+    uint32_t deliverTick;  ///< Tick the transmit timestamp is delivered in (TEST_NEVER if lost)
+    bool slotLive;         ///< The Sync is expected to own a slot
+    bool used;             ///< This entry is occupied
+} TestSync;
+
+/**
+ * @brief Timestamp delivery behaviour of a scenario.
+ */
+typedef struct {
+    const char *name;      ///< Name of the scenario
+    uint32_t maxDelay;     ///< Maximum timestamp delivery delay (ticks)
+    uint32_t lossPermille; ///< Probability of a timestamp never arriving (per mille)
+    uint32_t stallTicks;   ///< Length of the periodic stalls, no timestamp is delivered during a stall (ticks)
+    uint32_t stallPeriod;  ///< Period of the stalls (ticks, 0: no stalls)
+} TestScenario;
+
+/**
+ * @brief Counters of a scenario.
+ */
+typedef struct {
+    uint32_t syncs;       ///< Number of Syncs transmitted
+    uint32_t followUps;   ///< Number of Follow_Ups transmitted
+    uint32_t late;        ///< Number of timestamps delivered after the expiry of their slots
+    uint32_t skipped;     ///< Number of Syncs skipped as expected
+    uint32_t fullTicks;   ///< Number of ticks started with all slots occupied
+    uint32_t expired;     ///< Number of slots expired as expected
+    uint32_t minGap_us;   ///< Shortest interval between consecutive Syncs (us)
+    uint32_t maxGap_us;   ///< Longest interval between consecutive Syncs without a skipped one in between (us)
+    uint32_t failures;    ///< Number of failed checks
+} TestStats;
+
+/**
+ * @brief Test parameters.
+ */
+typedef struct {
+    int8_t logSyncPeriod; ///< Sync log. period
+    uint32_t duration_s;  ///< Duration of a scenario (s)
+    uint32_t seed;        ///< Random seed
+    bool verbose;         ///< Print every failed check
+} TestParams;
+
+static TestParams sParams = {
+    .logSyncPeriod = -7,
+    .duration_s = 60,
+    .seed = 1,
+    .verbose = false,
+};
+
+static const TestScenario sScenarios[] = {
+    {"prompt timestamps", 1, 0, 0, 0},
+    {"late and lost timestamps", PTP_MASTER_SYNC_SLOT_TIMEOUT_TICKS + 4, 20, 0, 0},
+    {"short stalls (all slots busy)", 1, 0, PTP_MASTER_SYNC_SLOTS + 4, 50},
+    {"long stalls (slots expire)", 2, 10, PTP_MASTER_SYNC_SLOT_TIMEOUT_TICKS + 6, 100},
+};
+
+static TestSync sInFlight[TEST_MAX_IN_FLIGHT]; ///< Syncs awaiting their timestamps
+static TestSync *sDelivering;                  ///< Sync whose timestamp is being delivered
+static uint32_t sFollowUpsOfDelivery;          ///< Number of Follow_Ups sent on the current delivery
+static TestStats sStats;                       ///< Counters of the current scenario
+static int8_t sLogSyncPeriod;                  ///< Sync log. period in effect
+static uint32_t sLastSyncTick;                 ///< Tick the last Sync was sent in (0: none or a Sync was skipped since)
+
+// ------------------------
+
+// count and report a failed check
+static void test_fail(const char *what, uint32_t a, uint32_t b) {
+    sStats.failures++;
+    if (sParams.verbose || (sStats.failures == 1)) {
+        MSG("  [tick %u] %s (%u vs. %u)\n", S.ticks, what, a, b);
+    }
+}
+
+// ------------------------
+
+// the simulated transmit path: Syncs await their timestamps, Follow_Ups are checked against the Sync being delivered
+bool ptp_transmit_enqueue(const RawPtpMessage *pMsg) {
+    PtpHeader header;
+    ptp_extract_header(&header, pMsg->data);
+
+    if (header.messageType == PTP_MT_Sync) {
+        TestSync *pTS = NULL;
+        for (uint32_t i = 0; i < TEST_MAX_IN_FLIGHT; i++) {
+            if (!sInFlight[i].used) {
+                pTS = &sInFlight[i];
+                break;
+            }
+        }
+        if (pTS == NULL) {
+            MSG("Simulated transmit path overflow!\n");
+            exit(1);
+        }
+
+        pTS->msg = *pMsg;
+        pTS->sequenceID = header.sequenceID;
+        pTS->enqueueTick = S.ticks;
+        pTS->deliverTick = 0; // scheduled after the tick
+        pTS->slotLive = true;
+        pTS->used = true;
+        sStats.syncs++;
+
+        // Syncs must be evenly spaced and advertise the period in effect
+        if (header.logMessagePeriod != sLogSyncPeriod) {
+            test_fail("Sync log. period", (uint32_t)header.logMessagePeriod, (uint32_t)sLogSyncPeriod);
+        }
+        if (sLastSyncTick != 0) {
+            uint32_t gap_us = (S.ticks - sLastSyncTick) * PTP_HEARTBEAT_TICKRATE_MS * 1000;
+            uint32_t period_us = ptp_logi2us(sLogSyncPeriod);
+            uint32_t tick_us = PTP_HEARTBEAT_TICKRATE_MS * 1000;
+            if ((gap_us == 0) || (gap_us + tick_us <= period_us) || (gap_us >= period_us + tick_us)) {
+                test_fail("Sync interval (us)", gap_us, period_us);
+            }
+            sStats.minGap_us = MIN(sStats.minGap_us, gap_us);
+            sStats.maxGap_us = MAX(sStats.maxGap_us, gap_us);
+        }
+        sLastSyncTick = S.ticks;
+    } else if (header.messageType == PTP_MT_Follow_Up) {
+        sStats.followUps++;
+        if (sDelivering == NULL) {
+            test_fail("Follow_Up without a timestamp delivery", header.sequenceID, 0);
+            return true;
+        }
+
+        sFollowUpsOfDelivery++;
+        if (header.sequenceID != sDelivering->sequenceID) {
+            test_fail("Follow_Up sequence ID does not match the Sync's", header.sequenceID, sDelivering->sequenceID);
+        }
+
+        TimestampI t1;
+        ptp_extract_timestamps(&t1, (void *)pMsg->data, 1);
+        if ((t1.sec != sDelivering->msg.ts.sec) || (t1.nanosec != sDelivering->msg.ts.nanosec)) {
+            test_fail("Follow_Up origin timestamp does not match the Sync's", (uint32_t)t1.nanosec, (uint32_t)sDelivering->msg.ts.nanosec);
+        }
+    }
+
+    return true;
+}
+
+uint32_t ptp_transmit_get_free_slots() {
+    return TEST_MAX_IN_FLIGHT;
+}
+
+bool ptp_read_and_clear_transmit_timestamp(uint32_t tag, TimestampI *pTs) {
+    (void)tag;
+    (void)pTs;
+    return false;
+}
+
+void ptp_invoke_user_event_cb(PtpUserEventCode uev) {
+    (void)uev;
+}
+
+// unicast negotiation is not involved
+bool ptp_unicast_is_active() {
+    return false;
+}
+
+bool ptp_unicast_is_granted(uint64_t clockIdentity, uint16_t portNumber, PtpUnicastMsg ucm) {
+    (void)clockIdentity;
+    (void)portNumber;
+    (void)ucm;
+    return false;
+}
+
+void ptp_unicast_master_tick() {
+    return;
+}
+
+// ------------------------
+
+// deliver the timestamps due in this tick in random order, the way the PTP task processes ptp_transmit_timestamp_cb()
+static void test_deliver(const TestScenario *pSc) {
+    bool stalled = (pSc->stallPeriod > 0) && ((S.ticks % pSc->stallPeriod) < pSc->stallTicks);
+    if (stalled) {
+        return;
+    }
+
+    TestSync *due[TEST_MAX_IN_FLIGHT];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < TEST_MAX_IN_FLIGHT; i++) {
+        TestSync *pTS = &sInFlight[i];
+        if (pTS->used && (pTS->deliverTick <= S.ticks)) {
+            due[n++] = pTS;
+        }
+    }
+
+    // shuffle
+    for (uint32_t i = n; i > 1; i--) {
+        uint32_t j = host_rand() % i;
+        TestSync *tmp = due[i - 1];
+        due[i - 1] = due[j];
+        due[j] = tmp;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        TestSync *pTS = due[i];
+        pTS->msg.ts.sec = pTS->enqueueTick;
+        pTS->msg.ts.nanosec = pTS->sequenceID;
+
+        sDelivering = pTS;
+        sFollowUpsOfDelivery = 0;
+        pTS->msg.pTxCb(&pTS->msg);
+        sDelivering = NULL;
+
+        // only a Sync still owning its slot gets a Follow_Up
+        uint32_t expected = pTS->slotLive ? 1 : 0;
+        if (sFollowUpsOfDelivery != expected) {
+            test_fail(pTS->slotLive ? "missing Follow_Up" : "Follow_Up sent for an expired slot", sFollowUpsOfDelivery, expected);
+        }
+        if (!pTS->slotLive) {
+            sStats.late++;
+        }
+
+        pTS->used = false;
+    }
+}
+
+// expire the modelled slots the same way the master does at the beginning of a tick, return the number of live slots
+static uint32_t test_model_expire() {
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < TEST_MAX_IN_FLIGHT; i++) {
+        TestSync *pTS = &sInFlight[i];
+        if (!pTS->used || !pTS->slotLive) {
+            continue;
+        }
+
+        if ((S.ticks - pTS->enqueueTick) > PTP_MASTER_SYNC_SLOT_TIMEOUT_TICKS) {
+            pTS->slotLive = false;
+            sStats.expired++;
+            if (pTS->deliverTick == TEST_NEVER) {
+                pTS->used = false; // its timestamp will never arrive
+            }
+        } else {
+            live++;
+        }
+    }
+    return live;
+}
+
+// schedule the delivery of the timestamps of the Syncs enqueued in this tick
+static void test_schedule_deliveries(const TestScenario *pSc) {
+    for (uint32_t i = 0; i < TEST_MAX_IN_FLIGHT; i++) {
+        TestSync *pTS = &sInFlight[i];
+        if (pTS->used && (pTS->enqueueTick == S.ticks) && (pTS->deliverTick == 0)) {
+            if ((host_rand() % 1000) < pSc->lossPermille) {
+                pTS->deliverTick = TEST_NEVER;
+            } else {
+                pTS->deliverTick = S.ticks + (host_rand() % (pSc->maxDelay + 1));
+            }
+        }
+    }
+}
+
+static uint32_t test_run_scenario(const TestScenario *pSc) {
+    memset(sInFlight, 0, sizeof(sInFlight));
+    memset(&sStats, 0, sizeof(sStats));
+    sStats.minGap_us = UINT32_MAX;
+    sLastSyncTick = 0;
+
+    // start a fresh master
+    memset(&S, 0, sizeof(PtpCoreState));
+    S.profile.delayMechanism = PTP_DM_E2E;
+    S.profile.logSyncPeriod = sParams.logSyncPeriod;
+    S.profile.logAnnouncePeriod = 0;
+    S.profile.logDelayReqPeriod = 0;
+    ptp_master_init();
+    S.master.oneStepSync = false;
+    ptp_master_reset();
+    ptp_master_enable();
+
+    const PtpMasterSyncSlotState *ss = ptp_master_get_sync_slot_state();
+    uint32_t ticks = sParams.duration_s * 1000 / PTP_HEARTBEAT_TICKRATE_MS;
+    uint64_t elapsed_us = 0;
+    uint32_t syncPeriod_us = ptp_logi2us(sLogSyncPeriod);
+
+    for (uint32_t t = 1; t <= ticks; t++) {
+        S.ticks = t;
+
+        // the expected number of Syncs due in this tick
+        uint32_t dueBefore = elapsed_us / syncPeriod_us;
+        elapsed_us += PTP_HEARTBEAT_TICKRATE_MS * 1000;
+        uint32_t due = (elapsed_us / syncPeriod_us) - dueBefore;
+
+        // the master has as many free slots as the model after expiry
+        uint32_t live = test_model_expire();
+        uint32_t free = PTP_MASTER_SYNC_SLOTS - live;
+        uint32_t expectedSent = (due < free) ? due : free;
+        if (free == 0) {
+            sStats.fullTicks++;
+        }
+
+        uint32_t skipped0 = ss->skipped, syncs0 = sStats.syncs;
+        ptp_master_tick();
+        uint32_t sent = sStats.syncs - syncs0;
+
+        if (sent != expectedSent) {
+            test_fail("number of Syncs sent", sent, expectedSent);
+        }
+        if ((ss->skipped - skipped0) != (due - expectedSent)) {
+            test_fail("number of Syncs skipped", ss->skipped - skipped0, due - expectedSent);
+        }
+        sStats.skipped += due - expectedSent;
+        if (due > expectedSent) {
+            sLastSyncTick = 0; // the interval spans a skipped Sync
+        }
+        if (ss->expired != sStats.expired) {
+            test_fail("number of expired slots", ss->expired, sStats.expired);
+        }
+
+        // timestamps arrive between the ticks
+        test_schedule_deliveries(pSc);
+        test_deliver(pSc);
+
+        // the occupied slots are the ones of the Syncs still awaiting their timestamps
+        uint32_t outstanding = 0;
+        for (uint32_t i = 0; i < TEST_MAX_IN_FLIGHT; i++) {
+            outstanding += (sInFlight[i].used && sInFlight[i].slotLive) ? 1 : 0;
+        }
+        if (ss->outstanding != outstanding) {
+            test_fail("number of occupied slots", ss->outstanding, outstanding);
+        }
+    }
+
+    MSG("--- %s ---\n", pSc->name);
+    MSG("Syncs: %u, Follow_Ups: %u, late timestamps: %u\n", sStats.syncs, sStats.followUps, sStats.late);
+    MSG("Skipped: %u (master: %u) in %u ticks with all slots busy, expired: %u (master: %u)\n", sStats.skipped, ss->skipped, sStats.fullTicks, sStats.expired, ss->expired);
+    MSG("Sync intervals: %.3f - %.3f ms\n", sStats.minGap_us / 1000.0, sStats.maxGap_us / 1000.0);
+    MSG("Failed checks: %u\n\n", sStats.failures);
+
+    return sStats.failures;
+}
+
+static void test_print_usage(const char *prog) {
+    MSG("Usage: %s [-p log_sync_period] [-t duration_s] [-s seed] [-v]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:s:vh")) != -1) {
+        switch (opt) {
+        case 'p':
+            sParams.logSyncPeriod = (int8_t)strtol(optarg, NULL, 10);
+            break;
+        case 't':
+            sParams.duration_s = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            sParams.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'v':
+            sParams.verbose = true;
+            break;
+        default:
+            test_print_usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if ((sParams.logSyncPeriod < PTP_LOGPER_MIN) || (sParams.logSyncPeriod > PTP_LOGPER_MAX) || (sParams.seed == 0)) {
+        test_print_usage(argv[0]);
+        return 1;
+    }
+
+    host_rand_seed(sParams.seed);
+
+    // the master raises periods shorter than the heartbeat
+    sLogSyncPeriod = MAX(sParams.logSyncPeriod, PTP_LOGPER_SYNC_MIN);
+    MSG("Sync period: 2^%d s (requested: 2^%d s), heartbeat: %u ms, %u slots, slot timeout: %u ticks\n\n", sLogSyncPeriod, sParams.logSyncPeriod,
+        PTP_HEARTBEAT_TICKRATE_MS, PTP_MASTER_SYNC_SLOTS, PTP_MASTER_SYNC_SLOT_TIMEOUT_TICKS);
+
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < sizeof(sScenarios) / sizeof(sScenarios[0]); i++) {
+        failures += test_run_scenario(&sScenarios[i]);
+    }
+
+    MSG("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}